@@ -0,0 +1,124 @@
+/**
+ * @file arena.c
+ * @brief Implements the bump-pointer arena allocator for the Obsidian compiler.
+ *
+ * This file hands out memory from large chunks by advancing an offset, which
+ * makes allocation a few instructions and freeing a whole tree a walk over a
+ * handful of chunks.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/arena.h"
+#include "include/memstats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE (64 * 1024)    ///< Default chunk payload size.
+#define ARENA_ALIGN 16                  ///< Alignment of every allocation.
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena Pointer to the arena to initialize.
+ */
+void initArena(Arena *arena) {
+    arena->head = NULL;
+    arena->totalBytes = 0;
+}
+
+/**
+ * @brief Allocates zeroed, suitably aligned memory from the arena.
+ *
+ * Requests larger than the default chunk size get a chunk of their own.
+ *
+ * @param arena Pointer to the arena.
+ * @param size Number of bytes to allocate.
+ * @return void* Pointer to the memory, or NULL if a chunk could not be allocated.
+ */
+void *arenaAlloc(Arena *arena, size_t size) {
+    ArenaChunk *chunk = arena->head;
+    void *memory;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        size_t chunkSize = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = malloc(sizeof(ArenaChunk) + chunkSize);
+        if (chunk == NULL) return NULL;
+        chunk->next = arena->head;
+        chunk->used = 0;
+        chunk->size = chunkSize;
+        arena->head = chunk;
+        arena->totalBytes += chunkSize;
+        memAcquire(MEM_ARENAS, chunkSize);
+    }
+
+    memory = chunk->data + chunk->used;
+    chunk->used += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+/**
+ * @brief Copies a buffer into the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @param data Pointer to the bytes to copy.
+ * @param size Number of bytes to copy.
+ * @return void* Pointer to the copy, or NULL if memory could not be allocated.
+ */
+void *arenaCopy(Arena *arena, const void *data, size_t size) {
+    void *memory = arenaAlloc(arena, size);
+    if (memory != NULL && size > 0) memcpy(memory, data, size);
+    return memory;
+}
+
+/**
+ * @brief Records the current position of the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @return ArenaMark The position, to be passed to arenaReset.
+ */
+ArenaMark arenaMark(const Arena *arena) {
+    ArenaMark mark;
+    mark.chunk = arena->head;
+    mark.used = arena->head != NULL ? arena->head->used : 0;
+    return mark;
+}
+
+/**
+ * @brief Releases everything allocated since a mark was taken.
+ *
+ * @param arena Pointer to the arena.
+ * @param mark A position returned by arenaMark on the same arena.
+ */
+void arenaReset(Arena *arena, ArenaMark mark) {
+    while (arena->head != mark.chunk && (mark.chunk != NULL || arena->head->next != NULL)) {
+        ArenaChunk *next = arena->head->next;
+        arena->totalBytes -= arena->head->size;
+        memRelease(MEM_ARENAS, arena->head->size);
+        free(arena->head);
+        arena->head = next;
+    }
+    if (arena->head != NULL) arena->head->used = arena->head == mark.chunk ? mark.used : 0;
+}
+
+/**
+ * @brief Releases every chunk owned by the arena.
+ *
+ * @param arena Pointer to the arena to free.
+ */
+void freeArena(Arena *arena) {
+    ArenaChunk *chunk = arena->head;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    memRelease(MEM_ARENAS, arena->totalBytes);
+    initArena(arena);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file ast.c
+ * @brief Implements helpers for the abstract syntax tree of the Obsidian language.
+ *
+ * This file contains the small queries over types that the parser, the
+ * semantic checker, and the code generators share.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/ast.h"
+
+/**
+ * @brief Maps a type keyword token to its TypeKind.
+ *
+ * @param kind The token kind of the type keyword.
+ * @return TypeKind The matching type, or TypeInvalid if the token is not a type.
+ */
+TypeKind typeFromToken(TokenKind kind) {
+    switch (kind) {
+        case TI8: return TypeI8;
+        case TI16: return TypeI16;
+        case TI32: return TypeI32;
+        case TI64: return TypeI64;
+        case TU8: return TypeU8;
+        case TU16: return TypeU16;
+        case TU32: return TypeU32;
+        case TU64: return TypeU64;
+        case TF32: return TypeF32;
+        case TF64: return TypeF64;
+        case TBool: return TypeBool;
+        case TChar: return TypeChar;
+        case TString: return TypeString;
+        case TVoid: return TypeVoid;
+        default: return TypeInvalid;
+    }
+}
+
+/**
+ * @brief Returns the source spelling of a type.
+ *
+ * @param type The type to name.
+ * @return const char* The type's keyword, or a description for internal types.
+ */
+const char *typeName(TypeKind type) {
+    switch (type) {
+        case TypeVoid: return "void";
+        case TypeBool: return "bool";
+        case TypeChar: return "char";
+        case TypeI8: return "i8";
+        case TypeI16: return "i16";
+        case TypeI32: return "i32";
+        case TypeI64: return "i64";
+        case TypeU8: return "u8";
+        case TypeU16: return "u16";
+        case TypeU32: return "u32";
+        case TypeU64: return "u64";
+        case TypeF32: return "f32";
+        case TypeF64: return "f64";
+        case TypeString: return "string";
+        case TypeUntypedInt: return "integer literal";
+        case TypeUntypedFloat: return "float literal";
+        default: return "invalid type";
+    }
+}
+
+/**
+ * @brief Checks whether a type is an integer type, including untyped integer literals.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is an integer type.
+ */
+int isIntegerType(TypeKind type) {
+    return (type >= TypeI8 && type <= TypeU64) || type == TypeUntypedInt;
+}
+
+/**
+ * @brief Checks whether a type is a floating-point type, including untyped float literals.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is a floating-point type.
+ */
+int isFloatType(TypeKind type) {
+    return type == TypeF32 || type == TypeF64 || type == TypeUntypedFloat;
+}
+
+/**
+ * @brief Checks whether a type is a signed integer type.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is i8, i16, i32, or i64.
+ */
+int isSignedType(TypeKind type) {
+    return type >= TypeI8 && type <= TypeI64;
+}
+
+/**
+ * @brief Checks whether a type is numeric (integer or floating-point).
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is numeric.
+ */
+int isNumericType(TypeKind type) {
+    return isIntegerType(type) || isFloatType(type);
+}
+
+/**
+ * @brief Returns the size in bytes of a value of the given type.
+ *
+ * @param type The type to measure.
+ * @return int The size in bytes; strings are pointer-sized.
+ */
+int typeSize(TypeKind type) {
+    switch (type) {
+        case TypeBool: case TypeChar: case TypeI8: case TypeU8: return 1;
+        case TypeI16: case TypeU16: return 2;
+        case TypeI32: case TypeU32: case TypeF32: return 4;
+        case TypeI64: case TypeU64: case TypeF64: case TypeString: return 8;
+        default: return 0;
+    }
+}
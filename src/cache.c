@@ -0,0 +1,288 @@
+/**
+ * @file cache.c
+ * @brief Implements the per-file token cache for the Obsidian compiler.
+ *
+ * This file lexes source files into token streams and keeps them, together
+ * with the source buffer and interned identifier symbols, so that repeated
+ * compilations of an unchanged file skip reading and lexing entirely.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _XOPEN_SOURCE 700
+#endif
+
+#include "include/cache.h"
+#include "include/common.h"
+#include "include/memstats.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__APPLE__)
+    #define STAT_MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#elif defined(_WIN32)
+    #define STAT_MTIME_NSEC(st) 0
+#else
+    #define STAT_MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
+
+#ifndef PATH_MAX
+    #define PATH_MAX 4096
+#endif
+
+#define TOKEN_BYTES (sizeof(Token) + sizeof(uint32_t))  ///< Stream bytes per token slot.
+
+/**
+ * @brief Hashes a buffer with 64-bit FNV-1a.
+ *
+ * @param data Pointer to the bytes to hash.
+ * @param length Number of bytes to hash.
+ * @return uint64_t The hash of the buffer.
+ */
+uint64_t hashContents(const char *data, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Lexes a NUL-terminated source buffer into a token stream.
+ *
+ * The token array is sized from the source length up front, which avoids
+ * most reallocations for typical code, and trimmed to the token count once
+ * lexing is done.
+ *
+ * @param source Pointer to the NUL-terminated source code.
+ * @param symbols Pointer to the intern table receiving identifier spellings.
+ * @param stream Pointer to the stream to fill.
+ * @param diagnostics Pointer to the sink that receives lexical errors, or NULL for stderr.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int tokenize(char *source, InternTable *symbols, TokenStream *stream, const DiagnosticSink *diagnostics) {
+    Lexer lexer;
+    size_t capacity = strlen(source) / 4 + 16;
+
+    stream->count = 0;
+    stream->capacity = 0;
+    stream->hasErrors = 0;
+    stream->tokens = malloc(capacity * sizeof(Token));
+    stream->symbols = malloc(capacity * sizeof(uint32_t));
+    if (stream->tokens == NULL || stream->symbols == NULL) {
+        freeTokenStream(stream);
+        return -1;
+    }
+    stream->capacity = capacity;
+    memAcquire(MEM_TOKENS, capacity * TOKEN_BYTES);
+
+    initLexer(&lexer, source);
+    lexer.diagnostics = diagnostics;
+    while (1) {
+        Token token = getNextToken(&lexer);
+
+        if (stream->count == capacity) {
+            Token *tokens;
+            uint32_t *ids;
+            capacity *= 2;
+            tokens = realloc(stream->tokens, capacity * sizeof(Token));
+            if (tokens == NULL) {
+                freeTokenStream(stream);
+                return -1;
+            }
+            stream->tokens = tokens;
+            ids = realloc(stream->symbols, capacity * sizeof(uint32_t));
+            if (ids == NULL) {
+                freeTokenStream(stream);
+                return -1;
+            }
+            stream->symbols = ids;
+            memAcquire(MEM_TOKENS, (capacity - stream->capacity) * TOKEN_BYTES);
+            stream->capacity = capacity;
+        }
+
+        stream->symbols[stream->count] = (token.type == TIdentifier) ? internSymbol(symbols, token.start, (size_t)token.length) : SYMBOL_NONE;
+        stream->tokens[stream->count++] = token;
+        if (token.type == TError) stream->hasErrors = 1;
+        if (token.type == TEof) break;
+    }
+
+    /* Streams stay cached for the life of the process; drop the unused tail. */
+    if (stream->count < stream->capacity) {
+        Token *tokens = realloc(stream->tokens, stream->count * sizeof(Token));
+        uint32_t *ids = realloc(stream->symbols, stream->count * sizeof(uint32_t));
+        if (tokens != NULL) stream->tokens = tokens;
+        if (ids != NULL) stream->symbols = ids;
+        if (tokens != NULL && ids != NULL) {
+            memRelease(MEM_TOKENS, (stream->capacity - stream->count) * TOKEN_BYTES);
+            stream->capacity = stream->count;
+        }
+    }
+    memNoteLexed(strlen(source), stream->count);
+    return 0;
+}
+
+/**
+ * @brief Releases the arrays owned by a token stream.
+ *
+ * @param stream Pointer to the stream to free.
+ */
+void freeTokenStream(TokenStream *stream) {
+    memRelease(MEM_TOKENS, stream->capacity * TOKEN_BYTES);
+    free(stream->tokens);
+    free(stream->symbols);
+    stream->tokens = NULL;
+    stream->symbols = NULL;
+    stream->count = 0;
+    stream->capacity = 0;
+    stream->hasErrors = 0;
+}
+
+/**
+ * @brief Frees the token stream and source buffer of an entry.
+ *
+ * @param entry Pointer to the cache entry.
+ */
+static void clearEntry(CacheEntry *entry) {
+    if (entry->source != NULL) memRelease(MEM_SOURCE, entry->sourceLength + 1);
+    free(entry->source);
+    entry->source = NULL;
+    entry->sourceLength = 0;
+    freeTokenStream(&entry->stream);
+}
+
+/**
+ * @brief Returns the entry slot for a canonical path, creating it if needed.
+ *
+ * @param cache Pointer to the token cache.
+ * @param path Canonical path of the file.
+ * @return CacheEntry* The entry, or NULL if memory could not be allocated.
+ */
+static CacheEntry *entryForPath(TokenCache *cache, const char *path) {
+    uint32_t id = internSymbol(&cache->paths, path, strlen(path));
+    CacheEntry *entry;
+
+    if (id == SYMBOL_NONE) return NULL;
+
+    if (id >= cache->capacity) {
+        size_t newCapacity = cache->capacity ? cache->capacity * 2 : 16;
+        CacheEntry **entries;
+        while (newCapacity <= id) newCapacity *= 2;
+        entries = realloc(cache->entries, newCapacity * sizeof(CacheEntry *));
+        if (entries == NULL) return NULL;
+        memset(entries + cache->capacity, 0, (newCapacity - cache->capacity) * sizeof(CacheEntry *));
+        cache->entries = entries;
+        cache->capacity = newCapacity;
+    }
+
+    entry = cache->entries[id];
+    if (entry == NULL) {
+        entry = calloc(1, sizeof(CacheEntry));
+        if (entry == NULL) return NULL;
+        entry->path = (char *)symbolName(&cache->paths, id);
+        cache->entries[id] = entry;
+    }
+    return entry;
+}
+
+/**
+ * @brief Initializes an empty token cache.
+ *
+ * @param cache Pointer to the token cache to initialize.
+ */
+void initTokenCache(TokenCache *cache) {
+    initInternTable(&cache->paths);
+    initInternTable(&cache->symbols);
+    cache->entries = NULL;
+    cache->capacity = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->diagnostics = NULL;
+}
+
+/**
+ * @brief Releases every entry, buffer, and symbol owned by the cache.
+ *
+ * @param cache Pointer to the token cache to free.
+ */
+void freeTokenCache(TokenCache *cache) {
+    for (size_t i = 0; i < cache->capacity; i++) {
+        if (cache->entries[i] != NULL) {
+            clearEntry(cache->entries[i]);
+            free(cache->entries[i]);
+        }
+    }
+    free(cache->entries);
+    freeInternTable(&cache->paths);
+    freeInternTable(&cache->symbols);
+    initTokenCache(cache);
+}
+
+/**
+ * @brief Returns the token stream of a file, lexing it only when needed.
+ *
+ * The fast path is a single stat call: if the modification time and size
+ * match what was recorded, the cached entry is returned untouched. Otherwise
+ * the file is read and hashed, and only lexed again if its contents changed.
+ *
+ * @param cache Pointer to the token cache.
+ * @param path Path of the source file.
+ * @return const CacheEntry* The up-to-date entry, or NULL if the file could not be read.
+ */
+const CacheEntry *loadTokens(TokenCache *cache, const char *path) {
+    char canonical[PATH_MAX];
+    struct stat info;
+    CacheEntry *entry;
+    char *source;
+    size_t length;
+    uint64_t hash;
+
+    if (stat(path, &info) != 0) return NULL;
+#ifdef _WIN32
+    if (_fullpath(canonical, path, sizeof(canonical)) == NULL) return NULL;
+#else
+    if (realpath(path, canonical) == NULL) return NULL;
+#endif
+
+    entry = entryForPath(cache, canonical);
+    if (entry == NULL) return NULL;
+
+    if (entry->source != NULL && !entry->stream.hasErrors && entry->mtimeSec == (int64_t)info.st_mtime && entry->mtimeNsec == (int64_t)STAT_MTIME_NSEC(info) && entry->fileSize == (int64_t)info.st_size) {
+        cache->hits++;
+        return entry;
+    }
+
+    source = readFile(canonical, &length);
+    if (source == NULL) return NULL;
+    hash = hashContents(source, length);
+
+    entry->mtimeSec = (int64_t)info.st_mtime;
+    entry->mtimeNsec = (int64_t)STAT_MTIME_NSEC(info);
+    entry->fileSize = (int64_t)info.st_size;
+
+    if (entry->source != NULL && !entry->stream.hasErrors && entry->hash == hash && entry->sourceLength == length) {
+        free(source);
+        cache->hits++;
+        return entry;
+    }
+
+    cache->misses++;
+    clearEntry(entry);
+    entry->source = source;
+    entry->sourceLength = length;
+    memAcquire(MEM_SOURCE, length + 1);
+    entry->hash = hash;
+
+    if (tokenize(entry->source, &cache->symbols, &entry->stream, cache->diagnostics) != 0) {
+        clearEntry(entry);
+        return NULL;
+    }
+    return entry;
+}
@@ -12,6 +12,10 @@
  * @license BSD 3-Clause
  */
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "include/common.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,9 +24,19 @@
 #if defined (_WIN32)  || defined(_WIN64)
     #include <windows.h>
 #else
+    #include <sys/stat.h>
     #include <sys/utsname.h>
+    #include <unistd.h>
 #endif
 
+#ifdef _MSC_VER
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+static THREAD_LOCAL MemoryGuard *memoryGuard;   ///< Innermost guard of the thread, or NULL.
+
 /**
  * @brief Displays the help menu for the Obsidian compiler.
  * 
@@ -31,6 +45,7 @@
  */
 void printHelpMenu(void) {
     puts("Usage: obsidian [options] file...\n"
+        "       obsidian fmt [--check] [-j <jobs>] [file|dir]...\n"
         "Options:\n"
         " --help           Displays this information.\n"
         " --help={optimizers|warnings|target}[,...].\n\n"
@@ -38,7 +53,19 @@ void printHelpMenu(void) {
         " -save-temps      Do not delete intermediate files.\n\n"
         " -S               Compile only; do not assemble or link.\n"
         " -c               Compile and assemble, but do not link.\n"
-        " -o <file>        Place the output into <file>.\n\n"
+        " -o <file>        Place the output into <file>.\n"
+        " -fsyntax-only    Check the declarations only; function bodies are skipped.\n"
+        " -fcheck-body=<fn>[,...]  Also check the bodies of the named functions.\n"
+        " --index          Print the declarations without parsing function bodies.\n\n"
+        " --run            Compile to bytecode and run the program's main function.\n"
+        " -O<number>       Set optimization level to <number> (0-3).\n"
+        " --emit-ir        Print the optimized intermediate representation.\n"
+        " --time-passes    Report the time spent in each optimization pass.\n"
+        " --mem-report     Report the memory held by each compiler subsystem.\n"
+        " --stats=json[=<file>]  Write the same memory statistics as JSON to stdout or <file>.\n\n"
+        " --daemon         Keep a warm compiler process on a local socket.\n"
+        " --client         Forward this command line to a running daemon.\n"
+        " --watch [dir]    Check the sources under dir and recheck them on change.\n\n"
         "Report bugs at <https://github.com/obsidian-language/obsidian/issues>");
 }
 
@@ -50,7 +77,13 @@ void printHelpMenu(void) {
  */
 void printOptimizersHelp(void) {
     puts("The following options control optimizations:\n"
-            " -O<number>        Set optimization level to <number>\n");
+            " -O<number>        Set optimization level to <number>\n"
+            " -O0               Do not optimize (default).\n"
+            " -O, -O1           Copy propagation, constant folding, dead code elimination.\n"
+            " -O2               Adds inlining of small leaf functions, global value\n"
+            "                   numbering, and loop-invariant code motion.\n"
+            " -O3               Inlines larger functions and repeats the -O2 passes.\n"
+            " --time-passes     Report the time spent in each pass.\n");
 }
 
 /**
@@ -117,3 +150,141 @@ void systemInfo(char *output, size_t size) {
 #endif
     output[size - 1] = '\0'; ///< Kept to insure safety 
 }
+
+/**
+ * @brief Reads a whole file into a NUL-terminated buffer.
+ * 
+ * @param path Path of the file to read.
+ * @param length Optional pointer that receives the number of bytes read.
+ * @return char* The file contents, or NULL if the file could not be read.
+ * 
+ * The file is opened in binary mode so the byte count reported by ftell
+ * matches what fread returns on every platform.
+ */
+char *readFile(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    char *buffer;
+    long size;
+
+    if (file == NULL) return NULL;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0) {
+        fclose(file);
+        return NULL;
+    }
+    rewind(file);
+
+    buffer = (char *)malloc((size_t)size + 1);
+    if (buffer == NULL) {
+        fclose(file);
+        return NULL;
+    }
+
+    if (fread(buffer, 1, (size_t)size, file) != (size_t)size) {
+        free(buffer);
+        fclose(file);
+        return NULL;
+    }
+    buffer[size] = '\0';
+    fclose(file);
+
+    if (length != NULL) *length = (size_t)size;
+    return buffer;
+}
+
+/**
+ * @brief Replaces a file's contents through a temporary file that is renamed over it.
+ * 
+ * The temporary file is created beside the file with mkstemp(), so runs
+ * writing the same file at once never share one, and it takes the mode of
+ * the file it replaces, or the default mode of a new file.
+ * 
+ * @param path Path of the file to replace or create.
+ * @param data The new contents.
+ * @param size Number of bytes in `data`.
+ * @return int Returns 0 on success, or -1 on failure.
+ */
+int replaceFile(const char *path, const void *data, size_t size) {
+    char *temporary = malloc(strlen(path) + 8);
+    FILE *file = NULL;
+    int status = -1;
+
+    if (temporary == NULL) return -1;
+#ifdef _WIN32
+    sprintf(temporary, "%s.tmp", path);
+    file = fopen(temporary, "wb");
+#else
+    sprintf(temporary, "%s.XXXXXX", path);
+    {
+        struct stat info;
+        int descriptor = mkstemp(temporary);
+
+        if (descriptor >= 0) {
+            mode_t mode;
+            if (stat(path, &info) == 0) {
+                mode = info.st_mode & 07777;
+            } else {
+                mode_t mask = umask(0);
+                umask(mask);
+                mode = 0666 & ~mask;
+            }
+            if (fchmod(descriptor, mode) == 0) file = fdopen(descriptor, "wb");
+            if (file == NULL) {
+                close(descriptor);
+                remove(temporary);
+            }
+        }
+    }
+#endif
+    if (file != NULL) {
+        status = fwrite(data, 1, size, file) == size ? 0 : -1;
+        if (fclose(file) != 0) status = -1;
+#ifdef _WIN32
+        if (status == 0) remove(path);
+#endif
+        if (status == 0 && rename(temporary, path) != 0) status = -1;
+        if (status != 0) remove(temporary);
+    }
+    free(temporary);
+    return status;
+}
+
+/**
+ * @brief Installs a guard as the innermost one of the calling thread.
+ * 
+ * @param guard Pointer to the guard, whose jump has been set with setjmp().
+ */
+void pushMemoryGuard(MemoryGuard *guard) {
+    guard->outer = memoryGuard;
+    memoryGuard = guard;
+}
+
+/**
+ * @brief Removes the innermost guard of the calling thread.
+ * 
+ * @param guard Pointer to the guard, which must be the innermost one.
+ */
+void popMemoryGuard(MemoryGuard *guard) {
+    memoryGuard = guard->outer;
+}
+
+/**
+ * @brief Handles a failed allocation; does not return.
+ * 
+ * Jumping out skips whatever the interrupted functions would have freed, so
+ * the owner of a guard releases what it can reach and the rest is lost; that
+ * only happens once memory has already run out.
+ * 
+ * @param activity What was being done, such as "compiling", or NULL.
+ */
+void outOfMemory(const char *activity) {
+    MemoryGuard *guard = memoryGuard;
+
+    if (guard != NULL) {
+        memoryGuard = guard->outer;
+        longjmp(guard->jump, 1);
+    }
+    if (activity != NULL) fprintf(stderr, "obsidian: error: out of memory while %s\n", activity);
+    else fputs("obsidian: error: out of memory\n", stderr);
+    exit(EXIT_FAILURE);
+}
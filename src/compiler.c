@@ -0,0 +1,1354 @@
+/**
+ * @file compiler.c
+ * @brief Implements the front end of the Obsidian compiler: type checking and IR construction.
+ *
+ * This file walks the syntax tree once per function, checking the types of
+ * every expression and building SSA form as it goes. Variables are never
+ * stored anywhere: each assignment simply records the value a variable has
+ * at the end of the current block, and reads look that value up, inserting
+ * phis at join points on demand. Loop headers stay unsealed until their
+ * back edge is known, so the phis they need are completed afterwards. This
+ * is the construction of Braun et al., which needs no dominance frontiers
+ * and no separate renaming pass.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/compiler.h"
+#include "include/common.h"
+#include "include/error.h"
+#include "include/interface.h"
+#include "include/scope.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct PendingPhi
+ * @brief A phi created in an unsealed block whose operands are still unknown.
+ */
+typedef struct {
+    int block, var, phi;
+} PendingPhi;
+
+/**
+ * @struct Compiler
+ * @brief The state of the compiler while it compiles one program.
+ *
+ * `functionOf` is indexed by symbol ID and holds the function index plus
+ * one, which makes call resolution a single array load. Functions declared
+ * by imported interfaces follow the program's own, and their declarations
+ * are kept in `imported`. The current value
+ * of each variable in each block lives in `defs`, an open-addressed table
+ * keyed by block and variable.
+ */
+typedef struct {
+    const Program *program;
+    const InternTable *names;
+    IrModule *module;
+    const FnDecl *decl;
+    IrFunction *fn;
+    int block;
+    int *functionOf;
+    FnDecl *imported;
+    int importedCount, importedCapacity;
+    ScopeStack scopes;
+    TypeKind *varTypes;
+    int varCount, varCapacity;
+    uint64_t *defKeys;
+    int *defValues;
+    size_t defCount, defCapacity;
+    unsigned char *sealed;
+    int sealedCapacity;
+    PendingPhi *pending;
+    int pendingCount, pendingCapacity;
+    int *loopExits;
+    int loopDepth, loopCapacity;
+    const DiagnosticSink *diagnostics;
+    int hadError;
+} Compiler;
+
+static TypeKind checkExpr(Compiler *compiler, Expr *expr, TypeKind expected);
+static int buildExpr(Compiler *compiler, const Expr *expr);
+static void compileStatement(Compiler *compiler, const Stmt *stmt);
+
+/**
+ * @brief Grows a dynamic array so that it can hold at least `needed` elements.
+ *
+ * Allocation failure goes to outOfMemory(), which returns to compileProgram().
+ */
+static void *growArray(void *items, int *capacity, int needed, size_t size) {
+    int newCapacity;
+    void *grown;
+
+    if (needed <= *capacity) return items;
+    newCapacity = *capacity ? *capacity * 2 : 16;
+    while (newCapacity < needed) newCapacity *= 2;
+    grown = realloc(items, (size_t)newCapacity * size);
+    if (grown == NULL) outOfMemory("compiling");
+    *capacity = newCapacity;
+    return grown;
+}
+
+/**
+ * @brief Reports a semantic error at a token.
+ */
+static void semanticError(Compiler *compiler, const Token *token, const char *message) {
+    compiler->hadError = 1;
+    reportError(compiler->diagnostics, SemanticError, message, token);
+}
+
+/**
+ * @brief Reports a type mismatch between what was expected and what was found.
+ */
+static void typeMismatch(Compiler *compiler, const Token *token, TypeKind expected, TypeKind found) {
+    char message[128];
+    snprintf(message, sizeof(message), "Expected '%s' but found '%s'", typeName(expected), typeName(found));
+    semanticError(compiler, token, message);
+}
+
+
+/**
+ * @brief Enters a new innermost scope.
+ */
+static void beginScope(Compiler *compiler) {
+    if (pushScope(&compiler->scopes) != 0) outOfMemory("compiling");
+}
+
+/**
+ * @brief Leaves the innermost scope.
+ */
+static void endScope(Compiler *compiler) {
+    popScope(&compiler->scopes);
+}
+
+/**
+ * @brief Finds the variable bound to a name by its innermost declaration.
+ *
+ * @return int The variable, or -1 if the name is not in scope.
+ */
+static int resolveLocal(const Compiler *compiler, uint32_t name) {
+    return lookupSymbol(&compiler->scopes, name);
+}
+
+/**
+ * @brief Creates a new SSA variable of the given type.
+ */
+static int newVariable(Compiler *compiler, TypeKind type) {
+    compiler->varTypes = growArray(compiler->varTypes, &compiler->varCapacity, compiler->varCount + 1, sizeof(TypeKind));
+    compiler->varTypes[compiler->varCount] = type;
+    return compiler->varCount++;
+}
+
+/**
+ * @brief Declares a local in the current scope and returns its variable.
+ */
+static int declareLocal(Compiler *compiler, uint32_t name, TypeKind type, const Token *token) {
+    int var = newVariable(compiler, type);
+
+    switch (declareSymbol(&compiler->scopes, name, var)) {
+        case 0: break;
+        case 1: semanticError(compiler, token, "Variable is already declared in this scope"); break;
+        default:
+            outOfMemory("compiling");
+    }
+    return var;
+}
+
+/**
+ * @brief Looks up the declaration of a called function.
+ *
+ * @return const FnDecl* The declaration, or NULL if no function has that name.
+ */
+static const FnDecl *resolveFunction(const Compiler *compiler, uint32_t name, int *index) {
+    int slot = (name <= compiler->names->count) ? compiler->functionOf[name] : 0;
+    if (slot == 0) return NULL;
+    if (index != NULL) *index = slot - 1;
+    if (slot > compiler->program->fnCount) return &compiler->imported[slot - 1 - compiler->program->fnCount];
+    return &compiler->program->fns[slot - 1];
+}
+
+/**
+ * @brief Combines the natural types of two operands.
+ *
+ * An untyped literal takes the type of the other operand; two literals stay
+ * untyped, becoming a float literal if either of them is one.
+ */
+static TypeKind unifyTypes(TypeKind left, TypeKind right) {
+    if (left == right) return left;
+    if (left == TypeUntypedInt && isNumericType(right)) return right;
+    if (right == TypeUntypedInt && isNumericType(left)) return left;
+    if (left == TypeUntypedFloat && isFloatType(right)) return right;
+    if (right == TypeUntypedFloat && isFloatType(left)) return left;
+    return left;
+}
+
+/**
+ * @brief Computes the type every node of an expression has before context is applied.
+ *
+ * The type of each node is stored in its `natural` field as the walk returns,
+ * so every node is visited once however deeply the expression nests. Numeric
+ * literals report TypeUntypedInt or TypeUntypedFloat so that an operator can
+ * give them the type of its other operand.
+ *
+ * @return TypeKind The natural type of the expression.
+ */
+static TypeKind inferTypes(const Compiler *compiler, Expr *expr) {
+    TypeKind type = TypeInvalid;
+
+    switch (expr->kind) {
+        case ExprIntLiteral: type = TypeUntypedInt; break;
+        case ExprFloatLiteral: type = TypeUntypedFloat; break;
+        case ExprBoolLiteral: type = TypeBool; break;
+        case ExprStringLiteral: type = TypeString; break;
+        case ExprCharLiteral: type = TypeChar; break;
+        case ExprName: {
+            int reg = resolveLocal(compiler, expr->as.symbol);
+            type = reg < 0 ? TypeInvalid : compiler->varTypes[reg];
+            break;
+        }
+        case ExprUnary:
+            type = inferTypes(compiler, expr->as.unary.operand);
+            if (expr->as.unary.op == TNot) type = TypeBool;
+            break;
+        case ExprBinary: {
+            TypeKind left = inferTypes(compiler, expr->as.binary.left);
+            TypeKind right = inferTypes(compiler, expr->as.binary.right);
+            switch (expr->as.binary.op) {
+                case TEqual: case TNotEqual: case TLess: case TLessEqual: case TGreater: case TGreaterEqual: case TLogicalAnd: case TLogicalOr:
+                    type = TypeBool;
+                    break;
+                case TLeftShift: case TRightShift:
+                    type = left;
+                    break;
+                default:
+                    type = unifyTypes(left, right);
+                    break;
+            }
+            break;
+        }
+        case ExprAssign:
+            inferTypes(compiler, expr->as.assign.value);
+            type = inferTypes(compiler, expr->as.assign.target);
+            break;
+        case ExprIncDec:
+            type = inferTypes(compiler, expr->as.incDec.target);
+            break;
+        case ExprTernary:
+            inferTypes(compiler, expr->as.ternary.condition);
+            type = unifyTypes(inferTypes(compiler, expr->as.ternary.then), inferTypes(compiler, expr->as.ternary.otherwise));
+            break;
+        case ExprCall: {
+            const FnDecl *fn = resolveFunction(compiler, expr->as.call.callee, NULL);
+            for (int i = 0; i < expr->as.call.argCount; i++) inferTypes(compiler, expr->as.call.args[i]);
+            type = fn == NULL ? TypeInvalid : fn->returnType;
+            break;
+        }
+        case ExprCast:
+            inferTypes(compiler, expr->as.cast.operand);
+            type = expr->as.cast.to;
+            break;
+    }
+    expr->natural = type;
+    return type;
+}
+
+/**
+ * @brief Picks the concrete type for a pair of operands.
+ *
+ * If both operands are literals, the expected type is used when it can hold
+ * them, and otherwise i32 for integers and f64 for floats.
+ */
+static TypeKind operandType(const Expr *left, const Expr *right, TypeKind expected) {
+    TypeKind type = unifyTypes(left->natural, right->natural);
+    if (type == TypeUntypedInt) return isNumericType(expected) ? expected : TypeI32;
+    if (type == TypeUntypedFloat) return isFloatType(expected) ? expected : TypeF64;
+    return type;
+}
+
+/**
+ * @brief Checks an expression and requires it to have a specific type.
+ */
+static void checkExprAs(Compiler *compiler, Expr *expr, TypeKind type) {
+    TypeKind found = checkExpr(compiler, expr, type);
+    if (found != type && found != TypeInvalid && type != TypeInvalid) {
+        typeMismatch(compiler, &expr->token, type, found);
+    }
+}
+
+/**
+ * @brief Checks a call expression against the declaration of its callee.
+ */
+static TypeKind checkCall(Compiler *compiler, Expr *expr) {
+    const FnDecl *fn = resolveFunction(compiler, expr->as.call.callee, NULL);
+
+    if (fn == NULL) {
+        semanticError(compiler, &expr->token, "Call to undefined function");
+        for (int i = 0; i < expr->as.call.argCount; i++) checkExpr(compiler, expr->as.call.args[i], TypeInvalid);
+        return TypeInvalid;
+    }
+    if (fn->paramCount != expr->as.call.argCount) {
+        char message[96];
+        snprintf(message, sizeof(message), "Expected %d argument(s) but found %d in call to", fn->paramCount, expr->as.call.argCount);
+        semanticError(compiler, &expr->token, message);
+        return fn->returnType;
+    }
+    for (int i = 0; i < fn->paramCount; i++) {
+        checkExprAs(compiler, expr->as.call.args[i], fn->params[i].type);
+    }
+    return fn->returnType;
+}
+
+/**
+ * @brief Checks an expression, annotates it with its type, and returns that type.
+ *
+ * @param compiler Pointer to the compiler.
+ * @param expr The expression to check.
+ * @param expected The type required by the context, or TypeInvalid if any type will do.
+ * @return TypeKind The concrete type of the expression, or TypeInvalid after an error.
+ */
+static TypeKind checkExpr(Compiler *compiler, Expr *expr, TypeKind expected) {
+    TypeKind type = TypeInvalid;
+
+    switch (expr->kind) {
+        case ExprIntLiteral:
+            type = isNumericType(expected) && expected != TypeUntypedInt && expected != TypeUntypedFloat ? expected : TypeI32;
+            break;
+
+        case ExprFloatLiteral:
+            type = (expected == TypeF32 || expected == TypeF64) ? expected : TypeF64;
+            break;
+
+        case ExprBoolLiteral: type = TypeBool; break;
+        case ExprStringLiteral: type = TypeString; break;
+        case ExprCharLiteral: type = TypeChar; break;
+
+        case ExprName: {
+            int reg = resolveLocal(compiler, expr->as.symbol);
+            if (reg < 0) {
+                semanticError(compiler, &expr->token, "Use of undeclared variable");
+            } else {
+                type = compiler->varTypes[reg];
+            }
+            break;
+        }
+
+        case ExprUnary:
+            if (expr->as.unary.op == TNot) {
+                checkExprAs(compiler, expr->as.unary.operand, TypeBool);
+                type = TypeBool;
+            } else {
+                type = checkExpr(compiler, expr->as.unary.operand, expected);
+                if (type != TypeInvalid && (expr->as.unary.op == TMinus ? !isNumericType(type) : !isIntegerType(type))) {
+                    semanticError(compiler, &expr->token, "Invalid operand type for unary operator");
+                    type = TypeInvalid;
+                }
+            }
+            break;
+
+        case ExprBinary: {
+            TokenKind op = expr->as.binary.op;
+            Expr *left = expr->as.binary.left, *right = expr->as.binary.right;
+
+            if (op == TLogicalAnd || op == TLogicalOr) {
+                checkExprAs(compiler, left, TypeBool);
+                checkExprAs(compiler, right, TypeBool);
+                type = TypeBool;
+            } else if (op == TLeftShift || op == TRightShift) {
+                type = checkExpr(compiler, left, expected);
+                checkExpr(compiler, right, type);
+                if (type != TypeInvalid && (!isIntegerType(type) || !isIntegerType(right->type))) {
+                    semanticError(compiler, &expr->token, "Shift operands must be integers");
+                    type = TypeInvalid;
+                }
+            } else {
+                int comparison = op == TEqual || op == TNotEqual || op == TLess || op == TLessEqual || op == TGreater || op == TGreaterEqual;
+                TypeKind operand = operandType(left, right, comparison ? TypeInvalid : expected);
+                TypeKind leftType = checkExpr(compiler, left, operand);
+                TypeKind rightType = checkExpr(compiler, right, operand);
+
+                if (leftType == TypeInvalid || rightType == TypeInvalid) {
+                    type = TypeInvalid;
+                } else if (leftType != rightType) {
+                    char message[128];
+                    snprintf(message, sizeof(message), "Mismatched operand types '%s' and '%s' for operator", typeName(leftType), typeName(rightType));
+                    semanticError(compiler, &expr->token, message);
+                } else if (comparison) {
+                    int ordered = op != TEqual && op != TNotEqual;
+                    if (leftType == TypeString || (ordered && leftType == TypeBool)) {
+                        semanticError(compiler, &expr->token, "Operands cannot be compared with operator");
+                    } else {
+                        type = TypeBool;
+                    }
+                } else if ((op == TAmpersand || op == TPipe || op == TCarot) ? !isIntegerType(leftType) : !isNumericType(leftType)) {
+                    semanticError(compiler, &expr->token, "Invalid operand types for operator");
+                } else if (op == TPlus || op == TMinus || op == TStar || op == TSlash || op == TPercent || op == TAmpersand || op == TPipe || op == TCarot) {
+                    type = leftType;
+                } else {
+                    semanticError(compiler, &expr->token, "Unsupported binary operator");
+                }
+            }
+            break;
+        }
+
+        case ExprAssign: {
+            Expr *target = expr->as.assign.target;
+            if (target->kind != ExprName) {
+                semanticError(compiler, &expr->token, "Invalid assignment target");
+                checkExpr(compiler, expr->as.assign.value, TypeInvalid);
+                break;
+            }
+            type = checkExpr(compiler, target, TypeInvalid);
+            checkExprAs(compiler, expr->as.assign.value, type);
+            if (type != TypeInvalid && expr->as.assign.op != TAssign && !isNumericType(type)) {
+                semanticError(compiler, &expr->token, "Compound assignment requires a numeric variable");
+                type = TypeInvalid;
+            }
+            break;
+        }
+
+        case ExprIncDec:
+            if (expr->as.incDec.target->kind != ExprName) {
+                semanticError(compiler, &expr->token, "Invalid increment or decrement target");
+                break;
+            }
+            type = checkExpr(compiler, expr->as.incDec.target, TypeInvalid);
+            if (type != TypeInvalid && !isNumericType(type)) {
+                semanticError(compiler, &expr->token, "Increment and decrement require a numeric variable");
+                type = TypeInvalid;
+            }
+            break;
+
+        case ExprTernary: {
+            TypeKind branch = operandType(expr->as.ternary.then, expr->as.ternary.otherwise, expected);
+            checkExprAs(compiler, expr->as.ternary.condition, TypeBool);
+            type = checkExpr(compiler, expr->as.ternary.then, branch);
+            checkExprAs(compiler, expr->as.ternary.otherwise, type);
+            break;
+        }
+
+        case ExprCall:
+            type = checkCall(compiler, expr);
+            break;
+
+        case ExprCast: {
+            TypeKind from = checkExpr(compiler, expr->as.cast.operand, TypeInvalid);
+            TypeKind to = expr->as.cast.to;
+            if (from == TypeString || to == TypeString || to == TypeVoid || from == TypeVoid) {
+                if (from != TypeInvalid) semanticError(compiler, &expr->token, "Invalid cast");
+            } else {
+                type = to;
+            }
+            break;
+        }
+    }
+
+    expr->type = type;
+    return type;
+}
+
+/**
+ * @brief Checks a whole expression, such as the one of a statement.
+ *
+ * The natural types of all its nodes are computed first, which the checks of
+ * its operators read as they pass the expected type down.
+ */
+static TypeKind checkTree(Compiler *compiler, Expr *expr, TypeKind expected) {
+    inferTypes(compiler, expr);
+    return checkExpr(compiler, expr, expected);
+}
+
+/**
+ * @brief Checks a whole expression and requires it to have a specific type.
+ */
+static void checkTreeAs(Compiler *compiler, Expr *expr, TypeKind type) {
+    inferTypes(compiler, expr);
+    checkExprAs(compiler, expr, type);
+}
+
+
+/**
+ * @brief Finds the slot of a (block, variable) pair in the definition table.
+ */
+static size_t findDef(const Compiler *compiler, uint64_t key) {
+    size_t mask = compiler->defCapacity - 1;
+    size_t slot = (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+    while (compiler->defKeys[slot] != 0 && compiler->defKeys[slot] != key) slot = (slot + 1) & mask;
+    return slot;
+}
+
+/**
+ * @brief Records the value a variable has at the end of a block.
+ */
+static void writeVariable(Compiler *compiler, int var, int block, int value) {
+    uint64_t key = ((uint64_t)(uint32_t)block << 32 | (uint32_t)var) + 1;
+    size_t slot;
+
+    if ((compiler->defCount + 1) * 2 > compiler->defCapacity) {
+        uint64_t *oldKeys = compiler->defKeys;
+        int *oldValues = compiler->defValues;
+        size_t oldCapacity = compiler->defCapacity;
+
+        compiler->defCapacity = oldCapacity ? oldCapacity * 2 : 256;
+        compiler->defKeys = calloc(compiler->defCapacity, sizeof(uint64_t));
+        compiler->defValues = malloc(compiler->defCapacity * sizeof(int));
+        if (compiler->defKeys == NULL || compiler->defValues == NULL) outOfMemory("compiling");
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldKeys[i] == 0) continue;
+            slot = findDef(compiler, oldKeys[i]);
+            compiler->defKeys[slot] = oldKeys[i];
+            compiler->defValues[slot] = oldValues[i];
+        }
+        free(oldKeys);
+        free(oldValues);
+    }
+
+    slot = findDef(compiler, key);
+    if (compiler->defKeys[slot] == 0) {
+        compiler->defKeys[slot] = key;
+        compiler->defCount++;
+    }
+    compiler->defValues[slot] = value;
+}
+
+/**
+ * @brief Looks up the value a variable has at the end of a block, if recorded.
+ */
+static int lookupVariable(const Compiler *compiler, int var, int block) {
+    uint64_t key = ((uint64_t)(uint32_t)block << 32 | (uint32_t)var) + 1;
+    size_t slot;
+
+    if (compiler->defCapacity == 0) return IR_NONE;
+    slot = findDef(compiler, key);
+    return compiler->defKeys[slot] == key ? compiler->defValues[slot] : IR_NONE;
+}
+
+/**
+ * @brief Creates a new block that has not been sealed yet.
+ */
+static int newBlock(Compiler *compiler) {
+    int block = irNewBlock(compiler->fn);
+    compiler->sealed = growArray(compiler->sealed, &compiler->sealedCapacity, block + 1, 1);
+    compiler->sealed[block] = 0;
+    return block;
+}
+
+/**
+ * @brief Builds a constant of the given type.
+ *
+ * Integer values are truncated to the width of the type, and each type is
+ * stored in the slot field the virtual machine reads it from.
+ */
+static int buildConstant(Compiler *compiler, int block, int position, TypeKind type, uint64_t intValue, double floatValue, int isFloat) {
+    Slot value;
+    int v;
+
+    value.u64 = 0;
+    switch (type) {
+        case TypeF32: value.f32 = isFloat ? (float)floatValue : (float)intValue; break;
+        case TypeF64: value.f64 = isFloat ? floatValue : (double)intValue; break;
+        case TypeI64: case TypeU64: case TypeString: value.u64 = intValue; break;
+        case TypeI8: value.i32 = (int8_t)intValue; break;
+        case TypeI16: value.i32 = (int16_t)intValue; break;
+        case TypeI32: value.i32 = (int32_t)intValue; break;
+        case TypeU8: case TypeChar: value.u32 = (uint8_t)intValue; break;
+        case TypeU16: value.u32 = (uint16_t)intValue; break;
+        case TypeBool: value.u32 = intValue != 0; break;
+        default: value.u32 = (uint32_t)intValue; break;
+    }
+
+    if (type == TypeString) {
+        value.str = "";
+    } else if (type == TypeInvalid || type == TypeVoid) {
+        type = TypeI32;
+    }
+    v = position < 0 ? irAppend(compiler->fn, block, IR_CONST, type, NULL, 0)
+                     : irInsert(compiler->fn, block, position, IR_CONST, type, NULL, 0);
+    compiler->fn->insns[v].as.constant = value;
+    return v;
+}
+
+/**
+ * @brief Builds a zero of the given type in the current block.
+ */
+static int buildZero(Compiler *compiler, TypeKind type) {
+    return buildConstant(compiler, compiler->block, -1, type, 0, 0.0, 0);
+}
+
+/**
+ * @brief Builds an instruction in the current block.
+ */
+static int build(Compiler *compiler, IrOp op, TypeKind type, const int *args, int argCount) {
+    return irAppend(compiler->fn, compiler->block, op, type, args, argCount);
+}
+
+/**
+ * @brief Builds an instruction whose operands are of a different type than its result.
+ */
+static int buildTyped(Compiler *compiler, IrOp op, TypeKind type, TypeKind operandType, const int *args, int argCount) {
+    int v = build(compiler, op, type, args, argCount);
+    compiler->fn->insns[v].operandType = operandType;
+    return v;
+}
+
+/**
+ * @brief Ends the current block with a jump.
+ */
+static void buildJump(Compiler *compiler, int target) {
+    int v = build(compiler, IR_JUMP, TypeVoid, NULL, 0);
+    compiler->fn->insns[v].as.targets[0] = target;
+    irAddPred(compiler->fn, target, compiler->block);
+}
+
+/**
+ * @brief Ends the current block with a two-way branch.
+ */
+static void buildBranch(Compiler *compiler, int condition, int then, int otherwise) {
+    int v = build(compiler, IR_BRANCH, TypeVoid, &condition, 1);
+    compiler->fn->insns[v].as.targets[0] = then;
+    compiler->fn->insns[v].as.targets[1] = otherwise;
+    irAddPred(compiler->fn, then, compiler->block);
+    irAddPred(compiler->fn, otherwise, compiler->block);
+}
+
+/**
+ * @brief Continues in a fresh block that nothing jumps to.
+ *
+ * Code after `return` or `break` is still checked and built, so it lands in
+ * a block that the optimizer and the code generators discard.
+ */
+static void startUnreachable(Compiler *compiler) {
+    compiler->block = newBlock(compiler);
+    compiler->sealed[compiler->block] = 1;
+}
+
+static int readVariable(Compiler *compiler, int var, int block);
+
+/**
+ * @brief Fills in a phi with the value of its variable in each predecessor.
+ */
+static void addPhiOperands(Compiler *compiler, int var, int phi) {
+    int block = compiler->fn->insns[phi].block;
+    int count = compiler->fn->blocks[block].predCount;
+    int *args = malloc((size_t)(count == 0 ? 1 : count) * sizeof(int));
+
+    if (args == NULL) outOfMemory("compiling");
+    for (int i = 0; i < count; i++) {
+        args[i] = readVariable(compiler, var, compiler->fn->blocks[block].preds[i]);
+    }
+    irSetArgs(compiler->fn, phi, args, count);
+    free(args);
+}
+
+/**
+ * @brief Creates an empty phi after the existing phis of a block.
+ */
+static int newPhi(Compiler *compiler, int block, TypeKind type) {
+    const IrBlock *b = &compiler->fn->blocks[block];
+    int position = 0;
+    while (position < b->insnCount && compiler->fn->insns[b->insns[position]].op == IR_PHI) position++;
+    return irInsert(compiler->fn, block, position, IR_PHI, type, NULL, 0);
+}
+
+/**
+ * @brief Returns the value of a variable at the end of a block.
+ *
+ * @param compiler Pointer to the compiler.
+ * @param var The variable.
+ * @param block The block.
+ * @return int The value index.
+ */
+static int readVariable(Compiler *compiler, int var, int block) {
+    const IrBlock *b;
+    TypeKind type = compiler->varTypes[var];
+    int value = lookupVariable(compiler, var, block);
+
+    if (value != IR_NONE) return value;
+
+    b = &compiler->fn->blocks[block];
+    if (!compiler->sealed[block]) {
+        value = newPhi(compiler, block, type);
+        compiler->pending = growArray(compiler->pending, &compiler->pendingCapacity, compiler->pendingCount + 1, sizeof(PendingPhi));
+        compiler->pending[compiler->pendingCount].block = block;
+        compiler->pending[compiler->pendingCount].var = var;
+        compiler->pending[compiler->pendingCount].phi = value;
+        compiler->pendingCount++;
+    } else if (b->predCount == 0) {
+        /* Only reachable from unreachable code; any value will do. */
+        int position = 0;
+        const IrBlock *entry = &compiler->fn->blocks[0];
+        while (position < entry->insnCount && compiler->fn->insns[entry->insns[position]].op == IR_PARAM) position++;
+        value = buildConstant(compiler, 0, position, type, 0, 0.0, 0);
+    } else if (b->predCount == 1) {
+        value = readVariable(compiler, var, b->preds[0]);
+    } else {
+        value = newPhi(compiler, block, type);
+        writeVariable(compiler, var, block, value);
+        addPhiOperands(compiler, var, value);
+    }
+
+    writeVariable(compiler, var, block, value);
+    return value;
+}
+
+/**
+ * @brief Marks a block as having all its predecessors and completes its phis.
+ */
+static void sealBlock(Compiler *compiler, int block) {
+    int kept = 0;
+
+    for (int i = 0; i < compiler->pendingCount; i++) {
+        PendingPhi pending = compiler->pending[i];
+        if (pending.block == block) {
+            addPhiOperands(compiler, pending.var, pending.phi);
+        } else {
+            compiler->pending[kept++] = pending;
+        }
+    }
+    compiler->pendingCount = kept;
+    compiler->sealed[block] = 1;
+}
+
+/**
+ * @brief Maps an arithmetic or bitwise operator to its IR opcode.
+ */
+static IrOp arithmeticOp(TokenKind op) {
+    switch (op) {
+        case TPlus: case TPlusAssign: case TIncrement: return IR_ADD;
+        case TMinus: case TMinusAssign: case TDecrement: return IR_SUB;
+        case TStar: case TStarAssign: return IR_MUL;
+        case TSlash: case TSlashAssign: return IR_DIV;
+        case TPercent: return IR_MOD;
+        case TAmpersand: return IR_AND;
+        case TPipe: return IR_OR;
+        case TCarot: return IR_XOR;
+        case TLeftShift: return IR_SHL;
+        default: return IR_SHR;
+    }
+}
+
+/**
+ * @brief Builds `&&` or `||`, evaluating the right operand only when needed.
+ */
+static int buildLogical(Compiler *compiler, const Expr *expr) {
+    int result = newVariable(compiler, TypeBool);
+    int left = buildExpr(compiler, expr->as.binary.left);
+    int right = newBlock(compiler);
+    int merge = newBlock(compiler);
+
+    writeVariable(compiler, result, compiler->block, left);
+    if (expr->as.binary.op == TLogicalAnd) {
+        buildBranch(compiler, left, right, merge);
+    } else {
+        buildBranch(compiler, left, merge, right);
+    }
+
+    sealBlock(compiler, right);
+    compiler->block = right;
+    writeVariable(compiler, result, compiler->block, buildExpr(compiler, expr->as.binary.right));
+    buildJump(compiler, merge);
+
+    sealBlock(compiler, merge);
+    compiler->block = merge;
+    return readVariable(compiler, result, merge);
+}
+
+/**
+ * @brief Builds a checked expression and returns the value it computes.
+ *
+ * @param compiler Pointer to the compiler.
+ * @param expr The checked expression.
+ * @return int The value index of the result; a void call yields its CALL.
+ */
+static int buildExpr(Compiler *compiler, const Expr *expr) {
+    switch (expr->kind) {
+        case ExprIntLiteral:
+        case ExprCharLiteral:
+            return buildConstant(compiler, compiler->block, -1, expr->type, expr->as.intValue, 0.0, 0);
+
+        case ExprFloatLiteral:
+            return buildConstant(compiler, compiler->block, -1, expr->type, 0, expr->as.floatValue, 1);
+
+        case ExprBoolLiteral:
+            return buildConstant(compiler, compiler->block, -1, TypeBool, (uint64_t)expr->as.boolValue, 0.0, 0);
+
+        case ExprStringLiteral: {
+            int v = buildZero(compiler, TypeString);
+            const char *chars = arenaCopy(&compiler->module->strings, expr->as.string.chars, expr->as.string.length + 1);
+            if (chars == NULL) outOfMemory("compiling");
+            compiler->fn->insns[v].as.constant.str = chars;
+            return v;
+        }
+
+        case ExprName: {
+            int local = resolveLocal(compiler, expr->as.symbol);
+            if (local < 0) return buildZero(compiler, expr->type);
+            return readVariable(compiler, local, compiler->block);
+        }
+
+        case ExprUnary: {
+            int operand = buildExpr(compiler, expr->as.unary.operand);
+            IrOp op = expr->as.unary.op == TNot ? IR_NOT : expr->as.unary.op == TMinus ? IR_NEG : IR_BNOT;
+            return build(compiler, op, expr->type, &operand, 1);
+        }
+
+        case ExprBinary: {
+            TokenKind op = expr->as.binary.op;
+            TypeKind operand = expr->as.binary.left->type;
+            int args[2];
+
+            if (op == TLogicalAnd || op == TLogicalOr) return buildLogical(compiler, expr);
+
+            args[0] = buildExpr(compiler, expr->as.binary.left);
+            args[1] = buildExpr(compiler, expr->as.binary.right);
+            switch (op) {
+                case TEqual: return buildTyped(compiler, IR_EQ, TypeBool, operand, args, 2);
+                case TNotEqual: return buildTyped(compiler, IR_NE, TypeBool, operand, args, 2);
+                case TLess: return buildTyped(compiler, IR_LT, TypeBool, operand, args, 2);
+                case TLessEqual: return buildTyped(compiler, IR_LE, TypeBool, operand, args, 2);
+                case TGreater: case TGreaterEqual: {
+                    int swapped[2];
+                    swapped[0] = args[1];
+                    swapped[1] = args[0];
+                    return buildTyped(compiler, op == TGreater ? IR_LT : IR_LE, TypeBool, operand, swapped, 2);
+                }
+                case TLeftShift: case TRightShift:
+                    if (expr->as.binary.right->type != operand) {
+                        args[1] = buildTyped(compiler, IR_CONV, operand, expr->as.binary.right->type, &args[1], 1);
+                    }
+                    return build(compiler, arithmeticOp(op), expr->type, args, 2);
+                default:
+                    return build(compiler, arithmeticOp(op), expr->type, args, 2);
+            }
+        }
+
+        case ExprAssign: {
+            int local = resolveLocal(compiler, expr->as.assign.target->as.symbol);
+            int value = buildExpr(compiler, expr->as.assign.value);
+
+            if (local < 0) return value;
+            if (expr->as.assign.op != TAssign) {
+                int args[2];
+                args[0] = readVariable(compiler, local, compiler->block);
+                args[1] = value;
+                value = build(compiler, arithmeticOp(expr->as.assign.op), expr->type, args, 2);
+            }
+            writeVariable(compiler, local, compiler->block, value);
+            return value;
+        }
+
+        case ExprIncDec: {
+            int local = resolveLocal(compiler, expr->as.incDec.target->as.symbol);
+            int args[2], value;
+
+            if (local < 0) return buildZero(compiler, expr->type);
+            args[0] = readVariable(compiler, local, compiler->block);
+            args[1] = buildConstant(compiler, compiler->block, -1, expr->type, 1, 1.0, isFloatType(expr->type));
+            value = build(compiler, arithmeticOp(expr->as.incDec.op), expr->type, args, 2);
+            writeVariable(compiler, local, compiler->block, value);
+            return expr->as.incDec.prefix ? value : args[0];
+        }
+
+        case ExprTernary: {
+            int result = newVariable(compiler, expr->type);
+            int condition = buildExpr(compiler, expr->as.ternary.condition);
+            int then = newBlock(compiler), otherwise = newBlock(compiler), merge = newBlock(compiler);
+
+            buildBranch(compiler, condition, then, otherwise);
+            sealBlock(compiler, then);
+            sealBlock(compiler, otherwise);
+
+            compiler->block = then;
+            writeVariable(compiler, result, compiler->block, buildExpr(compiler, expr->as.ternary.then));
+            buildJump(compiler, merge);
+
+            compiler->block = otherwise;
+            writeVariable(compiler, result, compiler->block, buildExpr(compiler, expr->as.ternary.otherwise));
+            buildJump(compiler, merge);
+
+            sealBlock(compiler, merge);
+            compiler->block = merge;
+            return readVariable(compiler, result, merge);
+        }
+
+        case ExprCall: {
+            int index = 0, count = expr->as.call.argCount, v;
+            int *args = malloc((size_t)(count == 0 ? 1 : count) * sizeof(int));
+
+            if (args == NULL) outOfMemory("compiling");
+            for (int i = 0; i < count; i++) args[i] = buildExpr(compiler, expr->as.call.args[i]);
+            if (resolveFunction(compiler, expr->as.call.callee, &index) == NULL) {
+                free(args);
+                return buildZero(compiler, expr->type);
+            }
+            v = build(compiler, IR_CALL, expr->type == TypeInvalid ? TypeVoid : expr->type, args, count);
+            compiler->fn->insns[v].as.index = index;
+            free(args);
+            return v;
+        }
+
+        case ExprCast: {
+            int operand = buildExpr(compiler, expr->as.cast.operand);
+            TypeKind from = expr->as.cast.operand->type;
+            if (from == expr->type) return operand;
+            return buildTyped(compiler, IR_CONV, expr->type, from, &operand, 1);
+        }
+    }
+    return buildZero(compiler, TypeI32);
+}
+
+/**
+ * @brief Compiles the statements of a block in a new scope.
+ */
+static void compileBlock(Compiler *compiler, const Stmt *block) {
+    beginScope(compiler);
+    for (int i = 0; i < block->as.block.count; i++) {
+        compileStatement(compiler, block->as.block.items[i]);
+    }
+    endScope(compiler);
+}
+
+/**
+ * @brief Enters a loop whose `break` statements jump to `exit`.
+ */
+static void beginLoop(Compiler *compiler, int exit) {
+    compiler->loopExits = growArray(compiler->loopExits, &compiler->loopCapacity, compiler->loopDepth + 1, sizeof(int));
+    compiler->loopExits[compiler->loopDepth++] = exit;
+}
+
+/**
+ * @brief Checks a condition and builds it in the current block.
+ */
+static int buildCondition(Compiler *compiler, Expr *condition) {
+    checkTreeAs(compiler, condition, TypeBool);
+    return buildExpr(compiler, condition);
+}
+
+/**
+ * @brief Builds a rotated loop: guard, body, step, latch condition, and exit.
+ *
+ * The condition is tested once before the loop and again at the bottom of
+ * the body, so each iteration ends in a single conditional branch back to
+ * the body instead of a jump to a separate test. It is type-checked once
+ * and built twice. The body is sealed only after the back edge from the
+ * latch has been added, and the exit only after every `break` is known.
+ */
+static void buildLoop(Compiler *compiler, Expr *condition, const Stmt *body, Expr *step) {
+    int bodyBlock = newBlock(compiler);
+    int exit = newBlock(compiler);
+
+    if (condition != NULL) {
+        buildBranch(compiler, buildCondition(compiler, condition), bodyBlock, exit);
+    } else {
+        buildJump(compiler, bodyBlock);
+    }
+
+    compiler->block = bodyBlock;
+    beginLoop(compiler, exit);
+    compileStatement(compiler, body);
+    if (step != NULL) {
+        checkTree(compiler, step, TypeInvalid);
+        buildExpr(compiler, step);
+    }
+    if (condition != NULL) {
+        buildBranch(compiler, buildExpr(compiler, condition), bodyBlock, exit);
+    } else {
+        buildJump(compiler, bodyBlock);
+    }
+    compiler->loopDepth--;
+
+    sealBlock(compiler, bodyBlock);
+    sealBlock(compiler, exit);
+    compiler->block = exit;
+}
+
+/**
+ * @brief Compiles a single statement.
+ */
+static void compileStatement(Compiler *compiler, const Stmt *stmt) {
+    switch (stmt->kind) {
+        case StmtVar: {
+            int value, var;
+            if (stmt->as.var.init != NULL) {
+                checkTreeAs(compiler, stmt->as.var.init, stmt->as.var.type);
+                value = buildExpr(compiler, stmt->as.var.init);
+            } else {
+                value = buildZero(compiler, stmt->as.var.type);
+            }
+            var = declareLocal(compiler, stmt->as.var.name, stmt->as.var.type, &stmt->token);
+            writeVariable(compiler, var, compiler->block, value);
+            break;
+        }
+
+        case StmtExpr:
+            checkTree(compiler, stmt->as.expr, TypeInvalid);
+            buildExpr(compiler, stmt->as.expr);
+            break;
+
+        case StmtPrint: {
+            TypeKind type = checkTree(compiler, stmt->as.expr, TypeInvalid);
+            int value = buildExpr(compiler, stmt->as.expr);
+            if (type == TypeVoid) semanticError(compiler, &stmt->token, "Cannot print a void value with");
+            buildTyped(compiler, IR_PRINT, TypeVoid, type, &value, 1);
+            break;
+        }
+
+        case StmtBlock:
+            compileBlock(compiler, stmt);
+            break;
+
+        case StmtIf: {
+            int condition = buildCondition(compiler, stmt->as.ifStmt.condition);
+            int then = newBlock(compiler);
+            int otherwise = stmt->as.ifStmt.otherwise != NULL ? newBlock(compiler) : IR_NONE;
+            int merge = newBlock(compiler);
+
+            buildBranch(compiler, condition, then, otherwise != IR_NONE ? otherwise : merge);
+            sealBlock(compiler, then);
+            compiler->block = then;
+            compileStatement(compiler, stmt->as.ifStmt.then);
+            buildJump(compiler, merge);
+
+            if (otherwise != IR_NONE) {
+                sealBlock(compiler, otherwise);
+                compiler->block = otherwise;
+                compileStatement(compiler, stmt->as.ifStmt.otherwise);
+                buildJump(compiler, merge);
+            }
+            sealBlock(compiler, merge);
+            compiler->block = merge;
+            break;
+        }
+
+        case StmtWhile:
+            buildLoop(compiler, stmt->as.whileStmt.condition, stmt->as.whileStmt.body, NULL);
+            break;
+
+        case StmtFor:
+            beginScope(compiler);
+            if (stmt->as.forStmt.init != NULL) compileStatement(compiler, stmt->as.forStmt.init);
+            buildLoop(compiler, stmt->as.forStmt.condition, stmt->as.forStmt.body, stmt->as.forStmt.step);
+            endScope(compiler);
+            break;
+
+        case StmtReturn:
+            if (stmt->as.expr == NULL) {
+                if (compiler->decl->returnType != TypeVoid) semanticError(compiler, &stmt->token, "Missing return value in non-void function at");
+                build(compiler, IR_RET, TypeVoid, NULL, 0);
+            } else if (compiler->decl->returnType == TypeVoid) {
+                semanticError(compiler, &stmt->token, "Void function cannot return a value at");
+            } else {
+                int value;
+                checkTreeAs(compiler, stmt->as.expr, compiler->decl->returnType);
+                value = buildExpr(compiler, stmt->as.expr);
+                build(compiler, IR_RET, TypeVoid, &value, 1);
+            }
+            startUnreachable(compiler);
+            break;
+
+        case StmtBreak:
+            if (compiler->loopDepth == 0) {
+                semanticError(compiler, &stmt->token, "Break outside of a loop at");
+                break;
+            }
+            buildJump(compiler, compiler->loopExits[compiler->loopDepth - 1]);
+            startUnreachable(compiler);
+            break;
+    }
+}
+
+/**
+ * @brief Reports whether control can reach the current block from the entry block.
+ *
+ * A branch on a constant follows only the edge it takes, so the end of a
+ * `while (true)` loop that is only left by `return` cannot be reached.
+ */
+static int reachesCurrentBlock(const Compiler *compiler) {
+    const IrFunction *fn = compiler->fn;
+    unsigned char *seen = calloc((size_t)fn->blockCount, 1);
+    int *stack = malloc((size_t)fn->blockCount * sizeof(int));
+    int depth = 0, reached = 0;
+
+    if (seen == NULL || stack == NULL) {
+        free(seen);
+        free(stack);
+        outOfMemory("compiling");
+    }
+    stack[depth++] = 0;
+    seen[0] = 1;
+    while (depth > 0 && !reached) {
+        int block = stack[--depth];
+        int term = irTerminator(fn, block);
+        int succ[2];
+        int n = irSuccessors(fn, block, succ);
+
+        reached = block == compiler->block;
+        if (n == 2 && fn->insns[fn->operands[fn->insns[term].argStart]].op == IR_CONST) {
+            if (!fn->insns[fn->operands[fn->insns[term].argStart]].as.constant.u32) succ[0] = succ[1];
+            n = 1;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!seen[succ[i]]) {
+                seen[succ[i]] = 1;
+                stack[depth++] = succ[i];
+            }
+        }
+    }
+    free(seen);
+    free(stack);
+    return reached;
+}
+
+/**
+ * @brief Compiles one function declaration into its IR function.
+ *
+ * A void function returns when control reaches its end; any other function
+ * whose end can be reached is missing a return and is reported.
+ */
+static void compileFunction(Compiler *compiler, const FnDecl *decl, IrFunction *fn) {
+    compiler->decl = decl;
+    compiler->fn = fn;
+    compiler->loopDepth = 0;
+    compiler->varCount = 0;
+    compiler->pendingCount = 0;
+    compiler->defCount = 0;
+    if (compiler->defKeys != NULL) memset(compiler->defKeys, 0, compiler->defCapacity * sizeof(uint64_t));
+
+    fn->paramCount = decl->paramCount;
+    fn->paramTypes = arenaAlloc(&compiler->module->strings, (size_t)(decl->paramCount + 1) * sizeof(TypeKind));
+    if (fn->paramTypes == NULL) outOfMemory("compiling");
+    fn->returnType = decl->returnType;
+    fn->exported = decl->exported;
+
+    compiler->block = newBlock(compiler);
+    compiler->sealed[compiler->block] = 1;
+    beginScope(compiler);
+    for (int i = 0; i < decl->paramCount; i++) {
+        int var = declareLocal(compiler, decl->params[i].name, decl->params[i].type, &decl->params[i].token);
+        int value = build(compiler, IR_PARAM, decl->params[i].type, NULL, 0);
+        fn->insns[value].as.index = i;
+        fn->paramTypes[i] = decl->params[i].type;
+        writeVariable(compiler, var, compiler->block, value);
+    }
+
+    compileBlock(compiler, decl->body);
+    endScope(compiler);
+
+    if (decl->returnType == TypeVoid) {
+        build(compiler, IR_RET, TypeVoid, NULL, 0);
+    } else {
+        /* The end is only closed off so the block has a terminator. */
+        int zero = buildZero(compiler, decl->returnType);
+        if (reachesCurrentBlock(compiler)) semanticError(compiler, &decl->token, "Missing return at the end of non-void function");
+        build(compiler, IR_RET, TypeVoid, &zero, 1);
+    }
+}
+
+/**
+ * @brief Declares a function of an imported module, if it is not defined and an interface exports it.
+ */
+static void importFunction(Compiler *compiler, uint32_t name) {
+    const Program *program = compiler->program;
+    InterfaceFunction found;
+    const char *spelling;
+    FnDecl *decl;
+    IrFunction *fn;
+    int index, i;
+
+    if (name == SYMBOL_NONE || name > compiler->names->count || compiler->functionOf[name] != 0) return;
+    spelling = symbolName(compiler->names, name);
+    for (i = 0; i < program->interfaceCount; i++) {
+        if (findInterfaceFunction(&program->interfaces[i], spelling, strlen(spelling), &found) == 0) break;
+    }
+    if (i == program->interfaceCount) return;
+
+    index = addIrFunction(compiler->module, spelling);
+    compiler->imported = growArray(compiler->imported, &compiler->importedCapacity, compiler->importedCount + 1, sizeof(FnDecl));
+    decl = &compiler->imported[compiler->importedCount++];
+    memset(decl, 0, sizeof(*decl));
+    decl->params = calloc((size_t)found.paramCount + 1, sizeof(Param));
+    fn = index < 0 ? NULL : &compiler->module->functions[index];
+    if (fn != NULL) fn->paramTypes = arenaAlloc(&compiler->module->strings, (size_t)(found.paramCount + 1) * sizeof(TypeKind));
+    if (fn == NULL || fn->paramTypes == NULL || decl->params == NULL) outOfMemory("compiling");
+
+    for (int p = 0; p < found.paramCount; p++) {
+        decl->params[p].type = (TypeKind)found.paramTypes[p];
+        fn->paramTypes[p] = decl->params[p].type;
+    }
+    decl->name = name;
+    decl->paramCount = fn->paramCount = found.paramCount;
+    decl->returnType = fn->returnType = found.returnType;
+    decl->exported = fn->exported = 1;
+    fn->external = 1;
+    compiler->functionOf[name] = index + 1;
+}
+
+/**
+ * @brief Imports every function called by an expression that the program does not define.
+ */
+static void importCallsInExpr(Compiler *compiler, const Expr *expr) {
+    if (expr == NULL) return;
+    switch (expr->kind) {
+        case ExprUnary:
+            importCallsInExpr(compiler, expr->as.unary.operand);
+            break;
+        case ExprBinary:
+            importCallsInExpr(compiler, expr->as.binary.left);
+            importCallsInExpr(compiler, expr->as.binary.right);
+            break;
+        case ExprAssign:
+            importCallsInExpr(compiler, expr->as.assign.target);
+            importCallsInExpr(compiler, expr->as.assign.value);
+            break;
+        case ExprTernary:
+            importCallsInExpr(compiler, expr->as.ternary.condition);
+            importCallsInExpr(compiler, expr->as.ternary.then);
+            importCallsInExpr(compiler, expr->as.ternary.otherwise);
+            break;
+        case ExprCall:
+            importFunction(compiler, expr->as.call.callee);
+            for (int i = 0; i < expr->as.call.argCount; i++) importCallsInExpr(compiler, expr->as.call.args[i]);
+            break;
+        case ExprCast:
+            importCallsInExpr(compiler, expr->as.cast.operand);
+            break;
+        case ExprIncDec:
+            importCallsInExpr(compiler, expr->as.incDec.target);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Imports every function called by a statement that the program does not define.
+ */
+static void importCallsInStmt(Compiler *compiler, const Stmt *stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->kind) {
+        case StmtVar:
+            importCallsInExpr(compiler, stmt->as.var.init);
+            break;
+        case StmtExpr: case StmtReturn: case StmtPrint:
+            importCallsInExpr(compiler, stmt->as.expr);
+            break;
+        case StmtBlock:
+            for (int i = 0; i < stmt->as.block.count; i++) importCallsInStmt(compiler, stmt->as.block.items[i]);
+            break;
+        case StmtIf:
+            importCallsInExpr(compiler, stmt->as.ifStmt.condition);
+            importCallsInStmt(compiler, stmt->as.ifStmt.then);
+            importCallsInStmt(compiler, stmt->as.ifStmt.otherwise);
+            break;
+        case StmtWhile:
+            importCallsInExpr(compiler, stmt->as.whileStmt.condition);
+            importCallsInStmt(compiler, stmt->as.whileStmt.body);
+            break;
+        case StmtFor:
+            importCallsInStmt(compiler, stmt->as.forStmt.init);
+            importCallsInExpr(compiler, stmt->as.forStmt.condition);
+            importCallsInExpr(compiler, stmt->as.forStmt.step);
+            importCallsInStmt(compiler, stmt->as.forStmt.body);
+            break;
+        case StmtBreak:
+            break;
+    }
+}
+
+/**
+ * @brief Releases the working memory of a compiler and the compiler itself.
+ */
+static void freeCompiler(Compiler *compiler) {
+    for (int i = 0; i < compiler->importedCount; i++) free(compiler->imported[i].params);
+    free(compiler->imported);
+    free(compiler->functionOf);
+    free(compiler->varTypes);
+    free(compiler->defKeys);
+    free(compiler->defValues);
+    free(compiler->sealed);
+    free(compiler->pending);
+    free(compiler->loopExits);
+    freeScopeStack(&compiler->scopes);
+    free(compiler);
+}
+
+/**
+ * @brief Compiles the functions of a program for compileProgram(), which guards it against running out of memory.
+ */
+static int compileFunctions(Compiler *compiler, const Program *program, IrModule *module) {
+    const InternTable *names = compiler->names;
+
+    compiler->functionOf = calloc(names->count + 1, sizeof(int));
+    if (compiler->functionOf == NULL) return -1;
+
+    for (int i = 0; i < program->fnCount; i++) {
+        const FnDecl *fn = &program->fns[i];
+        const char *name = symbolName(names, fn->name);
+        if (addIrFunction(module, name != NULL ? name : "<invalid>") < 0) return -1;
+        if (fn->name != SYMBOL_NONE) {
+            if (compiler->functionOf[fn->name] != 0) semanticError(compiler, &fn->token, "Function is already defined");
+            compiler->functionOf[fn->name] = i + 1;
+        }
+    }
+
+    /* Imports are declared up front: adding functions moves the module's function array. */
+    for (int i = 0; i < program->fnCount && program->interfaceCount > 0; i++) {
+        importCallsInStmt(compiler, program->fns[i].body);
+    }
+    for (int i = 0; i < program->fnCount; i++) {
+        compileFunction(compiler, &program->fns[i], &module->functions[i]);
+    }
+    return compiler->hadError ? 1 : 0;
+}
+
+/**
+ * @brief Type-checks every function of a program and builds its SSA form.
+ *
+ * @param program Pointer to the parsed program.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param module Pointer to an initialized IR module that receives the functions.
+ * @param diagnostics Pointer to the sink that receives semantic errors, or NULL for stderr.
+ * @return int Returns 0 on success, 1 if any error was reported, or -1 if memory ran out.
+ */
+int compileProgram(const Program *program, const InternTable *names, IrModule *module,
+                   const DiagnosticSink *diagnostics) {
+    Compiler *compiler = calloc(1, sizeof(Compiler));
+    MemoryGuard guard;
+    int status;
+
+    if (compiler == NULL) return -1;
+    compiler->diagnostics = diagnostics;
+    compiler->program = program;
+    compiler->names = names;
+    compiler->module = module;
+    initScopeStack(&compiler->scopes);
+    if (setjmp(guard.jump) != 0) {
+        freeCompiler(compiler);
+        return -1;
+    }
+    pushMemoryGuard(&guard);
+    status = compileFunctions(compiler, program, module);
+    popMemoryGuard(&guard);
+    freeCompiler(compiler);
+    return status;
+}
+
+/**
+ * @brief Finds a function of a parsed program by name.
+ *
+ * @param program Pointer to the parsed program.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param name The function name to look up.
+ * @return int The function's index, or -1 if it is not defined.
+ */
+int findFunction(const Program *program, const InternTable *names, const char *name) {
+    uint32_t symbol = findSymbol(names, name, strlen(name));
+    if (symbol == SYMBOL_NONE) return -1;
+    for (int i = 0; i < program->fnCount; i++) {
+        if (program->fns[i].name == symbol) return i;
+    }
+    return -1;
+}
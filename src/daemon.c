@@ -0,0 +1,624 @@
+/**
+ * @file daemon.c
+ * @brief Implements the persistent compiler daemon and its thin client.
+ *
+ * This file serves compilation requests over a Unix domain socket. A client
+ * sends its working directory and argument vector, and passes its standard
+ * output and error descriptors alongside them, so the daemon can run the
+ * driver as if it had been started in the client's terminal. Each connection
+ * is served by a forked process that inherits the daemon's token cache, and
+ * the daemon lexes the files its requests compiled once they report them, so
+ * the cache survives between requests. That removes process startup, file
+ * reading, and lexing from the cost of recompiling unchanged files.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _XOPEN_SOURCE 700
+#define _GNU_SOURCE
+#endif
+
+#include "include/daemon.h"
+#include "include/driver.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <limits.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Computes the socket path used by the daemon and its clients.
+ *
+ * @param output Pointer to the buffer where the path will be stored.
+ * @param size Size of the output buffer.
+ */
+void daemonSocketPath(char *output, size_t size) {
+    const char *override = getenv(DAEMON_SOCKET_ENV);
+    const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+
+    if (override != NULL && *override != '\0') {
+        snprintf(output, size, "%s", override);
+    } else if (runtimeDir != NULL && *runtimeDir != '\0') {
+        snprintf(output, size, "%s/obsidian.sock", runtimeDir);
+    } else {
+#ifdef _WIN32
+        snprintf(output, size, "%s", "obsidian.sock");
+#else
+        snprintf(output, size, "/tmp/obsidian-%lu/obsidian.sock", (unsigned long)getuid());
+#endif
+    }
+}
+
+#ifdef _WIN32
+
+int runDaemon(const char *socketPath) {
+    (void)socketPath;
+    fputs("obsidian: error: daemon mode is not supported on this platform\n", stderr);
+    return EXIT_FAILURE;
+}
+
+int runClient(const char *socketPath, int argc, char *argv[], int *status) {
+    (void)socketPath; (void)argc; (void)argv; (void)status;
+    return -1;
+}
+
+#else
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * @struct InputReports
+ * @brief Input paths reported by request processes, not yet read by the daemon.
+ *
+ * Every report is a canonical path followed by a NUL byte and is shorter
+ * than PIPE_BUF, so it reaches the pipe in one piece. The buffer holds two
+ * reports' worth, which leaves room for a whole report after any remainder.
+ */
+typedef struct {
+    char buffer[2 * PIPE_BUF];
+    size_t length;
+} InputReports;
+
+/**
+ * @brief Signal handler that asks the accept loop to stop.
+ *
+ * @param signal The signal number (unused).
+ */
+static void handleStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+/**
+ * @brief Reads exactly `length` bytes from a socket.
+ *
+ * @param fd The socket descriptor.
+ * @param buffer Destination buffer.
+ * @param length Number of bytes to read.
+ * @return int Returns 0 on success, or -1 on error or early end of stream.
+ */
+static int readAll(int fd, void *buffer, size_t length) {
+    char *cursor = buffer;
+    while (length > 0) {
+        ssize_t n = read(fd, cursor, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        cursor += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes exactly `length` bytes to a socket.
+ *
+ * @param fd The socket descriptor.
+ * @param buffer Source buffer.
+ * @param length Number of bytes to write.
+ * @return int Returns 0 on success, or -1 on error.
+ */
+static int writeAll(int fd, const void *buffer, size_t length) {
+    const char *cursor = buffer;
+    while (length > 0) {
+        ssize_t n = write(fd, cursor, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        cursor += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fills a Unix socket address, rejecting paths that do not fit.
+ *
+ * @param address Pointer to the address to fill.
+ * @param socketPath Path of the socket.
+ * @return int Returns 0 on success, or -1 if the path is too long.
+ */
+static int makeAddress(struct sockaddr_un *address, const char *socketPath) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address->sun_path)) return -1;
+    strcpy(address->sun_path, socketPath);
+    return 0;
+}
+
+/**
+ * @brief Computes the directory that holds the socket.
+ *
+ * @param socketPath Path of the socket.
+ * @param output Pointer to the buffer where the directory will be stored.
+ * @param size Size of the output buffer.
+ * @return int Returns 0 on success, or -1 if the directory does not fit.
+ */
+static int socketDirectory(const char *socketPath, char *output, size_t size) {
+    const char *slash = strrchr(socketPath, '/');
+    int length;
+
+    if (slash == NULL) {
+        length = snprintf(output, size, ".");
+    } else if (slash == socketPath) {
+        length = snprintf(output, size, "/");
+    } else {
+        length = snprintf(output, size, "%.*s", (int)(slash - socketPath), socketPath);
+    }
+    return length < 0 || (size_t)length >= size ? -1 : 0;
+}
+
+/**
+ * @brief Checks that a path is owned by the current user and writable by no one else.
+ *
+ * A final symbolic link is not followed, so a link planted in place of the
+ * directory or the socket is rejected rather than trusted.
+ *
+ * @param path The path to check.
+ * @param type The expected file type, S_IFDIR or S_IFSOCK.
+ * @return int Returns 0 if the path is private, 1 if it does not exist, or -1 otherwise.
+ */
+static int checkPrivate(const char *path, mode_t type) {
+    struct stat info;
+
+    if (lstat(path, &info) != 0) return errno == ENOENT ? 1 : -1;
+    if ((info.st_mode & S_IFMT) != type || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) return -1;
+    return 0;
+}
+
+/**
+ * @brief Checks that the process at the other end of a connection runs as the current user.
+ *
+ * @param connection The connected socket.
+ * @return int Returns 1 if the peer has the same effective user ID, or 0 otherwise.
+ */
+static int peerIsCurrentUser(int connection) {
+#ifdef SO_PEERCRED
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+
+    if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) return 0;
+    return credentials.uid == geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+
+    if (getpeereid(connection, &uid, &gid) != 0) return 0;
+    return uid == geteuid();
+#endif
+}
+
+/**
+ * @brief Tells the daemon which file a request compiled.
+ *
+ * The input is found the way the driver finds it: the first argument that
+ * is neither an option nor the file name after `-o`.
+ *
+ * @param reportFd The write end of the daemon's report pipe.
+ * @param argc The number of arguments of the request.
+ * @param argv The arguments of the request.
+ */
+static void reportInput(int reportFd, int argc, char *argv[]) {
+    char canonical[PATH_MAX];
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0) {
+            i++;
+        } else if (argv[i][0] != '-') {
+            if (realpath(argv[i], canonical) != NULL && strlen(canonical) < PIPE_BUF) {
+                writeAll(reportFd, canonical, strlen(canonical) + 1);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Lexes the files reported by finished requests into the daemon's cache.
+ *
+ * Request processes are forked from the daemon, so they start with every
+ * token stream the daemon holds but cannot add to it. Loading the files they
+ * compiled here lets later requests find them already lexed. Lexical errors
+ * are not printed; entries with errors are lexed again by the next request
+ * that loads them, which reports them to its own client.
+ *
+ * @param reportFd The read end of the report pipe.
+ * @param reports Pointer to the partial reports carried between reads.
+ * @param cache Pointer to the daemon's token cache.
+ */
+static void loadReportedInputs(int reportFd, InputReports *reports, TokenCache *cache) {
+    ssize_t n = read(reportFd, reports->buffer + reports->length, sizeof(reports->buffer) - reports->length);
+    size_t start = 0;
+
+    if (n <= 0) return;
+    reports->length += (size_t)n;
+    for (size_t i = 0; i < reports->length; i++) {
+        if (reports->buffer[i] == '\0') {
+            loadTokens(cache, reports->buffer + start);
+            start = i + 1;
+        }
+    }
+    memmove(reports->buffer, reports->buffer + start, reports->length - start);
+    reports->length -= start;
+}
+
+/**
+ * @brief Serves a single request on an accepted connection.
+ *
+ * This runs in a process forked for the connection, so the client's
+ * directory and descriptors can simply replace the process's own.
+ *
+ * @param connection The accepted connection.
+ * @param cache Pointer to the token cache inherited from the daemon.
+ * @param reportFd The write end of the daemon's report pipe.
+ */
+static void serveRequest(int connection, TokenCache *cache, int reportFd) {
+    RequestHeader header;
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    struct iovec iov = { &header, sizeof(header) };
+    struct msghdr message;
+    struct cmsghdr *cmsg;
+    int clientFds[2] = { -1, -1 };
+    char *payload = NULL, **argv = NULL;
+    int argc = 0;
+    int32_t status = EXIT_FAILURE;
+    ssize_t received;
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    do {
+        received = recvmsg(connection, &message, 0);
+    } while (received < 0 && errno == EINTR);
+
+    for (cmsg = CMSG_FIRSTHDR(&message); cmsg != NULL; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int))) {
+            memcpy(clientFds, CMSG_DATA(cmsg), sizeof(clientFds));
+        }
+    }
+
+    if (received != (ssize_t)sizeof(header) || header.magic != DAEMON_MAGIC || header.length == 0 || header.length > DAEMON_MAX_REQUEST || clientFds[0] < 0) goto done;
+
+    payload = malloc(header.length + 1);
+    if (payload == NULL || readAll(connection, payload, header.length) != 0) goto done;
+    payload[header.length] = '\0';
+
+    for (uint32_t i = 0; i < header.length; i++) {
+        if (payload[i] == '\0') argc++;
+    }
+    argc--; ///< The first string is the working directory.
+    if (argc < 1) goto done;
+
+    argv = calloc((size_t)argc + 1, sizeof(char *));
+    if (argv == NULL) goto done;
+    {
+        char *cursor = payload + strlen(payload) + 1;
+        for (int i = 0; i < argc; i++) {
+            argv[i] = cursor;
+            cursor += strlen(cursor) + 1;
+        }
+    }
+
+    if (chdir(payload) != 0) goto done;
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(clientFds[0], STDOUT_FILENO);
+    dup2(clientFds[1], STDERR_FILENO);
+
+    status = runCompiler(argc, argv, cache);
+
+    fflush(stdout);
+    fflush(stderr);
+
+done:
+    writeAll(connection, &status, sizeof(status));
+    if (argv != NULL) reportInput(reportFd, argc, argv);
+    if (clientFds[0] >= 0) close(clientFds[0]);
+    if (clientFds[1] >= 0) close(clientFds[1]);
+    free(argv);
+    free(payload);
+}
+
+/**
+ * @brief Forks a process that serves one connection.
+ *
+ * The daemon only accepts connections and keeps the cache, so a client that
+ * is slow to send its request, or a long compilation, never holds up the
+ * next client.
+ *
+ * @param server The listening socket, closed in the child.
+ * @param connection The accepted connection.
+ * @param reportFds The report pipe; the child keeps only its write end.
+ * @param cache Pointer to the daemon's token cache.
+ */
+static void forkRequest(int server, int connection, const int reportFds[2], TokenCache *cache) {
+    pid_t child = fork();
+
+    if (child < 0) {
+        perror("fork");
+        return;
+    }
+    if (child == 0) {
+        close(server);
+        close(reportFds[0]);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        cache->diagnostics = NULL;
+        serveRequest(connection, cache, reportFds[1]);
+        _exit(EXIT_SUCCESS);
+    }
+}
+
+/**
+ * @brief Binds the listening socket, replacing a stale socket left by a daemon that is gone.
+ *
+ * The socket is created with mode 0600. A stale file is only removed if it
+ * is a socket owned by the current user.
+ *
+ * @param server The socket to bind.
+ * @param address Pointer to the socket's address.
+ * @param socketPath Path of the socket.
+ * @return int Returns 0 on success, or -1 after printing why the socket could not be bound.
+ */
+static int bindSocket(int server, const struct sockaddr_un *address, const char *socketPath) {
+    mode_t savedMask = umask(0177);
+    int status = bind(server, (const struct sockaddr *)address, sizeof(*address));
+
+    if (status != 0 && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int alive = probe >= 0 && connect(probe, (const struct sockaddr *)address, sizeof(*address)) == 0;
+        if (probe >= 0) close(probe);
+
+        if (alive) {
+            fprintf(stderr, "obsidian: error: a daemon is already listening on '%s'\n", socketPath);
+            umask(savedMask);
+            return -1;
+        }
+        if (checkPrivate(socketPath, S_IFSOCK) != 0) {
+            fprintf(stderr, "obsidian: error: refusing to replace '%s', which is not a socket owned by the current user\n", socketPath);
+            umask(savedMask);
+            return -1;
+        }
+        unlink(socketPath);
+        status = bind(server, (const struct sockaddr *)address, sizeof(*address));
+    }
+    umask(savedMask);
+
+    if (status != 0) {
+        perror("bind");
+        return -1;
+    }
+    chmod(socketPath, S_IRUSR | S_IWUSR);
+    return 0;
+}
+
+/**
+ * @brief Runs the compiler daemon until it is interrupted.
+ *
+ * @param socketPath Path of the Unix domain socket to listen on.
+ * @return int Returns EXIT_SUCCESS on a clean shutdown, or EXIT_FAILURE on error.
+ */
+int runDaemon(const char *socketPath) {
+    struct sockaddr_un address;
+    struct sigaction action;
+    struct pollfd events[2];
+    char directory[4096];
+    DiagnosticSink silent = { NULL, NULL };
+    InputReports reports;
+    TokenCache cache;
+    int server, reportFds[2];
+
+    if (makeAddress(&address, socketPath) != 0 || socketDirectory(socketPath, directory, sizeof(directory)) != 0) {
+        fprintf(stderr, "obsidian: error: socket path '%s' is too long\n", socketPath);
+        return EXIT_FAILURE;
+    }
+
+    mkdir(directory, S_IRWXU);
+    if (checkPrivate(directory, S_IFDIR) != 0) {
+        fprintf(stderr, "obsidian: error: socket directory '%s' must be owned by the current user and writable by no one else\n", directory);
+        return EXIT_FAILURE;
+    }
+
+    server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+
+    if (bindSocket(server, &address, socketPath) != 0) {
+        close(server);
+        return EXIT_FAILURE;
+    }
+
+    if (listen(server, 64) != 0) {
+        perror("listen");
+        close(server);
+        unlink(socketPath);
+        return EXIT_FAILURE;
+    }
+    if (pipe(reportFds) != 0) {
+        perror("pipe");
+        close(server);
+        unlink(socketPath);
+        return EXIT_FAILURE;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    initTokenCache(&cache);
+    cache.diagnostics = &silent;
+    reports.length = 0;
+    events[0].fd = server;
+    events[0].events = POLLIN;
+    events[1].fd = reportFds[0];
+    events[1].events = POLLIN;
+
+    while (!stopRequested) {
+        if (poll(events, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        while (waitpid(-1, NULL, WNOHANG) > 0) {}
+
+        if (events[1].revents & POLLIN) loadReportedInputs(reportFds[0], &reports, &cache);
+        if (events[0].revents & POLLIN) {
+            int connection = accept(server, NULL, NULL);
+            if (connection < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                perror("accept");
+                break;
+            }
+            if (peerIsCurrentUser(connection)) {
+                forkRequest(server, connection, reportFds, &cache);
+            } else {
+                fputs("obsidian: warning: refused a connection from another user\n", stderr);
+            }
+            close(connection);
+        }
+    }
+
+    freeTokenCache(&cache);
+    close(reportFds[0]);
+    close(reportFds[1]);
+    close(server);
+    unlink(socketPath);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Forwards a command line to a running daemon.
+ *
+ * @param socketPath Path of the daemon's Unix domain socket.
+ * @param argc The number of command-line arguments to forward.
+ * @param argv The command-line arguments to forward.
+ * @param status Pointer that receives the exit status of the remote compilation.
+ * @return int Returns 0 if the request was sent, or -1 if no daemon could be reached.
+ */
+int runClient(const char *socketPath, int argc, char *argv[], int *status) {
+    struct sockaddr_un address;
+    char cwd[4096], directory[4096];
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    RequestHeader header;
+    struct iovec iov = { &header, sizeof(header) };
+    struct msghdr message;
+    struct cmsghdr *cmsg;
+    size_t length, offset;
+    char *payload;
+    int32_t remoteStatus;
+    int connection, privacy;
+
+    if (makeAddress(&address, socketPath) != 0 || getcwd(cwd, sizeof(cwd)) == NULL || socketDirectory(socketPath, directory, sizeof(directory)) != 0) return -1;
+
+    privacy = checkPrivate(directory, S_IFDIR);
+    if (privacy == 0) privacy = checkPrivate(socketPath, S_IFSOCK);
+    if (privacy < 0) fprintf(stderr, "obsidian: warning: ignoring daemon socket '%s', which is not private to the current user\n", socketPath);
+    if (privacy != 0) return -1;
+
+    length = strlen(cwd) + 1;
+    for (int i = 0; i < argc; i++) length += strlen(argv[i]) + 1;
+    if (length > DAEMON_MAX_REQUEST) return -1;
+
+    payload = malloc(length);
+    if (payload == NULL) return -1;
+    offset = 0;
+    memcpy(payload, cwd, strlen(cwd) + 1);
+    offset += strlen(cwd) + 1;
+    for (int i = 0; i < argc; i++) {
+        memcpy(payload + offset, argv[i], strlen(argv[i]) + 1);
+        offset += strlen(argv[i]) + 1;
+    }
+
+    connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        if (connection >= 0) close(connection);
+        free(payload);
+        return -1;
+    }
+    if (!peerIsCurrentUser(connection)) {
+        fprintf(stderr, "obsidian: warning: ignoring daemon socket '%s', which is served by another user\n", socketPath);
+        close(connection);
+        free(payload);
+        return -1;
+    }
+
+    header.magic = DAEMON_MAGIC;
+    header.length = (uint32_t)length;
+
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    fflush(stdout);
+    fflush(stderr);
+
+    if (sendmsg(connection, &message, 0) != (ssize_t)sizeof(header)) {
+        close(connection);
+        free(payload);
+        return -1;
+    }
+
+    /* Once the request is out, the daemon may have written output or files, so compiling again here would repeat them. */
+    if (writeAll(connection, payload, length) != 0 || readAll(connection, &remoteStatus, sizeof(remoteStatus)) != 0) {
+        fprintf(stderr, "obsidian: error: the daemon on '%s' failed while serving the request\n", socketPath);
+        remoteStatus = EXIT_FAILURE;
+    }
+
+    close(connection);
+    free(payload);
+    *status = remoteStatus;
+    return 0;
+}
+
+#endif // _WIN32
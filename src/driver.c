@@ -0,0 +1,697 @@
+/**
+ * @file driver.c
+ * @brief Implements the compiler driver for the Obsidian programming language.
+ *
+ * This file interprets the command-line arguments of a single compilation and
+ * runs the compiler phases over the input file. All state that outlives one
+ * compilation lives in the token cache passed in by the caller.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "include/driver.h"
+#include "include/common.h"
+#include "include/compiler.h"
+#include "include/interface.h"
+#include "include/lower.h"
+#include "include/memstats.h"
+#include "include/object.h"
+#include "include/parser.h"
+#include "include/passes.h"
+#include "include/vm.h"
+#include "include/x86.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct BuildOptions
+ * @brief Code generation settings selected on the command line.
+ */
+typedef struct {
+    int run;            ///< Run the program's main function.
+    int emitIr;         ///< Print the optimized IR instead of running.
+    int timePasses;     ///< Report the time spent in each optimization pass.
+    int optLevel;       ///< Optimization level selected with -O.
+    int emitAsm;        ///< Stop after writing assembly (-S).
+    int compileOnly;    ///< Stop after writing an object file (-c).
+    int saveTemps;      ///< Keep the assembly of an object file or executable.
+    const char *output; ///< Output file selected with -o, or NULL.
+    int memReport;      ///< Print a table of memory use (--mem-report).
+    int statsJson;      ///< Write memory use as JSON (--stats=json).
+    const char *statsPath;      ///< File named with --stats=json=<file>, or NULL for stdout.
+    int syntaxOnly;     ///< Check the declarations without parsing bodies (-fsyntax-only).
+    int index;          ///< Print the declarations without parsing bodies (--index).
+    const char *checkBodies;    ///< Comma-separated functions whose bodies are parsed anyway (-fcheck-body=).
+} BuildOptions;
+
+/**
+ * @brief Opens the interface file of every module a program imports.
+ *
+ * The interface of module `name` is `name.obi` in the directory of the
+ * importing file.
+ *
+ * @param path The path of the importing file.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param program Pointer to the parsed program.
+ * @param interfaces Pointer that receives one opened interface per import, or NULL if there are none.
+ * @return int Returns 0 on success, or -1 if an interface could not be opened.
+ */
+static int openImports(const char *path, const InternTable *names, const Program *program, ModuleInterface **interfaces) {
+    const char *slash = strrchr(path, '/');
+    int directory = slash == NULL ? 0 : (int)(slash - path + 1);
+
+    *interfaces = NULL;
+    if (program->importCount == 0) return 0;
+    *interfaces = malloc((size_t)program->importCount * sizeof(ModuleInterface));
+    if (*interfaces == NULL) {
+        fputs("obsidian: error: out of memory\n", stderr);
+        return -1;
+    }
+
+    for (int i = 0; i < program->importCount; i++) {
+        const char *module = symbolName(names, program->imports[i]);
+        char file[1024];
+        int status;
+
+        snprintf(file, sizeof(file), "%.*s%s%s", directory, path, module, INTERFACE_EXTENSION);
+        status = openInterface(&(*interfaces)[i], file);
+        if (status != 0) {
+            if (status < 0) fprintf(stderr, "obsidian: error: cannot import '%s': no interface file '%s'; compile the module first\n", module, file);
+            else fprintf(stderr, "obsidian: error: cannot import '%s': '%s' is not an interface file of this compiler\n", module, file);
+            while (i-- > 0) closeInterface(&(*interfaces)[i]);
+            free(*interfaces);
+            *interfaces = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses a source file and builds its optimized IR.
+ *
+ * The syntax tree only lives until the IR has been generated. The interfaces
+ * of imported modules are open while the program is compiled. A stream with
+ * lexical errors is not parsed, since its errors have been reported already
+ * and the parser would only add errors caused by them.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @param options Pointer to the selected code generation settings.
+ * @param ir Pointer to an initialized module that receives the IR.
+ * @param mainIndex Pointer that receives the index of `main`, or -1 if there is none.
+ * @return int Returns 0 on success, or -1 on a compile error.
+ */
+static int buildIr(const CacheEntry *entry, const TokenCache *cache, const BuildOptions *options, IrModule *ir, int *mainIndex) {
+    Arena arena;
+    Parser parser;
+    Program program;
+    ModuleInterface *interfaces = NULL;
+    PassStats stats;
+    int status;
+
+    *mainIndex = -1;
+    if (entry->stream.hasErrors) return -1;
+    initArena(&arena);
+    initParser(&parser, &entry->stream, &arena);
+
+    status = parseProgram(&parser, &program);
+    if (status < 0) outOfMemory("parsing");
+    if (status == 0) status = openImports(entry->path, &cache->symbols, &program, &interfaces);
+    if (status == 0) {
+        program.interfaces = interfaces;
+        program.interfaceCount = interfaces != NULL ? program.importCount : 0;
+        status = compileProgram(&program, &cache->symbols, ir, NULL);
+        if (status < 0) outOfMemory("compiling");
+        for (int i = 0; i < program.interfaceCount; i++) closeInterface(&interfaces[i]);
+        free(interfaces);
+    }
+    *mainIndex = status == 0 ? findFunction(&program, &cache->symbols, "main") : -1;
+    if (status == 0 && *mainIndex >= 0 && program.fns[*mainIndex].paramCount != 0) {
+        fputs("obsidian: error: 'main' must not take any parameters\n", stderr);
+        status = -1;
+    }
+    freeArena(&arena);
+    if (status != 0) return -1;
+
+    memset(&stats, 0, sizeof(stats));
+    optimizeModule(ir, options->optLevel, options->timePasses ? &stats : NULL);
+    if (options->timePasses) printPassStats(stderr, &stats);
+    return 0;
+}
+
+/**
+ * @brief Compiles and runs the `main` function of a source file.
+ *
+ * The exit status of the program is the value returned by an `i32` main.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @param options Pointer to the selected code generation settings.
+ * @return int The program's exit status, or EXIT_FAILURE on a compile or runtime error.
+ */
+static int runProgram(const CacheEntry *entry, const TokenCache *cache, const BuildOptions *options) {
+    IrModule ir;
+    Module module;
+    VM vm;
+    Slot result;
+    int status, mainIndex;
+
+    initIrModule(&ir);
+    initModule(&module);
+
+    status = buildIr(entry, cache, options, &ir, &mainIndex);
+    if (status == 0 && options->emitIr) {
+        for (int i = 0; i < ir.functionCount; i++) irPrintFunction(stdout, &ir, &ir.functions[i]);
+        freeIrModule(&ir);
+        return EXIT_SUCCESS;
+    }
+    if (status == 0 && mainIndex < 0) {
+        fprintf(stderr, "obsidian: error: '%s' does not define a 'main' function\n", entry->path);
+        status = -1;
+    }
+    if (status == 0) status = lowerModule(&ir, &module);
+    freeIrModule(&ir);
+
+    if (status != 0) {
+        freeModule(&module);
+        return EXIT_FAILURE;
+    }
+
+    if (initVM(&vm) != 0) {
+        fputs("obsidian: error: out of memory\n", stderr);
+        freeModule(&module);
+        return EXIT_FAILURE;
+    }
+    result.u64 = 0;
+    status = vmCall(&vm, &module, mainIndex, NULL, &result);
+    fflush(stdout);
+    if (status != 0) {
+        status = EXIT_FAILURE;
+    } else {
+        status = module.functions[mainIndex].returnType == TypeI32 ? result.i32 : EXIT_SUCCESS;
+    }
+
+    freeVM(&vm);
+    freeModule(&module);
+    return status;
+}
+
+/**
+ * @brief Derives an output file name from the input's name and a new extension.
+ *
+ * @param input The path of the source file.
+ * @param extension The extension of the output, including its dot.
+ * @param path Buffer that receives the file name.
+ * @param size Size of the buffer.
+ */
+static void outputName(const char *input, const char *extension, char *path, size_t size) {
+    const char *base = strrchr(input, '/');
+    size_t length;
+
+    base = base == NULL ? input : base + 1;
+    length = strlen(base);
+    if (length > 3 && strcmp(base + length - 3, ".ob") == 0) length -= 3;
+    snprintf(path, size, "%.*s%s", (int)length, base, extension);
+}
+
+/**
+ * @brief Writes the assembly of a module to a stream.
+ *
+ * @param ir Pointer to the IR module.
+ * @param file The stream that receives the assembly.
+ * @return int Returns 0 on success, or -1 if the assembly could not be written.
+ */
+static int writeAssembly(IrModule *ir, FILE *file) {
+    Writer *writer = malloc(sizeof(Writer));
+    int status;
+
+    if (writer == NULL) {
+        fputs("obsidian: error: out of memory\n", stderr);
+        return -1;
+    }
+    initWriter(writer, file);
+    emitX86Module(ir, writer);
+    status = flushWriter(writer);
+    free(writer);
+    return status;
+}
+
+/**
+ * @brief Writes the assembly of a module to a file.
+ *
+ * @param ir Pointer to the IR module.
+ * @param path The file to create, or "-" for the standard output.
+ * @return int Returns 0 on success, or -1 on error.
+ */
+static int saveAssembly(IrModule *ir, const char *path) {
+    FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    int status;
+
+    if (file == NULL) {
+        fprintf(stderr, "obsidian: error: could not open '%s' for writing\n", path);
+        return -1;
+    }
+    status = writeAssembly(ir, file);
+    if (file != stdout && fclose(file) != 0) status = -1;
+    if (status != 0) fprintf(stderr, "obsidian: error: could not write '%s'\n", path);
+    return status;
+}
+
+/**
+ * @brief Encodes a module straight into an ELF relocatable object file.
+ *
+ * No assembler is involved, so this works on any host.
+ *
+ * @param ir Pointer to the IR module.
+ * @param path The file to create.
+ * @return int Returns 0 on success, or -1 on error.
+ */
+static int saveObject(IrModule *ir, const char *path) {
+    ObjectFile object;
+    int status;
+
+    initObjectFile(&object);
+    emitX86Object(ir, &object);
+    status = writeObjectFile(&object, path);
+    freeObjectFile(&object);
+    if (status != 0) fprintf(stderr, "obsidian: error: could not write '%s'\n", path);
+    return status;
+}
+
+#if defined(__x86_64__) && defined(__ELF__)
+
+/**
+ * @brief Appends a string to a command line, quoted for the shell.
+ *
+ * @param command Buffer holding the command line.
+ * @param size Size of the buffer.
+ * @param text The argument to append.
+ * @return int Returns 0 on success, or -1 if the buffer is too small.
+ */
+static int appendQuoted(char *command, size_t size, const char *text) {
+    size_t length = strlen(command);
+
+    if (length + 3 >= size) return -1;
+    command[length++] = ' ';
+    command[length++] = '\'';
+    for (; *text != '\0'; text++) {
+        if (length + 6 >= size) return -1;
+        if (*text == '\'') {
+            memcpy(command + length, "'\\''", 4);
+            length += 4;
+        } else {
+            command[length++] = *text;
+        }
+    }
+    command[length++] = '\'';
+    command[length] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Assembles a module with the system C compiler, linking it unless `compileOnly` is set.
+ *
+ * The compiler named by the CC environment variable is used, or `cc` if it
+ * is unset. The assembly is piped to it unless `-save-temps` asks for it to
+ * be kept next to the output.
+ *
+ * @param ir Pointer to the IR module.
+ * @param input The path of the source file.
+ * @param output The file to create.
+ * @param options Pointer to the selected code generation settings.
+ * @return int Returns 0 on success, or -1 on error.
+ */
+static int assembleModule(IrModule *ir, const char *input, const char *output, const BuildOptions *options) {
+    const char *cc = getenv("CC");
+    char command[4096];
+    char source[1024];
+    int status;
+
+    if (cc == NULL || *cc == '\0') cc = "cc";
+    snprintf(command, sizeof(command), "%s -x assembler%s -o", cc, options->compileOnly ? " -c" : "");
+    if (appendQuoted(command, sizeof(command), output) != 0) {
+        fputs("obsidian: error: output file name is too long\n", stderr);
+        return -1;
+    }
+
+    if (options->saveTemps) {
+        outputName(input, ".s", source, sizeof(source));
+        if (saveAssembly(ir, source) != 0) return -1;
+        if (appendQuoted(command, sizeof(command), source) != 0) return -1;
+        if (!options->compileOnly) strcat(command, " -lm");
+        status = system(command);
+    } else {
+        FILE *assembler;
+        strcat(command, options->compileOnly ? " -" : " - -lm");
+        fflush(stdout);
+        assembler = popen(command, "w");
+        if (assembler == NULL) {
+            fprintf(stderr, "obsidian: error: could not run '%s'\n", cc);
+            return -1;
+        }
+        status = writeAssembly(ir, assembler);
+        if (pclose(assembler) != 0) status = -1;
+    }
+
+    if (status != 0) {
+        fprintf(stderr, "obsidian: error: '%s' failed to assemble '%s'\n", cc, output);
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+/**
+ * @brief Reports that this host cannot assemble x86-64 code.
+ */
+static int assembleModule(IrModule *ir, const char *input, const char *output, const BuildOptions *options) {
+    (void)ir;
+    (void)input;
+    (void)options;
+    fprintf(stderr, "obsidian: error: cannot create '%s': native code needs an x86-64 ELF host; use -S\n", output);
+    return -1;
+}
+
+#endif
+
+/**
+ * @brief Writes the interface file of a module that exports functions.
+ *
+ * The interface is written next to the source file, as its name with the
+ * `.obi` extension, where modules that import it look for it.
+ *
+ * @param ir Pointer to the IR module.
+ * @param input The path of the source file.
+ * @return int Returns 0 on success or if nothing is exported, or -1 on error.
+ */
+static int saveInterface(const IrModule *ir, const char *input) {
+    size_t length = strlen(input);
+    char path[1024];
+    int exported = 0;
+
+    for (int i = 0; i < ir->functionCount && !exported; i++) exported = ir->functions[i].exported && !ir->functions[i].external;
+    if (!exported) return 0;
+
+    if (length > 3 && strcmp(input + length - 3, ".ob") == 0) length -= 3;
+    snprintf(path, sizeof(path), "%.*s%s", (int)length, input, INTERFACE_EXTENSION);
+    if (writeInterface(ir, path) != 0) {
+        fprintf(stderr, "obsidian: error: could not write interface '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compiles a source file to x86-64 assembly, an object file, or an executable.
+ *
+ * Object files are encoded directly unless `-save-temps` asks for the
+ * assembly, which then goes through the system assembler. A module that
+ * exports functions also gets an interface file, unless only its assembly
+ * is emitted with `-S`.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @param options Pointer to the selected code generation settings.
+ * @return int Returns EXIT_SUCCESS on success, or EXIT_FAILURE on error.
+ */
+static int buildNative(const CacheEntry *entry, const TokenCache *cache, const BuildOptions *options) {
+    IrModule ir;
+    char output[1024];
+    int status, mainIndex;
+
+    initIrModule(&ir);
+    status = buildIr(entry, cache, options, &ir, &mainIndex);
+    if (status == 0 && !options->emitAsm && !options->compileOnly && mainIndex < 0) {
+        fprintf(stderr, "obsidian: error: '%s' does not define a 'main' function\n", entry->path);
+        status = -1;
+    }
+
+    if (options->output != NULL) {
+        snprintf(output, sizeof(output), "%s", options->output);
+    } else if (options->emitAsm || options->compileOnly) {
+        outputName(entry->path, options->emitAsm ? ".s" : ".o", output, sizeof(output));
+    } else {
+        snprintf(output, sizeof(output), "%s", "a.out");
+    }
+
+    if (status == 0 && options->emitAsm) {
+        status = saveAssembly(&ir, output);
+    } else if (status == 0 && options->compileOnly && !options->saveTemps) {
+        status = saveObject(&ir, output);
+    } else if (status == 0) {
+        status = assembleModule(&ir, entry->path, output, options);
+    }
+    if (status == 0 && !options->emitAsm) status = saveInterface(&ir, entry->path);
+    freeIrModule(&ir);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Prints one function declaration for --index.
+ *
+ * The declaration must be free of syntax errors, so that it has a name and
+ * every parameter has one.
+ *
+ * @param path The path of the source file.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param parser Pointer to the parser that parsed the declaration.
+ * @param fn Pointer to the declaration.
+ */
+static void printDeclaration(const char *path, const InternTable *names, const Parser *parser, const FnDecl *fn) {
+    const Token *close = &parser->tokens[fn->bodyEnd > fn->bodyStart ? fn->bodyEnd - 1 : fn->bodyStart];
+
+    printf("%s:%d:%d: %sfn %s(", path, fn->token.line, fn->token.column, fn->exported ? "export " : "",
+           symbolName(names, fn->name));
+    for (int i = 0; i < fn->paramCount; i++) {
+        printf("%s%s %s", i > 0 ? ", " : "", typeName(fn->params[i].type), symbolName(names, fn->params[i].name));
+    }
+    printf(")%s%s lines %d-%d\n", fn->returnType == TypeVoid ? "" : " ", fn->returnType == TypeVoid ? "" : typeName(fn->returnType),
+           parser->tokens[fn->bodyStart].line, close->line);
+}
+
+/**
+ * @brief Checks or indexes the top-level declarations of a source file.
+ *
+ * Function bodies are skipped by matching braces, so this costs little
+ * more than lexing. Only the bodies named with `-fcheck-body=` are parsed,
+ * and their syntax errors reported.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @param options Pointer to the selected settings.
+ * @return int Returns EXIT_SUCCESS if no error was found, or EXIT_FAILURE otherwise.
+ */
+static int checkDeclarations(const CacheEntry *entry, const TokenCache *cache, const BuildOptions *options) {
+    Arena arena;
+    Parser parser;
+    Program program;
+    int status;
+
+    if (entry->stream.hasErrors) return EXIT_FAILURE;
+    initArena(&arena);
+    initParser(&parser, &entry->stream, &arena);
+    parser.lazyBodies = 1;
+    status = parseProgram(&parser, &program);
+    if (status < 0) outOfMemory("parsing");
+
+    for (const char *name = options->checkBodies; name != NULL && *name != '\0';) {
+        size_t length = strcspn(name, ",");
+        char function[256];
+        int index;
+
+        snprintf(function, sizeof(function), "%.*s", (int)length, name);
+        index = findFunction(&program, &cache->symbols, function);
+        if (index < 0) {
+            fprintf(stderr, "obsidian: error: '%s' does not define a function '%s'\n", entry->path, function);
+            status = -1;
+        } else {
+            int body = parseFunctionBody(&parser, &program.fns[index]);
+            if (body < 0) outOfMemory("parsing");
+            if (body != 0) status = -1;
+        }
+        name += length + (name[length] == ',');
+    }
+
+    if (options->index) {
+        for (int i = 0; i < program.importCount; i++) {
+            printf("%s: import %s\n", entry->path, symbolName(&cache->symbols, program.imports[i]));
+        }
+        for (int i = 0; i < program.fnCount; i++) {
+            if (!program.fns[i].hasErrors) printDeclaration(entry->path, &cache->symbols, &parser, &program.fns[i]);
+        }
+    }
+    freeArena(&arena);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Parses and type-checks a loaded source file and builds its IR.
+ *
+ * A valid module that exports functions also gets its interface file.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @return int Returns 0 if the file is valid, or -1 if any error was reported.
+ */
+int checkFile(const CacheEntry *entry, const TokenCache *cache) {
+    BuildOptions options;
+    IrModule ir;
+    int status, mainIndex;
+
+    memset(&options, 0, sizeof(options));
+    initIrModule(&ir);
+    status = buildIr(entry, cache, &options, &ir, &mainIndex);
+    if (status == 0) status = saveInterface(&ir, entry->path);
+    freeIrModule(&ir);
+    return status;
+}
+
+/**
+ * @brief Writes the statistics of a run as a single-line JSON object.
+ *
+ * @param stats Pointer to the memory snapshot.
+ * @param path The file to write, or NULL for standard output.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+static int saveStats(const MemStats *stats, const char *path) {
+    FILE *out = path != NULL ? fopen(path, "w") : stdout;
+    int status;
+
+    if (out == NULL) {
+        fprintf(stderr, "obsidian: error: could not write statistics to '%s'\n", path);
+        return -1;
+    }
+    fputs("{\"memory\": ", out);
+    printMemJson(out, stats);
+    fputs("}\n", out);
+    status = fflush(out) != 0 || ferror(out) ? -1 : 0;
+    if (out != stdout && fclose(out) != 0) status = -1;
+    if (status != 0) fprintf(stderr, "obsidian: error: could not write statistics to '%s'\n", path != NULL ? path : "standard output");
+    return status;
+}
+
+/**
+ * @brief Runs one compilation as described by its command-line arguments.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of command-line argument strings.
+ * @param cache Pointer to the token cache used to load source files.
+ * @return int Returns EXIT_SUCCESS on success, or EXIT_FAILURE on error.
+ */
+int runCompiler(int argc, char *argv[], TokenCache *cache) {
+    const char *input = NULL;
+    const CacheEntry *entry;
+    BuildOptions options;
+    int status;
+
+    memset(&options, 0, sizeof(options));
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-v") == 0) {
+            printVersion();
+            return EXIT_SUCCESS;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printHelpMenu();
+            return EXIT_SUCCESS;
+        } else if (strncmp(argv[i], "--help=", 7) == 0) {
+            const char *helpTopic = argv[i] + 7;
+            if (strcmp(helpTopic, "optimizers") == 0) {
+                printOptimizersHelp();
+            } else if (strcmp(helpTopic, "target") == 0) {
+                printTargetHelp();
+            } else if (strcmp(helpTopic, "warnings") == 0) {
+                printWarningsHelp();
+            } else {
+                fprintf(stderr, "unrecognized argument to '--help=' option: '%s'\n", helpTopic);
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            options.run = 1;
+        } else if (strcmp(argv[i], "--emit-ir") == 0) {
+            options.emitIr = 1;
+        } else if (strcmp(argv[i], "--time-passes") == 0) {
+            options.timePasses = 1;
+        } else if (strcmp(argv[i], "--mem-report") == 0) {
+            options.memReport = 1;
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            if (strcmp(argv[i] + 8, "json") == 0) {
+                options.statsPath = NULL;
+            } else if (strncmp(argv[i] + 8, "json=", 5) == 0 && argv[i][13] != '\0') {
+                options.statsPath = argv[i] + 13;
+            } else {
+                fprintf(stderr, "obsidian: error: unrecognized statistics format '%s'\n", argv[i] + 8);
+                return EXIT_FAILURE;
+            }
+            options.statsJson = 1;
+        } else if (strcmp(argv[i], "-S") == 0 || strcmp(argv[i], "--compile-only") == 0) {
+            options.emitAsm = 1;
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--compile-assemble") == 0) {
+            options.compileOnly = 1;
+        } else if (strcmp(argv[i], "-fsyntax-only") == 0) {
+            options.syntaxOnly = 1;
+        } else if (strcmp(argv[i], "--index") == 0) {
+            options.index = 1;
+        } else if (strncmp(argv[i], "-fcheck-body=", 13) == 0) {
+            options.checkBodies = argv[i] + 13;
+        } else if (strcmp(argv[i], "-save-temps") == 0) {
+            options.saveTemps = 1;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 == argc) {
+                fputs("obsidian: error: missing filename after '-o'\n", stderr);
+                return EXIT_FAILURE;
+            }
+            options.output = argv[++i];
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            options.output = argv[i] + 9;
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            const char *level = argv[i] + 2;
+            if (*level == '\0') {
+                options.optLevel = 1;
+            } else if (strspn(level, "0123456789") == strlen(level)) {
+                long value = strtol(level, NULL, 10);
+                options.optLevel = value > OPT_LEVEL_MAX ? OPT_LEVEL_MAX : (int)value;
+            } else {
+                fprintf(stderr, "obsidian: error: invalid optimization level '%s'\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (input == NULL && argv[i][0] != '-') {
+            input = argv[i];
+        }
+    }
+
+    if (input == NULL) {
+        fputs("obsidian: error: no input file\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    entry = loadTokens(cache, input);
+    if (entry == NULL) {
+        fprintf(stderr, "obsidian: error: could not read file '%s'\n", input);
+        status = EXIT_FAILURE;
+    } else if (options.syntaxOnly || options.index) {
+        status = checkDeclarations(entry, cache, &options);
+    } else if (options.run || options.emitIr) {
+        status = runProgram(entry, cache, &options);
+    } else {
+        status = buildNative(entry, cache, &options);
+    }
+
+    if (options.memReport || options.statsJson) {
+        MemStats stats;
+        getMemStats(&stats);
+        if (options.memReport) printMemReport(stderr, &stats);
+        if (options.statsJson && saveStats(&stats, options.statsPath) != 0) status = EXIT_FAILURE;
+    }
+    return status;
+}
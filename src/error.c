@@ -14,6 +14,7 @@
 
 #include "include/error.h"
 #include "include/color.h"
+#include "include/memstats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,6 +35,18 @@ const char* errorTypeToString(ErrorType type) {
     }
 }
 
+#ifdef _WIN32
+/**
+ * @brief Sets the console text color.
+ *
+ * @param color The console attribute to set, between 0 and 255.
+ */
+void set_color(int color) {
+    if (color < 0 || color > 0xFF) return;
+    SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), (WORD)color);
+}
+#endif
+
 /**
  * @brief Prints an error message to stderr with context information.
  * 
@@ -42,54 +55,91 @@ const char* errorTypeToString(ErrorType type) {
  * around the error. It also handles color formatting for terminal output based on
  * the operating system.
  * 
- * @param type The type of error that occurred.
- * @param message A message describing the error.
- * @param token A pointer to the Token structure that contains information about
- *              the location of the error in the source code.
- * @return int Returns EXIT_FAILURE to indicate an error occurred.
+ * @param diagnostic Pointer to the located error.
  */
-int error(ErrorType type, const char *message, Token *token) {
-    const char *line_start = token->start;
-    const char *line_end = token->start;
-    int column_offset;
-
-    while (line_start > token->start - token->column && line_start > token->start - token->column + 1 && *(line_start - 1) != '\n') {
-        line_start--;
-    }
-
-    while (*line_end != '\n' && *line_end != '\0') {
-        line_end++;
-    }
-
-    column_offset = (int)(token->start - line_start);
+static void printDiagnostic(const Diagnostic *diagnostic) {
+    int column_offset = (int)(diagnostic->text - diagnostic->lineText);
+    int length = diagnostic->textLength > 0 ? diagnostic->textLength : 1;
 
 #ifdef _WIN32
     set_color(FOREGROUND_RED | FOREGROUND_INTENSITY);
-    fprintf(stderr, "%s: ", errorTypeToString(type));
+    fprintf(stderr, "%s: ", errorTypeToString(diagnostic->type));
     set_color(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
     fputs("[line ", stderr);
     set_color(FOREGROUND_BLUE | FOREGROUND_INTENSITY);
-    fprintf(stderr, "%d", token->line);
+    fprintf(stderr, "%d", diagnostic->line);
     set_color(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
     fputs(", column ", stderr);
     set_color(FOREGROUND_BLUE | FOREGROUND_INTENSITY);
-    fprintf(stderr, "%d", token->column);
+    fprintf(stderr, "%d", diagnostic->column);
     set_color(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
     fputs("] ", stderr);
     set_color(FOREGROUND_RED | FOREGROUND_INTENSITY);
-    fprintf(stderr, "%s: %c\n", message, *token->start);
+    fprintf(stderr, "%s: %.*s\n", diagnostic->message, length, diagnostic->text);
     set_color(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
 #else
-    fprintf(stderr, LIGHT_RED "%s: " RESET, errorTypeToString(type));
-    fprintf(stderr, "[line " LIGHT_BLUE "%d" RESET ", column " LIGHT_BLUE "%d" RESET "] ", token->line, token->column);
-    fprintf(stderr, LIGHT_RED "%s: " RESET "%c\n", message, *token->start);
+    fprintf(stderr, LIGHT_RED "%s: " RESET, errorTypeToString(diagnostic->type));
+    fprintf(stderr, "[line " LIGHT_BLUE "%d" RESET ", column " LIGHT_BLUE "%d" RESET "] ", diagnostic->line, diagnostic->column);
+    fprintf(stderr, LIGHT_RED "%s: " RESET "%.*s\n", diagnostic->message, length, diagnostic->text);
 #endif
-    fprintf(stderr, "    %d | %.*s\n", token->line, (int)(line_end - line_start), line_start);
+    fprintf(stderr, "    %d | %.*s\n", diagnostic->line, diagnostic->lineLength, diagnostic->lineText);
     fputs("      | ", stderr);
     for (int i = 0; i < column_offset; i++) {
-        fprintf(stderr, (line_start[i] == '\t') ? "\t" : " ");
+        fprintf(stderr, (diagnostic->lineText[i] == '\t') ? "\t" : " ");
     }
     fputs("^\n", stderr);
+}
 
+/**
+ * @brief Reports an error to a sink, or prints it to stderr if there is none.
+ *
+ * The source line quoted with the error is found by scanning back from the
+ * token to the start of its line, bounded by the token's column.
+ *
+ * @param sink Pointer to the sink that receives the error, or NULL for stderr.
+ * @param type The type of error being reported.
+ * @param message The error message to display.
+ * @param token Pointer to the token associated with the error.
+ * @return int Returns EXIT_FAILURE to indicate an error occurred.
+ */
+int reportError(const DiagnosticSink *sink, ErrorType type, const char *message, const Token *token) {
+    const char *line_start = token->start;
+    const char *line_end = token->start;
+    Diagnostic diagnostic;
+
+    while (line_start > token->start - token->column && line_start > token->start - token->column + 1 && *(line_start - 1) != '\n') {
+        line_start--;
+    }
+
+    while (*line_end != '\n' && *line_end != '\0') {
+        line_end++;
+    }
+
+    diagnostic.type = type;
+    diagnostic.message = message;
+    diagnostic.line = token->line;
+    diagnostic.column = token->column;
+    diagnostic.text = token->start;
+    diagnostic.textLength = token->length;
+    diagnostic.lineText = line_start;
+    diagnostic.lineLength = (int)(line_end - line_start);
+
+    if (sink == NULL) printDiagnostic(&diagnostic);
+    else if (sink->report != NULL) sink->report(&diagnostic, sink->context);
+
+    memNoteDiagnostic(strlen(message) + (size_t)(line_end - line_start));
     return EXIT_FAILURE;
 }
+
+/**
+ * @brief Prints an error message to stderr with context information.
+ * 
+ * @param type The type of error that occurred.
+ * @param message A message describing the error.
+ * @param token A pointer to the Token structure that contains information about
+ *              the location of the error in the source code.
+ * @return int Returns EXIT_FAILURE to indicate an error occurred.
+ */
+int error(ErrorType type, const char *message, Token *token) {
+    return reportError(NULL, type, message, token);
+}
@@ -0,0 +1,387 @@
+/**
+ * @file fmt.c
+ * @brief Implements the `obsidian fmt` command.
+ *
+ * The files to format are gathered first. Worker threads then claim them one
+ * at a time through a shared index, so a few large files do not hold up the
+ * rest. Each worker formats into a writer of its own that it reuses for every
+ * file, and compares the result with the file before touching the disk. A
+ * changed file is written to a temporary file beside it that is then renamed
+ * over it, so an interrupted run never leaves a file half written. Before
+ * that the output is lexed again, and a file whose tokens the formatting
+ * would change is left alone and reported.
+ *
+ * Run by a parallel `make`, the command shares make's job slots instead of
+ * starting a thread per processor: the main thread works in the slot make
+ * gave the process, and before each file it claims it starts another worker
+ * if a jobserver token is free. Each worker returns its token as it exits.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#endif
+
+#include "include/fmt.h"
+#include "include/common.h"
+#include "include/format.h"
+#include "include/jobserver.h"
+#include "include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <errno.h>
+    #include <pthread.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__GNUC__)
+    #define FETCH_ADD(counter, value) __atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED)
+    #define STORE(flag, value) __atomic_store_n(&(flag), (value), __ATOMIC_RELAXED)
+    #define LOAD(flag) __atomic_load_n(&(flag), __ATOMIC_RELAXED)
+#else
+    #define FETCH_ADD(counter, value) (((counter) += (value)) - (value))
+    #define STORE(flag, value) ((flag) = (value))
+    #define LOAD(flag) (flag)
+#endif
+
+#define FMT_MAX_JOBS 256    ///< Upper bound on the number of worker threads.
+
+/**
+ * @struct FmtRun
+ * @brief The files of one `obsidian fmt` command and the state its workers share.
+ */
+typedef struct {
+    char **paths;
+    size_t count, capacity;
+    int check;          ///< Only verify the files, as asked by `--check`.
+    size_t next;        ///< Index of the next file to claim.
+    int stop;           ///< Set once `--check` has found an unformatted file.
+    int failed;         ///< Set once any file could not be formatted.
+    JobServer jobServer;
+    long jobs;          ///< Upper bound on the number of threads, the main thread included.
+    long started;       ///< Workers started so far; only the main thread updates it.
+    struct FmtWorker *workers;
+} FmtRun;
+
+/**
+ * @struct FmtWorker
+ * @brief A worker thread started in addition to the main thread.
+ */
+typedef struct FmtWorker {
+    FmtRun *run;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+    int hasToken;       ///< Whether the worker holds a jobserver token.
+    char token;
+} FmtWorker;
+
+/**
+ * @brief Adds a copy of a path to the files to format.
+ *
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int addPath(FmtRun *run, const char *path) {
+    size_t length = strlen(path);
+    char *copy;
+
+    if (run->count == run->capacity) {
+        size_t capacity = run->capacity ? run->capacity * 2 : 64;
+        char **paths = realloc(run->paths, capacity * sizeof(char *));
+        if (paths == NULL) return -1;
+        run->paths = paths;
+        run->capacity = capacity;
+    }
+    copy = malloc(length + 1);
+    if (copy == NULL) return -1;
+    memcpy(copy, path, length + 1);
+    run->paths[run->count++] = copy;
+    return 0;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Adds every `.ob` file below a directory, skipping hidden entries and symbolic links.
+ *
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int addDirectory(FmtRun *run, const char *path) {
+    size_t length = strlen(path);
+    DIR *directory = opendir(path);
+    struct dirent *item;
+    int status = 0;
+
+    if (directory == NULL) {
+        fprintf(stderr, "obsidian: error: cannot open '%s': %s\n", path, strerror(errno));
+        run->failed = 1;
+        return 0;
+    }
+    while (length > 1 && path[length - 1] == '/') length--;
+
+    while (status == 0 && (item = readdir(directory)) != NULL) {
+        size_t nameLength = strlen(item->d_name);
+        struct stat info;
+        char *child;
+
+        if (item->d_name[0] == '.') continue;
+        child = malloc(length + nameLength + 2);
+        if (child == NULL) {
+            status = -1;
+            break;
+        }
+        sprintf(child, "%.*s/%s", (int)length, path, item->d_name);
+        if (lstat(child, &info) == 0) {
+            if (S_ISDIR(info.st_mode)) {
+                status = addDirectory(run, child);
+            } else if (S_ISREG(info.st_mode) && nameLength > 3 && strcmp(item->d_name + nameLength - 3, ".ob") == 0) {
+                status = addPath(run, child);
+            }
+        }
+        free(child);
+    }
+    closedir(directory);
+    return status;
+}
+
+#endif
+
+/**
+ * @brief Adds a command-line argument, which names a file or a directory.
+ *
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int addArgument(FmtRun *run, const char *path) {
+#ifndef _WIN32
+    struct stat info;
+
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) return addDirectory(run, path);
+#endif
+    return addPath(run, path);
+}
+
+/**
+ * @brief Reports whether two sources lex to the same sequence of token kinds.
+ */
+static int sameTokens(char *source, char *output) {
+    static const DiagnosticSink discard = { NULL, NULL };
+    Lexer before, after;
+    Token a, b;
+
+    initLexer(&before, source);
+    initLexer(&after, output);
+    before.keepComments = after.keepComments = 1;
+    before.diagnostics = after.diagnostics = &discard;
+    do {
+        a = getNextToken(&before);
+        b = getNextToken(&after);
+        if (a.type != b.type) return 0;
+    } while (a.type != TEof);
+    return 1;
+}
+
+/**
+ * @brief Prints a lexical error found while formatting, as one line.
+ */
+static void printFormatError(const Diagnostic *diagnostic, void *context) {
+    fprintf(stderr, "%s:%d:%d: error: %s\n", (const char *)context, diagnostic->line, diagnostic->column,
+            diagnostic->message);
+}
+
+/**
+ * @brief Formats one file, or with `--check` compares it with its formatting.
+ *
+ * @param run Pointer to the shared state of the command.
+ * @param writer Pointer to the worker's writer, which collects output in memory.
+ * @param path The path of the file.
+ */
+static void formatFile(FmtRun *run, Writer *writer, const char *path) {
+    DiagnosticSink sink;
+    size_t length = 0, size = 0;
+    char *source = readFile(path, &length);
+    char *output;
+    int status;
+
+    if (source == NULL) {
+        fprintf(stderr, "obsidian: error: cannot read '%s'\n", path);
+        STORE(run->failed, 1);
+        return;
+    }
+    sink.report = printFormatError;
+    sink.context = (void *)path;
+    status = formatSource(source, &sink, writer);
+    output = takeWriterMemory(writer, &size);
+
+    if (status != 0 || output == NULL) {
+        if (status != 1) fprintf(stderr, "obsidian: error: out of memory while formatting '%s'\n", path);
+        STORE(run->failed, 1);
+    } else if (size != length || memcmp(output, source, size) != 0) {
+        if (!sameTokens(source, output)) {
+            fprintf(stderr, "obsidian: error: formatting would change the tokens of '%s'; file left unchanged\n", path);
+            STORE(run->failed, 1);
+        } else if (run->check) {
+            fprintf(stderr, "obsidian: '%s' is not formatted\n", path);
+            STORE(run->stop, 1);
+            STORE(run->failed, 1);
+        } else if (replaceFile(path, output, size) != 0) {
+            fprintf(stderr, "obsidian: error: cannot write '%s'\n", path);
+            STORE(run->failed, 1);
+        }
+    }
+    free(output);
+    free(source);
+}
+
+static void *runWorker(void *argument);
+
+/**
+ * @brief Starts another worker if the job limit allows it and a jobserver token is free.
+ */
+static void startWorker(FmtRun *run) {
+#ifndef _WIN32
+    FmtWorker *worker;
+
+    if (run->started >= run->jobs - 1) return;
+    worker = &run->workers[run->started];
+    if (!tryAcquireJobToken(&run->jobServer, &worker->token)) return;
+    worker->run = run;
+    worker->hasToken = 1;
+    if (pthread_create(&worker->thread, NULL, runWorker, worker) != 0) {
+        releaseJobToken(&run->jobServer, worker->token);
+        return;
+    }
+    run->started++;
+#else
+    (void)run;
+#endif
+}
+
+/**
+ * @brief Claims and formats files until none are left or `--check` has found a difference.
+ *
+ * @param run Pointer to the shared state of the command.
+ * @param spawn Whether to start workers as files are claimed, which only the main thread does.
+ */
+static void formatFiles(FmtRun *run, int spawn) {
+    Writer *writer = malloc(sizeof(Writer));
+
+    if (writer == NULL) {
+        fputs("obsidian: error: out of memory while formatting\n", stderr);
+        STORE(run->failed, 1);
+        return;
+    }
+    initWriter(writer, NULL);
+    while (!LOAD(run->stop)) {
+        size_t index = FETCH_ADD(run->next, 1);
+        if (index >= run->count) break;
+        if (spawn && index + 1 < run->count) startWorker(run);
+        formatFile(run, writer, run->paths[index]);
+    }
+    free(writer);
+}
+
+/**
+ * @brief Formats files on a worker thread, then returns its jobserver token.
+ *
+ * @param argument Pointer to the worker's FmtWorker.
+ * @return void* Always NULL.
+ */
+static void *runWorker(void *argument) {
+    FmtWorker *worker = argument;
+
+    formatFiles(worker->run, 0);
+    if (worker->hasToken) releaseJobToken(&worker->run->jobServer, worker->token);
+    return NULL;
+}
+
+/**
+ * @brief Returns the number of worker threads to start when none is asked for.
+ */
+static long defaultJobs(void) {
+#if !defined(_WIN32) && defined(_SC_NPROCESSORS_ONLN)
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? processors : 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief Formats the files named on the command line.
+ *
+ * @param argc The number of arguments after `fmt`.
+ * @param argv The arguments after `fmt`.
+ * @return int Returns EXIT_SUCCESS if every file is formatted, or
+ *             EXIT_FAILURE on an error or, with `--check`, a difference.
+ */
+int runFmt(int argc, char *argv[]) {
+    FmtRun run = { NULL, 0, 0, 0, 0, 0, 0, { -1, -1, 0, 0 }, 0, 0, NULL };
+    long jobs = 0;
+    int named = 0, shared;
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0) {
+            run.check = 1;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char *count = argv[i][2] != '\0' ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            char *end;
+            jobs = strtol(count, &end, 10);
+            if (*count == '\0' || *end != '\0' || jobs < 1) {
+                fprintf(stderr, "obsidian: error: invalid job count '%s'\n", count);
+                return EXIT_FAILURE;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "obsidian: error: unrecognized fmt option '%s'\n", argv[i]);
+            return EXIT_FAILURE;
+        } else {
+            named = 1;
+            if (addArgument(&run, argv[i]) != 0) run.stop = 1;
+        }
+    }
+    if (!named && addArgument(&run, ".") != 0) run.stop = 1;
+    if (run.stop) {
+        fputs("obsidian: error: out of memory while formatting\n", stderr);
+        run.failed = 1;
+    }
+
+    if (jobs == 0) jobs = defaultJobs();
+    if (jobs > FMT_MAX_JOBS) jobs = FMT_MAX_JOBS;
+    if ((size_t)jobs > run.count) jobs = run.count > 0 ? (long)run.count : 1;
+    shared = jobs > 1 && openJobServer(&run.jobServer, getenv("MAKEFLAGS"));
+
+#ifndef _WIN32
+    if (jobs > 1) {
+        FmtWorker workers[FMT_MAX_JOBS];
+
+        run.jobs = jobs;
+        run.workers = workers;
+        while (!shared && run.started < jobs - 1) {
+            FmtWorker *worker = &workers[run.started];
+            worker->run = &run;
+            worker->hasToken = 0;
+            if (pthread_create(&worker->thread, NULL, runWorker, worker) != 0) break;
+            run.started++;
+        }
+        formatFiles(&run, shared);
+        for (long i = 0; i < run.started; i++) pthread_join(workers[i].thread, NULL);
+    } else
+#endif
+    {
+        formatFiles(&run, 0);
+    }
+
+    closeJobServer(&run.jobServer);
+    for (size_t i = 0; i < run.count; i++) free(run.paths[i]);
+    free(run.paths);
+    return run.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file format.c
+ * @brief Implements the source formatter of the Obsidian programming language.
+ *
+ * Tokens are read one ahead of the one being placed and collected into the
+ * pieces of the current output line. A line is laid out once it is complete,
+ * which is when wrapping is decided, since the best place to wrap a line may
+ * come well before the point where it grows too long. Comments never count
+ * towards the width, so a trailing comment stays on the line it follows.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/format.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct Piece
+ * @brief A token placed on the output line being collected.
+ */
+typedef struct {
+    const char *text;
+    int length;
+    int space;          ///< Whether a space separates the piece from the one before it.
+    int breakAfter;     ///< How good a place to wrap the line after the piece is, 0 if none.
+    int wrapBefore;     ///< Set by the layout when a continuation line starts at the piece.
+    int level;          ///< Number of brackets open around the piece.
+    int comment;
+} Piece;
+
+/**
+ * @struct Formatter
+ * @brief The output side of the formatter.
+ */
+typedef struct {
+    Writer *writer;
+    Piece *pieces;      ///< The pieces of the line being collected.
+    size_t count, capacity;
+    int indent;         ///< Indentation of the line being collected.
+    int continuation;   ///< Indentation of its wrapped parts.
+    int wroteLine;      ///< Whether any line has been written.
+    int failed;         ///< Set if memory for the pieces could not be allocated.
+} Formatter;
+
+/**
+ * @brief Appends a piece to the line being collected.
+ */
+static void addPiece(Formatter *formatter, const char *text, int length, int space, int breakAfter, int level,
+                     int comment) {
+    Piece *piece;
+
+    if (formatter->count == formatter->capacity) {
+        size_t capacity = formatter->capacity ? formatter->capacity * 2 : 64;
+        Piece *pieces = realloc(formatter->pieces, capacity * sizeof(Piece));
+        if (pieces == NULL) {
+            formatter->failed = 1;
+            return;
+        }
+        formatter->pieces = pieces;
+        formatter->capacity = capacity;
+    }
+    piece = &formatter->pieces[formatter->count++];
+    piece->text = text;
+    piece->length = length;
+    piece->space = space;
+    piece->breakAfter = breakAfter;
+    piece->level = level;
+    piece->comment = comment;
+}
+
+/**
+ * @brief Writes a run of spaces.
+ */
+static void writeIndent(Writer *writer, int columns) {
+    static const char spaces[] = "                                ";
+
+    while (columns > 0) {
+        int run = columns < (int)sizeof(spaces) - 1 ? columns : (int)sizeof(spaces) - 1;
+        writeBytes(writer, spaces, (size_t)run);
+        columns -= run;
+    }
+}
+
+/**
+ * @brief Sets the indentation of the next line from the brace depth.
+ *
+ * @param formatter Pointer to the formatter.
+ * @param depth The number of open braces.
+ * @param open Whether the line continues a statement begun on an earlier line.
+ */
+static void startLine(Formatter *formatter, int depth, int open) {
+    formatter->indent = depth * FORMAT_INDENT + (open ? FORMAT_CONTINUATION : 0);
+    formatter->continuation = depth * FORMAT_INDENT + FORMAT_CONTINUATION;
+}
+
+/**
+ * @brief Returns the columns a piece adds to a line, counting its space unless it starts the line.
+ */
+static int pieceWidth(const Piece *piece, int first) {
+    if (piece->comment) return 0;
+    return (first ? 0 : piece->space) + piece->length;
+}
+
+/**
+ * @brief Lays out and writes the line being collected, wrapping it where it is too long.
+ *
+ * When a piece would cross the line width, the line is wrapped at a break
+ * since the last wrap: the one inside the fewest brackets, then the one with
+ * the highest rank, then the last one. A call or parenthesized group is so
+ * kept whole where possible, and a comma is preferred over an operator.
+ */
+static void flushLine(Formatter *formatter) {
+    Piece *pieces = formatter->pieces;
+    int column = formatter->indent;
+    size_t start = 0;
+
+    if (formatter->count == 0) return;
+
+    for (size_t i = 0; i < formatter->count; i++) {
+        pieces[i].wrapBefore = 0;
+        if (i > start && !pieces[i].comment && column + pieceWidth(&pieces[i], 0) > FORMAT_LINE_WIDTH) {
+            size_t cut = i;
+            for (size_t j = start; j < i; j++) {
+                if (!pieces[j].breakAfter) continue;
+                if (cut == i || pieces[j].level < pieces[cut].level ||
+                    (pieces[j].level == pieces[cut].level && pieces[j].breakAfter >= pieces[cut].breakAfter)) {
+                    cut = j;
+                }
+            }
+            if (cut < i) {
+                start = cut + 1;
+                pieces[start].wrapBefore = 1;
+                column = formatter->continuation;
+                for (size_t j = start; j < i; j++) column += pieceWidth(&pieces[j], j == start);
+            }
+        }
+        column += pieceWidth(&pieces[i], i == start);
+    }
+
+    writeIndent(formatter->writer, formatter->indent);
+    for (size_t i = 0; i < formatter->count; i++) {
+        if (pieces[i].wrapBefore) {
+            writeChar(formatter->writer, '\n');
+            writeIndent(formatter->writer, formatter->continuation);
+        } else if (i > 0 && pieces[i].space) {
+            writeChar(formatter->writer, ' ');
+        }
+        writeBytes(formatter->writer, pieces[i].text, (size_t)pieces[i].length);
+    }
+    writeChar(formatter->writer, '\n');
+    formatter->count = 0;
+    formatter->wroteLine = 1;
+}
+
+/**
+ * @brief Reports whether a token ends an operand, so that an operator after it is binary.
+ */
+static int endsOperand(TokenKind kind) {
+    switch (kind) {
+        case TIdentifier: case TIntLiteral: case TFloatLiteral: case TBoolLiteral: case TStringLiteral:
+        case TCharLiteral: case TTrue: case TFalse: case TNull: case TRparen: case TRbracket:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Ranks the token as a place to wrap a line after it.
+ *
+ * A comma ranks highest, then binary operators from the loosest binding to
+ * the tightest, so that a wrap never splits an operand of a looser operator.
+ *
+ * @param kind The token kind.
+ * @return int The rank, or 0 if the line is never wrapped after the token.
+ */
+static int breakRank(TokenKind kind) {
+    switch (kind) {
+        case TComma: return 12;
+        case TLogicalOr: return 11;
+        case TLogicalAnd: return 10;
+        case TPipe: return 9;
+        case TCarot: case TXor: return 8;
+        case TAmpersand: return 7;
+        case TEqual: case TNotEqual: return 6;
+        case TLess: case TLessEqual: case TGreater: case TGreaterEqual: return 5;
+        case TLeftShift: case TRightShift: return 4;
+        case TPlus: case TMinus: return 3;
+        case TStar: case TSlash: case TPercent: return 2;
+        case TPower: return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Reports whether a token is a prefix operator where it stands.
+ *
+ * @param kind The token kind.
+ * @param afterOperand Whether the previous token ended an operand.
+ */
+static int isUnaryOperator(TokenKind kind, int afterOperand) {
+    switch (kind) {
+        case TNot: case TXorNot:
+            return 1;
+        case TMinus: case TPlus: case TStar: case TAmpersand: case TIncrement: case TDecrement:
+            return !afterOperand;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Reports whether a keyword is followed by its arguments like a call.
+ */
+static int isCallKeyword(TokenKind kind) {
+    switch (kind) {
+        case TPrintln: case TCast: case TSizeof: case TTypeof: case TLength: case TAlloc: case TDealloc:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Decides whether a space separates a token from the one before it on the same line.
+ *
+ * @param previous The kind of the previous token.
+ * @param kind The kind of the token.
+ * @param afterOperand Whether the previous token ended an operand.
+ * @param afterUnary Whether the previous token was a prefix operator.
+ * @param inCase Whether the token is part of a `case` or `default` label.
+ */
+static int spaceBefore(TokenKind previous, TokenKind kind, int afterOperand, int afterUnary, int inCase) {
+    switch (kind) {
+        case TRparen: case TRbracket: case TComma: case TSemi: case TDot:
+            return 0;
+        case TColon:
+            if (inCase) return 0;
+            break;
+        case TIncrement: case TDecrement:
+            if (afterOperand) return 0;
+            break;
+        case TLparen:
+            if (previous == TIdentifier || previous == TRparen || previous == TRbracket || isCallKeyword(previous)) return 0;
+            break;
+        case TLbracket:
+            if (afterOperand) return 0;
+            break;
+        default:
+            break;
+    }
+    return !(previous == TLparen || previous == TLbracket || previous == TDot || afterUnary);
+}
+
+/**
+ * @brief Reports whether two tokens would lex differently if written with no space between them.
+ *
+ * The joined text is lexed again, so `- -x` keeps its space rather than becoming
+ * the decrement `--x`, and likewise for `+ +x`, `* *p`, `& &x` and the rest.
+ */
+static int tokensMerge(const Token *previous, const Token *token) {
+    static const DiagnosticSink discard = { NULL, NULL };
+    char text[64];
+    Lexer lexer;
+    Token joined;
+
+    if ((size_t)previous->length + (size_t)token->length >= sizeof(text)) return 0;
+    memcpy(text, previous->start, (size_t)previous->length);
+    memcpy(text + previous->length, token->start, (size_t)token->length);
+    text[previous->length + token->length] = '\0';
+    initLexer(&lexer, text);
+    lexer.diagnostics = &discard;
+    joined = getNextToken(&lexer);
+    return joined.type != previous->type || joined.length != previous->length;
+}
+
+/**
+ * @brief Formats a source file.
+ *
+ * @param source Pointer to the NUL-terminated source code.
+ * @param diagnostics Receives lexical errors; NULL prints them.
+ * @param writer Pointer to the writer that receives the formatted source.
+ * @return int Returns 0 on success, 1 if the source has lexical errors, in
+ *             which case the output is incomplete, or -1 if memory could not be allocated.
+ */
+int formatSource(char *source, const DiagnosticSink *diagnostics, Writer *writer) {
+    Formatter formatter = { NULL, NULL, 0, 0, 0, 0, 0, 0 };
+    Lexer lexer;
+    Token token, next, last;
+    TokenKind previous = TEof;
+    int previousLine = 0, afterOperand = 0, afterUnary = 0;
+    int depth = 0, parens = 0, inCase = 0, open = 0, afterBrace = 0, status = 0;
+
+    formatter.writer = writer;
+    initLexer(&lexer, source);
+    lexer.keepComments = 1;
+    lexer.diagnostics = diagnostics;
+
+    next = getNextToken(&lexer);
+    last = next;
+    while (next.type != TEof && !formatter.failed) {
+        int unary, space, endLine = 0, joinBraces = 0;
+
+        token = next;
+        next = getNextToken(&lexer);
+        if (token.type == TError) {
+            status = 1;
+            continue;
+        }
+
+        if (formatter.count == 0 && formatter.wroteLine && token.line > previousLine + 1 && !afterBrace && token.type != TRbrace) {
+            writeChar(writer, '\n');
+        }
+
+        if (token.type == TComment) {
+            int length = token.length;
+            while (isspace((unsigned char)token.start[length - 1])) length--;
+            if (formatter.count > 0 && token.line != previousLine) flushLine(&formatter);
+            if (formatter.count == 0) {
+                startLine(&formatter, depth, open);
+                afterBrace = 0;
+            }
+            addPiece(&formatter, token.start, length, 1, 0, parens, 1);
+            flushLine(&formatter);
+            previousLine = token.line;
+            continue;
+        }
+        afterBrace = 0;
+
+        if (token.type == TRbrace) {
+            joinBraces = previous == TLbrace && formatter.count > 0;
+            if (!joinBraces) {
+                flushLine(&formatter);
+                if (depth > 0) depth--;
+            }
+        }
+        if (formatter.count == 0) startLine(&formatter, depth, open);
+
+        unary = isUnaryOperator(token.type, afterOperand);
+        space = !joinBraces && spaceBefore(previous, token.type, afterOperand, afterUnary, inCase);
+        if (!space && formatter.count > 0 && previous != TEof) space = tokensMerge(&last, &token);
+        addPiece(&formatter, token.start, token.length, space,
+                 unary ? 0 : breakRank(token.type), parens, 0);
+        open = 1;
+
+        switch (token.type) {
+            case TLbrace:
+                if (next.type != TRbrace) {
+                    depth++;
+                    endLine = 1;
+                    afterBrace = 1;
+                }
+                break;
+            case TRbrace:
+                endLine = next.type != TElse && next.type != TSemi && next.type != TRparen && next.type != TComma;
+                break;
+            case TSemi:
+                endLine = parens == 0;
+                inCase = 0;
+                break;
+            case TCase: case TDefault:
+                inCase = 1;
+                break;
+            case TColon:
+                endLine = inCase;
+                inCase = 0;
+                break;
+            case TLparen: case TLbracket:
+                parens++;
+                break;
+            case TRparen: case TRbracket:
+                if (parens > 0) parens--;
+                break;
+            default:
+                break;
+        }
+
+        if (endLine) {
+            open = 0;
+            if (next.type != TComment || next.line != token.line) flushLine(&formatter);
+        }
+        afterOperand = endsOperand(token.type) || ((token.type == TIncrement || token.type == TDecrement) && !unary);
+        afterUnary = unary;
+        previous = token.type;
+        last = token;
+        previousLine = token.line;
+    }
+
+    flushLine(&formatter);
+    free(formatter.pieces);
+    if (formatter.failed || writer->failed) return -1;
+    return status;
+}
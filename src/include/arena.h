@@ -0,0 +1,103 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/**
+ * @file arena.h
+ * @brief Defines the bump-pointer arena allocator used by the Obsidian compiler.
+ *
+ * This header file declares a simple region allocator. Objects that share a
+ * lifetime, such as the nodes of one syntax tree, are carved out of large
+ * chunks and released together when the arena is freed.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+
+/**
+ * @struct ArenaChunk
+ * @brief A single block of memory owned by an arena.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t used, size;
+    size_t reserved;        ///< Pads the header so `data` stays 16-byte aligned.
+    unsigned char data[];
+} ArenaChunk;
+
+/**
+ * @struct Arena
+ * @brief A bump-pointer allocator made of a list of chunks.
+ */
+typedef struct {
+    ArenaChunk *head;       ///< Chunk currently being filled.
+    size_t totalBytes;      ///< Bytes reserved across every chunk.
+} Arena;
+
+/**
+ * @struct ArenaMark
+ * @brief A position in an arena that later allocations can be rolled back to.
+ */
+typedef struct {
+    ArenaChunk *chunk;      ///< Chunk being filled when the mark was taken.
+    size_t used;            ///< Bytes of that chunk in use at the time.
+} ArenaMark;
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena Pointer to the arena to initialize.
+ */
+void initArena(Arena *arena);
+
+/**
+ * @brief Allocates zeroed, suitably aligned memory from the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @param size Number of bytes to allocate.
+ * @return void* Pointer to the memory, or NULL if a chunk could not be allocated.
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a buffer into the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @param data Pointer to the bytes to copy.
+ * @param size Number of bytes to copy.
+ * @return void* Pointer to the copy, or NULL if memory could not be allocated.
+ */
+void *arenaCopy(Arena *arena, const void *data, size_t size);
+
+/**
+ * @brief Records the current position of the arena.
+ *
+ * @param arena Pointer to the arena.
+ * @return ArenaMark The position, to be passed to arenaReset.
+ */
+ArenaMark arenaMark(const Arena *arena);
+
+/**
+ * @brief Releases everything allocated since a mark was taken.
+ *
+ * Chunks allocated after the mark are freed and the chunk that was being
+ * filled is rewound. Resetting to a mark taken on an empty arena keeps its
+ * first chunk for reuse. Marks must be reset in the reverse order they
+ * were taken.
+ *
+ * @param arena Pointer to the arena.
+ * @param mark A position returned by arenaMark on the same arena.
+ */
+void arenaReset(Arena *arena, ArenaMark mark);
+
+/**
+ * @brief Releases every chunk owned by the arena.
+ *
+ * @param arena Pointer to the arena to free.
+ */
+void freeArena(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,201 @@
+#ifndef AST_H
+#define AST_H
+
+/**
+ * @file ast.h
+ * @brief Defines the abstract syntax tree for the Obsidian programming language.
+ *
+ * This header file contains the node types produced by the parser: types,
+ * expressions, statements, and top-level function declarations. Every node
+ * is allocated from an arena owned by the program, and names are stored as
+ * interned symbol IDs rather than strings.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+
+/**
+ * @enum TypeKind
+ * @brief Enumeration of the value types of the language.
+ *
+ * TypeUntypedInt and TypeUntypedFloat are given to numeric literals before
+ * they take on the type required by their context.
+ */
+typedef enum {
+    TypeVoid, TypeBool, TypeChar, TypeI8, TypeI16, TypeI32, TypeI64, TypeU8, TypeU16, TypeU32, TypeU64, TypeF32, TypeF64, TypeString, TypeUntypedInt, TypeUntypedFloat, TypeInvalid
+} TypeKind;
+
+/**
+ * @enum ExprKind
+ * @brief Enumeration of expression node kinds.
+ */
+typedef enum {
+    ExprIntLiteral, ExprFloatLiteral, ExprBoolLiteral, ExprStringLiteral, ExprCharLiteral, ExprName, ExprUnary, ExprBinary, ExprAssign, ExprTernary, ExprCall, ExprCast, ExprIncDec
+} ExprKind;
+
+/**
+ * @enum StmtKind
+ * @brief Enumeration of statement node kinds.
+ */
+typedef enum {
+    StmtVar, StmtExpr, StmtBlock, StmtIf, StmtWhile, StmtFor, StmtReturn, StmtBreak, StmtPrint
+} StmtKind;
+
+typedef struct Expr Expr;
+typedef struct Stmt Stmt;
+
+/**
+ * @struct Expr
+ * @brief An expression node.
+ *
+ * `token` is the operator or primary token of the expression and is used for
+ * diagnostics. `type` is filled in by semantic analysis, after `natural`,
+ * the type the expression has before its context is applied.
+ */
+struct Expr {
+    ExprKind kind;
+    TypeKind type;
+    TypeKind natural;
+    Token token;
+    union {
+        uint64_t intValue;
+        double floatValue;
+        int boolValue;
+        uint32_t symbol;
+        struct { const char *chars; size_t length; } string;
+        struct { TokenKind op; Expr *operand; } unary;
+        struct { TokenKind op; Expr *left, *right; } binary;
+        struct { TokenKind op; Expr *target, *value; } assign;
+        struct { Expr *condition, *then, *otherwise; } ternary;
+        struct { uint32_t callee; Expr **args; int argCount; } call;
+        struct { Expr *operand; TypeKind to; } cast;
+        struct { TokenKind op; Expr *target; int prefix; } incDec;
+    } as;
+};
+
+/**
+ * @struct Stmt
+ * @brief A statement node.
+ *
+ * `expr` is used by expression, print, and return statements; a return
+ * without a value has a NULL `expr`.
+ */
+struct Stmt {
+    StmtKind kind;
+    Token token;
+    union {
+        Expr *expr;
+        struct { TypeKind type; uint32_t name; Expr *init; } var;
+        struct { Stmt **items; int count; } block;
+        struct { Expr *condition; Stmt *then, *otherwise; } ifStmt;
+        struct { Expr *condition; Stmt *body; } whileStmt;
+        struct { Stmt *init; Expr *condition, *step; Stmt *body; } forStmt;
+    } as;
+};
+
+/**
+ * @struct Param
+ * @brief A function parameter.
+ */
+typedef struct {
+    TypeKind type;
+    uint32_t name;
+    Token token;
+} Param;
+
+/**
+ * @struct FnDecl
+ * @brief A top-level function declaration.
+ *
+ * `body` is NULL while a lazily parsed body has only been skipped; its
+ * tokens are always known, so it can be parsed when it is needed. A
+ * declaration with `hasErrors` set may lack its name or parameter names.
+ */
+typedef struct {
+    uint32_t name;
+    Token token;
+    Param *params;
+    int paramCount;
+    TypeKind returnType;
+    Stmt *body;
+    size_t bodyStart, bodyEnd;  ///< Token range of the body, from its '{' to just past its '}'.
+    int exported;
+    int hasErrors;              ///< Non-zero if parsing the declaration reported a syntax error.
+} FnDecl;
+
+/**
+ * @struct Program
+ * @brief The top-level declarations of one source file.
+ */
+typedef struct {
+    FnDecl *fns;
+    int fnCount;
+    uint32_t *imports;
+    int importCount;
+    const struct ModuleInterface *interfaces;   ///< Interfaces of the imports, opened by the driver, or NULL.
+    int interfaceCount;
+} Program;
+
+/**
+ * @brief Maps a type keyword token to its TypeKind.
+ *
+ * @param kind The token kind of the type keyword.
+ * @return TypeKind The matching type, or TypeInvalid if the token is not a type.
+ */
+TypeKind typeFromToken(TokenKind kind);
+
+/**
+ * @brief Returns the source spelling of a type.
+ *
+ * @param type The type to name.
+ * @return const char* The type's keyword, or a description for internal types.
+ */
+const char *typeName(TypeKind type);
+
+/**
+ * @brief Checks whether a type is an integer type, including untyped integer literals.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is an integer type.
+ */
+int isIntegerType(TypeKind type);
+
+/**
+ * @brief Checks whether a type is a floating-point type, including untyped float literals.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is a floating-point type.
+ */
+int isFloatType(TypeKind type);
+
+/**
+ * @brief Checks whether a type is a signed integer type.
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is i8, i16, i32, or i64.
+ */
+int isSignedType(TypeKind type);
+
+/**
+ * @brief Checks whether a type is numeric (integer or floating-point).
+ *
+ * @param type The type to check.
+ * @return int Non-zero if the type is numeric.
+ */
+int isNumericType(TypeKind type);
+
+/**
+ * @brief Returns the size in bytes of a value of the given type.
+ *
+ * @param type The type to measure.
+ * @return int The size in bytes; strings are pointer-sized.
+ */
+int typeSize(TypeKind type);
+
+#endif // AST_H
@@ -0,0 +1,134 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+/**
+ * @file cache.h
+ * @brief Defines the per-file token cache used by the Obsidian compiler.
+ *
+ * This header file declares the token cache, which keeps the source buffer,
+ * the token stream, and the interned identifier symbols of every file that
+ * has been lexed. A long-lived process such as the compiler daemon reuses
+ * cached streams until the file's modification time or contents change.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "intern.h"
+#include "error.h"
+#include "lexer.h"
+
+/**
+ * @struct TokenStream
+ * @brief A fully lexed token stream with interned identifiers.
+ *
+ * `symbols` runs parallel to `tokens` and holds the interned symbol ID of
+ * every identifier token (SYMBOL_NONE otherwise). Token start pointers refer
+ * into the source buffer the stream was lexed from.
+ */
+typedef struct {
+    Token *tokens;          ///< Token stream, terminated by a TEof token.
+    uint32_t *symbols;      ///< Interned symbol of each identifier token.
+    size_t count;           ///< Number of tokens including the final TEof.
+    size_t capacity;        ///< Number of tokens the arrays can hold.
+    int hasErrors;          ///< Non-zero if lexing reported diagnostics.
+} TokenStream;
+
+/**
+ * @struct CacheEntry
+ * @brief Cached lexing results for a single source file.
+ *
+ * The token stream points into `source`, so the source buffer lives as long
+ * as the entry.
+ */
+typedef struct {
+    char *path;             ///< Canonical path of the file.
+    char *source;           ///< NUL-terminated contents of the file.
+    size_t sourceLength;    ///< Length of the contents in bytes.
+    int64_t mtimeSec, mtimeNsec; ///< Modification time when the file was read.
+    int64_t fileSize;       ///< File size when the file was read.
+    uint64_t hash;          ///< Content hash of `source`.
+    TokenStream stream;     ///< Lexed tokens of `source`.
+} CacheEntry;
+
+/**
+ * @struct TokenCache
+ * @brief Collection of cached files and the symbols they share.
+ *
+ * Entries are indexed by the interned symbol of their canonical path, so a
+ * lookup is one hash of the path rather than a scan over every file.
+ */
+typedef struct {
+    InternTable paths;      ///< Canonical paths, interned to entry indices.
+    InternTable symbols;    ///< Identifier spellings shared by every file.
+    CacheEntry **entries;   ///< Entries indexed by path symbol.
+    size_t capacity;
+    size_t hits, misses;    ///< Lookup statistics.
+    const DiagnosticSink *diagnostics; ///< Receives lexical errors, or NULL for stderr.
+} TokenCache;
+
+/**
+ * @brief Lexes a NUL-terminated source buffer into a token stream.
+ *
+ * Identifier tokens are interned into `symbols` as they are produced.
+ * Lexical errors are reported as they are found and recorded in the
+ * stream's `hasErrors` flag.
+ *
+ * @param source Pointer to the NUL-terminated source code.
+ * @param symbols Pointer to the intern table receiving identifier spellings.
+ * @param stream Pointer to the stream to fill.
+ * @param diagnostics Pointer to the sink that receives lexical errors, or NULL for stderr.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int tokenize(char *source, InternTable *symbols, TokenStream *stream, const DiagnosticSink *diagnostics);
+
+/**
+ * @brief Releases the arrays owned by a token stream.
+ *
+ * @param stream Pointer to the stream to free.
+ */
+void freeTokenStream(TokenStream *stream);
+
+/**
+ * @brief Initializes an empty token cache.
+ *
+ * @param cache Pointer to the token cache to initialize.
+ */
+void initTokenCache(TokenCache *cache);
+
+/**
+ * @brief Releases every entry, buffer, and symbol owned by the cache.
+ *
+ * @param cache Pointer to the token cache to free.
+ */
+void freeTokenCache(TokenCache *cache);
+
+/**
+ * @brief Returns the token stream of a file, lexing it only when needed.
+ *
+ * The cached entry is reused when the file's modification time and size are
+ * unchanged. When they differ the file is read again and its content hash is
+ * compared, so touching a file without editing it keeps the cached tokens.
+ * Files whose lexing reported errors are always lexed again, so their
+ * diagnostics reach the cache's sink on every request.
+ *
+ * @param cache Pointer to the token cache.
+ * @param path Path of the source file.
+ * @return const CacheEntry* The up-to-date entry, or NULL if the file could not be read.
+ */
+const CacheEntry *loadTokens(TokenCache *cache, const char *path);
+
+/**
+ * @brief Hashes a buffer with 64-bit FNV-1a.
+ *
+ * @param data Pointer to the bytes to hash.
+ * @param length Number of bytes to hash.
+ * @return uint64_t The hash of the buffer.
+ */
+uint64_t hashContents(const char *data, size_t length);
+
+#endif // CACHE_H
@@ -5,9 +5,10 @@
  * @file color.h
  * @brief Provides functions for setting text colors in the console.
  *
- * This header file defines the `set_color` function, which allows changing
- * the text color in the console output. It includes platform-specific 
- * implementations for Windows and ANSI escape codes for other systems.
+ * This header file declares the `set_color` function, which allows changing
+ * the text color in the console output on Windows, and defines ANSI escape
+ * codes for other systems. The Windows implementation lives in error.c, so
+ * including this header defines no objects.
  *
  * @author Codezz-ops <codezz-ops@obsidian.cc>
  * 
@@ -30,13 +31,6 @@ void set_color(int color);
 
 #ifdef _WIN32
     #include <windows.h>
-    HANDLE hConsole;
-    void set_color(int color) {
-        if (color < 0 || color > 0xFF) return;
-        hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-        SetConsoleTextAttribute(hConsole, (WORD)color);
-    }
-    
 #else
     #define LIGHT_GREEN   "\x1b[1;32m"
     #define LIGHT_YELLOW  "\x1b[1;33m"
@@ -15,6 +15,7 @@
  * @license BSD 3-Clause
  */
 
+#include <setjmp.h>
 #include <stddef.h>
 
 #define MAJOR_VERSION 0
@@ -71,4 +72,69 @@ void printWarningsHelp(void);
  */
 void systemInfo(char *output, size_t size);
 
+/**
+ * @brief Reads a whole file into a NUL-terminated buffer.
+ * 
+ * This function opens the file in binary mode, allocates a buffer large
+ * enough for its contents plus a terminating NUL, and reads it in one go.
+ * The caller owns the returned buffer and must free it.
+ * 
+ * @param path Path of the file to read.
+ * @param length Optional pointer that receives the number of bytes read.
+ * @return char* The file contents, or NULL if the file could not be read.
+ */
+char *readFile(const char *path, size_t *length);
+
+/**
+ * @brief Replaces a file's contents through a temporary file that is renamed over it.
+ * 
+ * The temporary file is created beside the file under a unique name, so a
+ * reader sees either the old or the new contents whole, and runs writing
+ * the same file at once do not collide. The file keeps its mode; a new one
+ * gets the default mode of the process.
+ * 
+ * @param path Path of the file to replace or create.
+ * @param data The new contents.
+ * @param size Number of bytes in `data`.
+ * @return int Returns 0 on success, or -1 on failure.
+ */
+int replaceFile(const char *path, const void *data, size_t size);
+
+/**
+ * @struct MemoryGuard
+ * @brief A point that a failed allocation returns to instead of ending the process.
+ *
+ * The function that owns the guard sets its jump with setjmp() and then
+ * installs it with pushMemoryGuard(). Guards nest, and each thread has its own.
+ */
+typedef struct MemoryGuard {
+    jmp_buf jump;
+    struct MemoryGuard *outer;
+} MemoryGuard;
+
+/**
+ * @brief Installs a guard as the innermost one of the calling thread.
+ * 
+ * @param guard Pointer to the guard, whose jump has been set with setjmp().
+ */
+void pushMemoryGuard(MemoryGuard *guard);
+
+/**
+ * @brief Removes the innermost guard of the calling thread.
+ * 
+ * @param guard Pointer to the guard, which must be the innermost one.
+ */
+void popMemoryGuard(MemoryGuard *guard);
+
+/**
+ * @brief Handles a failed allocation; does not return.
+ * 
+ * If the calling thread has a guard, it is removed and control returns to
+ * its setjmp() with the value 1. Otherwise an error is printed and the
+ * process exits, as it always has for the command-line compiler.
+ * 
+ * @param activity What was being done, such as "compiling", or NULL.
+ */
+void outOfMemory(const char *activity);
+
 #endif // COMMON_H
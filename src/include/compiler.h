@@ -0,0 +1,52 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+/**
+ * @file compiler.h
+ * @brief Defines the front end of the Obsidian compiler.
+ *
+ * This header file declares the single-pass compiler that checks the types
+ * of a parsed program and translates it into the SSA form described in
+ * ir.h, from which the optimizer and the code generators work.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "ast.h"
+#include "error.h"
+#include "intern.h"
+#include "ir.h"
+
+/**
+ * @brief Type-checks every function of a program and builds its SSA form.
+ *
+ * Function `i` of the program becomes function `i` of the module. Semantic
+ * errors (unknown names, mismatched types, wrong argument counts) are
+ * reported as they are found, and compilation continues with the next
+ * statement so that every independent error is shown. A function that is
+ * called but not defined is looked up in the program's interfaces, and the
+ * ones found there are appended to the module as external declarations.
+ *
+ * @param program Pointer to the parsed program.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param module Pointer to an initialized IR module that receives the functions.
+ * @param diagnostics Pointer to the sink that receives semantic errors, or NULL for stderr.
+ * @return int Returns 0 on success, 1 if any error was reported, or -1 if memory ran out.
+ */
+int compileProgram(const Program *program, const InternTable *names, IrModule *module,
+                   const DiagnosticSink *diagnostics);
+
+/**
+ * @brief Finds a function of a parsed program by name.
+ *
+ * @param program Pointer to the parsed program.
+ * @param names Pointer to the intern table holding the program's identifiers.
+ * @param name The function name to look up.
+ * @return int The function's index, or -1 if it is not defined.
+ */
+int findFunction(const Program *program, const InternTable *names, const char *name);
+
+#endif // COMPILER_H
@@ -0,0 +1,92 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/**
+ * @file daemon.h
+ * @brief Defines the persistent compiler daemon and its thin client.
+ *
+ * This header file declares the daemon mode, which keeps a warm compiler
+ * process listening on a Unix domain socket, and the client mode, which
+ * forwards one command line to the daemon instead of compiling in-process.
+ * The daemon keeps its keyword tables, interned symbols, and cached token
+ * streams across requests.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Environment variable that overrides the default socket path.
+ */
+#define DAEMON_SOCKET_ENV "OBSIDIAN_SOCKET"
+
+#define DAEMON_MAGIC 0x4f425344u        ///< "OBSD", first word of every request.
+#define DAEMON_MAX_REQUEST (1u << 20)   ///< Upper bound on a request payload.
+
+/**
+ * @struct RequestHeader
+ * @brief Fixed-size header that precedes every request payload.
+ *
+ * The header is sent together with the client's standard output and error
+ * descriptors. The payload that follows is the client's working directory
+ * and then each argument, all NUL-terminated. The daemon answers with the
+ * driver's exit status as a 32-bit integer.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+} RequestHeader;
+
+/**
+ * @brief Computes the socket path used by the daemon and its clients.
+ *
+ * The path comes from the OBSIDIAN_SOCKET environment variable when it is
+ * set, otherwise from XDG_RUNTIME_DIR, and finally falls back to a per-user
+ * directory in /tmp.
+ *
+ * @param output Pointer to the buffer where the path will be stored.
+ * @param size Size of the output buffer.
+ */
+void daemonSocketPath(char *output, size_t size);
+
+/**
+ * @brief Runs the compiler daemon until it is interrupted.
+ *
+ * Each request carries the client's working directory, its argument
+ * vector, and its standard output and error descriptors, so diagnostics are
+ * written straight to the client's terminal. The driver's exit status is
+ * sent back when the request finishes. Every connection is served by its own
+ * forked process, so requests run side by side.
+ *
+ * The socket is created with mode 0600 in a directory that must belong to
+ * the current user and be writable by no one else; the directory is created
+ * if it is missing. Connections from processes of other users are refused.
+ *
+ * @param socketPath Path of the Unix domain socket to listen on.
+ * @return int Returns EXIT_SUCCESS on a clean shutdown, or EXIT_FAILURE on error.
+ */
+int runDaemon(const char *socketPath);
+
+/**
+ * @brief Forwards a command line to a running daemon.
+ *
+ * A socket that is not owned by the current user, or that lies in a
+ * directory others can write to, is ignored with a warning, and so is a
+ * daemon that runs as another user. Once the request has been sent, it is
+ * never compiled again in-process: if the daemon fails before answering, an
+ * error is printed and the status is EXIT_FAILURE.
+ *
+ * @param socketPath Path of the daemon's Unix domain socket.
+ * @param argc The number of command-line arguments to forward.
+ * @param argv The command-line arguments to forward.
+ * @param status Pointer that receives the exit status of the remote compilation.
+ * @return int Returns 0 if the request was sent, or -1 if no daemon could be reached.
+ */
+int runClient(const char *socketPath, int argc, char *argv[], int *status);
+
+#endif // DAEMON_H
@@ -0,0 +1,50 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+/**
+ * @file driver.h
+ * @brief Defines the compiler driver for the Obsidian compiler.
+ *
+ * This header file declares the driver entry point, which interprets the
+ * command-line arguments of one compilation and runs the requested phases.
+ * The driver is shared by the standalone executable and the compiler daemon,
+ * which runs it once per forwarded request.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "cache.h"
+
+/**
+ * @brief Runs one compilation as described by its command-line arguments.
+ *
+ * This function handles the informational options (help and version), then
+ * loads the input file through the token cache and runs the compiler phases
+ * on it. It never calls exit, so it can be invoked repeatedly by a daemon.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of command-line argument strings.
+ * @param cache Pointer to the token cache used to load source files.
+ * @return int Returns EXIT_SUCCESS on success, or EXIT_FAILURE on error.
+ */
+int runCompiler(int argc, char *argv[], TokenCache *cache);
+
+/**
+ * @brief Parses and type-checks a loaded source file and builds its IR.
+ *
+ * Diagnostics are printed to stderr. The IR is discarded, so only the
+ * front end's verdict on the file remains, together with the interface file
+ * of a valid module that exports functions, which is written as `-c` would
+ * write it so that importers are checked against the module's current
+ * signatures.
+ *
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ * @param cache Pointer to the token cache that interned the file's identifiers.
+ * @return int Returns 0 if the file is valid, or -1 if any error was reported.
+ */
+int checkFile(const CacheEntry *entry, const TokenCache *cache);
+
+#endif // DRIVER_H
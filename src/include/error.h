@@ -7,7 +7,8 @@
  *
  * This header file provides the definitions for various error types that can occur 
  * during the compilation process, as well as functions for converting error types 
- * to strings and reporting errors.
+ * to strings and reporting errors. Errors are printed to stderr unless the phase
+ * that finds them was given a diagnostic sink, which receives them instead.
  * 
  * @author Codezz-ops <codezz-ops@obsidian.cc>
  * 
@@ -40,6 +41,45 @@ typedef enum {
  */
 const char* errorTypeToString(ErrorType type);
 
+/**
+ * @struct Diagnostic
+ * @brief A located error, as delivered to a diagnostic sink.
+ *
+ * The strings point into the message and source buffers and are only valid
+ * during the call that receives the diagnostic.
+ */
+typedef struct {
+    ErrorType type;
+    const char *message;
+    int line, column;
+    const char *text;           ///< Spelling of the token the error refers to.
+    int textLength;
+    const char *lineText;       ///< The source line holding the token, without its newline.
+    int lineLength;
+} Diagnostic;
+
+/**
+ * @struct DiagnosticSink
+ * @brief A callback that receives diagnostics instead of stderr.
+ *
+ * A sink whose `report` is NULL discards every diagnostic.
+ */
+typedef struct DiagnosticSink {
+    void (*report)(const Diagnostic *diagnostic, void *context);
+    void *context;
+} DiagnosticSink;
+
+/**
+ * @brief Reports an error to a sink, or prints it to stderr if there is none.
+ *
+ * @param sink Pointer to the sink that receives the error, or NULL for stderr.
+ * @param type The type of error being reported.
+ * @param message The error message to display.
+ * @param token Pointer to the token associated with the error.
+ * @return int Returns EXIT_FAILURE to indicate an error occurred.
+ */
+int reportError(const DiagnosticSink *sink, ErrorType type, const char *message, const Token *token);
+
 /**
  * @brief Reports an error with a specific message and token information.
  * 
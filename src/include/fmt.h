@@ -0,0 +1,36 @@
+#ifndef FMT_H
+#define FMT_H
+
+/**
+ * @file fmt.h
+ * @brief Defines the `obsidian fmt` command.
+ *
+ * This header file declares the command that formats source files in
+ * place, or with `--check` only verifies that they are formatted.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+/**
+ * @brief Formats the files named on the command line.
+ *
+ * Each argument is a source file or a directory, which stands for every
+ * `.ob` file below it; with no arguments the current directory is used.
+ * Files are formatted in parallel by one thread per processor unless
+ * `-j N` asks for a different number. Under a parallel `make` with a
+ * jobserver, that number only caps the threads: each one after the first
+ * is started when a job token is free. A file is only rewritten if its
+ * formatting changes. With `--check` no file is written: the first file
+ * found to be unformatted is reported and the command stops.
+ *
+ * @param argc The number of arguments after `fmt`.
+ * @param argv The arguments after `fmt`.
+ * @return int Returns EXIT_SUCCESS if every file is formatted, or
+ *             EXIT_FAILURE on an error or, with `--check`, a difference.
+ */
+int runFmt(int argc, char *argv[]);
+
+#endif // FMT_H
@@ -0,0 +1,42 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+/**
+ * @file format.h
+ * @brief Defines the source formatter of the Obsidian programming language.
+ *
+ * This header file declares the formatter behind `obsidian fmt`. It works
+ * directly on the token stream, with comments kept as tokens, and never
+ * builds a syntax tree, so it can format files that do not type-check.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "error.h"
+#include "writer.h"
+
+#define FORMAT_INDENT 4             ///< Columns of indentation per open brace.
+#define FORMAT_CONTINUATION 8       ///< Extra columns of indentation on a wrapped line.
+#define FORMAT_LINE_WIDTH 100       ///< Column past which lines are wrapped.
+
+/**
+ * @brief Formats a source file.
+ *
+ * Statements go on lines of their own, indented by brace depth. Operators
+ * are spaced by whether they are unary or binary. A line longer than
+ * FORMAT_LINE_WIDTH is wrapped after a comma or binary operator. Single
+ * blank lines between statements and all comments are kept. Formatting
+ * its own output leaves a file unchanged.
+ *
+ * @param source Pointer to the NUL-terminated source code.
+ * @param diagnostics Receives lexical errors; NULL prints them.
+ * @param writer Pointer to the writer that receives the formatted source.
+ * @return int Returns 0 on success, 1 if the source has lexical errors, in
+ *             which case the output is incomplete, or -1 if memory could not be allocated.
+ */
+int formatSource(char *source, const DiagnosticSink *diagnostics, Writer *writer);
+
+#endif // FORMAT_H
@@ -0,0 +1,120 @@
+#ifndef INTERFACE_H
+#define INTERFACE_H
+
+/**
+ * @file interface.h
+ * @brief Defines the binary module interface files of the Obsidian compiler.
+ *
+ * This header file declares the writer and reader of `.obi` files, which
+ * describe the exported functions of a compiled module so that a module that
+ * imports it never reads its source. The file is a fixed header followed by
+ * a table of functions sorted by name, their parameter types, and their
+ * names. A reader maps the file and only validates the header when opening
+ * it; a function's entry is read when the importer first calls it, which
+ * makes importing a large module cost as much as the functions used from it.
+ * Values are stored in the byte order of the host.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+#include "ir.h"
+
+#define INTERFACE_MAGIC 0x4649424fu     ///< "OBIF", first word of every interface file.
+#define INTERFACE_VERSION 1u            ///< Bumped whenever the layout or TypeKind changes.
+#define INTERFACE_EXTENSION ".obi"
+
+/**
+ * @struct InterfaceHeader
+ * @brief The header at the start of an interface file.
+ */
+typedef struct {
+    uint32_t magic, version;
+    uint64_t hash;              ///< FNV-1a hash of everything after the header.
+    uint32_t functionCount;
+    uint32_t typesOffset;       ///< File offset of the parameter type table.
+    uint32_t namesOffset;       ///< File offset of the name table.
+    uint32_t size;              ///< Size of the whole file.
+} InterfaceHeader;
+
+/**
+ * @struct InterfaceEntry
+ * @brief One exported function in the table that follows the header.
+ */
+typedef struct {
+    uint32_t nameOffset, nameLength;    ///< Slice of the name table.
+    uint32_t typesOffset;               ///< First parameter type in the type table.
+    uint16_t paramCount;
+    uint8_t returnType;
+    uint8_t reserved;
+} InterfaceEntry;
+
+/**
+ * @struct ModuleInterface
+ * @brief An interface file opened for reading.
+ */
+typedef struct ModuleInterface {
+    const unsigned char *data;
+    size_t size;
+    int mapped;                 ///< Whether `data` is a mapping rather than a heap copy.
+} ModuleInterface;
+
+/**
+ * @struct InterfaceFunction
+ * @brief The signature of a function found in an interface.
+ */
+typedef struct {
+    TypeKind returnType;
+    int paramCount;
+    const uint8_t *paramTypes;  ///< One TypeKind per parameter, pointing into the interface.
+} InterfaceFunction;
+
+/**
+ * @brief Writes the interface of a module's exported functions.
+ *
+ * Functions the module imports itself are left out. An existing file with
+ * the same contents is left untouched, so that its modification time only
+ * changes along with the interface. A changed interface is written to a
+ * temporary file that is then renamed over the old one, so importers that
+ * read the file meanwhile see it either whole or not at all.
+ *
+ * @param module Pointer to the IR module.
+ * @param path The file to create.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int writeInterface(const IrModule *module, const char *path);
+
+/**
+ * @brief Opens an interface file.
+ *
+ * @param interfaceFile Pointer to the interface to fill.
+ * @param path The file to open.
+ * @return int Returns 0 on success, -1 if the file could not be read, or 1
+ *             if it is not an interface file of this version.
+ */
+int openInterface(ModuleInterface *interfaceFile, const char *path);
+
+/**
+ * @brief Closes an interface file.
+ *
+ * @param interfaceFile Pointer to the interface to close.
+ */
+void closeInterface(ModuleInterface *interfaceFile);
+
+/**
+ * @brief Finds an exported function of an interface by name.
+ *
+ * @param interfaceFile Pointer to the interface.
+ * @param name The name of the function; it need not be NUL-terminated.
+ * @param length The length of the name.
+ * @param function Pointer that receives the function's signature.
+ * @return int Returns 0 if the function was found, or -1 if it is missing or its entry is malformed.
+ */
+int findInterfaceFunction(const ModuleInterface *interfaceFile, const char *name, size_t length, InterfaceFunction *function);
+
+#endif // INTERFACE_H
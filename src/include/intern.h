@@ -0,0 +1,88 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+/**
+ * @file intern.h
+ * @brief Defines the symbol interning table for the Obsidian compiler.
+ *
+ * This header file declares the intern table, which maps identifier spellings
+ * to small integer symbol IDs. Once a name has been interned, later phases can
+ * compare and hash symbols as integers instead of strings.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Symbol ID returned for names that are not present in the table.
+ */
+#define SYMBOL_NONE 0u
+
+/**
+ * @struct InternTable
+ * @brief Open-addressed hash table of interned identifier spellings.
+ *
+ * Every distinct spelling is copied once into the table and assigned a
+ * symbol ID starting at 1. The slot array stores symbol IDs and is always
+ * a power of two in size so probing can use a mask.
+ */
+typedef struct {
+    char **names;       ///< Interned spellings, indexed by symbol ID.
+    size_t *lengths;    ///< Length of each interned spelling.
+    uint32_t *hashes;   ///< Cached hash of each interned spelling.
+    uint32_t *slots;    ///< Open-addressed slots holding symbol IDs.
+    size_t count, capacity, slotCount;
+} InternTable;
+
+/**
+ * @brief Initializes an empty intern table.
+ *
+ * @param table Pointer to the intern table to initialize.
+ */
+void initInternTable(InternTable *table);
+
+/**
+ * @brief Releases every spelling and array owned by the intern table.
+ *
+ * @param table Pointer to the intern table to free.
+ */
+void freeInternTable(InternTable *table);
+
+/**
+ * @brief Interns a spelling and returns its symbol ID.
+ *
+ * If the spelling is already present its existing ID is returned, otherwise
+ * the spelling is copied into the table and assigned the next free ID.
+ *
+ * @param table Pointer to the intern table.
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @return uint32_t The symbol ID, or SYMBOL_NONE if memory could not be allocated.
+ */
+uint32_t internSymbol(InternTable *table, const char *start, size_t length);
+
+/**
+ * @brief Looks up a spelling without inserting it.
+ *
+ * @param table Pointer to the intern table.
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @return uint32_t The symbol ID, or SYMBOL_NONE if the spelling was never interned.
+ */
+uint32_t findSymbol(const InternTable *table, const char *start, size_t length);
+
+/**
+ * @brief Returns the spelling of an interned symbol.
+ *
+ * @param table Pointer to the intern table.
+ * @param symbol The symbol ID to look up.
+ * @return const char* The NUL-terminated spelling, or NULL for an unknown ID.
+ */
+const char *symbolName(const InternTable *table, uint32_t symbol);
+
+#endif // INTERN_H
@@ -0,0 +1,395 @@
+#ifndef IR_H
+#define IR_H
+
+/**
+ * @file ir.h
+ * @brief Defines the SSA intermediate representation of the Obsidian compiler.
+ *
+ * This header file describes the mid-level IR that sits between the type
+ * checker and the code generators. Every instruction defines at most one
+ * value, identified by its index in the function's instruction array, and
+ * every value is assigned exactly once. Control flow is a graph of basic
+ * blocks that each end in a single terminator; values that merge at a join
+ * point are selected by phi instructions at the start of the join block.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stdio.h>
+#include "arena.h"
+#include "ast.h"
+#include "vm.h"
+
+/**
+ * @brief List of every IR opcode, expanded with an X-macro.
+ *
+ * Comparisons and conversions record the type of their operands in
+ * `operandType`; every other instruction operates on values of its own
+ * result type. There is no greater-than: the builder swaps the operands.
+ */
+#define IR_OPCODES(X) \
+    X(NOP)     /* deleted instruction                          */ \
+    X(CONST)   /* constant value                               */ \
+    X(PARAM)   /* incoming parameter `index`                   */ \
+    X(COPY)    /* value of its single operand                  */ \
+    X(PHI)     /* one operand per predecessor, in pred order   */ \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) \
+    X(AND) X(OR) X(XOR) X(SHL) X(SHR) \
+    X(NEG) X(BNOT) X(NOT) \
+    X(EQ) X(NE) X(LT) X(LE) \
+    X(CONV)    /* convert from operandType to type             */ \
+    X(CALL)    /* call function `index` with the operands      */ \
+    X(PRINT)   /* print the operand as a value of operandType  */ \
+    X(JUMP)    /* continue at targets[0]                       */ \
+    X(BRANCH)  /* operand ? targets[0] : targets[1]            */ \
+    X(RET)     /* return the operand, if any                   */
+
+#define IR_OPCODE_ENUM(name) IR_##name,
+
+/**
+ * @enum IrOp
+ * @brief Enumeration of IR opcodes.
+ */
+typedef enum {
+    IR_OPCODES(IR_OPCODE_ENUM)
+    IR_OP_COUNT
+} IrOp;
+
+#define IR_NONE (-1)    ///< Absent value or block.
+
+/**
+ * @struct IrInsn
+ * @brief A single SSA instruction.
+ *
+ * Operands are value indices stored in the function's operand pool, so an
+ * instruction is a fixed-size record regardless of its operand count.
+ */
+typedef struct {
+    IrOp op;
+    TypeKind type;          ///< Type of the result, or TypeVoid.
+    TypeKind operandType;   ///< Operand type of comparisons, conversions, and prints.
+    int block;              ///< Owning block, or IR_NONE once deleted.
+    int argStart, argCount; ///< Operand slice of the function's operand pool.
+    union {
+        Slot constant;      ///< Value of IR_CONST.
+        int index;          ///< Parameter of IR_PARAM, callee of IR_CALL.
+        int targets[2];     ///< Successors of IR_JUMP and IR_BRANCH.
+    } as;
+} IrInsn;
+
+/**
+ * @struct IrBlock
+ * @brief A basic block: phis first, then ordinary instructions, then one terminator.
+ */
+typedef struct {
+    int *insns;
+    int insnCount, insnCapacity;
+    int *preds;
+    int predCount, predCapacity;
+    int idom;               ///< Immediate dominator, valid after irComputeDominators.
+    int order;              ///< Reverse postorder index, or IR_NONE if unreachable.
+} IrBlock;
+
+/**
+ * @struct IrFunction
+ * @brief A function in SSA form. Block 0 is the entry block.
+ */
+typedef struct {
+    const char *name;
+    TypeKind returnType;
+    int paramCount;
+    TypeKind *paramTypes;   ///< Type of each parameter, stored in the module's arena.
+    int exported;
+    int external;           ///< Declared by an imported module's interface; has no blocks.
+    IrInsn *insns;
+    int insnCount, insnCapacity;
+    int *operands;
+    int operandCount, operandCapacity;
+    IrBlock *blocks;
+    int blockCount, blockCapacity;
+} IrFunction;
+
+/**
+ * @struct IrModule
+ * @brief The IR of a whole program. Function `i` is function `i` of the program.
+ *
+ * Functions called from imported modules follow the program's own, as
+ * external declarations.
+ *
+ * String constants, function names, and parameter types are stored in the
+ * module's arena.
+ */
+typedef struct {
+    IrFunction *functions;
+    int functionCount, functionCapacity;
+    Arena strings;
+} IrModule;
+
+/**
+ * @brief Initializes an empty IR module.
+ *
+ * @param module Pointer to the module to initialize.
+ */
+void initIrModule(IrModule *module);
+
+/**
+ * @brief Releases every function and string owned by the module.
+ *
+ * @param module Pointer to the module to free.
+ */
+void freeIrModule(IrModule *module);
+
+/**
+ * @brief Adds an empty function to the module.
+ *
+ * @param module Pointer to the module.
+ * @param name Name of the function; copied into the module.
+ * @return int Index of the new function, or -1 if memory could not be allocated.
+ */
+int addIrFunction(IrModule *module, const char *name);
+
+/**
+ * @brief Appends a new, empty block to a function.
+ *
+ * @param fn Pointer to the function.
+ * @return int Index of the new block.
+ */
+int irNewBlock(IrFunction *fn);
+
+/**
+ * @brief Creates an instruction and appends it to a block.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that receives the instruction.
+ * @param op The opcode.
+ * @param type The result type, or TypeVoid.
+ * @param args The operand values; may be NULL if `argCount` is 0.
+ * @param argCount The number of operands.
+ * @return int The new instruction's value index.
+ */
+int irAppend(IrFunction *fn, int block, IrOp op, TypeKind type, const int *args, int argCount);
+
+/**
+ * @brief Creates an instruction and inserts it into a block at a position.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that receives the instruction.
+ * @param position Index in the block's instruction list.
+ * @param op The opcode.
+ * @param type The result type, or TypeVoid.
+ * @param args The operand values; may be NULL if `argCount` is 0.
+ * @param argCount The number of operands.
+ * @return int The new instruction's value index.
+ */
+int irInsert(IrFunction *fn, int block, int position, IrOp op, TypeKind type, const int *args, int argCount);
+
+/**
+ * @brief Moves an existing instruction into a block at a position.
+ *
+ * The instruction stays in its old block's list until the next irCompact,
+ * which drops entries whose instruction now belongs to another block.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to move.
+ * @param block The block that receives the instruction.
+ * @param position Index in the block's instruction list.
+ */
+void irMove(IrFunction *fn, int value, int block, int position);
+
+/**
+ * @brief Replaces the operands of an instruction.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to update.
+ * @param args The new operand values.
+ * @param argCount The number of operands.
+ */
+void irSetArgs(IrFunction *fn, int value, const int *args, int argCount);
+
+/**
+ * @brief Returns the operands of an instruction.
+ *
+ * The pointer is invalidated by any call that adds operands to the function.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int* The instruction's operand slice.
+ */
+int *irArgs(const IrFunction *fn, int value);
+
+/**
+ * @brief Records `pred` as a predecessor of `block`.
+ *
+ * @param fn Pointer to the function.
+ * @param block The successor block.
+ * @param pred The predecessor block.
+ */
+void irAddPred(IrFunction *fn, int block, int pred);
+
+/**
+ * @brief Removes the edge from `pred` to `block`, dropping the matching phi operands.
+ *
+ * @param fn Pointer to the function.
+ * @param block The successor block.
+ * @param pred The predecessor block.
+ */
+void irRemovePred(IrFunction *fn, int block, int pred);
+
+/**
+ * @brief Returns the terminator of a block, or IR_NONE if the block is open.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block.
+ * @return int The value index of the terminator.
+ */
+int irTerminator(const IrFunction *fn, int block);
+
+/**
+ * @brief Returns the successors of a block.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block.
+ * @param succ Array that receives up to two successor blocks.
+ * @return int The number of successors.
+ */
+int irSuccessors(const IrFunction *fn, int block, int succ[2]);
+
+/**
+ * @brief Marks an instruction deleted; irCompact later drops it from its block.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to delete.
+ */
+void irDelete(IrFunction *fn, int value);
+
+/**
+ * @brief Removes deleted instructions from every block's instruction list.
+ *
+ * @param fn Pointer to the function.
+ */
+void irCompact(IrFunction *fn);
+
+/**
+ * @brief Reports whether an instruction has no side effects and cannot trap.
+ *
+ * Pure instructions may be removed when unused, merged with an identical
+ * instruction, or moved to any point where their operands are available.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int Non-zero if the instruction is pure.
+ */
+int irIsPure(const IrFunction *fn, int value);
+
+/**
+ * @brief Reports whether an instruction may be implemented as a call.
+ *
+ * Native code generators print values and compute floating-point
+ * remainders through the C library, so these count as calls too.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int Non-zero if the instruction clobbers caller-saved registers.
+ */
+int irIsCall(const IrFunction *fn, int value);
+
+/**
+ * @brief Numbers the reachable blocks in reverse postorder.
+ *
+ * Sets the `order` field of every block.
+ *
+ * @param fn Pointer to the function.
+ * @param rpo Array of at least `blockCount` entries that receives the order.
+ * @return int The number of reachable blocks.
+ */
+int irComputeOrder(IrFunction *fn, int *rpo);
+
+/**
+ * @brief Computes the immediate dominator of every reachable block.
+ *
+ * @param fn Pointer to the function.
+ * @param rpo The reverse postorder computed by irComputeOrder.
+ * @param count The number of reachable blocks.
+ */
+void irComputeDominators(IrFunction *fn, const int *rpo, int count);
+
+/**
+ * @brief Reports whether block `a` dominates block `b`.
+ *
+ * @param fn Pointer to the function with computed dominators.
+ * @param a The candidate dominator.
+ * @param b The dominated block.
+ * @return int Non-zero if every path from the entry to `b` passes through `a`.
+ */
+int irDominates(const IrFunction *fn, int a, int b);
+
+/**
+ * @brief Deletes every block that cannot be reached from the entry block.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if any block was removed.
+ */
+int irRemoveUnreachable(IrFunction *fn);
+
+/**
+ * @brief Inserts an empty block on the edge from a branch to one of its targets.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that ends in the branch.
+ * @param which The index of the target whose edge is split, 0 or 1.
+ * @return int The new block, which jumps to the original target.
+ */
+int irSplitEdge(IrFunction *fn, int block, int which);
+
+/**
+ * @brief Splits every edge that leaves a branch and enters a block with phis.
+ *
+ * Afterwards the moves that implement a phi can be placed at the end of the
+ * predecessor without affecting the other successor of a branch.
+ *
+ * @param fn Pointer to the function.
+ */
+void irSplitEdges(IrFunction *fn);
+
+/**
+ * @brief Rewrites every operand through a replacement map.
+ *
+ * `forward[v]` is the value that replaces `v`, or IR_NONE to keep `v`.
+ * Chains of replacements are followed to their end.
+ *
+ * @param fn Pointer to the function.
+ * @param forward The replacement map, indexed by value.
+ */
+void irReplaceValues(IrFunction *fn, int *forward);
+
+/**
+ * @brief Counts the live instructions of a function.
+ *
+ * @param fn Pointer to the function.
+ * @return int The number of instructions that are not deleted.
+ */
+int irSize(const IrFunction *fn);
+
+/**
+ * @brief Writes a readable listing of a function.
+ *
+ * An external function is listed as a one-line declaration.
+ *
+ * @param out The stream to write to.
+ * @param module Pointer to the module, used to name callees.
+ * @param fn Pointer to the function.
+ */
+void irPrintFunction(FILE *out, const IrModule *module, const IrFunction *fn);
+
+/**
+ * @brief Returns the name of an IR opcode.
+ *
+ * @param op The opcode.
+ * @return const char* The opcode's lowercase name.
+ */
+const char *irOpName(IrOp op);
+
+#endif // IR_H
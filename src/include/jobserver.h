@@ -0,0 +1,68 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+/**
+ * @file jobserver.h
+ * @brief Defines the client side of the GNU make jobserver.
+ *
+ * This header file declares the functions that let the compiler share the
+ * job slots of a parallel `make`. Make hands out one token per slot through
+ * a pipe or a named fifo, which it names in `MAKEFLAGS` as
+ * `--jobserver-auth=R,W` or `--jobserver-auth=fifo:PATH`. A process started
+ * by make already holds one implicit slot; every further thread it runs must
+ * read a token first and write the same byte back once it is done.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+/**
+ * @struct JobServer
+ * @brief A connection to the jobserver of the make that started the process.
+ */
+typedef struct {
+    int readFd, writeFd;    ///< Both -1 when there is no jobserver.
+    int ownsRead;           ///< Whether `readFd` was opened here rather than inherited.
+    int nonBlocking;        ///< Whether reading `readFd` returns at once when no token is free.
+} JobServer;
+
+/**
+ * @brief Connects to the jobserver named in make's flags.
+ *
+ * The last `--jobserver-auth=` (or older `--jobserver-fds=`) option wins.
+ * Inherited descriptors that are not open, which happens when make did not
+ * consider the command recursive, count as no jobserver.
+ *
+ * @param server Pointer to the connection to initialize.
+ * @param makeflags The value of `MAKEFLAGS`, or NULL.
+ * @return int Returns 1 if a jobserver is available, or 0 if there is none.
+ */
+int openJobServer(JobServer *server, const char *makeflags);
+
+/**
+ * @brief Takes a job token if one is free, without waiting.
+ *
+ * @param server Pointer to an open connection.
+ * @param token Receives the byte that must be handed back.
+ * @return int Returns 1 if a token was taken, or 0 if none is free or there is no jobserver.
+ */
+int tryAcquireJobToken(JobServer *server, char *token);
+
+/**
+ * @brief Hands a job token back to the jobserver.
+ *
+ * @param server Pointer to the connection the token came from.
+ * @param token The byte returned by tryAcquireJobToken().
+ */
+void releaseJobToken(JobServer *server, char token);
+
+/**
+ * @brief Closes the descriptors opened by openJobServer().
+ *
+ * @param server Pointer to the connection to close.
+ */
+void closeJobServer(JobServer *server);
+
+#endif // JOBSERVER_H
@@ -25,7 +25,7 @@
 #include <stddef.h>
 
 typedef enum {
-    TLparen, TRparen, TLbrace, TRbrace, TLbracket, TRbracket, TPlus, TMinus, TStar, TSlash, TDot, TColon, TSemi, TComma, TNot, TGreater, TLess, TCarot, TPercent, TAssign, TAmpersand, TPipe, TQuestion, TXorNot, TPower, TLogicalOr, TLogicalAnd, TPlusAssign, TMinusAssign, TStarAssign, TSlashAssign, TEqual, TNotEqual, TGreaterEqual, TLessEqual, TDecrement, TIncrement, TXor, TLeftShift, TRightShift, TI8, TI16, TI32, TI64, TU8, TU16, TU32, TU64, TF32, TF64, TString, TChar, TBool, TVoid, TConst, TFn, TIf, TElse, TSwitch, TCase, TDefault, TWhile, TFor, TReturn, TStruct, TEnum, TNew, TNull, TTrue, TFalse, TAlloc, TDealloc, TUnsafe, TSizeof, TPrivate, TTypeof, TImport, TExport, TCast, TPrintln, TLength, TBreak, TEof, TError, TIntLiteral, TFloatLiteral, TBoolLiteral, TStringLiteral, TCharLiteral, TIdentifier, TReturnType, TUnknown
+    TLparen, TRparen, TLbrace, TRbrace, TLbracket, TRbracket, TPlus, TMinus, TStar, TSlash, TDot, TColon, TSemi, TComma, TNot, TGreater, TLess, TCarot, TPercent, TAssign, TAmpersand, TPipe, TQuestion, TXorNot, TPower, TLogicalOr, TLogicalAnd, TPlusAssign, TMinusAssign, TStarAssign, TSlashAssign, TEqual, TNotEqual, TGreaterEqual, TLessEqual, TDecrement, TIncrement, TXor, TLeftShift, TRightShift, TI8, TI16, TI32, TI64, TU8, TU16, TU32, TU64, TF32, TF64, TString, TChar, TBool, TVoid, TConst, TFn, TIf, TElse, TSwitch, TCase, TDefault, TWhile, TFor, TReturn, TStruct, TEnum, TNew, TNull, TTrue, TFalse, TAlloc, TDealloc, TUnsafe, TSizeof, TPrivate, TTypeof, TImport, TExport, TCast, TPrintln, TLength, TBreak, TEof, TError, TIntLiteral, TFloatLiteral, TBoolLiteral, TStringLiteral, TCharLiteral, TIdentifier, TReturnType, TComment, TUnknown
 } TokenKind;
 
 /**
@@ -52,6 +52,8 @@ typedef struct {
 typedef struct {
     char *start, *current;
     int line, column;
+    int keepComments;                           ///< Return `//` comments as TComment tokens instead of skipping them.
+    const struct DiagnosticSink *diagnostics;   ///< Receives lexical errors; NULL prints them.
 } Lexer;
 
 /**
@@ -91,7 +93,9 @@ Token getNextToken(Lexer *lexer);
  * @brief Skips whitespace and comments in the source code.
  * 
  * This function advances the lexer's current position, skipping over
- * any whitespace characters or comments found in the source code.
+ * any whitespace characters or comments found in the source code. A
+ * comment runs from `//` to the end of the line; it is left in place
+ * when the lexer keeps comments.
  * 
  * @param lexer Pointer to the lexer instance.
  */
@@ -109,19 +113,12 @@ void skipWhitespace(Lexer *lexer);
  */
 int compareKeywords(const void *a, const void *b);
 
-/**
- * @brief Sorts the keywords array if it hasn't been sorted yet.
- * 
- * This function sorts the array of keyword entries to prepare for
- * binary search operations.
- */
-void sortKeywords(void);
-
 /**
  * @brief Checks if a given string is a keyword.
  * 
  * This function compares the provided string against a list of known
- * keywords and returns the corresponding token type.
+ * keywords and returns the corresponding token type. The list is constant,
+ * so the lookup is safe to run from several threads at once.
  * 
  * @param start Pointer to the start of the keyword string.
  * @param length Length of the keyword string.
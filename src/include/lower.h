@@ -0,0 +1,35 @@
+#ifndef LOWER_H
+#define LOWER_H
+
+/**
+ * @file lower.h
+ * @brief Defines the translation of the IR into bytecode for the virtual machine.
+ *
+ * This header file declares the bytecode generator. SSA values are mapped to
+ * virtual machine registers by the linear-scan allocator, phis become moves
+ * on the incoming edges, and blocks are laid out so that most jumps fall
+ * through.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "ir.h"
+#include "vm.h"
+
+/**
+ * @brief Generates bytecode for every function of an IR module.
+ *
+ * Function `i` of the IR module becomes function `i` of the bytecode
+ * module, which is prepared for execution on success. The IR is edited in
+ * place: unreachable blocks are removed and critical edges are split.
+ *
+ * @param ir Pointer to the IR module.
+ * @param module Pointer to an initialized module that receives the bytecode.
+ * @return int Returns 0 on success, or -1 if a function cannot be encoded or is external.
+ */
+int lowerModule(IrModule *ir, Module *module);
+
+#endif // LOWER_H
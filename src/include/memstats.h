@@ -0,0 +1,104 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+/**
+ * @file memstats.h
+ * @brief Defines the memory accounting of the Obsidian compiler.
+ *
+ * This header file declares process-wide counters of the bytes held by each
+ * subsystem that grows with the size of its input, together with the peak
+ * resident set size reported by the operating system. The counters are
+ * updated where memory is allocated and released, so a request served by
+ * the daemon also counts the token streams the daemon keeps between requests.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @enum MemCategory
+ * @brief Enumeration of the subsystems whose memory is accounted.
+ */
+typedef enum {
+    MEM_SOURCE,         ///< Source file buffers.
+    MEM_TOKENS,         ///< Token and symbol arrays of token streams.
+    MEM_SYMBOLS,        ///< Intern tables and their spellings.
+    MEM_ARENAS,         ///< Arena chunks holding syntax trees and IR strings.
+    MEM_CATEGORY_COUNT
+} MemCategory;
+
+/**
+ * @struct MemStats
+ * @brief A snapshot of the memory counters.
+ */
+typedef struct {
+    size_t current[MEM_CATEGORY_COUNT];     ///< Bytes held now.
+    size_t peak[MEM_CATEGORY_COUNT];        ///< Most bytes held at once.
+    size_t totalCurrent, totalPeak;         ///< The same over every category.
+    size_t sourceBytes;                     ///< Bytes of source lexed.
+    size_t tokens;                          ///< Tokens produced by lexing them.
+    size_t diagnostics;                     ///< Diagnostics reported.
+    size_t diagnosticBytes;                 ///< Bytes of message and source line they quoted.
+    long long peakResident;                 ///< Peak resident set size in bytes, or -1 if unknown.
+} MemStats;
+
+/**
+ * @brief Records memory taken by a subsystem.
+ *
+ * @param category The subsystem that holds the memory.
+ * @param bytes The number of bytes allocated.
+ */
+void memAcquire(MemCategory category, size_t bytes);
+
+/**
+ * @brief Records memory given back by a subsystem.
+ *
+ * @param category The subsystem that held the memory.
+ * @param bytes The number of bytes freed.
+ */
+void memRelease(MemCategory category, size_t bytes);
+
+/**
+ * @brief Records that a source buffer was lexed.
+ *
+ * @param sourceBytes The length of the source in bytes.
+ * @param tokens The number of tokens it produced.
+ */
+void memNoteLexed(size_t sourceBytes, size_t tokens);
+
+/**
+ * @brief Records that a diagnostic was reported.
+ *
+ * @param bytes The size of its message and quoted source line.
+ */
+void memNoteDiagnostic(size_t bytes);
+
+/**
+ * @brief Takes a snapshot of the counters and the peak resident set size.
+ *
+ * @param stats Pointer to the snapshot to fill.
+ */
+void getMemStats(MemStats *stats);
+
+/**
+ * @brief Writes a snapshot as a table.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the snapshot.
+ */
+void printMemReport(FILE *out, const MemStats *stats);
+
+/**
+ * @brief Writes a snapshot as a JSON object.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the snapshot.
+ */
+void printMemJson(FILE *out, const MemStats *stats);
+
+#endif // MEMSTATS_H
@@ -0,0 +1,149 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+/**
+ * @file object.h
+ * @brief Defines the ELF64 relocatable object writer of the Obsidian compiler.
+ *
+ * This header file declares an in-memory object file for x86-64: a code
+ * section, a read-only data section, symbols, and the relocations the
+ * linker must apply to the code. The native backend fills it directly with
+ * machine code, so `-c` needs no assembler, and writeObjectFile() lays out
+ * the whole file in memory and writes it at once.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBJECT_TEXT 0           ///< Section index of the code.
+#define OBJECT_RODATA 1         ///< Section index of the read-only data.
+#define OBJECT_UNDEFINED (-1)   ///< Section of a symbol defined in another object.
+
+#define OBJECT_SECTION_SYMBOL(section) (-1 - (section))    ///< Symbol standing for the start of a section.
+
+#define R_X86_64_PC32 2         ///< 32-bit PC-relative reference.
+#define R_X86_64_PLT32 4        ///< 32-bit PC-relative call, through the PLT if need be.
+
+/**
+ * @struct ObjectSection
+ * @brief A growing block of section contents.
+ */
+typedef struct {
+    unsigned char *data;
+    size_t size, capacity;
+} ObjectSection;
+
+/**
+ * @struct ObjectSymbol
+ * @brief A symbol of the object file.
+ */
+typedef struct {
+    uint32_t name;          ///< Offset of the name in the string table.
+    int section;            ///< OBJECT_TEXT, OBJECT_RODATA, or OBJECT_UNDEFINED.
+    uint64_t value, size;
+    int global;
+} ObjectSymbol;
+
+/**
+ * @struct ObjectRelocation
+ * @brief A reference in the code that the linker resolves.
+ */
+typedef struct {
+    uint64_t offset;        ///< Position of the field in the code section.
+    int symbol;             ///< Index returned by addObjectSymbol(), or OBJECT_SECTION_SYMBOL().
+    uint32_t type;
+    int64_t addend;
+} ObjectRelocation;
+
+/**
+ * @struct ObjectFile
+ * @brief An x86-64 ELF relocatable object under construction.
+ */
+typedef struct {
+    ObjectSection sections[2];  ///< Indexed by OBJECT_TEXT and OBJECT_RODATA.
+    ObjectSection strings;      ///< The symbol string table.
+    ObjectSymbol *symbols;
+    int symbolCount, symbolCapacity;
+    ObjectRelocation *relocations;
+    int relocationCount, relocationCapacity;
+} ObjectFile;
+
+/**
+ * @brief Initializes an empty object file.
+ *
+ * @param object Pointer to the object file to initialize.
+ */
+void initObjectFile(ObjectFile *object);
+
+/**
+ * @brief Frees the memory owned by an object file.
+ *
+ * @param object Pointer to the object file to free.
+ */
+void freeObjectFile(ObjectFile *object);
+
+/**
+ * @brief Appends bytes to a section.
+ *
+ * Like the rest of the compiler, this calls outOfMemory() if memory runs out.
+ *
+ * @param section Pointer to the section.
+ * @param data Pointer to the bytes to append.
+ * @param size Number of bytes to append.
+ */
+void appendObjectBytes(ObjectSection *section, const void *data, size_t size);
+
+/**
+ * @brief Pads a section to a multiple of an alignment.
+ *
+ * @param section Pointer to the section.
+ * @param alignment The alignment, a power of two.
+ * @param fill The byte to pad with.
+ */
+void alignObjectSection(ObjectSection *section, size_t alignment, unsigned char fill);
+
+/**
+ * @brief Adds a symbol.
+ *
+ * Symbols defined in the code section are typed as functions.
+ *
+ * @param object Pointer to the object file.
+ * @param name The name of the symbol.
+ * @param section The section that defines it, or OBJECT_UNDEFINED.
+ * @param value Offset of the symbol in its section.
+ * @param size Size of what the symbol names.
+ * @param global Whether the symbol is visible to other objects; undefined symbols always are.
+ * @return int The index of the symbol.
+ */
+int addObjectSymbol(ObjectFile *object, const char *name, int section, uint64_t value, uint64_t size, int global);
+
+/**
+ * @brief Adds a relocation to the code section.
+ *
+ * @param object Pointer to the object file.
+ * @param offset Position of the 32-bit field in the code section.
+ * @param symbol The symbol referred to.
+ * @param type The relocation type, such as R_X86_64_PC32.
+ * @param addend The value added to the symbol's address.
+ * @return int The index of the relocation, whose addend may still be changed.
+ */
+int addObjectRelocation(ObjectFile *object, uint64_t offset, int symbol, uint32_t type, int64_t addend);
+
+/**
+ * @brief Writes an object file.
+ *
+ * The sections, symbol table, string tables, relocations, and section
+ * headers are assembled in memory and written with a single write.
+ *
+ * @param object Pointer to the object file.
+ * @param path The file to create.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int writeObjectFile(const ObjectFile *object, const char *path);
+
+#endif // OBJECT_H
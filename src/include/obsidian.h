@@ -0,0 +1,159 @@
+#ifndef OBSIDIAN_H
+#define OBSIDIAN_H
+
+/**
+ * @file obsidian.h
+ * @brief Declares the public C interface of the libobsidian library.
+ *
+ * This header file is the only one an embedding program needs. A session
+ * holds the settings and the interned identifiers of a series of
+ * compilations, and delivers every diagnostic to a callback instead of
+ * printing it. The library keeps no mutable state of its own outside its
+ * sessions, so distinct sessions may be used from different threads at the
+ * same time. A single session must not be used by two threads at once.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct ObsidianSession
+ * @brief An opaque compilation session.
+ */
+typedef struct ObsidianSession ObsidianSession;
+
+/**
+ * @enum ObsidianDiagnosticKind
+ * @brief Enumeration of the phases that report diagnostics.
+ */
+typedef enum {
+    OBSIDIAN_LEXICAL_ERROR,
+    OBSIDIAN_SYNTAX_ERROR,
+    OBSIDIAN_SEMANTIC_ERROR
+} ObsidianDiagnosticKind;
+
+/**
+ * @struct ObsidianDiagnostic
+ * @brief A located error in a source buffer.
+ *
+ * The strings are only valid during the call to the handler that receives
+ * the diagnostic; `text` and `lineText` are not NUL-terminated.
+ */
+typedef struct {
+    ObsidianDiagnosticKind kind;
+    const char *file;           ///< The name the source was compiled under.
+    const char *message;
+    int line, column;
+    const char *text;           ///< Spelling of the token the error refers to.
+    size_t textLength;
+    const char *lineText;       ///< The source line holding the token, without its newline.
+    size_t lineLength;
+} ObsidianDiagnostic;
+
+/**
+ * @brief A callback that receives the diagnostics of a session.
+ *
+ * @param diagnostic Pointer to the diagnostic.
+ * @param userData The pointer given to obsidianSetDiagnosticHandler.
+ */
+typedef void (*ObsidianDiagnosticHandler)(const ObsidianDiagnostic *diagnostic, void *userData);
+
+/**
+ * @brief Returns the version of the library as a "major.minor.patch" string.
+ */
+const char *obsidianVersion(void);
+
+/**
+ * @brief Creates a session with no diagnostic handler and optimization level 0.
+ *
+ * @return ObsidianSession* The new session, or NULL if memory could not be allocated.
+ */
+ObsidianSession *obsidianCreateSession(void);
+
+/**
+ * @brief Destroys a session and everything it holds.
+ *
+ * @param session Pointer to the session, or NULL.
+ */
+void obsidianDestroySession(ObsidianSession *session);
+
+/**
+ * @brief Sets the callback that receives the diagnostics of a session.
+ *
+ * Diagnostics are discarded while no handler is set.
+ *
+ * @param session Pointer to the session.
+ * @param handler The callback, or NULL to discard diagnostics.
+ * @param userData A pointer passed to every call of the handler.
+ */
+void obsidianSetDiagnosticHandler(ObsidianSession *session, ObsidianDiagnosticHandler handler, void *userData);
+
+/**
+ * @brief Sets the optimization level used by obsidianCompileToAssembly.
+ *
+ * @param session Pointer to the session.
+ * @param level The level, from 0 to 3; higher levels are clamped to 3.
+ */
+void obsidianSetOptimizationLevel(ObsidianSession *session, int level);
+
+/**
+ * @brief Sets the directory in which the interfaces of imported modules are looked up.
+ *
+ * The interface of module `name` is `name.obi` in the directory, written by
+ * the command-line compiler when it compiles the module. Until a directory
+ * is set, a source that imports a module is rejected with a diagnostic.
+ *
+ * @param session Pointer to the session.
+ * @param directory The directory, or NULL to reject imports.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int obsidianSetImportDirectory(ObsidianSession *session, const char *directory);
+
+/**
+ * @brief Lexes, parses and type-checks a source buffer.
+ *
+ * @param session Pointer to the session.
+ * @param name The name reported with diagnostics, or NULL.
+ * @param source Pointer to the source code, which need not be NUL-terminated.
+ * @param length Length of the source in bytes.
+ * @return int Returns 0 if the source is valid, 1 if diagnostics were reported,
+ *             or -1 if memory could not be allocated.
+ */
+int obsidianCheck(ObsidianSession *session, const char *name, const char *source, size_t length);
+
+/**
+ * @brief Compiles a source buffer to x86-64 assembly in AT&T syntax.
+ *
+ * @param session Pointer to the session.
+ * @param name The name reported with diagnostics, or NULL.
+ * @param source Pointer to the source code, which need not be NUL-terminated.
+ * @param length Length of the source in bytes.
+ * @param assembly Pointer that receives the NUL-terminated assembly, to be
+ *                 released with obsidianFree, or NULL on failure.
+ * @param size Pointer that receives the length of the assembly, or NULL.
+ * @return int Returns 0 on success, 1 if diagnostics were reported, or -1 if
+ *             memory could not be allocated.
+ */
+int obsidianCompileToAssembly(ObsidianSession *session, const char *name, const char *source, size_t length,
+                              char **assembly, size_t *size);
+
+/**
+ * @brief Releases memory returned by the library.
+ *
+ * @param memory Pointer to the memory, or NULL.
+ */
+void obsidianFree(void *memory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OBSIDIAN_H
@@ -0,0 +1,87 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+/**
+ * @file parser.h
+ * @brief Defines the parser for the Obsidian programming language.
+ *
+ * This header file declares the recursive-descent parser, which turns a
+ * token stream into the abstract syntax tree described in ast.h. All nodes
+ * are allocated from the arena supplied by the caller.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "arena.h"
+#include "ast.h"
+#include "cache.h"
+
+/**
+ * @struct Parser
+ * @brief Represents the parser state.
+ *
+ * The parser walks an already lexed token stream, so lookahead is a simple
+ * index into the token array. With `lazyBodies` set, function bodies are
+ * skipped by matching braces and only their token ranges are kept; the
+ * stream and arena must then outlive the program, since a body can be
+ * parsed later with parseFunctionBody().
+ */
+typedef struct {
+    const Token *tokens;
+    const uint32_t *symbols;
+    size_t count, current;
+    Arena *arena;
+    const struct DiagnosticSink *diagnostics;   ///< Receives syntax errors; NULL prints them.
+    int hadError, panicMode;
+    int lazyBodies;     ///< Skip function bodies instead of parsing them.
+} Parser;
+
+/**
+ * @brief Initializes the parser over a token stream.
+ *
+ * @param parser Pointer to the parser instance to initialize.
+ * @param stream Pointer to the token stream to parse.
+ * @param arena Pointer to the arena that receives every node.
+ */
+void initParser(Parser *parser, const TokenStream *stream, Arena *arena);
+
+/**
+ * @brief Parses every top-level declaration of the token stream.
+ *
+ * Syntax errors are reported as they are found; the parser then skips to
+ * the next statement boundary and continues, so one run reports as many
+ * independent errors as possible.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param program Pointer to the program that receives the declarations.
+ * @return int Returns 0 on success, 1 if any syntax error was reported, or -1
+ *             if memory ran out, in which case the program is left empty.
+ */
+int parseProgram(Parser *parser, Program *program);
+
+/**
+ * @brief Parses the body of a function whose body was skipped.
+ *
+ * Syntax errors in the body are reported as if the whole file had been
+ * parsed. A body that was already parsed is left as it is.
+ *
+ * @param parser Pointer to the parser that parsed the program.
+ * @param fn Pointer to the declaration whose body to parse.
+ * @return int Returns 0 on success, 1 if a syntax error was reported in the
+ *             body, or -1 if memory ran out.
+ */
+int parseFunctionBody(Parser *parser, FnDecl *fn);
+
+/**
+ * @brief Parses every body of a program that was skipped.
+ *
+ * @param parser Pointer to the parser that parsed the program.
+ * @param program Pointer to the program.
+ * @return int Returns 0 on success, 1 if any body had a syntax error, or -1 if memory ran out.
+ */
+int parseFunctionBodies(Parser *parser, Program *program);
+
+#endif // PARSER_H
@@ -0,0 +1,154 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+/**
+ * @file passes.h
+ * @brief Defines the IR optimization passes and the pass manager of the Obsidian compiler.
+ *
+ * This header file declares the scalar optimizations that run on the SSA IR
+ * and the pipelines selected by `-O0` through `-O3`. Every pass reports
+ * whether it changed the function, and the pass manager records how often
+ * each pass ran and how long it took so `--time-passes` can show where the
+ * optimizer spends its time.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stdio.h>
+#include "ir.h"
+
+#define OPT_LEVEL_MAX 3     ///< Highest accepted `-O` level.
+
+/**
+ * @brief List of every optimization pass, expanded with an X-macro.
+ */
+#define OPT_PASSES(X) \
+    X(INLINE, "inline") \
+    X(COPYPROP, "copy-propagation") \
+    X(CONSTFOLD, "constant-folding") \
+    X(GVN, "gvn") \
+    X(LICM, "licm") \
+    X(DCE, "dce")
+
+#define OPT_PASS_ENUM(name, text) PASS_##name,
+
+/**
+ * @enum PassKind
+ * @brief Enumeration of optimization passes.
+ */
+typedef enum {
+    OPT_PASSES(OPT_PASS_ENUM)
+    PASS_COUNT
+} PassKind;
+
+/**
+ * @struct PassStats
+ * @brief Accumulated cost and effect of every pass over a compilation.
+ */
+typedef struct {
+    double seconds[PASS_COUNT];     ///< Wall time spent in each pass.
+    int runs[PASS_COUNT];           ///< Number of times each pass ran on a function.
+    int changes[PASS_COUNT];        ///< Number of runs that changed the function.
+    int sizeBefore, sizeAfter;      ///< Total instruction count before and after optimization.
+} PassStats;
+
+/**
+ * @brief Replaces copies with their source and removes trivial phis.
+ *
+ * A phi is trivial when all of its operands, other than the phi itself,
+ * are the same value.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int propagateCopies(IrFunction *fn);
+
+/**
+ * @brief Evaluates instructions whose operands are constants.
+ *
+ * Folding follows the VM's semantics exactly: integer arithmetic wraps and
+ * is narrowed to its type, and divisions that would trap are left alone.
+ * Algebraic identities such as `x + 0` become copies, branches on a
+ * constant become jumps, which may leave blocks unreachable, and a block
+ * that is the only successor of its only predecessor is merged into it.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int foldConstants(IrFunction *fn);
+
+/**
+ * @brief Removes instructions whose results are never used and that have no side effects.
+ *
+ * Unreachable blocks are removed first, so their uses keep nothing alive.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int eliminateDeadCode(IrFunction *fn);
+
+/**
+ * @brief Replaces every pure instruction with an identical dominating one.
+ *
+ * Values are numbered in a preorder walk of the dominator tree, so a value
+ * is only ever replaced by one that is available on every path to it.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int numberValues(IrFunction *fn);
+
+/**
+ * @brief Moves pure instructions whose operands are defined outside a loop to its preheader.
+ *
+ * Inner loops are processed first, so an invariant of a nest moves out one
+ * level at a time. Loops without a unique preheader are skipped.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int hoistInvariants(IrFunction *fn);
+
+/**
+ * @brief Inlines calls to small functions that do not call anything themselves.
+ *
+ * @param module Pointer to the module that holds the callees.
+ * @param fn Pointer to the calling function.
+ * @param limit Largest callee, in instructions, that is inlined.
+ * @return int Non-zero if the function changed.
+ */
+int inlineCalls(IrModule *module, IrFunction *fn, int limit);
+
+/**
+ * @brief Runs the pipeline of an optimization level on every function of a module.
+ *
+ * Level 0 leaves the module untouched. Level 1 runs the cheap cleanups,
+ * level 2 adds inlining, value numbering, and loop-invariant code motion,
+ * and level 3 inlines larger functions and iterates the scalar pipeline.
+ *
+ * @param module Pointer to the module.
+ * @param level The optimization level, from 0 to OPT_LEVEL_MAX.
+ * @param stats Pointer to the statistics to accumulate into; may be NULL.
+ */
+void optimizeModule(IrModule *module, int level, PassStats *stats);
+
+/**
+ * @brief Writes a table of the time spent in each pass.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the accumulated statistics.
+ */
+void printPassStats(FILE *out, const PassStats *stats);
+
+/**
+ * @brief Returns the name of an optimization pass.
+ *
+ * @param pass The pass.
+ * @return const char* The pass's name as shown by `--time-passes`.
+ */
+const char *passName(PassKind pass);
+
+#endif // PASSES_H
@@ -0,0 +1,133 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+/**
+ * @file regalloc.h
+ * @brief Defines liveness analysis and linear-scan register allocation over the IR.
+ *
+ * This header file declares the register allocator shared by the code
+ * generators. Blocks are laid out in reverse postorder and every value gets
+ * a single live interval spanning all the positions where it is live; the
+ * allocator then walks the intervals in order of their start and assigns
+ * each one a register of its class, or a spill slot when none is free.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stdint.h>
+#include "ir.h"
+
+#define LOCATION_NONE (-1)                          ///< The value has no result or is never defined.
+#define LOCATION_SPILL(slot) (-2 - (slot))          ///< Encodes a spill slot as a location.
+#define IS_SPILLED(location) ((location) <= -2)     ///< Tests whether a location is a spill slot.
+#define SPILL_SLOT(location) (-2 - (location))      ///< Decodes the spill slot of a location.
+
+#define REGISTER_CLASSES 2      ///< Register classes, e.g. integer and floating point.
+
+/**
+ * @struct LiveIntervals
+ * @brief The block layout of a function and the live interval of each value.
+ *
+ * Every block occupies an even-numbered start position, one position per
+ * non-phi instruction, and an end position at which phi moves into its
+ * successors take place. Phis are defined at the start of their block.
+ *
+ * A phi and those of its operands it does not interfere with are coalesced
+ * into one group that shares a single interval, so the moves between them
+ * disappear. Only the leader of a group is allocated. Parameters are never
+ * coalesced, so a code generator may pin them to their incoming registers.
+ */
+typedef struct {
+    int *layout;            ///< Reachable blocks in emission order.
+    int layoutCount;
+    int *blockStart;        ///< Start position of each block, indexed by block.
+    int *blockEnd;          ///< End position of each block, indexed by block.
+    int *start;             ///< First live position of each value, or -1.
+    int *end;               ///< Last live position of each value, or -1.
+    int *leader;            ///< Group leader whose interval and location each value shares.
+    int *calls;             ///< Positions of instructions that count as calls, in increasing order.
+    int callCount;
+} LiveIntervals;
+
+/**
+ * @struct RegisterFile
+ * @brief Describes the registers available to the allocator.
+ */
+typedef struct {
+    int registerCounts[REGISTER_CLASSES];   ///< Allocatable registers in each class.
+    uint32_t callerSaved[REGISTER_CLASSES]; ///< Registers of the first 32 that calls clobber.
+    int (*classOf)(TypeKind type);          ///< Maps a value type to its register class.
+} RegisterFile;
+
+/**
+ * @struct Allocation
+ * @brief The location chosen for every value of a function.
+ */
+typedef struct {
+    int *location;                          ///< Register index, spill location, or LOCATION_NONE.
+    int spillCount;                         ///< Number of spill slots used.
+    int registersUsed[REGISTER_CLASSES];    ///< One past the highest register used in each class.
+    uint32_t usedMask[REGISTER_CLASSES];    ///< Registers of the first 32 used in each class.
+} Allocation;
+
+/**
+ * @brief Lays out the blocks of a function and computes live intervals.
+ *
+ * Critical edges into blocks with phis must already have been split.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the intervals to fill in.
+ */
+void computeLiveIntervals(IrFunction *fn, LiveIntervals *live);
+
+/**
+ * @brief Releases the arrays of a set of live intervals.
+ *
+ * @param live Pointer to the intervals to free.
+ */
+void freeLiveIntervals(LiveIntervals *live);
+
+/**
+ * @brief Assigns a location to every value of a function.
+ *
+ * Values whose interval spans a call are kept out of caller-saved
+ * registers, and every value receives the location of its group leader.
+ * `fixed`, if not NULL, pins values to registers; pinned values must start
+ * before every unpinned value of the same class.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the function's live intervals.
+ * @param file Pointer to the description of the available registers.
+ * @param fixed Register of each pinned value, or -1; may be NULL.
+ * @param allocation Pointer to the allocation to fill in.
+ */
+void allocateRegisters(const IrFunction *fn, const LiveIntervals *live, const RegisterFile *file, const int *fixed, Allocation *allocation);
+
+/**
+ * @brief Releases the arrays of an allocation.
+ *
+ * @param allocation Pointer to the allocation to free.
+ */
+void freeAllocation(Allocation *allocation);
+
+/**
+ * @brief Threads jumps through blocks that would only contain a jump.
+ *
+ * Such blocks are mostly left behind by edge splitting when the phis of the
+ * target needed no moves after all. A jump to one of them can go straight
+ * to the block it forwards to, and the block itself need not be emitted.
+ * The entry block always stays, and a cycle of empty blocks is kept as is.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the function's live intervals.
+ * @param allocation Pointer to the function's allocation.
+ * @param target Array of `blockCount` entries that receives, for each block,
+ *               the block a jump to it lands on; a block is emitted only if
+ *               it lands on itself.
+ */
+void threadJumps(const IrFunction *fn, const LiveIntervals *live, const Allocation *allocation, int *target);
+
+#endif // REGALLOC_H
@@ -0,0 +1,69 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+/**
+ * @file runtime.h
+ * @brief Declares the memory allocator of the Obsidian runtime library.
+ *
+ * This header file declares the functions behind the language's `alloc`,
+ * `new` and `dealloc`, which compiled programs reach by linking against
+ * libobsidian-rt. Small requests are served from per-thread pools of
+ * equally sized blocks; larger ones are mapped directly. Memory may be
+ * released by a different thread from the one that allocated it.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RUNTIME_SLAB_SIZE ((size_t)1 << 20)     ///< Size and alignment of the pages that pools are carved from.
+#define RUNTIME_MAX_SMALL ((size_t)64 << 10)    ///< Largest request served from a pool.
+#define RUNTIME_ALIGNMENT 16                    ///< Alignment of every block returned.
+
+/**
+ * @brief Allocates memory, backing the language's `alloc`.
+ *
+ * @param size The number of bytes needed; 0 still returns a unique block.
+ * @return void* Pointer to uninitialized memory aligned to RUNTIME_ALIGNMENT,
+ *               or NULL if no memory is available.
+ */
+void *obsidianAlloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory, backing the language's `new`.
+ *
+ * @param size The number of bytes needed.
+ * @return void* Pointer to zeroed memory, or NULL if no memory is available.
+ */
+void *obsidianNew(size_t size);
+
+/**
+ * @brief Releases memory, backing the language's `dealloc`.
+ *
+ * Memory released by a thread other than the one that allocated it is
+ * collected in small batches that are handed back to the owning pool together.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew(), or NULL.
+ */
+void obsidianDealloc(void *pointer);
+
+/**
+ * @brief Returns the number of bytes usable in an allocated block.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew().
+ * @return size_t The usable size, which is at least the size requested.
+ */
+size_t obsidianAllocSize(const void *pointer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RUNTIME_H
@@ -0,0 +1,105 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+/**
+ * @file scope.h
+ * @brief Defines the scoped symbol table used by semantic analysis.
+ *
+ * This header file declares a stack of lexical scopes kept in a single
+ * arena. Each scope is a small open-addressed table keyed by interned
+ * symbol ID, so declaring and resolving a name never touches its spelling.
+ * Entering a scope takes an arena mark and leaving it resets the arena to
+ * that mark, which releases the scope's table in constant time.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stdint.h>
+#include "arena.h"
+
+/**
+ * @struct ScopeEntry
+ * @brief A name declared in a scope and the value bound to it.
+ */
+typedef struct {
+    uint32_t name;          ///< Symbol ID, or SYMBOL_NONE for an empty slot.
+    int value;
+} ScopeEntry;
+
+/**
+ * @struct Scope
+ * @brief One lexical scope, allocated from the stack's arena.
+ */
+typedef struct Scope {
+    struct Scope *parent;   ///< The enclosing scope, or NULL for the outermost one.
+    ArenaMark mark;         ///< Arena position before the scope was entered.
+    ScopeEntry *slots;      ///< Open-addressed table; its size is a power of two.
+    uint32_t mask, count;
+} Scope;
+
+/**
+ * @struct ScopeStack
+ * @brief The scopes that enclose the point being analyzed.
+ */
+typedef struct {
+    Arena arena;
+    Scope *innermost;       ///< The scope declarations go to, or NULL if none is open.
+    int depth;
+} ScopeStack;
+
+/**
+ * @brief Initializes an empty scope stack.
+ *
+ * @param stack Pointer to the scope stack to initialize.
+ */
+void initScopeStack(ScopeStack *stack);
+
+/**
+ * @brief Releases the memory of every scope.
+ *
+ * @param stack Pointer to the scope stack to free.
+ */
+void freeScopeStack(ScopeStack *stack);
+
+/**
+ * @brief Enters a new innermost scope.
+ *
+ * @param stack Pointer to the scope stack.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int pushScope(ScopeStack *stack);
+
+/**
+ * @brief Leaves the innermost scope, forgetting every name declared in it.
+ *
+ * @param stack Pointer to the scope stack.
+ */
+void popScope(ScopeStack *stack);
+
+/**
+ * @brief Declares a name in the innermost scope.
+ *
+ * A name that is already declared in the innermost scope is rebound to the
+ * new value.
+ *
+ * @param stack Pointer to the scope stack, which must have a scope open.
+ * @param name The symbol ID of the name.
+ * @param value The value bound to the name.
+ * @return int Returns 0 on success, 1 if the name was already declared in
+ *             the innermost scope, or -1 if memory could not be allocated.
+ */
+int declareSymbol(ScopeStack *stack, uint32_t name, int value);
+
+/**
+ * @brief Resolves a name through the innermost scope outwards.
+ *
+ * @param stack Pointer to the scope stack.
+ * @param name The symbol ID of the name.
+ * @return int The value bound by the innermost declaration, or -1 if the name is not in scope.
+ */
+int lookupSymbol(const ScopeStack *stack, uint32_t name);
+
+#endif // SCOPE_H
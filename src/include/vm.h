@@ -0,0 +1,256 @@
+#ifndef VM_H
+#define VM_H
+
+/**
+ * @file vm.h
+ * @brief Defines the register-based bytecode virtual machine for the Obsidian language.
+ *
+ * This header file describes the bytecode format, the compiled function and
+ * module containers, and the interpreter entry points. Instructions are 32-bit
+ * words operating on unboxed 64-bit register slots; every arithmetic opcode is
+ * specialized for the type of its operands, so the interpreter never inspects
+ * a value's type at run time.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "ast.h"
+
+/**
+ * @brief List of every opcode, expanded with an X-macro.
+ *
+ * Operand layouts: ABC uses three 8-bit register operands, ABx uses one
+ * register and a 16-bit unsigned operand, AsBx uses a 16-bit signed offset.
+ * Jump offsets are relative to the instruction after the jump.
+ */
+#define VM_OPCODES(X) \
+    X(MOVE)    /* A B      R(A) = R(B)                          */ \
+    X(LOADK)   /* A Bx     R(A) = K(Bx)                         */ \
+    X(ADD_I32) X(SUB_I32) X(MUL_I32) X(DIV_I32) X(MOD_I32) X(DIV_U32) X(MOD_U32) \
+    X(ADD_I64) X(SUB_I64) X(MUL_I64) X(DIV_I64) X(MOD_I64) X(DIV_U64) X(MOD_U64) \
+    X(ADD_F32) X(SUB_F32) X(MUL_F32) X(DIV_F32) X(MOD_F32) \
+    X(ADD_F64) X(SUB_F64) X(MUL_F64) X(DIV_F64) X(MOD_F64) \
+    X(AND_I32) X(OR_I32) X(XOR_I32) X(SHL_I32) X(SHR_I32) X(SHR_U32) \
+    X(AND_I64) X(OR_I64) X(XOR_I64) X(SHL_I64) X(SHR_I64) X(SHR_U64) \
+    X(NEG_I32) X(NEG_I64) X(NEG_F32) X(NEG_F64) X(BNOT_I32) X(BNOT_I64) X(NOT) \
+    X(EQ_I32) X(NE_I32) X(LT_I32) X(LE_I32) X(LT_U32) X(LE_U32) \
+    X(EQ_I64) X(NE_I64) X(LT_I64) X(LE_I64) X(LT_U64) X(LE_U64) \
+    X(EQ_F32) X(NE_F32) X(LT_F32) X(LE_F32) \
+    X(EQ_F64) X(NE_F64) X(LT_F64) X(LE_F64) \
+    X(CONV)    /* A B C    R(A) = convert R(B) from C>>4 to C&15 */ \
+    X(JMP)     /* sBx      pc += sBx                            */ \
+    X(JMPF)    /* A sBx    if !R(A) then pc += sBx              */ \
+    X(JMPT)    /* A sBx    if R(A) then pc += sBx               */ \
+    X(CALL)    /* A Bx     R(A) = F(Bx)(R(A), R(A+1), ...)      */ \
+    X(RET)     /* A        return R(A)                          */ \
+    X(RETV)    /*          return                               */ \
+    X(PRINT)   /* A B      print R(A) as a value of type B      */
+
+#define VM_OPCODE_ENUM(name) OP_##name,
+
+/**
+ * @enum OpCode
+ * @brief Enumeration of bytecode opcodes.
+ */
+typedef enum {
+    VM_OPCODES(VM_OPCODE_ENUM)
+    OP_COUNT
+} OpCode;
+
+#define INSN_ABC(op, a, b, c) ((uint32_t)(op) | ((uint32_t)(a) << 8) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 24))
+#define INSN_ABX(op, a, bx) ((uint32_t)(op) | ((uint32_t)(a) << 8) | ((uint32_t)(bx) << 16))
+#define INSN_ASBX(op, a, sbx) INSN_ABX(op, a, (uint32_t)((sbx) + INSN_SBX_BIAS))
+#define INSN_OP(i) ((i) & 0xffu)
+#define INSN_A(i) (((i) >> 8) & 0xffu)
+#define INSN_B(i) (((i) >> 16) & 0xffu)
+#define INSN_C(i) ((i) >> 24)
+#define INSN_BX(i) ((i) >> 16)
+#define INSN_SBX(i) ((int32_t)INSN_BX(i) - INSN_SBX_BIAS)
+#define INSN_SBX_BIAS 32767
+#define INSN_MAX_BX 65535
+
+#define VM_MAX_REGISTERS 256            ///< Registers addressable by one function.
+#define VM_STACK_SLOTS (1 << 20)        ///< Register slots shared by every frame.
+#define VM_MAX_FRAMES (1 << 16)         ///< Maximum call depth.
+
+/**
+ * @union Slot
+ * @brief An unboxed register value.
+ *
+ * Signed integers up to 32 bits live in `i32`, unsigned ones in `u32`,
+ * bools and chars in `u32`, and 64-bit values in their own fields.
+ */
+typedef union {
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+    float f32;
+    double f64;
+    const char *str;
+} Slot;
+
+/**
+ * @struct ThreadedInsn
+ * @brief An instruction paired with the address of its handler.
+ *
+ * When the interpreter is built with computed goto, dispatch jumps straight
+ * to `handler` instead of looking the opcode up in a table.
+ */
+typedef struct {
+    const void *handler;
+    uint32_t insn;
+} ThreadedInsn;
+
+/**
+ * @struct Function
+ * @brief A compiled function: its bytecode, constants, and frame size.
+ */
+typedef struct {
+    const char *name;
+    uint32_t *code;
+    int codeCount, codeCapacity;
+    Slot *constants;
+    int constantCount, constantCapacity;
+    int paramCount, registerCount;
+    TypeKind returnType;
+    ThreadedInsn *threaded;
+} Function;
+
+/**
+ * @struct Module
+ * @brief The compiled functions of a program.
+ *
+ * String constants and function names are stored in the module's arena.
+ */
+typedef struct {
+    Function *functions;
+    int functionCount, functionCapacity;
+    Arena strings;
+} Module;
+
+/**
+ * @struct CallFrame
+ * @brief The saved state of a caller while a callee runs.
+ */
+typedef struct {
+    Function *function;
+    ThreadedInsn *ip;
+    Slot *base;
+} CallFrame;
+
+/**
+ * @struct VM
+ * @brief The interpreter state: one contiguous register stack and its frames.
+ *
+ * A callee's registers start at the register holding its first argument,
+ * so arguments are passed without copying.
+ */
+typedef struct {
+    Slot *stack, *stackEnd;
+    CallFrame *frames;
+    int frameCount;
+} VM;
+
+/**
+ * @brief Initializes an empty module.
+ *
+ * @param module Pointer to the module to initialize.
+ */
+void initModule(Module *module);
+
+/**
+ * @brief Releases every function and string owned by the module.
+ *
+ * @param module Pointer to the module to free.
+ */
+void freeModule(Module *module);
+
+/**
+ * @brief Adds an empty function to the module.
+ *
+ * @param module Pointer to the module.
+ * @param name Name of the function; copied into the module.
+ * @return int Index of the new function, or -1 if memory could not be allocated.
+ */
+int addFunction(Module *module, const char *name);
+
+/**
+ * @brief Appends an instruction to a function.
+ *
+ * @param function Pointer to the function.
+ * @param insn The encoded instruction.
+ * @return int Index of the instruction, or -1 if memory could not be allocated.
+ */
+int emitInsn(Function *function, uint32_t insn);
+
+/**
+ * @brief Adds a constant to a function, reusing an identical one if present.
+ *
+ * @param function Pointer to the function.
+ * @param value The constant value.
+ * @return int Index of the constant, or -1 if memory could not be allocated.
+ */
+int addConstant(Function *function, Slot value);
+
+/**
+ * @brief Converts a value between two types with the VM's conversion rules.
+ *
+ * Narrowing follows two's complement truncation and float-to-integer
+ * conversion truncates toward zero, exactly as the CONV instruction does.
+ *
+ * @param value The source value.
+ * @param from The source type.
+ * @param to The destination type.
+ * @return Slot The converted value.
+ */
+Slot convertValue(Slot value, TypeKind from, TypeKind to);
+
+/**
+ * @brief Prepares every function of the module for execution.
+ *
+ * This builds the threaded form of each function's bytecode. It must be
+ * called once after code generation and before vmCall.
+ *
+ * @param module Pointer to the module.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int prepareModule(Module *module);
+
+/**
+ * @brief Initializes the interpreter and allocates its register stack.
+ *
+ * @param vm Pointer to the VM to initialize.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int initVM(VM *vm);
+
+/**
+ * @brief Releases the interpreter's register stack and frames.
+ *
+ * @param vm Pointer to the VM to free.
+ */
+void freeVM(VM *vm);
+
+/**
+ * @brief Calls a function of a prepared module.
+ *
+ * Runtime errors such as division by zero or stack overflow are reported
+ * to stderr and abort the call.
+ *
+ * @param vm Pointer to the VM.
+ * @param module Pointer to the prepared module.
+ * @param function Index of the function to call.
+ * @param args Argument values, one per parameter.
+ * @param result Pointer that receives the return value; may be NULL.
+ * @return int Returns 0 on success, or -1 on a runtime error.
+ */
+int vmCall(VM *vm, Module *module, int function, const Slot *args, Slot *result);
+
+#endif // VM_H
@@ -0,0 +1,39 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+/**
+ * @file watch.h
+ * @brief Defines the watch mode of the Obsidian compiler.
+ *
+ * This header file declares the loop behind `obsidian --watch`, which checks
+ * every source file under a directory and then rechecks only the files that
+ * change, for as long as it runs.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#define WATCH_DEBOUNCE_MS 50    ///< Quiet time that ends a burst of file events.
+
+/**
+ * @brief Checks the sources under a directory and rechecks them as they change.
+ *
+ * Every `.ob` file below the directory is checked once at startup. After
+ * that the loop waits for the file system to report writes, renames and
+ * deletions, collects them until no event has arrived for
+ * WATCH_DEBOUNCE_MS milliseconds, and checks just the files that changed.
+ * A valid module gets its interface file written, and when that changes
+ * the interface, the files importing the module are checked again in the
+ * same round; modules are checked before their importers. Diagnostics are
+ * printed for the checked files only. Token streams of unchanged files stay
+ * in memory between rounds. New subdirectories are watched as they appear.
+ * The loop runs until it is interrupted.
+ *
+ * @param directory The directory to watch.
+ * @return int Returns EXIT_SUCCESS when interrupted, or EXIT_FAILURE on error.
+ */
+int runWatch(const char *directory);
+
+#endif // WATCH_H
@@ -0,0 +1,107 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+/**
+ * @file writer.h
+ * @brief Defines the buffered output writer used by the code generators.
+ *
+ * This header file declares a small writer that collects output in a fixed
+ * buffer and hands it to the underlying stream in large blocks. Numbers are
+ * formatted by hand, so emitting an instruction costs a few copies instead
+ * of a trip through the stdio format machinery. A writer without a stream
+ * collects its output in memory instead.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define WRITER_BUFFER_SIZE (64 * 1024)  ///< Bytes collected before each flush.
+
+/**
+ * @struct Writer
+ * @brief A buffered writer over a stdio stream or a growing memory block.
+ */
+typedef struct {
+    FILE *file;             ///< The stream, or NULL to write to memory.
+    char *memory;           ///< Output drained so far when writing to memory.
+    size_t memorySize, memoryCapacity;
+    size_t used;
+    int failed;             ///< Set once a write to the stream has failed.
+    char buffer[WRITER_BUFFER_SIZE];
+} Writer;
+
+/**
+ * @brief Initializes a writer over a stream.
+ *
+ * @param writer Pointer to the writer to initialize.
+ * @param file The stream that receives the output, or NULL to collect it in memory.
+ */
+void initWriter(Writer *writer, FILE *file);
+
+/**
+ * @brief Appends raw bytes.
+ *
+ * @param writer Pointer to the writer.
+ * @param data Pointer to the bytes to write.
+ * @param size Number of bytes to write.
+ */
+void writeBytes(Writer *writer, const void *data, size_t size);
+
+/**
+ * @brief Appends a NUL-terminated string.
+ *
+ * @param writer Pointer to the writer.
+ * @param text The string to write.
+ */
+void writeString(Writer *writer, const char *text);
+
+/**
+ * @brief Appends a single character.
+ *
+ * @param writer Pointer to the writer.
+ * @param c The character to write.
+ */
+void writeChar(Writer *writer, char c);
+
+/**
+ * @brief Appends a signed integer in decimal.
+ *
+ * @param writer Pointer to the writer.
+ * @param value The integer to write.
+ */
+void writeInt(Writer *writer, int64_t value);
+
+/**
+ * @brief Appends an unsigned integer in decimal.
+ *
+ * @param writer Pointer to the writer.
+ * @param value The integer to write.
+ */
+void writeUnsigned(Writer *writer, uint64_t value);
+
+/**
+ * @brief Writes the buffered output to the stream and flushes it.
+ *
+ * @param writer Pointer to the writer.
+ * @return int Returns 0 on success, or -1 if any write has failed.
+ */
+int flushWriter(Writer *writer);
+
+/**
+ * @brief Takes the output collected by a writer without a stream.
+ *
+ * The writer is left empty and may be reused.
+ *
+ * @param writer Pointer to the writer.
+ * @param size Pointer that receives the length of the output, excluding its NUL terminator.
+ * @return char* The NUL-terminated output, to be released with free(), or NULL if any write has failed.
+ */
+char *takeWriterMemory(Writer *writer, size_t *size);
+
+#endif // WRITER_H
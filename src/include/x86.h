@@ -0,0 +1,52 @@
+#ifndef X86_H
+#define X86_H
+
+/**
+ * @file x86.h
+ * @brief Defines the x86-64 code generator of the Obsidian compiler.
+ *
+ * This header file declares the native backend, which translates the
+ * optimized IR into GNU assembler source for x86-64 under the System V
+ * ABI. Values live in general-purpose or SSE registers chosen by the
+ * shared linear-scan allocator, floating-point arithmetic uses scalar SSE
+ * instructions, and printing goes through the C library, so the output is
+ * linked by the system C compiler. The same instructions can also be
+ * encoded straight into an ELF relocatable object, which needs no assembler.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "ir.h"
+#include "object.h"
+#include "writer.h"
+
+/**
+ * @brief Writes the assembly of every function of an IR module.
+ *
+ * Exported functions and `main` become global symbols under their own
+ * names; every other function is a local symbol with an `.ob` suffix, so
+ * it cannot collide with the C library. A `main` that does not return
+ * `i32` exits with status 0.
+ *
+ * @param ir Pointer to the IR module; its functions are prepared for code generation in place.
+ * @param out Pointer to the writer that receives the assembly.
+ */
+void emitX86Module(IrModule *ir, Writer *out);
+
+/**
+ * @brief Encodes every function of an IR module into an object file.
+ *
+ * The machine code matches what emitX86Module() writes, with symbols named
+ * the same way. Jumps always take 32-bit displacements, calls between
+ * local functions are resolved in place, and references to read-only
+ * constants, global functions, and the C library are left to the linker.
+ *
+ * @param ir Pointer to the IR module; its functions are prepared for code generation in place.
+ * @param object Pointer to an empty object file that receives the code.
+ */
+void emitX86Object(IrModule *ir, ObjectFile *object);
+
+#endif // X86_H
@@ -0,0 +1,277 @@
+/**
+ * @file interface.c
+ * @brief Implements the binary module interface files of the Obsidian compiler.
+ *
+ * An interface is assembled in memory and written to a temporary file that
+ * is renamed over the old one, so an importer never maps a partial file. The
+ * reader maps the file read-only, so that opening it reads nothing but its
+ * header and the pages of the entries a lookup touches. Lookups binary-search
+ * the entries, which are sorted by the bytes of their names, and check every
+ * offset they follow, since the file may be stale or damaged.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "include/interface.h"
+#include "include/common.h"
+#include "include/cache.h"
+#include "include/writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Orders two names by their bytes, a shorter name first when one is a prefix of the other.
+ */
+static int compareNames(const char *a, size_t aLength, const char *b, size_t bLength) {
+    int order = memcmp(a, b, aLength < bLength ? aLength : bLength);
+    if (order != 0) return order;
+    return aLength < bLength ? -1 : aLength > bLength;
+}
+
+/**
+ * @brief Orders two exported functions by name for qsort.
+ */
+static int compareExports(const void *a, const void *b) {
+    const char *left = (*(const IrFunction *const *)a)->name;
+    const char *right = (*(const IrFunction *const *)b)->name;
+    return compareNames(left, strlen(left), right, strlen(right));
+}
+
+/**
+ * @brief Writes the interface of a module's exported functions.
+ *
+ * @param module Pointer to the IR module.
+ * @param path The file to create.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int writeInterface(const IrModule *module, const char *path) {
+    const IrFunction **exports = malloc((size_t)(module->functionCount + 1) * sizeof(IrFunction *));
+    InterfaceHeader header;
+    ModuleInterface existing;
+    Writer *writer = malloc(sizeof(Writer));
+    uint32_t count = 0, types = 0, names = 0;
+    unsigned char *data;
+    size_t size = 0;
+    int status = 0;
+
+    if (exports == NULL || writer == NULL) {
+        free(exports);
+        free(writer);
+        return -1;
+    }
+    for (int i = 0; i < module->functionCount; i++) {
+        const IrFunction *fn = &module->functions[i];
+        if (!fn->exported || fn->external) continue;
+        exports[count++] = fn;
+        types += (uint32_t)fn->paramCount;
+        names += (uint32_t)strlen(fn->name);
+    }
+    qsort(exports, count, sizeof(IrFunction *), compareExports);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = INTERFACE_MAGIC;
+    header.version = INTERFACE_VERSION;
+    header.functionCount = count;
+    header.typesOffset = (uint32_t)(sizeof(InterfaceHeader) + count * sizeof(InterfaceEntry));
+    header.namesOffset = header.typesOffset + types;
+    header.size = header.namesOffset + names;
+
+    initWriter(writer, NULL);
+    writeBytes(writer, &header, sizeof(header));
+    types = 0;
+    names = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        InterfaceEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.nameOffset = names;
+        entry.nameLength = (uint32_t)strlen(exports[i]->name);
+        entry.typesOffset = types;
+        entry.paramCount = (uint16_t)exports[i]->paramCount;
+        entry.returnType = (uint8_t)exports[i]->returnType;
+        writeBytes(writer, &entry, sizeof(entry));
+        names += entry.nameLength;
+        types += entry.paramCount;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        for (int p = 0; p < exports[i]->paramCount; p++) writeChar(writer, (char)exports[i]->paramTypes[p]);
+    }
+    for (uint32_t i = 0; i < count; i++) writeString(writer, exports[i]->name);
+    data = (unsigned char *)takeWriterMemory(writer, &size);
+    free(writer);
+    free(exports);
+    if (data == NULL) return -1;
+
+    header.hash = hashContents((const char *)data + sizeof(header), size - sizeof(header));
+    memcpy(data, &header, sizeof(header));
+
+    if (openInterface(&existing, path) == 0) {
+        InterfaceHeader old;
+        memcpy(&old, existing.data, sizeof(old));
+        status = old.hash == header.hash && existing.size == size && memcmp(existing.data, data, size) == 0;
+        closeInterface(&existing);
+        if (status) {
+            free(data);
+            return 0;
+        }
+    }
+
+    status = replaceFile(path, data, size);
+    free(data);
+    return status;
+}
+
+/**
+ * @brief Opens an interface file.
+ *
+ * @param interfaceFile Pointer to the interface to fill.
+ * @param path The file to open.
+ * @return int Returns 0 on success, -1 if the file could not be read, or 1
+ *             if it is not an interface file of this version.
+ */
+int openInterface(ModuleInterface *interfaceFile, const char *path) {
+    InterfaceHeader header;
+
+    interfaceFile->data = NULL;
+    interfaceFile->size = 0;
+    interfaceFile->mapped = 0;
+
+#ifndef _WIN32
+    {
+        struct stat info;
+        int fd = open(path, O_RDONLY);
+        void *data;
+
+        if (fd < 0) return -1;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return -1;
+        }
+        if ((size_t)info.st_size < sizeof(InterfaceHeader)) {
+            close(fd);
+            return 1;
+        }
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return -1;
+        interfaceFile->data = data;
+        interfaceFile->size = (size_t)info.st_size;
+        interfaceFile->mapped = 1;
+    }
+#else
+    {
+        FILE *file = fopen(path, "rb");
+        unsigned char *data;
+        long size;
+
+        if (file == NULL) return -1;
+        if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+            fclose(file);
+            return -1;
+        }
+        if ((size_t)size < sizeof(InterfaceHeader)) {
+            fclose(file);
+            return 1;
+        }
+        data = malloc((size_t)size);
+        if (data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size) {
+            free(data);
+            fclose(file);
+            return -1;
+        }
+        fclose(file);
+        interfaceFile->data = data;
+        interfaceFile->size = (size_t)size;
+    }
+#endif
+
+    memcpy(&header, interfaceFile->data, sizeof(header));
+    if (header.magic != INTERFACE_MAGIC || header.version != INTERFACE_VERSION || header.size != interfaceFile->size ||
+        (uint64_t)header.typesOffset < sizeof(InterfaceHeader) + (uint64_t)header.functionCount * sizeof(InterfaceEntry) ||
+        header.namesOffset < header.typesOffset || header.namesOffset > header.size) {
+        closeInterface(interfaceFile);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Closes an interface file.
+ *
+ * @param interfaceFile Pointer to the interface to close.
+ */
+void closeInterface(ModuleInterface *interfaceFile) {
+    if (interfaceFile->data == NULL) return;
+#ifndef _WIN32
+    if (interfaceFile->mapped) munmap((void *)interfaceFile->data, interfaceFile->size);
+    else
+#endif
+    free((void *)interfaceFile->data);
+    interfaceFile->data = NULL;
+    interfaceFile->size = 0;
+}
+
+/**
+ * @brief Reports whether a stored type is one a parameter or result may have.
+ */
+static int isStoredType(uint8_t type, int allowVoid) {
+    return type <= TypeString && (allowVoid || type != TypeVoid);
+}
+
+/**
+ * @brief Finds an exported function of an interface by name.
+ *
+ * @param interfaceFile Pointer to the interface.
+ * @param name The name of the function; it need not be NUL-terminated.
+ * @param length The length of the name.
+ * @param function Pointer that receives the function's signature.
+ * @return int Returns 0 if the function was found, or -1 if it is missing or its entry is malformed.
+ */
+int findInterfaceFunction(const ModuleInterface *interfaceFile, const char *name, size_t length, InterfaceFunction *function) {
+    const unsigned char *data = interfaceFile->data;
+    InterfaceHeader header;
+    uint32_t low = 0, high;
+
+    memcpy(&header, data, sizeof(header));
+    high = header.functionCount;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        InterfaceEntry entry;
+        int order;
+
+        memcpy(&entry, data + sizeof(InterfaceHeader) + middle * sizeof(InterfaceEntry), sizeof(entry));
+        if ((uint64_t)header.namesOffset + entry.nameOffset + entry.nameLength > header.size) return -1;
+        order = compareNames(name, length, (const char *)data + header.namesOffset + entry.nameOffset, entry.nameLength);
+        if (order < 0) {
+            high = middle;
+        } else if (order > 0) {
+            low = middle + 1;
+        } else {
+            const uint8_t *types = data + header.typesOffset + entry.typesOffset;
+            if ((uint64_t)header.typesOffset + entry.typesOffset + entry.paramCount > header.namesOffset) return -1;
+            if (!isStoredType(entry.returnType, 1)) return -1;
+            for (int i = 0; i < entry.paramCount; i++) {
+                if (!isStoredType(types[i], 0)) return -1;
+            }
+            function->returnType = (TypeKind)entry.returnType;
+            function->paramCount = entry.paramCount;
+            function->paramTypes = types;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file intern.c
+ * @brief Implements the symbol interning table for the Obsidian compiler.
+ *
+ * This file maps identifier spellings to dense integer symbol IDs using an
+ * open-addressed hash table with linear probing. Spellings are hashed once
+ * when they are interned; afterwards symbols are compared as integers.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/intern.h"
+#include "include/memstats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SYMBOL_BYTES (sizeof(char *) + sizeof(size_t) + sizeof(uint32_t))  ///< Per-symbol array bytes.
+
+/**
+ * @brief Hashes a spelling with 32-bit FNV-1a.
+ *
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @return uint32_t The hash of the spelling.
+ */
+static uint32_t hashSpelling(const char *start, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)start[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finds the slot holding a spelling, or the empty slot where it belongs.
+ *
+ * @param table Pointer to the intern table.
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @param hash Hash of the spelling.
+ * @return size_t Index of the matching or empty slot.
+ */
+static size_t probeSlot(const InternTable *table, const char *start, size_t length, uint32_t hash) {
+    size_t mask = table->slotCount - 1;
+    size_t index = hash & mask;
+
+    while (table->slots[index] != SYMBOL_NONE) {
+        uint32_t symbol = table->slots[index];
+        if (table->hashes[symbol] == hash && table->lengths[symbol] == length && memcmp(table->names[symbol], start, length) == 0) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+/**
+ * @brief Doubles the slot array and reinserts every interned symbol.
+ *
+ * @param table Pointer to the intern table.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int growSlots(InternTable *table) {
+    size_t newCount = table->slotCount ? table->slotCount * 2 : 64;
+    uint32_t *slots = calloc(newCount, sizeof(uint32_t));
+    if (slots == NULL) return -1;
+
+    for (size_t symbol = 1; symbol <= table->count; symbol++) {
+        size_t index = table->hashes[symbol] & (newCount - 1);
+        while (slots[index] != SYMBOL_NONE) {
+            index = (index + 1) & (newCount - 1);
+        }
+        slots[index] = (uint32_t)symbol;
+    }
+
+    free(table->slots);
+    memAcquire(MEM_SYMBOLS, (newCount - table->slotCount) * sizeof(uint32_t));
+    table->slots = slots;
+    table->slotCount = newCount;
+    return 0;
+}
+
+/**
+ * @brief Grows the per-symbol arrays so one more symbol fits.
+ *
+ * @param table Pointer to the intern table.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int growSymbols(InternTable *table) {
+    size_t newCapacity = table->capacity ? table->capacity * 2 : 64;
+    char **names = realloc(table->names, newCapacity * sizeof(char *));
+    if (names == NULL) return -1;
+    table->names = names;
+
+    size_t *lengths = realloc(table->lengths, newCapacity * sizeof(size_t));
+    if (lengths == NULL) return -1;
+    table->lengths = lengths;
+
+    uint32_t *hashes = realloc(table->hashes, newCapacity * sizeof(uint32_t));
+    if (hashes == NULL) return -1;
+    table->hashes = hashes;
+
+    memAcquire(MEM_SYMBOLS, (newCapacity - table->capacity) * SYMBOL_BYTES);
+    table->capacity = newCapacity;
+    return 0;
+}
+
+/**
+ * @brief Initializes an empty intern table.
+ *
+ * @param table Pointer to the intern table to initialize.
+ */
+void initInternTable(InternTable *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @brief Releases every spelling and array owned by the intern table.
+ *
+ * @param table Pointer to the intern table to free.
+ */
+void freeInternTable(InternTable *table) {
+    size_t bytes = table->capacity * SYMBOL_BYTES + table->slotCount * sizeof(uint32_t);
+    for (size_t symbol = 1; symbol <= table->count; symbol++) {
+        bytes += table->lengths[symbol] + 1;
+        free(table->names[symbol]);
+    }
+    memRelease(MEM_SYMBOLS, bytes);
+    free(table->names);
+    free(table->lengths);
+    free(table->hashes);
+    free(table->slots);
+    initInternTable(table);
+}
+
+/**
+ * @brief Interns a spelling and returns its symbol ID.
+ *
+ * Symbol IDs are dense and start at 1, so callers can index side tables
+ * directly by symbol. The slot array is kept at most half full.
+ *
+ * @param table Pointer to the intern table.
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @return uint32_t The symbol ID, or SYMBOL_NONE if memory could not be allocated.
+ */
+uint32_t internSymbol(InternTable *table, const char *start, size_t length) {
+    uint32_t hash = hashSpelling(start, length);
+    size_t index;
+    uint32_t symbol;
+    char *copy;
+
+    if ((table->count + 1) * 2 > table->slotCount && growSlots(table) != 0) return SYMBOL_NONE;
+
+    index = probeSlot(table, start, length, hash);
+    if (table->slots[index] != SYMBOL_NONE) return table->slots[index];
+
+    if (table->count + 2 > table->capacity && growSymbols(table) != 0) return SYMBOL_NONE;
+
+    copy = malloc(length + 1);
+    if (copy == NULL) return SYMBOL_NONE;
+    memcpy(copy, start, length);
+    copy[length] = '\0';
+    memAcquire(MEM_SYMBOLS, length + 1);
+
+    symbol = (uint32_t)++table->count;
+    table->names[symbol] = copy;
+    table->lengths[symbol] = length;
+    table->hashes[symbol] = hash;
+    table->slots[index] = symbol;
+    return symbol;
+}
+
+/**
+ * @brief Looks up a spelling without inserting it.
+ *
+ * @param table Pointer to the intern table.
+ * @param start Pointer to the first character of the spelling.
+ * @param length Length of the spelling in bytes.
+ * @return uint32_t The symbol ID, or SYMBOL_NONE if the spelling was never interned.
+ */
+uint32_t findSymbol(const InternTable *table, const char *start, size_t length) {
+    if (table->slotCount == 0) return SYMBOL_NONE;
+    return table->slots[probeSlot(table, start, length, hashSpelling(start, length))];
+}
+
+/**
+ * @brief Returns the spelling of an interned symbol.
+ *
+ * @param table Pointer to the intern table.
+ * @param symbol The symbol ID to look up.
+ * @return const char* The NUL-terminated spelling, or NULL for an unknown ID.
+ */
+const char *symbolName(const InternTable *table, uint32_t symbol) {
+    if (symbol == SYMBOL_NONE || symbol > table->count) return NULL;
+    return table->names[symbol];
+}
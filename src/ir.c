@@ -0,0 +1,726 @@
+/**
+ * @file ir.c
+ * @brief Implements the SSA intermediate representation of the Obsidian compiler.
+ *
+ * This file provides construction and editing primitives for IR functions,
+ * the control-flow analyses shared by the optimization passes and the code
+ * generators (block ordering and dominators), and a textual dump used by
+ * `--emit-ir`.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/ir.h"
+#include "include/common.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IR_OPCODE_NAME(name) #name,
+
+static const char *const opNames[] = { IR_OPCODES(IR_OPCODE_NAME) };
+
+/**
+ * @brief Grows a dynamic array so that it can hold at least `needed` elements.
+ *
+ * Allocation failure goes to outOfMemory().
+ */
+static void *growArray(void *items, int *capacity, int needed, size_t size) {
+    int newCapacity;
+    void *grown;
+
+    if (needed <= *capacity) return items;
+    newCapacity = *capacity ? *capacity * 2 : 8;
+    while (newCapacity < needed) newCapacity *= 2;
+    grown = realloc(items, (size_t)newCapacity * size);
+    if (grown == NULL) outOfMemory(NULL);
+    *capacity = newCapacity;
+    return grown;
+}
+
+/**
+ * @brief Releases the storage of one function.
+ */
+static void freeIrFunction(IrFunction *fn) {
+    for (int i = 0; i < fn->blockCount; i++) {
+        free(fn->blocks[i].insns);
+        free(fn->blocks[i].preds);
+    }
+    free(fn->blocks);
+    free(fn->insns);
+    free(fn->operands);
+}
+
+/**
+ * @brief Initializes an empty IR module.
+ *
+ * @param module Pointer to the module to initialize.
+ */
+void initIrModule(IrModule *module) {
+    module->functions = NULL;
+    module->functionCount = 0;
+    module->functionCapacity = 0;
+    initArena(&module->strings);
+}
+
+/**
+ * @brief Releases every function and string owned by the module.
+ *
+ * @param module Pointer to the module to free.
+ */
+void freeIrModule(IrModule *module) {
+    for (int i = 0; i < module->functionCount; i++) {
+        freeIrFunction(&module->functions[i]);
+    }
+    free(module->functions);
+    freeArena(&module->strings);
+    initIrModule(module);
+}
+
+/**
+ * @brief Adds an empty function to the module.
+ *
+ * @param module Pointer to the module.
+ * @param name Name of the function; copied into the module.
+ * @return int Index of the new function, or -1 if memory could not be allocated.
+ */
+int addIrFunction(IrModule *module, const char *name) {
+    IrFunction *fn;
+
+    if (module->functionCount == module->functionCapacity) {
+        int capacity = module->functionCapacity ? module->functionCapacity * 2 : 16;
+        IrFunction *functions = realloc(module->functions, (size_t)capacity * sizeof(IrFunction));
+        if (functions == NULL) return -1;
+        module->functions = functions;
+        module->functionCapacity = capacity;
+    }
+
+    fn = &module->functions[module->functionCount];
+    memset(fn, 0, sizeof(*fn));
+    fn->name = arenaCopy(&module->strings, name, strlen(name) + 1);
+    if (fn->name == NULL) return -1;
+    return module->functionCount++;
+}
+
+/**
+ * @brief Appends a new, empty block to a function.
+ *
+ * @param fn Pointer to the function.
+ * @return int Index of the new block.
+ */
+int irNewBlock(IrFunction *fn) {
+    IrBlock *block;
+
+    fn->blocks = growArray(fn->blocks, &fn->blockCapacity, fn->blockCount + 1, sizeof(IrBlock));
+    block = &fn->blocks[fn->blockCount];
+    memset(block, 0, sizeof(*block));
+    block->idom = IR_NONE;
+    block->order = IR_NONE;
+    return fn->blockCount++;
+}
+
+/**
+ * @brief Copies operands into the function's operand pool.
+ *
+ * @return int Index of the first copied operand.
+ */
+static int addOperands(IrFunction *fn, const int *args, int argCount) {
+    int start = fn->operandCount;
+    if (argCount == 0) return start;
+    fn->operands = growArray(fn->operands, &fn->operandCapacity, fn->operandCount + argCount, sizeof(int));
+    memcpy(fn->operands + start, args, (size_t)argCount * sizeof(int));
+    fn->operandCount += argCount;
+    return start;
+}
+
+/**
+ * @brief Creates an instruction that does not yet belong to any block.
+ */
+static int newInsn(IrFunction *fn, int block, IrOp op, TypeKind type, const int *args, int argCount) {
+    IrInsn *insn;
+
+    fn->insns = growArray(fn->insns, &fn->insnCapacity, fn->insnCount + 1, sizeof(IrInsn));
+    insn = &fn->insns[fn->insnCount];
+    memset(insn, 0, sizeof(*insn));
+    insn->op = op;
+    insn->type = type;
+    insn->operandType = TypeVoid;
+    insn->block = block;
+    insn->argCount = argCount;
+    insn->argStart = addOperands(fn, args, argCount);
+    return fn->insnCount++;
+}
+
+/**
+ * @brief Creates an instruction and appends it to a block.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that receives the instruction.
+ * @param op The opcode.
+ * @param type The result type, or TypeVoid.
+ * @param args The operand values; may be NULL if `argCount` is 0.
+ * @param argCount The number of operands.
+ * @return int The new instruction's value index.
+ */
+int irAppend(IrFunction *fn, int block, IrOp op, TypeKind type, const int *args, int argCount) {
+    return irInsert(fn, block, fn->blocks[block].insnCount, op, type, args, argCount);
+}
+
+/**
+ * @brief Creates an instruction and inserts it into a block at a position.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that receives the instruction.
+ * @param position Index in the block's instruction list.
+ * @param op The opcode.
+ * @param type The result type, or TypeVoid.
+ * @param args The operand values; may be NULL if `argCount` is 0.
+ * @param argCount The number of operands.
+ * @return int The new instruction's value index.
+ */
+int irInsert(IrFunction *fn, int block, int position, IrOp op, TypeKind type, const int *args, int argCount) {
+    int value = newInsn(fn, block, op, type, args, argCount);
+    irMove(fn, value, block, position);
+    return value;
+}
+
+/**
+ * @brief Moves an existing instruction into a block at a position.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to move.
+ * @param block The block that receives the instruction.
+ * @param position Index in the block's instruction list.
+ */
+void irMove(IrFunction *fn, int value, int block, int position) {
+    IrBlock *b = &fn->blocks[block];
+
+    b->insns = growArray(b->insns, &b->insnCapacity, b->insnCount + 1, sizeof(int));
+    memmove(b->insns + position + 1, b->insns + position, (size_t)(b->insnCount - position) * sizeof(int));
+    b->insns[position] = value;
+    b->insnCount++;
+    fn->insns[value].block = block;
+}
+
+/**
+ * @brief Replaces the operands of an instruction.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to update.
+ * @param args The new operand values.
+ * @param argCount The number of operands.
+ */
+void irSetArgs(IrFunction *fn, int value, const int *args, int argCount) {
+    if (argCount <= fn->insns[value].argCount) {
+        memmove(fn->operands + fn->insns[value].argStart, args, (size_t)argCount * sizeof(int));
+        fn->insns[value].argCount = argCount;
+        return;
+    }
+    fn->insns[value].argStart = addOperands(fn, args, argCount);
+    fn->insns[value].argCount = argCount;
+}
+
+/**
+ * @brief Returns the operands of an instruction.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int* The instruction's operand slice.
+ */
+int *irArgs(const IrFunction *fn, int value) {
+    return fn->operands + fn->insns[value].argStart;
+}
+
+/**
+ * @brief Records `pred` as a predecessor of `block`.
+ *
+ * @param fn Pointer to the function.
+ * @param block The successor block.
+ * @param pred The predecessor block.
+ */
+void irAddPred(IrFunction *fn, int block, int pred) {
+    IrBlock *b = &fn->blocks[block];
+    b->preds = growArray(b->preds, &b->predCapacity, b->predCount + 1, sizeof(int));
+    b->preds[b->predCount++] = pred;
+}
+
+/**
+ * @brief Removes the edge from `pred` to `block`, dropping the matching phi operands.
+ *
+ * @param fn Pointer to the function.
+ * @param block The successor block.
+ * @param pred The predecessor block.
+ */
+void irRemovePred(IrFunction *fn, int block, int pred) {
+    IrBlock *b = &fn->blocks[block];
+    int index = -1;
+
+    for (int i = 0; i < b->predCount; i++) {
+        if (b->preds[i] == pred) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) return;
+
+    for (int i = 0; i < b->insnCount; i++) {
+        IrInsn *insn = &fn->insns[b->insns[i]];
+        int *args;
+        if (insn->op == IR_NOP) continue;
+        if (insn->op != IR_PHI) break;
+        if (insn->argCount <= index) continue;
+        args = fn->operands + insn->argStart;
+        memmove(args + index, args + index + 1, (size_t)(insn->argCount - index - 1) * sizeof(int));
+        insn->argCount--;
+    }
+    memmove(b->preds + index, b->preds + index + 1, (size_t)(b->predCount - index - 1) * sizeof(int));
+    b->predCount--;
+}
+
+/**
+ * @brief Returns the terminator of a block, or IR_NONE if the block is open.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block.
+ * @return int The value index of the terminator.
+ */
+int irTerminator(const IrFunction *fn, int block) {
+    const IrBlock *b = &fn->blocks[block];
+    int last;
+
+    if (b->insnCount == 0) return IR_NONE;
+    last = b->insns[b->insnCount - 1];
+    switch (fn->insns[last].op) {
+        case IR_JUMP: case IR_BRANCH: case IR_RET: return last;
+        default: return IR_NONE;
+    }
+}
+
+/**
+ * @brief Returns the successors of a block.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block.
+ * @param succ Array that receives up to two successor blocks.
+ * @return int The number of successors.
+ */
+int irSuccessors(const IrFunction *fn, int block, int succ[2]) {
+    int term = irTerminator(fn, block);
+    if (term == IR_NONE) return 0;
+    switch (fn->insns[term].op) {
+        case IR_JUMP:
+            succ[0] = fn->insns[term].as.targets[0];
+            return 1;
+        case IR_BRANCH:
+            succ[0] = fn->insns[term].as.targets[0];
+            succ[1] = fn->insns[term].as.targets[1];
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Marks an instruction deleted; irCompact later drops it from its block.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction to delete.
+ */
+void irDelete(IrFunction *fn, int value) {
+    fn->insns[value].op = IR_NOP;
+    fn->insns[value].argCount = 0;
+}
+
+/**
+ * @brief Removes deleted instructions from every block's instruction list.
+ *
+ * @param fn Pointer to the function.
+ */
+void irCompact(IrFunction *fn) {
+    for (int b = 0; b < fn->blockCount; b++) {
+        IrBlock *block = &fn->blocks[b];
+        int kept = 0;
+        for (int i = 0; i < block->insnCount; i++) {
+            int value = block->insns[i];
+            if (fn->insns[value].op == IR_NOP) {
+                fn->insns[value].block = IR_NONE;
+            } else if (fn->insns[value].block == b) {
+                block->insns[kept++] = value;
+            }
+        }
+        block->insnCount = kept;
+    }
+}
+
+/**
+ * @brief Reports whether an instruction has no side effects and cannot trap.
+ *
+ * Integer division traps on a zero divisor and on MIN / -1, so it is only
+ * pure when its divisor is a constant that rules both out.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int Non-zero if the instruction is pure.
+ */
+int irIsPure(const IrFunction *fn, int value) {
+    const IrInsn *insn = &fn->insns[value];
+
+    switch (insn->op) {
+        case IR_CONST: case IR_COPY:
+        case IR_ADD: case IR_SUB: case IR_MUL:
+        case IR_AND: case IR_OR: case IR_XOR: case IR_SHL: case IR_SHR:
+        case IR_NEG: case IR_BNOT: case IR_NOT:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+        case IR_CONV:
+            return 1;
+        case IR_DIV: case IR_MOD: {
+            const IrInsn *divisor;
+            if (isFloatType(insn->type)) return 1;
+            divisor = &fn->insns[fn->operands[insn->argStart + 1]];
+            if (divisor->op != IR_CONST || divisor->as.constant.u64 == 0) return 0;
+            if (insn->type == TypeI64) return divisor->as.constant.i64 != -1;
+            if (insn->type == TypeU64) return 1;
+            return divisor->as.constant.u32 != 0 && (!isSignedType(insn->type) || divisor->as.constant.i32 != -1);
+        }
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Reports whether an instruction may be implemented as a call.
+ *
+ * Besides calls to other functions, native code generators print values and
+ * compute floating-point remainders through the C library, so these clobber
+ * the same registers as a call.
+ *
+ * @param fn Pointer to the function.
+ * @param value The instruction.
+ * @return int Non-zero if the instruction clobbers caller-saved registers.
+ */
+int irIsCall(const IrFunction *fn, int value) {
+    const IrInsn *insn = &fn->insns[value];
+
+    switch (insn->op) {
+        case IR_CALL: case IR_PRINT:
+            return 1;
+        case IR_MOD:
+            return isFloatType(insn->type);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Numbers the reachable blocks in reverse postorder.
+ *
+ * @param fn Pointer to the function.
+ * @param rpo Array of at least `blockCount` entries that receives the order.
+ * @return int The number of reachable blocks.
+ */
+int irComputeOrder(IrFunction *fn, int *rpo) {
+    int *stack = malloc((size_t)(fn->blockCount + 1) * sizeof(int));
+    int *next = calloc((size_t)fn->blockCount + 1, sizeof(int));
+    int depth = 0, count = 0;
+
+    if (stack == NULL || next == NULL) outOfMemory(NULL);
+    for (int b = 0; b < fn->blockCount; b++) fn->blocks[b].order = IR_NONE;
+
+    /* Iterative depth-first search; `order` doubles as the visited mark
+       until the final numbering is assigned below. */
+    stack[depth++] = 0;
+    fn->blocks[0].order = 0;
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        int succ[2];
+        int n = irSuccessors(fn, block, succ);
+
+        if (next[block] < n) {
+            int s = succ[next[block]++];
+            if (fn->blocks[s].order == IR_NONE) {
+                fn->blocks[s].order = 0;
+                stack[depth++] = s;
+            }
+        } else {
+            rpo[count++] = block;
+            depth--;
+        }
+    }
+
+    for (int i = 0; i < count / 2; i++) {
+        int swap = rpo[i];
+        rpo[i] = rpo[count - 1 - i];
+        rpo[count - 1 - i] = swap;
+    }
+    for (int i = 0; i < count; i++) fn->blocks[rpo[i]].order = i;
+
+    free(stack);
+    free(next);
+    return count;
+}
+
+/**
+ * @brief Finds the nearest common dominator of two blocks.
+ */
+static int intersect(const IrFunction *fn, int a, int b) {
+    while (a != b) {
+        while (fn->blocks[a].order > fn->blocks[b].order) a = fn->blocks[a].idom;
+        while (fn->blocks[b].order > fn->blocks[a].order) b = fn->blocks[b].idom;
+    }
+    return a;
+}
+
+/**
+ * @brief Computes the immediate dominator of every reachable block.
+ *
+ * This is the iterative algorithm of Cooper, Harvey, and Kennedy, which
+ * converges in two or three sweeps on the reducible graphs the builder
+ * produces.
+ *
+ * @param fn Pointer to the function.
+ * @param rpo The reverse postorder computed by irComputeOrder.
+ * @param count The number of reachable blocks.
+ */
+void irComputeDominators(IrFunction *fn, const int *rpo, int count) {
+    int changed = 1;
+
+    for (int b = 0; b < fn->blockCount; b++) fn->blocks[b].idom = IR_NONE;
+    fn->blocks[rpo[0]].idom = rpo[0];
+
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < count; i++) {
+            IrBlock *block = &fn->blocks[rpo[i]];
+            int idom = IR_NONE;
+            for (int p = 0; p < block->predCount; p++) {
+                int pred = block->preds[p];
+                if (fn->blocks[pred].order == IR_NONE || fn->blocks[pred].idom == IR_NONE) continue;
+                idom = idom == IR_NONE ? pred : intersect(fn, pred, idom);
+            }
+            if (idom != block->idom) {
+                block->idom = idom;
+                changed = 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Reports whether block `a` dominates block `b`.
+ *
+ * @param fn Pointer to the function with computed dominators.
+ * @param a The candidate dominator.
+ * @param b The dominated block.
+ * @return int Non-zero if every path from the entry to `b` passes through `a`.
+ */
+int irDominates(const IrFunction *fn, int a, int b) {
+    if (fn->blocks[a].order == IR_NONE || fn->blocks[b].order == IR_NONE) return 0;
+    while (fn->blocks[b].order > fn->blocks[a].order) b = fn->blocks[b].idom;
+    return a == b;
+}
+
+/**
+ * @brief Deletes every block that cannot be reached from the entry block.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if any block was removed.
+ */
+int irRemoveUnreachable(IrFunction *fn) {
+    int *rpo = malloc((size_t)fn->blockCount * sizeof(int));
+    int removed = 0;
+
+    if (rpo == NULL) outOfMemory(NULL);
+    irComputeOrder(fn, rpo);
+    free(rpo);
+
+    for (int b = 0; b < fn->blockCount; b++) {
+        IrBlock *block = &fn->blocks[b];
+        int succ[2], n;
+
+        if (block->order != IR_NONE || (block->insnCount == 0 && block->predCount == 0)) continue;
+        n = irSuccessors(fn, b, succ);
+        for (int i = 0; i < n; i++) {
+            if (fn->blocks[succ[i]].order != IR_NONE) irRemovePred(fn, succ[i], b);
+        }
+        for (int i = 0; i < block->insnCount; i++) irDelete(fn, block->insns[i]);
+        block->predCount = 0;
+        removed = 1;
+    }
+    if (removed) irCompact(fn);
+    return removed;
+}
+
+/**
+ * @brief Reports whether a block starts with a phi.
+ */
+static int hasPhis(const IrFunction *fn, int block) {
+    const IrBlock *b = &fn->blocks[block];
+    return b->insnCount > 0 && fn->insns[b->insns[0]].op == IR_PHI;
+}
+
+/**
+ * @brief Inserts an empty block on the edge from a branch to one of its targets.
+ *
+ * @param fn Pointer to the function.
+ * @param block The block that ends in the branch.
+ * @param which The index of the target whose edge is split, 0 or 1.
+ * @return int The new block, which jumps to the original target.
+ */
+int irSplitEdge(IrFunction *fn, int block, int which) {
+    int term = irTerminator(fn, block);
+    int target = fn->insns[term].as.targets[which];
+    int split = irNewBlock(fn);
+    int jump = irAppend(fn, split, IR_JUMP, TypeVoid, NULL, 0);
+
+    fn->insns[jump].as.targets[0] = target;
+    fn->insns[term].as.targets[which] = split;
+    irAddPred(fn, split, block);
+    for (int p = 0; p < fn->blocks[target].predCount; p++) {
+        if (fn->blocks[target].preds[p] == block) {
+            fn->blocks[target].preds[p] = split;
+            break;
+        }
+    }
+    return split;
+}
+
+/**
+ * @brief Splits every edge that leaves a branch and enters a block with phis.
+ *
+ * @param fn Pointer to the function.
+ */
+void irSplitEdges(IrFunction *fn) {
+    int blockCount = fn->blockCount;
+
+    for (int b = 0; b < blockCount; b++) {
+        int term = irTerminator(fn, b);
+        if (term == IR_NONE || fn->insns[term].op != IR_BRANCH) continue;
+
+        for (int k = 0; k < 2; k++) {
+            if (hasPhis(fn, fn->insns[term].as.targets[k])) irSplitEdge(fn, b, k);
+        }
+    }
+}
+
+/**
+ * @brief Follows a chain of replacements to its end, compressing the path.
+ */
+static int resolve(int *forward, int value) {
+    int root = value;
+    while (forward[root] != IR_NONE) root = forward[root];
+    while (forward[value] != IR_NONE) {
+        int next = forward[value];
+        forward[value] = root;
+        value = next;
+    }
+    return root;
+}
+
+/**
+ * @brief Rewrites every operand through a replacement map.
+ *
+ * @param fn Pointer to the function.
+ * @param forward The replacement map, indexed by value.
+ */
+void irReplaceValues(IrFunction *fn, int *forward) {
+    for (int v = 0; v < fn->insnCount; v++) {
+        IrInsn *insn = &fn->insns[v];
+        int *args = fn->operands + insn->argStart;
+        if (insn->op == IR_NOP) continue;
+        for (int i = 0; i < insn->argCount; i++) {
+            if (forward[args[i]] != IR_NONE) args[i] = resolve(forward, args[i]);
+        }
+    }
+}
+
+/**
+ * @brief Counts the live instructions of a function.
+ *
+ * @param fn Pointer to the function.
+ * @return int The number of instructions that are not deleted.
+ */
+int irSize(const IrFunction *fn) {
+    int size = 0;
+    for (int b = 0; b < fn->blockCount; b++) {
+        size += fn->blocks[b].insnCount;
+    }
+    return size;
+}
+
+/**
+ * @brief Returns the name of an IR opcode.
+ *
+ * @param op The opcode.
+ * @return const char* The opcode's lowercase name.
+ */
+const char *irOpName(IrOp op) {
+    return op < IR_OP_COUNT ? opNames[op] : "?";
+}
+
+/**
+ * @brief Writes a constant in a form that matches its type.
+ */
+static void printConstant(FILE *out, Slot value, TypeKind type) {
+    switch (type) {
+        case TypeF32: fprintf(out, "%g", (double)value.f32); break;
+        case TypeF64: fprintf(out, "%g", value.f64); break;
+        case TypeI64: fprintf(out, "%" PRId64, value.i64); break;
+        case TypeU64: fprintf(out, "%" PRIu64, value.u64); break;
+        case TypeI8: case TypeI16: case TypeI32: fprintf(out, "%" PRId32, value.i32); break;
+        case TypeBool: fputs(value.u32 ? "true" : "false", out); break;
+        case TypeString: fprintf(out, "\"%s\"", value.str != NULL ? value.str : ""); break;
+        default: fprintf(out, "%" PRIu32, value.u32); break;
+    }
+}
+
+/**
+ * @brief Writes a readable listing of a function.
+ *
+ * @param out The stream to write to.
+ * @param module Pointer to the module, used to name callees.
+ * @param fn Pointer to the function.
+ */
+void irPrintFunction(FILE *out, const IrModule *module, const IrFunction *fn) {
+    if (fn->external) {
+        fprintf(out, "declare fn %s(%d) %s\n", fn->name, fn->paramCount, typeName(fn->returnType));
+        return;
+    }
+    fprintf(out, "fn %s(%d) %s {\n", fn->name, fn->paramCount, typeName(fn->returnType));
+    for (int b = 0; b < fn->blockCount; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        if (block->insnCount == 0) continue;
+
+        fprintf(out, "b%d:", b);
+        if (block->predCount > 0) {
+            fputs("    ; preds", out);
+            for (int p = 0; p < block->predCount; p++) fprintf(out, " b%d", block->preds[p]);
+        }
+        fputc('\n', out);
+
+        for (int i = 0; i < block->insnCount; i++) {
+            int v = block->insns[i];
+            const IrInsn *insn = &fn->insns[v];
+            const int *args = fn->operands + insn->argStart;
+
+            fputs("    ", out);
+            if (insn->type != TypeVoid) fprintf(out, "v%d: %s = ", v, typeName(insn->type));
+            fputs(irOpName(insn->op), out);
+            if (insn->operandType != TypeVoid) fprintf(out, ".%s", typeName(insn->operandType));
+
+            switch (insn->op) {
+                case IR_CONST: fputc(' ', out); printConstant(out, insn->as.constant, insn->type); break;
+                case IR_PARAM: fprintf(out, " %d", insn->as.index); break;
+                case IR_CALL: fprintf(out, " %s", module->functions[insn->as.index].name); break;
+                default: break;
+            }
+            for (int a = 0; a < insn->argCount; a++) fprintf(out, "%s v%d", a == 0 ? "" : ",", args[a]);
+            if (insn->op == IR_JUMP) fprintf(out, " b%d", insn->as.targets[0]);
+            if (insn->op == IR_BRANCH) fprintf(out, ", b%d, b%d", insn->as.targets[0], insn->as.targets[1]);
+            fputc('\n', out);
+        }
+    }
+    fputs("}\n", out);
+}
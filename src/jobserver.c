@@ -0,0 +1,187 @@
+/**
+ * @file jobserver.c
+ * @brief Implements the client side of the GNU make jobserver.
+ *
+ * Tokens are only ever taken without waiting, so a process that finds none
+ * free keeps working with the threads it has. The inherited read end of the
+ * pipe is shared with every other job of the build and must stay blocking
+ * for them; on Linux it is reopened through /proc to get a description of
+ * its own that can be made non-blocking. Elsewhere a poll precedes the read,
+ * which may then wait briefly if another job took the token in between.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "include/jobserver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+/**
+ * @brief Finds the value of the last jobserver option in make's flags.
+ *
+ * @param makeflags The value of `MAKEFLAGS`.
+ * @param length Receives the length of the value.
+ * @return const char* The value, which is not NUL-terminated, or NULL if there is none.
+ */
+static const char *findAuth(const char *makeflags, size_t *length) {
+    static const char *const options[] = { "--jobserver-auth=", "--jobserver-fds=" };
+    const char *value = NULL, *word = makeflags;
+
+    while (*word != '\0') {
+        size_t size = strcspn(word, " \t");
+        for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+            size_t prefix = strlen(options[i]);
+            if (size > prefix && strncmp(word, options[i], prefix) == 0) {
+                value = word + prefix;
+                *length = size - prefix;
+            }
+        }
+        word += size;
+        word += strspn(word, " \t");
+    }
+    return value;
+}
+
+/**
+ * @brief Parses a descriptor number and reports whether it is open.
+ */
+static int parseDescriptor(const char *text, char **end) {
+    long fd = strtol(text, end, 10);
+    if (*end == text || fd < 0 || fd > 65535 || fcntl((int)fd, F_GETFD) == -1) return -1;
+    return (int)fd;
+}
+
+#endif
+
+/**
+ * @brief Connects to the jobserver named in make's flags.
+ *
+ * The last `--jobserver-auth=` (or older `--jobserver-fds=`) option wins.
+ * Inherited descriptors that are not open, which happens when make did not
+ * consider the command recursive, count as no jobserver.
+ *
+ * @param server Pointer to the connection to initialize.
+ * @param makeflags The value of `MAKEFLAGS`, or NULL.
+ * @return int Returns 1 if a jobserver is available, or 0 if there is none.
+ */
+int openJobServer(JobServer *server, const char *makeflags) {
+    server->readFd = server->writeFd = -1;
+    server->ownsRead = 0;
+    server->nonBlocking = 0;
+
+#ifndef _WIN32
+    {
+        size_t length = 0;
+        const char *auth = makeflags != NULL ? findAuth(makeflags, &length) : NULL;
+        char *value, *end;
+
+        if (auth == NULL) return 0;
+        value = malloc(length + 1);
+        if (value == NULL) return 0;
+        memcpy(value, auth, length);
+        value[length] = '\0';
+
+        if (strncmp(value, "fifo:", 5) == 0) {
+            int fd = open(value + 5, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (fd >= 0) {
+                server->readFd = server->writeFd = fd;
+                server->ownsRead = 1;
+                server->nonBlocking = 1;
+            }
+        } else {
+            int readFd = parseDescriptor(value, &end), writeFd = -1;
+            if (readFd >= 0 && *end == ',') writeFd = parseDescriptor(end + 1, &end);
+            if (readFd >= 0 && writeFd >= 0 && *end == '\0') {
+                char path[64];
+                int own;
+
+                snprintf(path, sizeof(path), "/proc/self/fd/%d", readFd);
+                own = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+                server->readFd = own >= 0 ? own : readFd;
+                server->writeFd = writeFd;
+                server->ownsRead = own >= 0;
+                server->nonBlocking = own >= 0;
+            }
+        }
+        free(value);
+    }
+#else
+    (void)makeflags;
+#endif
+    return server->readFd >= 0;
+}
+
+/**
+ * @brief Takes a job token if one is free, without waiting.
+ *
+ * @param server Pointer to an open connection.
+ * @param token Receives the byte that must be handed back.
+ * @return int Returns 1 if a token was taken, or 0 if none is free or there is no jobserver.
+ */
+int tryAcquireJobToken(JobServer *server, char *token) {
+#ifndef _WIN32
+    if (server->readFd < 0) return 0;
+    if (!server->nonBlocking) {
+        struct pollfd ready;
+        ready.fd = server->readFd;
+        ready.events = POLLIN;
+        if (poll(&ready, 1, 0) != 1 || !(ready.revents & POLLIN)) return 0;
+    }
+    for (;;) {
+        ssize_t count = read(server->readFd, token, 1);
+        if (count == 1) return 1;
+        if (count < 0 && errno == EINTR) continue;
+        return 0;
+    }
+#else
+    (void)server;
+    (void)token;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Hands a job token back to the jobserver.
+ *
+ * @param server Pointer to the connection the token came from.
+ * @param token The byte returned by tryAcquireJobToken().
+ */
+void releaseJobToken(JobServer *server, char token) {
+#ifndef _WIN32
+    while (write(server->writeFd, &token, 1) < 0 && errno == EINTR) {
+    }
+#else
+    (void)server;
+    (void)token;
+#endif
+}
+
+/**
+ * @brief Closes the descriptors opened by openJobServer().
+ *
+ * @param server Pointer to the connection to close.
+ */
+void closeJobServer(JobServer *server) {
+#ifndef _WIN32
+    if (server->ownsRead) close(server->readFd);
+#endif
+    server->readFd = server->writeFd = -1;
+    server->ownsRead = 0;
+}
@@ -18,37 +18,23 @@
 #include "include/error.h"
 
 /**
- * @brief Array of keyword entries for the lexer.
+ * @brief Array of keyword entries for the lexer, in strcmp order for bsearch.
  */
-static KeywordEntry keywords[] = {
-    {"alloc", TAlloc}, {"break", TBreak}, {"case", TCase}, {"char", TChar}, {"const", TConst}, {"dealloc", TDealloc}, {"default", TDefault}, {"else", TElse}, {"enum", TEnum}, {"export", TExport}, {"false", TFalse}, {"fn", TFn}, {"for", TFor}, {"if", TIf}, {"import", TImport}, {"i8", TI8}, {"i16", TI16}, {"i32", TI32}, {"i64", TI64}, {"f32", TF32}, {"f64", TF64}, {"length", TLength}, {"new", TNew}, {"null", TNull}, {"private", TPrivate}, {"println", TPrintln}, {"return", TReturn}, {"sizeof", TSizeof}, {"string", TString}, {"struct", TStruct}, {"switch", TSwitch}, {"true", TTrue}, {"typeOf", TTypeof}, {"unsafe", TUnsafe}, {"u8", TU8}, {"u16", TU16}, {"u32", TU32}, {"u64", TU64}, {"void", TVoid}, {"while", TWhile}
+static const KeywordEntry keywords[] = {
+    {"alloc", TAlloc}, {"bool", TBool}, {"break", TBreak}, {"case", TCase}, {"cast", TCast}, {"char", TChar}, {"const", TConst}, {"dealloc", TDealloc}, {"default", TDefault}, {"else", TElse}, {"enum", TEnum}, {"export", TExport}, {"f32", TF32}, {"f64", TF64}, {"false", TFalse}, {"fn", TFn}, {"for", TFor}, {"i16", TI16}, {"i32", TI32}, {"i64", TI64}, {"i8", TI8}, {"if", TIf}, {"import", TImport}, {"length", TLength}, {"new", TNew}, {"null", TNull}, {"println", TPrintln}, {"private", TPrivate}, {"return", TReturn}, {"sizeof", TSizeof}, {"string", TString}, {"struct", TStruct}, {"switch", TSwitch}, {"true", TTrue}, {"typeOf", TTypeof}, {"u16", TU16}, {"u32", TU32}, {"u64", TU64}, {"u8", TU8}, {"unsafe", TUnsafe}, {"void", TVoid}, {"while", TWhile}
 };
 
 /**
- * @brief Compares two keyword entries for qsort and bsearch.
+ * @brief Compares two keyword entries for bsearch.
  * 
  * This function is used to compare two keyword entries based on their keyword strings.
- * It is utilized by the qsort and bsearch functions to sort and search the keywords array.
+ * It is utilized by bsearch to search the keywords array.
  * 
  * @param a Pointer to the first keyword entry.
  * @param b Pointer to the second keyword entry.
  * @return int Result of the comparison: negative if a < b, zero if a == b, positive if a > b.
  */
-int compareKeywords(const void *a, const void *b) { return strcmp(((KeywordEntry *)a)->keyword, ((KeywordEntry *)b)->keyword); }
-
-/**
- * @brief Sorts the keywords array if it hasn't been sorted yet.
- * 
- * This function uses the qsort function to sort the keywords array based on the keyword strings.
- * It ensures that the keywords are sorted only once to optimize subsequent searches.
- */
-void sortKeywords(void) {
-    static int sorted = 0;
-    if (!sorted) {
-        qsort(keywords, sizeof(keywords) / sizeof(keywords[0]), sizeof(KeywordEntry), compareKeywords);
-        sorted = 1;
-    }
-}
+int compareKeywords(const void *a, const void *b) { return strcmp(((const KeywordEntry *)a)->keyword, ((const KeywordEntry *)b)->keyword); }
 
 /**
  * @brief Initializes the lexer with the source code.
@@ -61,24 +47,24 @@ void initLexer(Lexer *lexer, char *source) {
     lexer->current = source;
     lexer->line = 1;
     lexer->column = 1;
+    lexer->keepComments = 0;
+    lexer->diagnostics = NULL;
 }
 
 /**
  * @brief Checks if a given string is a keyword.
  * 
  * This function compares the provided string against a list of known keywords
- * and returns the corresponding token type. It sorts the keywords if they
- * haven't been sorted yet.
+ * and returns the corresponding token type with a binary search.
  * 
  * @param start Pointer to the start of the keyword string.
  * @param length Length of the keyword string.
  * @return TokenKind The token kind corresponding to the keyword or TIdentifier if not found.
  */
 TokenKind checkKeyword(const char *start, size_t length) {
-    sortKeywords();
     char keyword[32];
     size_t keywordsCount;
-    KeywordEntry *result;
+    const KeywordEntry *result;
 
     if(length >= sizeof(keyword)) return TIdentifier;
     memcpy(keyword, start, length);  ///< Copy the keyword from the source.
@@ -110,6 +96,7 @@ Token getNextToken(Lexer *lexer) {
 
     token.type = TUnknown;
     token.start = lexer->current;
+    token.length = 1;
     token.line = lexer->line;
     token.column = lexer->column;
 
@@ -135,7 +122,16 @@ Token getNextToken(Lexer *lexer) {
         case '+': token.type = (*lexer->current == '+') ? (lexer->current++, lexer->column++, TIncrement) : ((*lexer->current == '=') ? (lexer->current++, lexer->column++, TPlusAssign) : TPlus); break;
         case '-': token.type = (*lexer->current == '-') ? (lexer->current++, lexer->column++, TDecrement) : ((*lexer->current == '=') ? (lexer->current++, lexer->column++, TMinusAssign) : TMinus); break;
         case '*': token.type = (*lexer->current == '=') ? (lexer->current++, lexer->column++, TStarAssign) : ((*lexer->current == '*') ? (lexer->current++, lexer->column++, TPower) : TStar); break;
-        case '/': token.type = (*lexer->current == '=') ? (lexer->current++, lexer->column++, TSlashAssign) : TSlash; break;
+        case '/':
+            if (*lexer->current == '/') {
+                while (*lexer->current != '\n' && *lexer->current != '\0') {
+                    lexer->current++;
+                    lexer->column++;
+                }
+                token.type = TComment;
+                break;
+            }
+            token.type = (*lexer->current == '=') ? (lexer->current++, lexer->column++, TSlashAssign) : TSlash; break;
         case '!': token.type = (*lexer->current == '=') ? (lexer->current++, lexer->column++, TNotEqual) : TNot; break;
         case '=': token.type = (*lexer->current == '=') ? (lexer->current++, lexer->column++, TEqual) : TAssign; break;
         case '&': token.type = (*lexer->current == '&') ? (lexer->current++, lexer->column++, TLogicalAnd) : TAmpersand; break;
@@ -145,6 +141,10 @@ Token getNextToken(Lexer *lexer) {
 
         case '"': {
             while (*lexer->current != '"' && *lexer->current != '\0') {
+                if (*lexer->current == '\\' && lexer->current[1] != '\0') {
+                    lexer->current++;
+                    lexer->column++;
+                }
                 lexer->current++;
                 lexer->column++;
             }
@@ -154,7 +154,7 @@ Token getNextToken(Lexer *lexer) {
                 token.type = TStringLiteral;
                 token.length = (int)(lexer->current - token.start);
             } else {
-                error(LexicalError, "Unterminated string literal", &token);
+                reportError(lexer->diagnostics, LexicalError, "Unterminated string literal", &token);
                 token.type = TError;
             }
             return token;
@@ -173,7 +173,7 @@ Token getNextToken(Lexer *lexer) {
                 token.type = TCharLiteral;
                 token.length = (int)(lexer->current - token.start);
             } else {
-                error(LexicalError, "Unterminated character literal", &token);
+                reportError(lexer->diagnostics, LexicalError, "Unterminated character literal", &token);
                 token.type = TError;
             }
             return token;
@@ -209,11 +209,11 @@ Token getNextToken(Lexer *lexer) {
                 } else {
                     token.type = TIntLiteral;
                 }
-                token.length = (int)(lexer->current - lexer->current - 1);
+                token.length = (int)(lexer->current - token.start);
                 return token;
             }
 
-            error(LexicalError, "Unexpected character", &token);
+            reportError(lexer->diagnostics, LexicalError, "Unexpected character", &token);
             token.type = TError;
 
             while (!isspace(*lexer->current) && *lexer->current != '\0') {
@@ -231,14 +231,22 @@ Token getNextToken(Lexer *lexer) {
  * @brief Skips whitespace and comments in the source code.
  * 
  * This function advances the lexer’s current position, skipping over
- * any whitespace characters or comments found in the source code.
+ * any whitespace characters or comments found in the source code. A
+ * `//` comment is left in place when the lexer keeps comments.
  * 
  * @param lexer Pointer to the lexer instance.
  */
 void skipWhitespace(Lexer *lexer) {
-    while (isspace(*lexer->current) || *lexer->current == '#') {
-        lexer->column = (*lexer->current == '\n') ? 1 : lexer->column + 1;
-        lexer->line += (*lexer->current == '\n');
-        lexer->current++;
+    while (1) {
+        while (isspace(*lexer->current) || *lexer->current == '#') {
+            lexer->column = (*lexer->current == '\n') ? 1 : lexer->column + 1;
+            lexer->line += (*lexer->current == '\n');
+            lexer->current++;
+        }
+        if (lexer->keepComments || lexer->current[0] != '/' || lexer->current[1] != '/') return;
+        while (*lexer->current != '\n' && *lexer->current != '\0') {
+            lexer->current++;
+            lexer->column++;
+        }
     }
 }
@@ -0,0 +1,371 @@
+/**
+ * @file libobsidian.c
+ * @brief Implements the public C interface of the libobsidian library.
+ *
+ * Every compilation runs the same phases as the command-line driver, with
+ * each phase given a diagnostic sink that forwards errors to the session's
+ * handler. Output is collected in memory rather than written to a file.
+ * The modules a source imports are looked up in the session's import
+ * directory, as the driver looks them up beside the importing file.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/obsidian.h"
+#include "include/cache.h"
+#include "include/common.h"
+#include "include/compiler.h"
+#include "include/interface.h"
+#include "include/memstats.h"
+#include "include/parser.h"
+#include "include/passes.h"
+#include "include/writer.h"
+#include "include/x86.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRINGIFY(x) #x
+#define VERSION_STRING(major, minor, patch) STRINGIFY(major) "." STRINGIFY(minor) "." STRINGIFY(patch)
+
+/**
+ * @struct ObsidianSession
+ * @brief The settings and identifiers shared by a series of compilations.
+ */
+struct ObsidianSession {
+    InternTable symbols;                ///< Identifier spellings shared by every compilation.
+    ObsidianDiagnosticHandler handler;
+    void *userData;
+    int optLevel;
+    char *importDirectory;              ///< Directory holding the interfaces of imported modules, or NULL.
+};
+
+/**
+ * @struct Reporter
+ * @brief The context of the diagnostic sink of one compilation.
+ */
+typedef struct {
+    const ObsidianSession *session;
+    const char *file;
+} Reporter;
+
+/**
+ * @brief Returns the version of the library as a "major.minor.patch" string.
+ */
+const char *obsidianVersion(void) {
+    return VERSION_STRING(MAJOR_VERSION, MINOR_VERSION, PATCH_VERSION);
+}
+
+/**
+ * @brief Creates a session with no diagnostic handler and optimization level 0.
+ *
+ * @return ObsidianSession* The new session, or NULL if memory could not be allocated.
+ */
+ObsidianSession *obsidianCreateSession(void) {
+    ObsidianSession *session = malloc(sizeof(ObsidianSession));
+
+    if (session == NULL) return NULL;
+    initInternTable(&session->symbols);
+    session->handler = NULL;
+    session->userData = NULL;
+    session->optLevel = 0;
+    session->importDirectory = NULL;
+    return session;
+}
+
+/**
+ * @brief Destroys a session and everything it holds.
+ *
+ * @param session Pointer to the session, or NULL.
+ */
+void obsidianDestroySession(ObsidianSession *session) {
+    if (session == NULL) return;
+    freeInternTable(&session->symbols);
+    free(session->importDirectory);
+    free(session);
+}
+
+/**
+ * @brief Sets the callback that receives the diagnostics of a session.
+ *
+ * @param session Pointer to the session.
+ * @param handler The callback, or NULL to discard diagnostics.
+ * @param userData A pointer passed to every call of the handler.
+ */
+void obsidianSetDiagnosticHandler(ObsidianSession *session, ObsidianDiagnosticHandler handler, void *userData) {
+    session->handler = handler;
+    session->userData = userData;
+}
+
+/**
+ * @brief Sets the optimization level used by obsidianCompileToAssembly.
+ *
+ * @param session Pointer to the session.
+ * @param level The level, from 0 to 3; higher levels are clamped to 3.
+ */
+void obsidianSetOptimizationLevel(ObsidianSession *session, int level) {
+    session->optLevel = level < 0 ? 0 : level > OPT_LEVEL_MAX ? OPT_LEVEL_MAX : level;
+}
+
+/**
+ * @brief Sets the directory in which the interfaces of imported modules are looked up.
+ *
+ * @param session Pointer to the session.
+ * @param directory The directory, or NULL to reject imports.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int obsidianSetImportDirectory(ObsidianSession *session, const char *directory) {
+    char *copy = NULL;
+
+    if (directory != NULL) {
+        copy = malloc(strlen(directory) + 1);
+        if (copy == NULL) return -1;
+        strcpy(copy, directory);
+    }
+    free(session->importDirectory);
+    session->importDirectory = copy;
+    return 0;
+}
+
+/**
+ * @brief Converts a diagnostic from the compiler's sink to the public form and hands it to the session's handler.
+ */
+static void forwardDiagnostic(const Diagnostic *diagnostic, void *context) {
+    const Reporter *reporter = context;
+    ObsidianDiagnostic converted;
+
+    if (reporter->session->handler == NULL) return;
+    switch (diagnostic->type) {
+        case LexicalError: converted.kind = OBSIDIAN_LEXICAL_ERROR; break;
+        case SyntaxError: converted.kind = OBSIDIAN_SYNTAX_ERROR; break;
+        default: converted.kind = OBSIDIAN_SEMANTIC_ERROR; break;
+    }
+    converted.file = reporter->file;
+    converted.message = diagnostic->message;
+    converted.line = diagnostic->line;
+    converted.column = diagnostic->column;
+    converted.text = diagnostic->text;
+    converted.textLength = diagnostic->textLength > 0 ? (size_t)diagnostic->textLength : 0;
+    converted.lineText = diagnostic->lineText;
+    converted.lineLength = diagnostic->lineLength > 0 ? (size_t)diagnostic->lineLength : 0;
+    reporter->session->handler(&converted, reporter->session->userData);
+}
+
+/**
+ * @brief Finds the module name of the import statement that imports a symbol.
+ */
+static const Token *findImport(const TokenStream *stream, uint32_t module) {
+    for (size_t i = 0; i + 1 < stream->count; i++) {
+        if (stream->tokens[i].type == TImport && stream->symbols[i + 1] == module) return &stream->tokens[i + 1];
+    }
+    return &stream->tokens[stream->count - 1];
+}
+
+/**
+ * @brief Opens the interface of every module a program imports from the session's import directory.
+ *
+ * An import that cannot be resolved is reported at its module name.
+ *
+ * @param interfaces Pointer that receives one opened interface per import, or NULL if there are none.
+ * @return int Returns 0 on success, 1 if diagnostics were reported, or -1 if memory could not be allocated.
+ */
+static int openSessionImports(const ObsidianSession *session, const TokenStream *stream, const Program *program,
+                              ModuleInterface **interfaces, const DiagnosticSink *sink) {
+    int status = 0;
+
+    *interfaces = NULL;
+    if (program->importCount == 0) return 0;
+    if (session->importDirectory == NULL) {
+        for (int i = 0; i < program->importCount; i++) {
+            reportError(sink, SemanticError, "Cannot import without an import directory; set one with "
+                        "obsidianSetImportDirectory. Module: ", findImport(stream, program->imports[i]));
+        }
+        return 1;
+    }
+
+    *interfaces = malloc((size_t)program->importCount * sizeof(ModuleInterface));
+    if (*interfaces == NULL) return -1;
+    for (int i = 0; i < program->importCount; i++) {
+        const char *module = symbolName(&session->symbols, program->imports[i]);
+        size_t length = strlen(session->importDirectory) + strlen(module) + sizeof(INTERFACE_EXTENSION) + 1;
+        char *file = malloc(length);
+        int opened;
+
+        if (file == NULL) {
+            status = -1;
+        } else {
+            snprintf(file, length, "%s/%s%s", session->importDirectory, module, INTERFACE_EXTENSION);
+            opened = openInterface(&(*interfaces)[i], file);
+            free(file);
+            if (opened != 0) {
+                reportError(sink, SemanticError, opened < 0 ? "No interface file in the import directory for module: "
+                                                            : "Not an interface file of this compiler for module: ",
+                            findImport(stream, program->imports[i]));
+                status = 1;
+            }
+        }
+        if (status != 0) {
+            while (i-- > 0) closeInterface(&(*interfaces)[i]);
+            free(*interfaces);
+            *interfaces = NULL;
+            return status;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Lexes, parses and type-checks a source buffer into unoptimized IR.
+ *
+ * The source is copied so that it can be NUL-terminated for the lexer. The
+ * copy, the tokens and the syntax tree are released before returning.
+ *
+ * @param session Pointer to the session.
+ * @param name The name reported with diagnostics, or NULL.
+ * @param source Pointer to the source code.
+ * @param length Length of the source in bytes.
+ * @param ir Pointer to an initialized module that receives the IR.
+ * @return int Returns 0 on success, 1 if diagnostics were reported, or -1 if memory could not be allocated.
+ */
+static int buildSessionIr(ObsidianSession *session, const char *name, const char *source, size_t length, IrModule *ir) {
+    Reporter reporter;
+    DiagnosticSink sink;
+    TokenStream stream;
+    Arena arena;
+    Parser parser;
+    Program program;
+    ModuleInterface *interfaces = NULL;
+    char *buffer;
+    int status;
+
+    buffer = malloc(length + 1);
+    if (buffer == NULL) return -1;
+    memcpy(buffer, source, length);
+    buffer[length] = '\0';
+    memAcquire(MEM_SOURCE, length + 1);
+
+    reporter.session = session;
+    reporter.file = name != NULL ? name : "<input>";
+    sink.report = forwardDiagnostic;
+    sink.context = &reporter;
+
+    if (tokenize(buffer, &session->symbols, &stream, &sink) != 0) {
+        status = -1;
+    } else if (stream.hasErrors) {
+        freeTokenStream(&stream);
+        status = 1;
+    } else {
+        initArena(&arena);
+        initParser(&parser, &stream, &arena);
+        parser.diagnostics = &sink;
+        status = parseProgram(&parser, &program);
+        if (status == 0) status = openSessionImports(session, &stream, &program, &interfaces, &sink);
+        if (status == 0) {
+            program.interfaces = interfaces;
+            program.interfaceCount = interfaces != NULL ? program.importCount : 0;
+            status = compileProgram(&program, &session->symbols, ir, &sink);
+            for (int i = 0; i < program.interfaceCount; i++) closeInterface(&interfaces[i]);
+            free(interfaces);
+        }
+        freeArena(&arena);
+        freeTokenStream(&stream);
+    }
+
+    free(buffer);
+    memRelease(MEM_SOURCE, length + 1);
+    return status;
+}
+
+/**
+ * @brief Lexes, parses and type-checks a source buffer.
+ *
+ * @param session Pointer to the session.
+ * @param name The name reported with diagnostics, or NULL.
+ * @param source Pointer to the source code, which need not be NUL-terminated.
+ * @param length Length of the source in bytes.
+ * @return int Returns 0 if the source is valid, 1 if diagnostics were reported,
+ *             or -1 if memory could not be allocated.
+ */
+int obsidianCheck(ObsidianSession *session, const char *name, const char *source, size_t length) {
+    IrModule ir;
+    int status;
+
+    initIrModule(&ir);
+    status = buildSessionIr(session, name, source, length, &ir);
+    freeIrModule(&ir);
+    return status;
+}
+
+/**
+ * @brief Optimizes a module and writes its assembly, returning -1 instead of exiting if memory runs out.
+ */
+static int emitSessionAssembly(const ObsidianSession *session, IrModule *ir, Writer *writer) {
+    MemoryGuard guard;
+
+    if (setjmp(guard.jump) != 0) return -1;
+    pushMemoryGuard(&guard);
+    optimizeModule(ir, session->optLevel, NULL);
+    emitX86Module(ir, writer);
+    popMemoryGuard(&guard);
+    return 0;
+}
+
+/**
+ * @brief Compiles a source buffer to x86-64 assembly in AT&T syntax.
+ *
+ * @param session Pointer to the session.
+ * @param name The name reported with diagnostics, or NULL.
+ * @param source Pointer to the source code, which need not be NUL-terminated.
+ * @param length Length of the source in bytes.
+ * @param assembly Pointer that receives the NUL-terminated assembly, to be
+ *                 released with obsidianFree, or NULL on failure.
+ * @param size Pointer that receives the length of the assembly, or NULL.
+ * @return int Returns 0 on success, 1 if diagnostics were reported, or -1 if
+ *             memory could not be allocated.
+ */
+int obsidianCompileToAssembly(ObsidianSession *session, const char *name, const char *source, size_t length,
+                              char **assembly, size_t *size) {
+    IrModule ir;
+    Writer *writer;
+    size_t written = 0;
+    int status;
+
+    *assembly = NULL;
+    if (size != NULL) *size = 0;
+
+    initIrModule(&ir);
+    status = buildSessionIr(session, name, source, length, &ir);
+    if (status == 0) {
+        writer = malloc(sizeof(Writer));
+        if (writer == NULL) {
+            status = -1;
+        } else {
+            initWriter(writer, NULL);
+            status = emitSessionAssembly(session, &ir, writer);
+            *assembly = takeWriterMemory(writer, &written);
+            if (status != 0 || *assembly == NULL) {
+                free(*assembly);
+                *assembly = NULL;
+                written = 0;
+                status = -1;
+            }
+            free(writer);
+        }
+    }
+    freeIrModule(&ir);
+
+    if (size != NULL) *size = written;
+    return status;
+}
+
+/**
+ * @brief Releases memory returned by the library.
+ *
+ * @param memory Pointer to the memory, or NULL.
+ */
+void obsidianFree(void *memory) {
+    free(memory);
+}
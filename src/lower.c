@@ -0,0 +1,471 @@
+/**
+ * @file lower.c
+ * @brief Implements the translation of the IR into bytecode for the virtual machine.
+ *
+ * Every value that needs one gets a register from the linear-scan allocator.
+ * Parameters are pinned to the registers the caller fills in, and the
+ * registers above the allocated ones form the call area: arguments are
+ * moved there and the callee's frame starts at the first of them, so a call
+ * never clobbers a live value of the caller.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/lower.h"
+#include "include/common.h"
+#include "include/regalloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct Fixup
+ * @brief A jump whose target block had not been placed when it was emitted.
+ */
+typedef struct {
+    int pc, block;
+} Fixup;
+
+/**
+ * @struct Lowering
+ * @brief The state of the bytecode generator while it lowers one function.
+ */
+typedef struct {
+    IrFunction *fn;
+    Module *module;
+    Function *function;
+    Allocation allocation;
+    int scratch;            ///< First register of the call area, free between instructions.
+    int *blockPc;
+    int *target;            ///< Block that a jump to each block actually lands on.
+    Fixup *fixups;
+    int fixupCount;
+    int failed;
+} Lowering;
+
+/**
+ * @brief Maps every type to the single register class of the virtual machine.
+ */
+static int vmClass(TypeKind type) {
+    (void)type;
+    return 0;
+}
+
+/**
+ * @brief Appends an instruction, recording allocation failure.
+ */
+static void emit(Lowering *lowering, uint32_t insn) {
+    if (emitInsn(lowering->function, insn) < 0) lowering->failed = 1;
+}
+
+/**
+ * @brief Returns the register of a value.
+ */
+static int reg(const Lowering *lowering, int value) {
+    return lowering->allocation.location[value];
+}
+
+/**
+ * @brief Reports whether a type uses the 64-bit integer opcodes.
+ */
+static int isWide(TypeKind type) {
+    return type == TypeI64 || type == TypeU64 || type == TypeString;
+}
+
+/**
+ * @brief Selects the opcode of an arithmetic or bitwise instruction for a type.
+ */
+static OpCode arithmeticOp(IrOp op, TypeKind type) {
+    int isUnsigned = isIntegerType(type) && !isSignedType(type);
+
+    if (type == TypeF32) {
+        switch (op) {
+            case IR_ADD: return OP_ADD_F32;
+            case IR_SUB: return OP_SUB_F32;
+            case IR_MUL: return OP_MUL_F32;
+            case IR_DIV: return OP_DIV_F32;
+            default: return OP_MOD_F32;
+        }
+    }
+    if (type == TypeF64) {
+        switch (op) {
+            case IR_ADD: return OP_ADD_F64;
+            case IR_SUB: return OP_SUB_F64;
+            case IR_MUL: return OP_MUL_F64;
+            case IR_DIV: return OP_DIV_F64;
+            default: return OP_MOD_F64;
+        }
+    }
+    if (isWide(type)) {
+        switch (op) {
+            case IR_ADD: return OP_ADD_I64;
+            case IR_SUB: return OP_SUB_I64;
+            case IR_MUL: return OP_MUL_I64;
+            case IR_DIV: return isUnsigned ? OP_DIV_U64 : OP_DIV_I64;
+            case IR_MOD: return isUnsigned ? OP_MOD_U64 : OP_MOD_I64;
+            case IR_AND: return OP_AND_I64;
+            case IR_OR: return OP_OR_I64;
+            case IR_XOR: return OP_XOR_I64;
+            case IR_SHL: return OP_SHL_I64;
+            default: return isUnsigned ? OP_SHR_U64 : OP_SHR_I64;
+        }
+    }
+    switch (op) {
+        case IR_ADD: return OP_ADD_I32;
+        case IR_SUB: return OP_SUB_I32;
+        case IR_MUL: return OP_MUL_I32;
+        case IR_DIV: return isUnsigned ? OP_DIV_U32 : OP_DIV_I32;
+        case IR_MOD: return isUnsigned ? OP_MOD_U32 : OP_MOD_I32;
+        case IR_AND: return OP_AND_I32;
+        case IR_OR: return OP_OR_I32;
+        case IR_XOR: return OP_XOR_I32;
+        case IR_SHL: return OP_SHL_I32;
+        default: return isUnsigned ? OP_SHR_U32 : OP_SHR_I32;
+    }
+}
+
+/**
+ * @brief Selects the opcode of a comparison for an operand type.
+ */
+static OpCode compareOp(IrOp op, TypeKind type) {
+    int isUnsigned = (isIntegerType(type) && !isSignedType(type)) || type == TypeBool || type == TypeChar;
+    int index = op == IR_EQ ? 0 : op == IR_NE ? 1 : op == IR_LT ? 2 : 3;
+
+    if (type == TypeF32) return (OpCode)(OP_EQ_F32 + index);
+    if (type == TypeF64) return (OpCode)(OP_EQ_F64 + index);
+    if (isWide(type)) {
+        if (index < 2) return (OpCode)(OP_EQ_I64 + index);
+        return (OpCode)((isUnsigned ? OP_LT_U64 : OP_LT_I64) + index - 2);
+    }
+    if (index < 2) return (OpCode)(OP_EQ_I32 + index);
+    return (OpCode)((isUnsigned ? OP_LT_U32 : OP_LT_I32) + index - 2);
+}
+
+/**
+ * @brief Re-normalizes a register after 32-bit arithmetic on an 8- or 16-bit type.
+ */
+static void emitNarrow(Lowering *lowering, int dst, TypeKind type) {
+    if (type == TypeI8 || type == TypeI16) {
+        emit(lowering, INSN_ABC(OP_CONV, dst, dst, (TypeI32 << 4) | type));
+    } else if (type == TypeU8 || type == TypeU16 || type == TypeChar) {
+        emit(lowering, INSN_ABC(OP_CONV, dst, dst, (TypeU32 << 4) | type));
+    }
+}
+
+/**
+ * @brief Emits the moves that give the phis of `target` their values from `block`.
+ *
+ * The moves happen in parallel, so they are ordered to never overwrite a
+ * register that a later move still reads; a cycle is broken by parking one
+ * register in the scratch register.
+ */
+static void emitPhiMoves(Lowering *lowering, int block, int target) {
+    const IrFunction *fn = lowering->fn;
+    const IrBlock *b = &fn->blocks[target];
+    int *dst = malloc((size_t)(b->insnCount + 1) * sizeof(int));
+    int *src = malloc((size_t)(b->insnCount + 1) * sizeof(int));
+    int index = -1, count = 0;
+
+    if (dst == NULL || src == NULL) outOfMemory(NULL);
+    for (int p = 0; p < b->predCount; p++) {
+        if (b->preds[p] == block) index = p;
+    }
+    for (int i = 0; index >= 0 && i < b->insnCount; i++) {
+        int phi = b->insns[i];
+        int from;
+        if (fn->insns[phi].op != IR_PHI) break;
+        if (reg(lowering, phi) < 0 || index >= fn->insns[phi].argCount) continue;
+        from = reg(lowering, fn->operands[fn->insns[phi].argStart + index]);
+        if (from < 0 || from == reg(lowering, phi)) continue;
+        dst[count] = reg(lowering, phi);
+        src[count] = from;
+        count++;
+    }
+
+    while (count > 0) {
+        int ready = -1;
+        for (int i = 0; i < count && ready < 0; i++) {
+            int blocked = 0;
+            for (int j = 0; j < count; j++) {
+                if (j != i && src[j] == dst[i]) {
+                    blocked = 1;
+                    break;
+                }
+            }
+            if (!blocked) ready = i;
+        }
+
+        if (ready < 0) {
+            emit(lowering, INSN_ABC(OP_MOVE, lowering->scratch, dst[0], 0));
+            for (int j = 0; j < count; j++) {
+                if (src[j] == dst[0]) src[j] = lowering->scratch;
+            }
+            ready = 0;
+        }
+        if (dst[ready] != src[ready]) emit(lowering, INSN_ABC(OP_MOVE, dst[ready], src[ready], 0));
+        dst[ready] = dst[count - 1];
+        src[ready] = src[count - 1];
+        count--;
+    }
+
+    free(dst);
+    free(src);
+}
+
+/**
+ * @brief Emits a jump to a block, to be patched once every block is placed.
+ */
+static void emitJumpTo(Lowering *lowering, OpCode op, int condition, int block) {
+    Fixup *fixups = realloc(lowering->fixups, (size_t)(lowering->fixupCount + 1) * sizeof(Fixup));
+    if (fixups == NULL) {
+        lowering->failed = 1;
+        return;
+    }
+    lowering->fixups = fixups;
+    lowering->fixups[lowering->fixupCount].pc = lowering->function->codeCount;
+    lowering->fixups[lowering->fixupCount].block = block;
+    lowering->fixupCount++;
+    emit(lowering, INSN_ASBX(op, condition < 0 ? 0 : condition, 0));
+}
+
+/**
+ * @brief Emits one IR instruction.
+ *
+ * @param lowering Pointer to the lowering state.
+ * @param value The instruction to lower.
+ * @param next The block laid out after the current one, or IR_NONE.
+ */
+static void lowerInsn(Lowering *lowering, int value, int next) {
+    const IrFunction *fn = lowering->fn;
+    const IrInsn *insn = &fn->insns[value];
+    const int *args = fn->operands + insn->argStart;
+    int dst = reg(lowering, value);
+
+    if (dst < 0 && insn->type != TypeVoid) {
+        if (irIsPure(fn, value) || insn->op == IR_PHI || insn->op == IR_PARAM) return;
+        dst = lowering->scratch;
+    }
+
+    switch (insn->op) {
+        case IR_NOP: case IR_PARAM: case IR_PHI:
+            break;
+
+        case IR_CONST: {
+            Slot constant = insn->as.constant;
+            int index;
+            if (insn->type == TypeString) {
+                constant.str = arenaCopy(&lowering->module->strings, constant.str, strlen(constant.str) + 1);
+                if (constant.str == NULL) {
+                    lowering->failed = 1;
+                    break;
+                }
+            }
+            index = addConstant(lowering->function, constant);
+            if (index < 0 || index > INSN_MAX_BX) {
+                lowering->failed = 1;
+                break;
+            }
+            emit(lowering, INSN_ABX(OP_LOADK, dst, index));
+            break;
+        }
+
+        case IR_COPY:
+            if (dst != reg(lowering, args[0])) emit(lowering, INSN_ABC(OP_MOVE, dst, reg(lowering, args[0]), 0));
+            break;
+
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_AND: case IR_OR: case IR_XOR: case IR_SHL: case IR_SHR:
+            emit(lowering, INSN_ABC(arithmeticOp(insn->op, insn->type), dst, reg(lowering, args[0]), reg(lowering, args[1])));
+            emitNarrow(lowering, dst, insn->type);
+            break;
+
+        case IR_NEG: {
+            TypeKind type = insn->type;
+            OpCode op = type == TypeF32 ? OP_NEG_F32 : type == TypeF64 ? OP_NEG_F64 : isWide(type) ? OP_NEG_I64 : OP_NEG_I32;
+            emit(lowering, INSN_ABC(op, dst, reg(lowering, args[0]), 0));
+            emitNarrow(lowering, dst, type);
+            break;
+        }
+
+        case IR_BNOT:
+            emit(lowering, INSN_ABC(isWide(insn->type) ? OP_BNOT_I64 : OP_BNOT_I32, dst, reg(lowering, args[0]), 0));
+            emitNarrow(lowering, dst, insn->type);
+            break;
+
+        case IR_NOT:
+            emit(lowering, INSN_ABC(OP_NOT, dst, reg(lowering, args[0]), 0));
+            break;
+
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+            emit(lowering, INSN_ABC(compareOp(insn->op, insn->operandType), dst, reg(lowering, args[0]), reg(lowering, args[1])));
+            break;
+
+        case IR_CONV:
+            emit(lowering, INSN_ABC(OP_CONV, dst, reg(lowering, args[0]), ((unsigned)insn->operandType << 4) | (unsigned)insn->type));
+            break;
+
+        case IR_CALL:
+            for (int i = 0; i < insn->argCount; i++) {
+                emit(lowering, INSN_ABC(OP_MOVE, lowering->scratch + i, reg(lowering, args[i]), 0));
+            }
+            emit(lowering, INSN_ABX(OP_CALL, lowering->scratch, insn->as.index));
+            if (reg(lowering, value) >= 0) emit(lowering, INSN_ABC(OP_MOVE, dst, lowering->scratch, 0));
+            break;
+
+        case IR_PRINT:
+            emit(lowering, INSN_ABC(OP_PRINT, reg(lowering, args[0]), insn->operandType, 0));
+            break;
+
+        case IR_JUMP: {
+            int target = lowering->target[insn->as.targets[0]];
+            emitPhiMoves(lowering, insn->block, insn->as.targets[0]);
+            if (target != next) emitJumpTo(lowering, OP_JMP, -1, target);
+            break;
+        }
+
+        case IR_BRANCH: {
+            int condition = reg(lowering, args[0]);
+            int taken = lowering->target[insn->as.targets[0]];
+            int notTaken = lowering->target[insn->as.targets[1]];
+            if (notTaken == next) {
+                emitJumpTo(lowering, OP_JMPT, condition, taken);
+            } else if (taken == next) {
+                emitJumpTo(lowering, OP_JMPF, condition, notTaken);
+            } else {
+                emitJumpTo(lowering, OP_JMPF, condition, notTaken);
+                emitJumpTo(lowering, OP_JMP, -1, taken);
+            }
+            break;
+        }
+
+        case IR_RET:
+            if (insn->argCount == 0) {
+                emit(lowering, INSN_ABC(OP_RETV, 0, 0, 0));
+            } else {
+                emit(lowering, INSN_ABC(OP_RET, reg(lowering, args[0]), 0, 0));
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Generates the bytecode of one function.
+ *
+ * @return int Returns 0 on success, or -1 if the function cannot be encoded.
+ */
+static int lowerFunction(IrFunction *fn, Module *module, Function *function) {
+    Lowering lowering;
+    LiveIntervals live;
+    RegisterFile file;
+    int *fixed;
+    int maxArgs = 1;
+
+    irRemoveUnreachable(fn);
+    irSplitEdges(fn);
+    computeLiveIntervals(fn, &live);
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        if (fn->insns[v].op == IR_CALL && fn->insns[v].argCount > maxArgs) maxArgs = fn->insns[v].argCount;
+    }
+
+    fixed = malloc((size_t)(fn->insnCount + 1) * sizeof(int));
+    if (fixed == NULL) {
+        freeLiveIntervals(&live);
+        return -1;
+    }
+    for (int v = 0; v < fn->insnCount; v++) {
+        fixed[v] = fn->insns[v].op == IR_PARAM ? fn->insns[v].as.index : -1;
+    }
+
+    memset(&file, 0, sizeof(file));
+    file.registerCounts[0] = VM_MAX_REGISTERS - maxArgs;
+    file.classOf = vmClass;
+
+    memset(&lowering, 0, sizeof(lowering));
+    lowering.fn = fn;
+    lowering.module = module;
+    lowering.function = function;
+    allocateRegisters(fn, &live, &file, fixed, &lowering.allocation);
+    free(fixed);
+
+    if (lowering.allocation.spillCount > 0) {
+        fprintf(stderr, "obsidian: error: function '%s' needs too many registers\n", fn->name);
+        freeAllocation(&lowering.allocation);
+        freeLiveIntervals(&live);
+        return -1;
+    }
+
+    lowering.scratch = lowering.allocation.registersUsed[0];
+    if (lowering.scratch < fn->paramCount) lowering.scratch = fn->paramCount;
+    function->paramCount = fn->paramCount;
+    function->returnType = fn->returnType;
+    function->registerCount = lowering.scratch + maxArgs;
+
+    lowering.blockPc = malloc((size_t)(fn->blockCount + 1) * sizeof(int));
+    lowering.target = malloc((size_t)(fn->blockCount + 1) * sizeof(int));
+    if (lowering.blockPc == NULL || lowering.target == NULL) {
+        lowering.failed = 1;
+    } else {
+        threadJumps(fn, &live, &lowering.allocation, lowering.target);
+    }
+
+    for (int i = 0; !lowering.failed && i < live.layoutCount; i++) {
+        int b = live.layout[i];
+        int next = IR_NONE;
+        if (lowering.target[b] != b) continue;
+        for (int j = i + 1; j < live.layoutCount && next == IR_NONE; j++) {
+            if (lowering.target[live.layout[j]] == live.layout[j]) next = live.layout[j];
+        }
+        lowering.blockPc[b] = function->codeCount;
+        for (int k = 0; k < fn->blocks[b].insnCount; k++) {
+            lowerInsn(&lowering, fn->blocks[b].insns[k], next);
+        }
+    }
+
+    for (int i = 0; !lowering.failed && i < lowering.fixupCount; i++) {
+        int pc = lowering.fixups[i].pc;
+        int offset = lowering.blockPc[lowering.fixups[i].block] - (pc + 1);
+        uint32_t insn = function->code[pc];
+        if (offset > INSN_SBX_BIAS || offset < -INSN_SBX_BIAS) {
+            fprintf(stderr, "obsidian: error: function '%s' is too large to compile\n", fn->name);
+            lowering.failed = 1;
+            break;
+        }
+        function->code[pc] = INSN_ASBX(INSN_OP(insn), INSN_A(insn), offset);
+    }
+
+    free(lowering.blockPc);
+    free(lowering.target);
+    free(lowering.fixups);
+    freeAllocation(&lowering.allocation);
+    freeLiveIntervals(&live);
+    return lowering.failed ? -1 : 0;
+}
+
+/**
+ * @brief Generates bytecode for every function of an IR module.
+ *
+ * @param ir Pointer to the IR module.
+ * @param module Pointer to an initialized module that receives the bytecode.
+ * @return int Returns 0 on success, or -1 if a function cannot be encoded or is external.
+ */
+int lowerModule(IrModule *ir, Module *module) {
+    for (int i = 0; i < ir->functionCount; i++) {
+        if (ir->functions[i].external) {
+            fprintf(stderr, "obsidian: error: '%s' is imported from another module and cannot be run by the interpreter\n",
+                    ir->functions[i].name);
+            return -1;
+        }
+        if (addFunction(module, ir->functions[i].name) < 0) return -1;
+    }
+    for (int i = 0; i < ir->functionCount; i++) {
+        if (lowerFunction(&ir->functions[i], module, &module->functions[i]) != 0) return -1;
+    }
+    return prepareModule(module);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file memstats.c
+ * @brief Implements the memory accounting of the Obsidian compiler.
+ *
+ * The counters are process-wide and shared by every library session, so
+ * they are updated with relaxed atomic operations where the compiler offers
+ * them. A snapshot is not taken atomically as a whole; each counter in it is
+ * individually exact.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/memstats.h"
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+static const char *const categoryNames[MEM_CATEGORY_COUNT] = {
+    "source", "tokens", "symbols", "arenas"
+};
+
+static MemStats counters;
+
+#if defined(__GNUC__)
+    #define COUNTER_ADD(counter, value) __atomic_add_fetch(&(counter), (value), __ATOMIC_RELAXED)
+    #define COUNTER_SUB(counter, value) __atomic_sub_fetch(&(counter), (value), __ATOMIC_RELAXED)
+    #define COUNTER_LOAD(counter) __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#else
+    #define COUNTER_ADD(counter, value) ((counter) += (value))
+    #define COUNTER_SUB(counter, value) ((counter) -= (value))
+    #define COUNTER_LOAD(counter) (counter)
+#endif
+
+/**
+ * @brief Raises a peak counter to a value if the value is higher.
+ */
+static void raisePeak(size_t *peak, size_t value) {
+#if defined(__GNUC__)
+    size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(peak, &seen, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#else
+    if (value > *peak) *peak = value;
+#endif
+}
+
+/**
+ * @brief Records memory taken by a subsystem.
+ *
+ * @param category The subsystem that holds the memory.
+ * @param bytes The number of bytes allocated.
+ */
+void memAcquire(MemCategory category, size_t bytes) {
+    raisePeak(&counters.peak[category], COUNTER_ADD(counters.current[category], bytes));
+    raisePeak(&counters.totalPeak, COUNTER_ADD(counters.totalCurrent, bytes));
+}
+
+/**
+ * @brief Records memory given back by a subsystem.
+ *
+ * @param category The subsystem that held the memory.
+ * @param bytes The number of bytes freed.
+ */
+void memRelease(MemCategory category, size_t bytes) {
+    COUNTER_SUB(counters.current[category], bytes);
+    COUNTER_SUB(counters.totalCurrent, bytes);
+}
+
+/**
+ * @brief Records that a source buffer was lexed.
+ *
+ * @param sourceBytes The length of the source in bytes.
+ * @param tokens The number of tokens it produced.
+ */
+void memNoteLexed(size_t sourceBytes, size_t tokens) {
+    COUNTER_ADD(counters.sourceBytes, sourceBytes);
+    COUNTER_ADD(counters.tokens, tokens);
+}
+
+/**
+ * @brief Records that a diagnostic was reported.
+ *
+ * @param bytes The size of its message and quoted source line.
+ */
+void memNoteDiagnostic(size_t bytes) {
+    COUNTER_ADD(counters.diagnostics, 1);
+    COUNTER_ADD(counters.diagnosticBytes, bytes);
+}
+
+/**
+ * @brief Returns the peak resident set size of the process in bytes, or -1 if unknown.
+ */
+static long long peakResident(void) {
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(__APPLE__)
+    return (long long)usage.ru_maxrss;
+#else
+    return (long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/**
+ * @brief Takes a snapshot of the counters and the peak resident set size.
+ *
+ * @param stats Pointer to the snapshot to fill.
+ */
+void getMemStats(MemStats *stats) {
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) {
+        stats->current[i] = COUNTER_LOAD(counters.current[i]);
+        stats->peak[i] = COUNTER_LOAD(counters.peak[i]);
+    }
+    stats->totalCurrent = COUNTER_LOAD(counters.totalCurrent);
+    stats->totalPeak = COUNTER_LOAD(counters.totalPeak);
+    stats->sourceBytes = COUNTER_LOAD(counters.sourceBytes);
+    stats->tokens = COUNTER_LOAD(counters.tokens);
+    stats->diagnostics = COUNTER_LOAD(counters.diagnostics);
+    stats->diagnosticBytes = COUNTER_LOAD(counters.diagnosticBytes);
+    stats->peakResident = peakResident();
+}
+
+/**
+ * @brief Divides two counts, returning 0 when the divisor is 0.
+ */
+static double ratio(size_t bytes, size_t count) {
+    return count == 0 ? 0.0 : (double)bytes / (double)count;
+}
+
+/**
+ * @brief Writes a snapshot as a table.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the snapshot.
+ */
+void printMemReport(FILE *out, const MemStats *stats) {
+    fprintf(out, "%-18s %12s %12s\n", "memory", "current", "peak");
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) {
+        fprintf(out, "%-18s %12zu %12zu\n", categoryNames[i], stats->current[i], stats->peak[i]);
+    }
+    fprintf(out, "%-18s %12zu %12zu\n", "total", stats->totalCurrent, stats->totalPeak);
+    if (stats->peakResident >= 0) fprintf(out, "%-18s %12s %12lld\n", "resident", "", stats->peakResident);
+    else fprintf(out, "%-18s %12s %12s\n", "resident", "", "n/a");
+
+    fprintf(out, "%-18s %12zu bytes, %zu tokens\n", "lexed", stats->sourceBytes, stats->tokens);
+    fprintf(out, "%-18s %12.2f per source byte, %.2f per token\n", "tracked peak",
+            ratio(stats->totalPeak, stats->sourceBytes), ratio(stats->totalPeak, stats->tokens));
+    fprintf(out, "%-18s %12.2f per token\n", "token arrays", ratio(stats->current[MEM_TOKENS], stats->tokens));
+    fprintf(out, "%-18s %12zu reported, %zu bytes\n", "diagnostics", stats->diagnostics, stats->diagnosticBytes);
+}
+
+/**
+ * @brief Writes a snapshot as a JSON object.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the snapshot.
+ */
+void printMemJson(FILE *out, const MemStats *stats) {
+    fputs("{\"categories\": {", out);
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) {
+        fprintf(out, "%s\"%s\": {\"current\": %zu, \"peak\": %zu}", i > 0 ? ", " : "", categoryNames[i],
+                stats->current[i], stats->peak[i]);
+    }
+    fprintf(out, "}, \"total\": {\"current\": %zu, \"peak\": %zu}, ", stats->totalCurrent, stats->totalPeak);
+    if (stats->peakResident >= 0) fprintf(out, "\"peak_resident\": %lld, ", stats->peakResident);
+    else fputs("\"peak_resident\": null, ", out);
+    fprintf(out, "\"source_bytes\": %zu, \"tokens\": %zu, ", stats->sourceBytes, stats->tokens);
+    fprintf(out, "\"bytes_per_source_byte\": %.4f, \"bytes_per_token\": %.4f, \"token_bytes_per_token\": %.4f, ",
+            ratio(stats->totalPeak, stats->sourceBytes), ratio(stats->totalPeak, stats->tokens),
+            ratio(stats->current[MEM_TOKENS], stats->tokens));
+    fprintf(out, "\"diagnostics\": {\"count\": %zu, \"bytes\": %zu}}", stats->diagnostics, stats->diagnosticBytes);
+}
@@ -0,0 +1,403 @@
+/**
+ * @file object.c
+ * @brief Implements the ELF64 relocatable object writer of the Obsidian compiler.
+ *
+ * The file is laid out as the ELF header, the contents of every section,
+ * and then the section header table. Every field is written in little-endian
+ * byte order one value at a time, so the output does not depend on the
+ * host's structure layout or byte order. ELF requires local symbols to come
+ * before global ones, so symbols are renumbered in that order on output and
+ * the relocations are rewritten to match.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "include/object.h"
+#include "include/common.h"
+#include "include/writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#define ELF_HEADER_SIZE 64
+#define SECTION_HEADER_SIZE 64
+#define SYMBOL_SIZE 24
+#define RELOCATION_SIZE 24
+
+#define SHT_PROGBITS 1
+#define SHT_SYMTAB 2
+#define SHT_STRTAB 3
+#define SHT_RELA 4
+
+#define SHF_ALLOC 0x2
+#define SHF_EXECINSTR 0x4
+#define SHF_INFO_LINK 0x40
+
+#define STB_LOCAL 0
+#define STB_GLOBAL 1
+#define STT_NOTYPE 0
+#define STT_FUNC 2
+#define STT_SECTION 3
+
+/**
+ * @brief Section header indices of the output file.
+ */
+enum {
+    SECTION_NULL, SECTION_TEXT, SECTION_RODATA, SECTION_RELA_TEXT, SECTION_NOTE, SECTION_SYMTAB, SECTION_STRTAB,
+    SECTION_SHSTRTAB, SECTION_COUNT
+};
+
+/**
+ * @brief Names of the output sections, in the order of their indices.
+ */
+static const char sectionNames[] = "\0.text\0.rodata\0.rela.text\0.note.GNU-stack\0.symtab\0.strtab\0.shstrtab";
+
+/**
+ * @brief Grows an array; running out of memory goes to outOfMemory().
+ */
+static void *growArray(void *array, size_t count, size_t size) {
+    void *memory = realloc(array, count * size);
+    if (memory == NULL) outOfMemory(NULL);
+    return memory;
+}
+
+/**
+ * @brief Initializes an empty object file.
+ *
+ * @param object Pointer to the object file to initialize.
+ */
+void initObjectFile(ObjectFile *object) {
+    memset(object, 0, sizeof(*object));
+    appendObjectBytes(&object->strings, "", 1);
+}
+
+/**
+ * @brief Frees the memory owned by an object file.
+ *
+ * @param object Pointer to the object file to free.
+ */
+void freeObjectFile(ObjectFile *object) {
+    free(object->sections[OBJECT_TEXT].data);
+    free(object->sections[OBJECT_RODATA].data);
+    free(object->strings.data);
+    free(object->symbols);
+    free(object->relocations);
+    memset(object, 0, sizeof(*object));
+}
+
+/**
+ * @brief Appends bytes to a section.
+ *
+ * Like the rest of the compiler, this calls outOfMemory() if memory runs out.
+ *
+ * @param section Pointer to the section.
+ * @param data Pointer to the bytes to append.
+ * @param size Number of bytes to append.
+ */
+void appendObjectBytes(ObjectSection *section, const void *data, size_t size) {
+    if (section->size + size > section->capacity) {
+        size_t capacity = section->capacity ? section->capacity * 2 : 4096;
+        while (capacity < section->size + size) capacity *= 2;
+        section->data = growArray(section->data, capacity, 1);
+        section->capacity = capacity;
+    }
+    memcpy(section->data + section->size, data, size);
+    section->size += size;
+}
+
+/**
+ * @brief Pads a section to a multiple of an alignment.
+ *
+ * @param section Pointer to the section.
+ * @param alignment The alignment, a power of two.
+ * @param fill The byte to pad with.
+ */
+void alignObjectSection(ObjectSection *section, size_t alignment, unsigned char fill) {
+    while (section->size & (alignment - 1)) appendObjectBytes(section, &fill, 1);
+}
+
+/**
+ * @brief Adds a symbol.
+ *
+ * Symbols defined in the code section are typed as functions.
+ *
+ * @param object Pointer to the object file.
+ * @param name The name of the symbol.
+ * @param section The section that defines it, or OBJECT_UNDEFINED.
+ * @param value Offset of the symbol in its section.
+ * @param size Size of what the symbol names.
+ * @param global Whether the symbol is visible to other objects; undefined symbols always are.
+ * @return int The index of the symbol.
+ */
+int addObjectSymbol(ObjectFile *object, const char *name, int section, uint64_t value, uint64_t size, int global) {
+    ObjectSymbol *symbol;
+
+    if (object->symbolCount == object->symbolCapacity) {
+        object->symbolCapacity = object->symbolCapacity ? object->symbolCapacity * 2 : 64;
+        object->symbols = growArray(object->symbols, (size_t)object->symbolCapacity, sizeof(ObjectSymbol));
+    }
+    symbol = &object->symbols[object->symbolCount];
+    symbol->name = (uint32_t)object->strings.size;
+    symbol->section = section;
+    symbol->value = value;
+    symbol->size = size;
+    symbol->global = global || section == OBJECT_UNDEFINED;
+    appendObjectBytes(&object->strings, name, strlen(name) + 1);
+    return object->symbolCount++;
+}
+
+/**
+ * @brief Adds a relocation to the code section.
+ *
+ * @param object Pointer to the object file.
+ * @param offset Position of the 32-bit field in the code section.
+ * @param symbol The symbol referred to.
+ * @param type The relocation type, such as R_X86_64_PC32.
+ * @param addend The value added to the symbol's address.
+ * @return int The index of the relocation, whose addend may still be changed.
+ */
+int addObjectRelocation(ObjectFile *object, uint64_t offset, int symbol, uint32_t type, int64_t addend) {
+    ObjectRelocation *relocation;
+
+    if (object->relocationCount == object->relocationCapacity) {
+        object->relocationCapacity = object->relocationCapacity ? object->relocationCapacity * 2 : 64;
+        object->relocations = growArray(object->relocations, (size_t)object->relocationCapacity, sizeof(ObjectRelocation));
+    }
+    relocation = &object->relocations[object->relocationCount];
+    relocation->offset = offset;
+    relocation->symbol = symbol;
+    relocation->type = type;
+    relocation->addend = addend;
+    return object->relocationCount++;
+}
+
+/**
+ * @brief Writes an unsigned value of 1 to 8 bytes in little-endian order.
+ */
+static void writeLittle(Writer *writer, uint64_t value, int bytes) {
+    unsigned char data[8];
+    for (int i = 0; i < bytes; i++) data[i] = (unsigned char)(value >> (8 * i));
+    writeBytes(writer, data, (size_t)bytes);
+}
+
+/**
+ * @brief Pads the file to a multiple of an alignment and returns the new offset.
+ */
+static size_t padTo(Writer *writer, size_t offset, size_t alignment) {
+    static const char zeros[16] = { 0 };
+    size_t padding = (alignment - offset % alignment) % alignment;
+    writeBytes(writer, zeros, padding);
+    return offset + padding;
+}
+
+/**
+ * @brief Writes one section header.
+ */
+static void writeSectionHeader(Writer *writer, uint32_t name, uint32_t type, uint64_t flags, uint64_t offset,
+                               uint64_t size, uint32_t link, uint32_t info, uint64_t alignment, uint64_t entrySize) {
+    writeLittle(writer, name, 4);
+    writeLittle(writer, type, 4);
+    writeLittle(writer, flags, 8);
+    writeLittle(writer, 0, 8);
+    writeLittle(writer, offset, 8);
+    writeLittle(writer, size, 8);
+    writeLittle(writer, link, 4);
+    writeLittle(writer, info, 4);
+    writeLittle(writer, alignment, 8);
+    writeLittle(writer, entrySize, 8);
+}
+
+/**
+ * @brief Writes one symbol table entry.
+ */
+static void writeSymbol(Writer *writer, uint32_t name, int binding, int type, uint16_t section, uint64_t value,
+                        uint64_t size) {
+    writeLittle(writer, name, 4);
+    writeLittle(writer, (uint64_t)((binding << 4) | type), 1);
+    writeLittle(writer, 0, 1);
+    writeLittle(writer, section, 2);
+    writeLittle(writer, value, 8);
+    writeLittle(writer, size, 8);
+}
+
+/**
+ * @brief Returns the offset of a section's name in the section name table.
+ */
+static uint32_t sectionName(int index) {
+    const char *name = sectionNames;
+    for (int i = 0; i < index; i++) name += strlen(name) + 1;
+    return (uint32_t)(name - sectionNames);
+}
+
+/**
+ * @brief Writes a file's contents with a single write where the platform allows it.
+ */
+static int writeWhole(const char *path, const char *data, size_t size) {
+#ifndef _WIN32
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    int status = 0;
+
+    if (fd < 0) return -1;
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            status = -1;
+            break;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    if (close(fd) != 0) status = -1;
+    return status;
+#else
+    FILE *file = fopen(path, "wb");
+    int status;
+
+    if (file == NULL) return -1;
+    status = fwrite(data, 1, size, file) == size ? 0 : -1;
+    if (fclose(file) != 0) status = -1;
+    return status;
+#endif
+}
+
+/**
+ * @brief Writes an object file.
+ *
+ * The sections, symbol table, string tables, relocations, and section
+ * headers are assembled in memory and written with a single write.
+ *
+ * @param object Pointer to the object file.
+ * @param path The file to create.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int writeObjectFile(const ObjectFile *object, const char *path) {
+    const ObjectSection *text = &object->sections[OBJECT_TEXT], *rodata = &object->sections[OBJECT_RODATA];
+    uint64_t offsets[SECTION_COUNT], sizes[SECTION_COUNT];
+    int *order = malloc((size_t)(object->symbolCount + 1) * sizeof(int));
+    Writer *writer = malloc(sizeof(Writer));
+    int firstGlobal = 3, status;
+    size_t offset, size;
+    char *image;
+
+    if (order == NULL || writer == NULL) {
+        free(order);
+        free(writer);
+        return -1;
+    }
+
+    /* The null symbol and the two section symbols come first, then the locals, then the globals. */
+    for (int pass = 0, next = 3; pass < 2; pass++) {
+        for (int i = 0; i < object->symbolCount; i++) {
+            if (object->symbols[i].global == pass) order[i] = next++;
+        }
+        if (pass == 0) firstGlobal = next;
+    }
+
+    initWriter(writer, NULL);
+    writeBytes(writer, "\177ELF\2\1\1\0\0\0\0\0\0\0\0\0", 16);
+    writeLittle(writer, 1, 2);                              /* ET_REL */
+    writeLittle(writer, 62, 2);                             /* EM_X86_64 */
+    writeLittle(writer, 1, 4);
+    writeLittle(writer, 0, 8);
+    writeLittle(writer, 0, 8);
+    {
+        /* The section header table follows the contents, whose size is known up front. */
+        size_t end = ELF_HEADER_SIZE;
+        end = (end + 15) / 16 * 16 + text->size;
+        end = (end + 15) / 16 * 16 + rodata->size;
+        end = (end + 7) / 8 * 8 + (size_t)object->relocationCount * RELOCATION_SIZE;
+        end = (end + 7) / 8 * 8 + (size_t)(object->symbolCount + 3) * SYMBOL_SIZE;
+        end += object->strings.size + sizeof(sectionNames);
+        writeLittle(writer, (end + 7) / 8 * 8, 8);
+    }
+    writeLittle(writer, 0, 4);
+    writeLittle(writer, ELF_HEADER_SIZE, 2);
+    writeLittle(writer, 0, 2);
+    writeLittle(writer, 0, 2);
+    writeLittle(writer, SECTION_HEADER_SIZE, 2);
+    writeLittle(writer, SECTION_COUNT, 2);
+    writeLittle(writer, SECTION_SHSTRTAB, 2);
+    offset = ELF_HEADER_SIZE;
+
+    offsets[SECTION_TEXT] = offset = padTo(writer, offset, 16);
+    writeBytes(writer, text->data, text->size);
+    offset += sizes[SECTION_TEXT] = text->size;
+
+    offsets[SECTION_RODATA] = offset = padTo(writer, offset, 16);
+    writeBytes(writer, rodata->data, rodata->size);
+    offset += sizes[SECTION_RODATA] = rodata->size;
+
+    offsets[SECTION_RELA_TEXT] = offset = padTo(writer, offset, 8);
+    for (int i = 0; i < object->relocationCount; i++) {
+        const ObjectRelocation *relocation = &object->relocations[i];
+        uint64_t symbol = relocation->symbol < 0 ? (uint64_t)(-relocation->symbol) : (uint64_t)order[relocation->symbol];
+        writeLittle(writer, relocation->offset, 8);
+        writeLittle(writer, symbol << 32 | relocation->type, 8);
+        writeLittle(writer, (uint64_t)relocation->addend, 8);
+    }
+    offset += sizes[SECTION_RELA_TEXT] = (uint64_t)object->relocationCount * RELOCATION_SIZE;
+
+    offsets[SECTION_NOTE] = offset;
+    sizes[SECTION_NOTE] = 0;
+
+    offsets[SECTION_SYMTAB] = offset = padTo(writer, offset, 8);
+    writeSymbol(writer, 0, STB_LOCAL, STT_NOTYPE, 0, 0, 0);
+    writeSymbol(writer, 0, STB_LOCAL, STT_SECTION, SECTION_TEXT, 0, 0);
+    writeSymbol(writer, 0, STB_LOCAL, STT_SECTION, SECTION_RODATA, 0, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < object->symbolCount; i++) {
+            const ObjectSymbol *symbol = &object->symbols[i];
+            uint16_t section = symbol->section == OBJECT_UNDEFINED ? 0 : (uint16_t)(SECTION_TEXT + symbol->section);
+            if (symbol->global != pass) continue;
+            writeSymbol(writer, symbol->name, pass ? STB_GLOBAL : STB_LOCAL,
+                        symbol->section == OBJECT_TEXT ? STT_FUNC : STT_NOTYPE, section, symbol->value, symbol->size);
+        }
+    }
+    offset += sizes[SECTION_SYMTAB] = (uint64_t)(object->symbolCount + 3) * SYMBOL_SIZE;
+
+    offsets[SECTION_STRTAB] = offset;
+    writeBytes(writer, object->strings.data, object->strings.size);
+    offset += sizes[SECTION_STRTAB] = object->strings.size;
+
+    offsets[SECTION_SHSTRTAB] = offset;
+    writeBytes(writer, sectionNames, sizeof(sectionNames));
+    offset += sizes[SECTION_SHSTRTAB] = sizeof(sectionNames);
+
+    padTo(writer, offset, 8);
+    writeSectionHeader(writer, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    writeSectionHeader(writer, sectionName(SECTION_TEXT), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                       offsets[SECTION_TEXT], sizes[SECTION_TEXT], 0, 0, 16, 0);
+    writeSectionHeader(writer, sectionName(SECTION_RODATA), SHT_PROGBITS, SHF_ALLOC, offsets[SECTION_RODATA],
+                       sizes[SECTION_RODATA], 0, 0, 16, 0);
+    writeSectionHeader(writer, sectionName(SECTION_RELA_TEXT), SHT_RELA, SHF_INFO_LINK, offsets[SECTION_RELA_TEXT],
+                       sizes[SECTION_RELA_TEXT], SECTION_SYMTAB, SECTION_TEXT, 8, RELOCATION_SIZE);
+    writeSectionHeader(writer, sectionName(SECTION_NOTE), SHT_PROGBITS, 0, offsets[SECTION_NOTE], 0, 0, 0, 1, 0);
+    writeSectionHeader(writer, sectionName(SECTION_SYMTAB), SHT_SYMTAB, 0, offsets[SECTION_SYMTAB],
+                       sizes[SECTION_SYMTAB], SECTION_STRTAB, (uint32_t)firstGlobal, 8, SYMBOL_SIZE);
+    writeSectionHeader(writer, sectionName(SECTION_STRTAB), SHT_STRTAB, 0, offsets[SECTION_STRTAB],
+                       sizes[SECTION_STRTAB], 0, 0, 1, 0);
+    writeSectionHeader(writer, sectionName(SECTION_SHSTRTAB), SHT_STRTAB, 0, offsets[SECTION_SHSTRTAB],
+                       sizes[SECTION_SHSTRTAB], 0, 0, 1, 0);
+
+    image = takeWriterMemory(writer, &size);
+    free(writer);
+    free(order);
+    if (image == NULL) return -1;
+    status = writeWhole(path, image, size);
+    free(image);
+    return status;
+}
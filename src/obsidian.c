@@ -17,8 +17,10 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif // WIN32
 
-#include "include/common.h"
-#include "include/lexer.h"
+#include "include/daemon.h"
+#include "include/driver.h"
+#include "include/fmt.h"
+#include "include/watch.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -26,87 +28,50 @@
 /**
  * @brief The main entry point of the Obsidian compiler.
  * 
- * This function processes command-line arguments, opens the input file,
- * reads its contents into memory, initializes the lexer, and retrieves
- * tokens from the source code until the end of the file is reached.
+ * This function dispatches to one of five modes. `obsidian fmt` formats
+ * source files and takes the rest of the command line. `--daemon[=socket]` starts
+ * the persistent compiler daemon. `--watch [dir]` checks the sources under a
+ * directory and rechecks them as they change. `--client` forwards the remaining arguments
+ * to a running daemon, compiling in-process if none is reachable. Otherwise
+ * the arguments are handed straight to the driver.
  * 
  * @param argc The number of command-line arguments.
  * @param argv An array of command-line argument strings.
  * @return int Returns EXIT_SUCCESS on successful execution, or EXIT_FAILURE on error.
  */
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fputs("obsidian: error: no input file\n", stderr);
-        return EXIT_FAILURE;
+    char socketPath[512];
+    TokenCache cache;
+    int status;
+
+    if (argc > 1 && strcmp(argv[1], "fmt") == 0) {
+        return runFmt(argc - 2, argv + 2);
     }
 
-    long length;
-    FILE *file;
-    char *buffer;
-    Lexer lexer;
-    size_t bytesRead;
+    daemonSocketPath(socketPath, sizeof(socketPath));
 
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--version") == 0 || strcmp(argv[i], "-v") == 0) {
-            printVersion();
-            return EXIT_SUCCESS;
-        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            printHelpMenu();
-            return EXIT_SUCCESS;
-        } else if (strncmp(argv[i], "--help=", 7) == 0) {
-            const char *helpTopic = argv[i] + 7;
-            if (strcmp(helpTopic, "optimizers") == 0) {
-                printOptimizersHelp();
-            } else if (strcmp(helpTopic, "target") == 0) {
-                printTargetHelp();
-            } else if (strcmp(helpTopic, "warnings") == 0) {
-                printWarningsHelp();
-            } else {
-                fprintf(stderr, "unrecognized argument to '--help=' option: '%s'\n", helpTopic);
-                return EXIT_FAILURE;
+        if (strcmp(argv[i], "--daemon") == 0) {
+            return runDaemon(socketPath);
+        } else if (strncmp(argv[i], "--daemon=", 9) == 0) {
+            return runDaemon(argv[i] + 9);
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            return runWatch(i + 1 < argc && argv[i + 1][0] != '-' ? argv[i + 1] : ".");
+        } else if (strncmp(argv[i], "--watch=", 8) == 0) {
+            return runWatch(argv[i] + 8);
+        } else if (strcmp(argv[i], "--client") == 0) {
+            memmove(&argv[i], &argv[i + 1], (size_t)(argc - i) * sizeof(char *));
+            argc--;
+            if (runClient(socketPath, argc, argv, &status) == 0) {
+                return status;
             }
-            return EXIT_SUCCESS;
-        }
-    }
-     
-    file = fopen(argv[1], "r");
-    if (file == NULL) {
-        fputs("obsidian: error: could not read file\n", stderr);
-        return EXIT_FAILURE;
-    }
-
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    rewind(file);
-
-    buffer = (char *)malloc((size_t)(length + 1));
-    if (buffer == NULL) {
-        fprintf(stderr, "obsidian: error: could not allocate memory for file '%s'\n", argv[1]);
-        return EXIT_FAILURE;
-    }
-
-    bytesRead = fread(buffer, 1, (size_t)(length), file);
-    if (bytesRead != (size_t)length) {
-        fprintf(stderr, "obsidian: error: could not read file '%s'\n", argv[1]);
-        free(buffer);
-        fclose(file);
-        return EXIT_FAILURE;
-    }
-    buffer[length] = '\0';
-
-    initLexer(&lexer, buffer);
-
-    while (1) {
-        Token token = getNextToken(&lexer);
-        if (token.type == TEof) {
             break;
         }
-
-        printf("Token: %d\n", token.type);
     }
 
-    fclose(file);
-    free(buffer);
+    initTokenCache(&cache);
+    status = runCompiler(argc, argv, &cache);
+    freeTokenCache(&cache);
 
-    return EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,782 @@
+/**
+ * @file parser.c
+ * @brief Implements the parser for the Obsidian programming language.
+ *
+ * This file contains a recursive-descent parser that builds the abstract
+ * syntax tree from a token stream. Binary operators are parsed by precedence
+ * climbing over a single precedence table.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/parser.h"
+#include "include/common.h"
+#include "include/error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct NodeList
+ * @brief Growable array used while collecting the children of a node.
+ *
+ * The finished list is copied into the arena, so the heap buffer only lives
+ * while the node is being parsed.
+ */
+typedef struct {
+    void **items;
+    int count, capacity;
+} NodeList;
+
+static Expr *parseExpression(Parser *parser);
+static Stmt *parseStatement(Parser *parser);
+
+/**
+ * @brief Allocates memory from the parser's arena; running out goes to outOfMemory().
+ *
+ * @param parser Pointer to the parser instance.
+ * @param size Number of bytes to allocate.
+ * @return void* Pointer to zeroed memory.
+ */
+static void *allocNode(Parser *parser, size_t size) {
+    void *node = arenaAlloc(parser->arena, size);
+    if (node == NULL) outOfMemory("parsing");
+    return node;
+}
+
+/**
+ * @brief Appends an item to a node list.
+ *
+ * @param list Pointer to the list.
+ * @param item The item to append.
+ */
+static void pushNode(NodeList *list, void *item) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        void **items = realloc(list->items, (size_t)capacity * sizeof(void *));
+        if (items == NULL) outOfMemory("parsing");
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+}
+
+/**
+ * @brief Moves a node list into the arena and releases its heap buffer.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param list Pointer to the list.
+ * @return void** The arena copy of the items, or NULL for an empty list.
+ */
+static void **finishNodes(Parser *parser, NodeList *list) {
+    void **items = NULL;
+    if (list->count > 0) {
+        items = allocNode(parser, (size_t)list->count * sizeof(void *));
+        memcpy(items, list->items, (size_t)list->count * sizeof(void *));
+    }
+    free(list->items);
+    list->items = NULL;
+    return items;
+}
+
+/**
+ * @brief Returns the current token without consuming it.
+ */
+static const Token *peek(const Parser *parser) {
+    return &parser->tokens[parser->current];
+}
+
+/**
+ * @brief Checks whether the current token has the given kind.
+ */
+static int check(const Parser *parser, TokenKind kind) {
+    return peek(parser)->type == kind;
+}
+
+/**
+ * @brief Consumes and returns the current token.
+ */
+static const Token *advance(Parser *parser) {
+    const Token *token = peek(parser);
+    if (token->type != TEof) parser->current++;
+    return token;
+}
+
+/**
+ * @brief Consumes the current token if it has the given kind.
+ *
+ * @return int Non-zero if the token was consumed.
+ */
+static int match(Parser *parser, TokenKind kind) {
+    if (!check(parser, kind)) return 0;
+    advance(parser);
+    return 1;
+}
+
+/**
+ * @brief Reports a syntax error at a token unless the parser is already recovering.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param token The token the error refers to.
+ * @param message The error message to display.
+ */
+static void syntaxError(Parser *parser, const Token *token, const char *message) {
+    if (parser->panicMode) return;
+    parser->panicMode = 1;
+    parser->hadError = 1;
+    reportError(parser->diagnostics, SyntaxError, message, token);
+}
+
+/**
+ * @brief Consumes a token of the given kind or reports a syntax error.
+ *
+ * @return const Token* The consumed token, or the offending token on error.
+ */
+static const Token *expect(Parser *parser, TokenKind kind, const char *message) {
+    if (check(parser, kind)) return advance(parser);
+    syntaxError(parser, peek(parser), message);
+    return peek(parser);
+}
+
+/**
+ * @brief Skips tokens until a likely statement or declaration boundary.
+ */
+static void synchronize(Parser *parser) {
+    parser->panicMode = 0;
+    while (!check(parser, TEof)) {
+        if (parser->current > 0 && parser->tokens[parser->current - 1].type == TSemi) return;
+        switch (peek(parser)->type) {
+            case TFn: case TIf: case TWhile: case TFor: case TReturn: case TRbrace: case TImport: case TExport:
+                return;
+            default:
+                break;
+        }
+        advance(parser);
+    }
+}
+
+/**
+ * @brief Creates an expression node of the given kind at a token.
+ */
+static Expr *newExpr(Parser *parser, ExprKind kind, const Token *token) {
+    Expr *expr = allocNode(parser, sizeof(Expr));
+    expr->kind = kind;
+    expr->type = TypeInvalid;
+    expr->token = *token;
+    return expr;
+}
+
+/**
+ * @brief Creates a statement node of the given kind at a token.
+ */
+static Stmt *newStmt(Parser *parser, StmtKind kind, const Token *token) {
+    Stmt *stmt = allocNode(parser, sizeof(Stmt));
+    stmt->kind = kind;
+    stmt->token = *token;
+    return stmt;
+}
+
+/**
+ * @brief Parses a type keyword.
+ *
+ * @return TypeKind The parsed type, or TypeInvalid after reporting an error.
+ */
+static TypeKind parseType(Parser *parser) {
+    TypeKind type = typeFromToken(peek(parser)->type);
+    if (type == TypeInvalid) {
+        syntaxError(parser, peek(parser), "Expected a type");
+        return TypeInvalid;
+    }
+    advance(parser);
+    return type;
+}
+
+/**
+ * @brief Decodes the escape sequences of a string or character literal body.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param start Pointer to the first character after the opening quote.
+ * @param length Number of characters before the closing quote.
+ * @param decodedLength Pointer that receives the decoded length.
+ * @return char* The decoded, NUL-terminated text in the arena.
+ */
+static char *decodeLiteral(Parser *parser, const char *start, size_t length, size_t *decodedLength) {
+    char *text = allocNode(parser, length + 1);
+    size_t out = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = start[i];
+        if (c == '\\' && i + 1 < length) {
+            switch (start[++i]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = '\0'; break;
+                default: c = start[i]; break;
+            }
+        }
+        text[out++] = c;
+    }
+    text[out] = '\0';
+    *decodedLength = out;
+    return text;
+}
+
+/**
+ * @brief Parses a primary expression: a literal, a name, a call, a cast, or a parenthesized expression.
+ */
+static Expr *parsePrimary(Parser *parser) {
+    const Token *token = peek(parser);
+    Expr *expr;
+
+    switch (token->type) {
+        case TIntLiteral:
+            advance(parser);
+            expr = newExpr(parser, ExprIntLiteral, token);
+            expr->as.intValue = strtoull(token->start, NULL, 10);
+            return expr;
+
+        case TFloatLiteral:
+            advance(parser);
+            expr = newExpr(parser, ExprFloatLiteral, token);
+            expr->as.floatValue = strtod(token->start, NULL);
+            return expr;
+
+        case TTrue:
+        case TFalse:
+            advance(parser);
+            expr = newExpr(parser, ExprBoolLiteral, token);
+            expr->as.boolValue = token->type == TTrue;
+            return expr;
+
+        case TStringLiteral:
+            advance(parser);
+            expr = newExpr(parser, ExprStringLiteral, token);
+            expr->as.string.chars = decodeLiteral(parser, token->start + 1, (size_t)token->length - 2, &expr->as.string.length);
+            return expr;
+
+        case TCharLiteral: {
+            size_t length;
+            advance(parser);
+            expr = newExpr(parser, ExprCharLiteral, token);
+            expr->as.intValue = (uint8_t)*decodeLiteral(parser, token->start + 1, (size_t)token->length - 2, &length);
+            return expr;
+        }
+
+        case TIdentifier: {
+            uint32_t symbol = parser->symbols[parser->current];
+            advance(parser);
+            if (match(parser, TLparen)) {
+                NodeList args = { NULL, 0, 0 };
+                expr = newExpr(parser, ExprCall, token);
+                expr->as.call.callee = symbol;
+                if (!check(parser, TRparen)) {
+                    do {
+                        pushNode(&args, parseExpression(parser));
+                    } while (match(parser, TComma));
+                }
+                expect(parser, TRparen, "Expected ')' after arguments");
+                expr->as.call.argCount = args.count;
+                expr->as.call.args = (Expr **)finishNodes(parser, &args);
+                return expr;
+            }
+            expr = newExpr(parser, ExprName, token);
+            expr->as.symbol = symbol;
+            return expr;
+        }
+
+        case TCast:
+            advance(parser);
+            expr = newExpr(parser, ExprCast, token);
+            expect(parser, TLparen, "Expected '(' after 'cast'");
+            expr->as.cast.operand = parseExpression(parser);
+            expect(parser, TComma, "Expected ',' between the value and the type of a cast");
+            expr->as.cast.to = parseType(parser);
+            expect(parser, TRparen, "Expected ')' after cast type");
+            return expr;
+
+        case TLparen:
+            advance(parser);
+            expr = parseExpression(parser);
+            expect(parser, TRparen, "Expected ')' after expression");
+            return expr;
+
+        default:
+            syntaxError(parser, token, "Expected an expression");
+            if (token->type != TSemi && token->type != TRbrace && token->type != TRparen) advance(parser);
+            expr = newExpr(parser, ExprIntLiteral, token);
+            return expr;
+    }
+}
+
+/**
+ * @brief Parses postfix increment and decrement operators.
+ */
+static Expr *parsePostfix(Parser *parser) {
+    Expr *expr = parsePrimary(parser);
+    while (check(parser, TIncrement) || check(parser, TDecrement)) {
+        const Token *op = advance(parser);
+        Expr *incDec = newExpr(parser, ExprIncDec, op);
+        incDec->as.incDec.op = op->type;
+        incDec->as.incDec.target = expr;
+        incDec->as.incDec.prefix = 0;
+        expr = incDec;
+    }
+    return expr;
+}
+
+/**
+ * @brief Parses prefix unary operators.
+ */
+static Expr *parseUnary(Parser *parser) {
+    const Token *op = peek(parser);
+    Expr *expr;
+
+    switch (op->type) {
+        case TMinus: case TNot: case TXorNot:
+            advance(parser);
+            expr = newExpr(parser, ExprUnary, op);
+            expr->as.unary.op = op->type;
+            expr->as.unary.operand = parseUnary(parser);
+            return expr;
+        case TIncrement: case TDecrement:
+            advance(parser);
+            expr = newExpr(parser, ExprIncDec, op);
+            expr->as.incDec.op = op->type;
+            expr->as.incDec.target = parseUnary(parser);
+            expr->as.incDec.prefix = 1;
+            return expr;
+        default:
+            return parsePostfix(parser);
+    }
+}
+
+/**
+ * @brief Returns the binding power of a binary operator.
+ *
+ * @param kind The operator token kind.
+ * @return int The precedence, or 0 if the token is not a binary operator.
+ */
+static int binaryPrecedence(TokenKind kind) {
+    switch (kind) {
+        case TLogicalOr: return 1;
+        case TLogicalAnd: return 2;
+        case TPipe: return 3;
+        case TCarot: return 4;
+        case TAmpersand: return 5;
+        case TEqual: case TNotEqual: return 6;
+        case TLess: case TLessEqual: case TGreater: case TGreaterEqual: return 7;
+        case TLeftShift: case TRightShift: return 8;
+        case TPlus: case TMinus: return 9;
+        case TStar: case TSlash: case TPercent: return 10;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Parses binary operators whose precedence is at least `minPrecedence`.
+ */
+static Expr *parseBinary(Parser *parser, int minPrecedence) {
+    Expr *left = parseUnary(parser);
+
+    while (1) {
+        const Token *op = peek(parser);
+        int precedence = binaryPrecedence(op->type);
+        Expr *expr;
+
+        if (precedence == 0 || precedence < minPrecedence) return left;
+        advance(parser);
+
+        expr = newExpr(parser, ExprBinary, op);
+        expr->as.binary.op = op->type;
+        expr->as.binary.left = left;
+        expr->as.binary.right = parseBinary(parser, precedence + 1);
+        left = expr;
+    }
+}
+
+/**
+ * @brief Parses the conditional operator `cond ? a : b`.
+ */
+static Expr *parseTernary(Parser *parser) {
+    Expr *condition = parseBinary(parser, 1);
+    const Token *question = peek(parser);
+    Expr *expr;
+
+    if (!match(parser, TQuestion)) return condition;
+
+    expr = newExpr(parser, ExprTernary, question);
+    expr->as.ternary.condition = condition;
+    expr->as.ternary.then = parseExpression(parser);
+    expect(parser, TColon, "Expected ':' in conditional expression");
+    expr->as.ternary.otherwise = parseTernary(parser);
+    return expr;
+}
+
+/**
+ * @brief Parses an expression, including right-associative assignment.
+ */
+static Expr *parseExpression(Parser *parser) {
+    Expr *target = parseTernary(parser);
+    const Token *op = peek(parser);
+    Expr *expr;
+
+    switch (op->type) {
+        case TAssign: case TPlusAssign: case TMinusAssign: case TStarAssign: case TSlashAssign:
+            advance(parser);
+            expr = newExpr(parser, ExprAssign, op);
+            expr->as.assign.op = op->type;
+            expr->as.assign.target = target;
+            expr->as.assign.value = parseExpression(parser);
+            return expr;
+        default:
+            return target;
+    }
+}
+
+/**
+ * @brief Parses a variable declaration `type name (= expr)?;`.
+ */
+static Stmt *parseVarDecl(Parser *parser) {
+    const Token *start = peek(parser);
+    Stmt *stmt = newStmt(parser, StmtVar, start);
+    const Token *name;
+
+    stmt->as.var.type = parseType(parser);
+    name = expect(parser, TIdentifier, "Expected a variable name");
+    stmt->token = *name;
+    stmt->as.var.name = (name->type == TIdentifier) ? parser->symbols[name - parser->tokens] : 0;
+    if (match(parser, TAssign)) {
+        stmt->as.var.init = parseExpression(parser);
+    }
+    expect(parser, TSemi, "Expected ';' after variable declaration");
+    return stmt;
+}
+
+/**
+ * @brief Parses a brace-delimited block of statements.
+ */
+static Stmt *parseBlock(Parser *parser) {
+    const Token *brace = expect(parser, TLbrace, "Expected '{'");
+    Stmt *stmt = newStmt(parser, StmtBlock, brace);
+    NodeList items = { NULL, 0, 0 };
+
+    while (!check(parser, TRbrace) && !check(parser, TEof)) {
+        size_t start = parser->current;
+        pushNode(&items, parseStatement(parser));
+        if (parser->panicMode) {
+            synchronize(parser);
+            if (parser->current == start) advance(parser);
+        }
+    }
+    expect(parser, TRbrace, "Expected '}' after block");
+
+    stmt->as.block.count = items.count;
+    stmt->as.block.items = (Stmt **)finishNodes(parser, &items);
+    return stmt;
+}
+
+/**
+ * @brief Parses a single statement.
+ */
+static Stmt *parseStatement(Parser *parser) {
+    const Token *token = peek(parser);
+    Stmt *stmt;
+
+    if (typeFromToken(token->type) != TypeInvalid && token->type != TVoid) {
+        return parseVarDecl(parser);
+    }
+
+    switch (token->type) {
+        case TLbrace:
+            return parseBlock(parser);
+
+        case TIf:
+            advance(parser);
+            stmt = newStmt(parser, StmtIf, token);
+            expect(parser, TLparen, "Expected '(' after 'if'");
+            stmt->as.ifStmt.condition = parseExpression(parser);
+            expect(parser, TRparen, "Expected ')' after condition");
+            stmt->as.ifStmt.then = parseStatement(parser);
+            if (match(parser, TElse)) {
+                stmt->as.ifStmt.otherwise = parseStatement(parser);
+            }
+            return stmt;
+
+        case TWhile:
+            advance(parser);
+            stmt = newStmt(parser, StmtWhile, token);
+            expect(parser, TLparen, "Expected '(' after 'while'");
+            stmt->as.whileStmt.condition = parseExpression(parser);
+            expect(parser, TRparen, "Expected ')' after condition");
+            stmt->as.whileStmt.body = parseStatement(parser);
+            return stmt;
+
+        case TFor:
+            advance(parser);
+            stmt = newStmt(parser, StmtFor, token);
+            expect(parser, TLparen, "Expected '(' after 'for'");
+            if (!match(parser, TSemi)) {
+                if (typeFromToken(peek(parser)->type) != TypeInvalid) {
+                    stmt->as.forStmt.init = parseVarDecl(parser);
+                } else {
+                    Stmt *init = newStmt(parser, StmtExpr, peek(parser));
+                    init->as.expr = parseExpression(parser);
+                    expect(parser, TSemi, "Expected ';' after loop initializer");
+                    stmt->as.forStmt.init = init;
+                }
+            }
+            if (!check(parser, TSemi)) stmt->as.forStmt.condition = parseExpression(parser);
+            expect(parser, TSemi, "Expected ';' after loop condition");
+            if (!check(parser, TRparen)) stmt->as.forStmt.step = parseExpression(parser);
+            expect(parser, TRparen, "Expected ')' after for clauses");
+            stmt->as.forStmt.body = parseStatement(parser);
+            return stmt;
+
+        case TReturn:
+            advance(parser);
+            stmt = newStmt(parser, StmtReturn, token);
+            if (!check(parser, TSemi)) stmt->as.expr = parseExpression(parser);
+            expect(parser, TSemi, "Expected ';' after return value");
+            return stmt;
+
+        case TBreak:
+            advance(parser);
+            stmt = newStmt(parser, StmtBreak, token);
+            expect(parser, TSemi, "Expected ';' after 'break'");
+            return stmt;
+
+        case TPrintln:
+            advance(parser);
+            stmt = newStmt(parser, StmtPrint, token);
+            expect(parser, TLparen, "Expected '(' after 'println'");
+            stmt->as.expr = parseExpression(parser);
+            expect(parser, TRparen, "Expected ')' after 'println' argument");
+            expect(parser, TSemi, "Expected ';' after statement");
+            return stmt;
+
+        default:
+            stmt = newStmt(parser, StmtExpr, token);
+            stmt->as.expr = parseExpression(parser);
+            expect(parser, TSemi, "Expected ';' after expression");
+            return stmt;
+    }
+}
+
+/**
+ * @brief Skips a brace-delimited block without parsing it.
+ *
+ * Only braces are looked at, so this costs little more than reading the
+ * tokens. A block that is never closed is reported as parseBlock() would.
+ */
+static void skipBody(Parser *parser) {
+    int depth = 0;
+
+    do {
+        TokenKind kind = advance(parser)->type;
+        if (kind == TLbrace) depth++;
+        else if (kind == TRbrace) depth--;
+    } while (depth > 0 && !check(parser, TEof));
+    if (depth > 0) expect(parser, TRbrace, "Expected '}' after block");
+}
+
+/**
+ * @brief Parses a function declaration after its `fn` keyword.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param fn Pointer to the declaration to fill.
+ */
+static void parseFunction(Parser *parser, FnDecl *fn) {
+    const Token *name = expect(parser, TIdentifier, "Expected a function name");
+    NodeList params = { NULL, 0, 0 };
+
+    fn->token = *name;
+    fn->name = (name->type == TIdentifier) ? parser->symbols[name - parser->tokens] : 0;
+
+    expect(parser, TLparen, "Expected '(' after function name");
+    if (!check(parser, TRparen)) {
+        do {
+            Param *param = allocNode(parser, sizeof(Param));
+            const Token *paramName;
+            param->type = parseType(parser);
+            paramName = expect(parser, TIdentifier, "Expected a parameter name");
+            param->token = *paramName;
+            param->name = (paramName->type == TIdentifier) ? parser->symbols[paramName - parser->tokens] : 0;
+            pushNode(&params, param);
+        } while (match(parser, TComma));
+    }
+    expect(parser, TRparen, "Expected ')' after parameters");
+
+    fn->paramCount = params.count;
+    fn->params = allocNode(parser, (size_t)(params.count + 1) * sizeof(Param));
+    for (int i = 0; i < params.count; i++) {
+        fn->params[i] = *(Param *)params.items[i];
+    }
+    free(params.items);
+
+    fn->returnType = TypeVoid;
+    if (typeFromToken(peek(parser)->type) != TypeInvalid) {
+        fn->returnType = parseType(parser);
+    }
+
+    fn->bodyStart = parser->current;
+    if (parser->lazyBodies && check(parser, TLbrace)) {
+        skipBody(parser);
+    } else {
+        fn->body = parseBlock(parser);
+    }
+    fn->bodyEnd = parser->current;
+}
+
+/**
+ * @brief Initializes the parser over a token stream.
+ *
+ * @param parser Pointer to the parser instance to initialize.
+ * @param stream Pointer to the token stream to parse.
+ * @param arena Pointer to the arena that receives every node.
+ */
+void initParser(Parser *parser, const TokenStream *stream, Arena *arena) {
+    parser->tokens = stream->tokens;
+    parser->symbols = stream->symbols;
+    parser->count = stream->count;
+    parser->current = 0;
+    parser->arena = arena;
+    parser->diagnostics = NULL;
+    parser->hadError = 0;
+    parser->panicMode = 0;
+    parser->lazyBodies = 0;
+}
+
+/**
+ * @brief Parses the top-level declarations for parseProgram(), which guards it against running out of memory.
+ */
+static int parseDeclarations(Parser *parser, Program *program) {
+    NodeList fns = { NULL, 0, 0 };
+    NodeList imports = { NULL, 0, 0 };
+
+    while (!check(parser, TEof)) {
+        const Token *token = peek(parser);
+        int exported = match(parser, TExport);
+
+        if (match(parser, TFn)) {
+            FnDecl *fn = allocNode(parser, sizeof(FnDecl));
+            int hadError = parser->hadError;
+            fn->exported = exported;
+            parser->hadError = 0;
+            parseFunction(parser, fn);
+            fn->hasErrors = parser->hadError;
+            parser->hadError |= hadError;
+            pushNode(&fns, fn);
+        } else if (!exported && match(parser, TImport)) {
+            const Token *name = expect(parser, TIdentifier, "Expected a module name after 'import'");
+            if (name->type == TIdentifier) {
+                pushNode(&imports, (void *)(uintptr_t)parser->symbols[name - parser->tokens]);
+            }
+            expect(parser, TSemi, "Expected ';' after import");
+        } else {
+            syntaxError(parser, token, exported ? "Expected 'fn' after 'export'" : "Expected a top-level declaration");
+            if (peek(parser) == token) advance(parser);
+        }
+
+        if (parser->panicMode) {
+            synchronize(parser);
+            while (!check(parser, TEof) && !check(parser, TFn) && !check(parser, TImport) && !check(parser, TExport)) advance(parser);
+            parser->panicMode = 0;
+        }
+    }
+
+    program->fnCount = fns.count;
+    program->fns = allocNode(parser, (size_t)(fns.count + 1) * sizeof(FnDecl));
+    for (int i = 0; i < fns.count; i++) {
+        program->fns[i] = *(FnDecl *)fns.items[i];
+    }
+    free(fns.items);
+
+    program->importCount = imports.count;
+    program->imports = allocNode(parser, (size_t)(imports.count + 1) * sizeof(uint32_t));
+    for (int i = 0; i < imports.count; i++) {
+        program->imports[i] = (uint32_t)(uintptr_t)imports.items[i];
+    }
+    free(imports.items);
+    program->interfaces = NULL;
+    program->interfaceCount = 0;
+
+    return parser->hadError ? 1 : 0;
+}
+
+/**
+ * @brief Parses every top-level declaration of the token stream.
+ *
+ * @param parser Pointer to the parser instance.
+ * @param program Pointer to the program that receives the declarations.
+ * @return int Returns 0 on success, 1 if any syntax error was reported, or -1
+ *             if memory ran out, in which case the program is left empty.
+ */
+int parseProgram(Parser *parser, Program *program) {
+    MemoryGuard guard;
+    int status;
+
+    memset(program, 0, sizeof(*program));
+    if (setjmp(guard.jump) != 0) {
+        memset(program, 0, sizeof(*program));
+        return -1;
+    }
+    pushMemoryGuard(&guard);
+    status = parseDeclarations(parser, program);
+    popMemoryGuard(&guard);
+    return status;
+}
+
+/**
+ * @brief Parses the body of a function whose body was skipped.
+ *
+ * @param parser Pointer to the parser that parsed the program.
+ * @param fn Pointer to the declaration whose body to parse.
+ * @return int Returns 0 on success, 1 if a syntax error was reported in the
+ *             body, or -1 if memory ran out.
+ */
+int parseFunctionBody(Parser *parser, FnDecl *fn) {
+    size_t current = parser->current;
+    int hadError = parser->hadError;
+    MemoryGuard guard;
+    int status;
+
+    if (fn->body != NULL) return 0;
+    if (setjmp(guard.jump) != 0) {
+        fn->body = NULL;
+        parser->current = current;
+        parser->hadError = 1;
+        parser->panicMode = 0;
+        return -1;
+    }
+    pushMemoryGuard(&guard);
+    parser->current = fn->bodyStart;
+    parser->hadError = 0;
+    parser->panicMode = 0;
+    fn->body = parseBlock(parser);
+    popMemoryGuard(&guard);
+    status = parser->hadError ? 1 : 0;
+    parser->current = current;
+    parser->hadError |= hadError;
+    parser->panicMode = 0;
+    return status;
+}
+
+/**
+ * @brief Parses every body of a program that was skipped.
+ *
+ * @param parser Pointer to the parser that parsed the program.
+ * @param program Pointer to the program.
+ * @return int Returns 0 on success, 1 if any body had a syntax error, or -1 if memory ran out.
+ */
+int parseFunctionBodies(Parser *parser, Program *program) {
+    int status = 0;
+    for (int i = 0; i < program->fnCount && status >= 0; i++) {
+        int body = parseFunctionBody(parser, &program->fns[i]);
+        if (body != 0) status = body;
+    }
+    return status;
+}
@@ -0,0 +1,1137 @@
+/**
+ * @file passes.c
+ * @brief Implements the IR optimization passes and the pass manager.
+ *
+ * Every pass works on one function in SSA form and keeps it in SSA form.
+ * Passes that replace a value record the replacement in a forwarding map
+ * and rewrite all operands in one sweep with irReplaceValues, then delete
+ * the replaced instructions, so no pass needs use lists.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include "include/passes.h"
+#include "include/common.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INLINE_LIMIT_O2 40          ///< Largest callee inlined at -O2, in instructions.
+#define INLINE_LIMIT_O3 120         ///< Largest callee inlined at -O3, in instructions.
+#define INLINE_GROWTH_LIMIT 4000    ///< Callers of this size receive no more inlined bodies.
+
+#define OPT_PASS_NAME(name, text) text,
+
+static const char *const passNames[] = { OPT_PASSES(OPT_PASS_NAME) };
+
+/** Cheap cleanups run at -O1 and before inlining at higher levels. */
+static const PassKind earlyPipeline[] = {
+    PASS_COPYPROP, PASS_CONSTFOLD, PASS_COPYPROP, PASS_DCE
+};
+
+/** Scalar optimizations run after inlining at -O2 and -O3. */
+static const PassKind scalarPipeline[] = {
+    PASS_COPYPROP, PASS_CONSTFOLD, PASS_COPYPROP, PASS_LICM, PASS_GVN,
+    PASS_CONSTFOLD, PASS_COPYPROP, PASS_DCE
+};
+
+/**
+ * @brief Allocates a zeroed array; running out of memory goes to outOfMemory().
+ */
+static void *allocate(int count, size_t size) {
+    void *items = calloc((size_t)count + 1, size);
+    if (items == NULL) outOfMemory(NULL);
+    return items;
+}
+
+/**
+ * @brief Allocates an array of `count` IR_NONE entries.
+ */
+static int *allocateMap(int count) {
+    int *map = allocate(count, sizeof(int));
+    for (int i = 0; i < count; i++) map[i] = IR_NONE;
+    return map;
+}
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ */
+static double now(void) {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * @brief Reports whether a type uses the 64-bit integer opcodes.
+ */
+static int isWide(TypeKind type) {
+    return type == TypeI64 || type == TypeU64 || type == TypeString;
+}
+
+/**
+ * @brief Reports whether a type compares as unsigned.
+ */
+static int isUnsigned(TypeKind type) {
+    return (isIntegerType(type) && !isSignedType(type)) || type == TypeBool || type == TypeChar;
+}
+
+/**
+ * @brief Returns the significant bits of a constant of the given type.
+ */
+static uint64_t constantBits(Slot value, TypeKind type) {
+    return isWide(type) || type == TypeF64 ? value.u64 : value.u32;
+}
+
+/**
+ * @brief Follows a value through copies to its source.
+ */
+static int resolveCopy(const IrFunction *fn, int value) {
+    while (fn->insns[value].op == IR_COPY) value = fn->operands[fn->insns[value].argStart];
+    return value;
+}
+
+/**
+ * @brief Follows a value through a forwarding map without modifying it.
+ */
+static int resolveForward(const int *forward, int value) {
+    while (forward[value] != IR_NONE) value = forward[value];
+    return value;
+}
+
+/**
+ * @brief Reads the constant behind a value, looking through copies.
+ */
+static int constantOf(const IrFunction *fn, int value, Slot *out) {
+    const IrInsn *insn = &fn->insns[resolveCopy(fn, value)];
+    if (insn->op != IR_CONST) return 0;
+    *out = insn->as.constant;
+    return 1;
+}
+
+/**
+ * @brief Turns an instruction into a constant.
+ */
+static void makeConstant(IrFunction *fn, int value, Slot constant) {
+    IrInsn *insn = &fn->insns[value];
+    insn->op = IR_CONST;
+    insn->argCount = 0;
+    insn->operandType = TypeVoid;
+    insn->as.constant = constant;
+}
+
+/**
+ * @brief Turns an instruction into a copy of another value.
+ */
+static void makeCopy(IrFunction *fn, int value, int source) {
+    irSetArgs(fn, value, &source, 1);
+    fn->insns[value].op = IR_COPY;
+    fn->insns[value].operandType = TypeVoid;
+}
+
+/**
+ * @brief Evaluates a comparison the way the VM's compare opcodes do.
+ */
+static uint32_t compare(IrOp op, TypeKind type, Slot a, Slot b) {
+    if (type == TypeF32) {
+        switch (op) {
+            case IR_EQ: return a.f32 == b.f32;
+            case IR_NE: return a.f32 != b.f32;
+            case IR_LT: return a.f32 < b.f32;
+            default: return a.f32 <= b.f32;
+        }
+    }
+    if (type == TypeF64) {
+        switch (op) {
+            case IR_EQ: return a.f64 == b.f64;
+            case IR_NE: return a.f64 != b.f64;
+            case IR_LT: return a.f64 < b.f64;
+            default: return a.f64 <= b.f64;
+        }
+    }
+    if (isWide(type)) {
+        switch (op) {
+            case IR_EQ: return a.u64 == b.u64;
+            case IR_NE: return a.u64 != b.u64;
+            case IR_LT: return isUnsigned(type) ? a.u64 < b.u64 : a.i64 < b.i64;
+            default: return isUnsigned(type) ? a.u64 <= b.u64 : a.i64 <= b.i64;
+        }
+    }
+    switch (op) {
+        case IR_EQ: return a.u32 == b.u32;
+        case IR_NE: return a.u32 != b.u32;
+        case IR_LT: return isUnsigned(type) ? a.u32 < b.u32 : a.i32 < b.i32;
+        default: return isUnsigned(type) ? a.u32 <= b.u32 : a.i32 <= b.i32;
+    }
+}
+
+/**
+ * @brief Evaluates floating-point arithmetic.
+ */
+static int evaluateFloat(IrOp op, TypeKind type, Slot a, Slot b, Slot *out) {
+    if (type == TypeF32) {
+        switch (op) {
+            case IR_ADD: out->f32 = a.f32 + b.f32; return 1;
+            case IR_SUB: out->f32 = a.f32 - b.f32; return 1;
+            case IR_MUL: out->f32 = a.f32 * b.f32; return 1;
+            case IR_DIV: out->f32 = a.f32 / b.f32; return 1;
+            case IR_MOD: out->f32 = fmodf(a.f32, b.f32); return 1;
+            case IR_NEG: out->f32 = -a.f32; return 1;
+            default: return 0;
+        }
+    }
+    switch (op) {
+        case IR_ADD: out->f64 = a.f64 + b.f64; return 1;
+        case IR_SUB: out->f64 = a.f64 - b.f64; return 1;
+        case IR_MUL: out->f64 = a.f64 * b.f64; return 1;
+        case IR_DIV: out->f64 = a.f64 / b.f64; return 1;
+        case IR_MOD: out->f64 = fmod(a.f64, b.f64); return 1;
+        case IR_NEG: out->f64 = -a.f64; return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Evaluates 64-bit integer arithmetic; fails where the VM would trap.
+ */
+static int evaluateWide(IrOp op, TypeKind type, Slot a, Slot b, Slot *out) {
+    int isSigned = !isUnsigned(type);
+
+    switch (op) {
+        case IR_ADD: out->u64 = a.u64 + b.u64; return 1;
+        case IR_SUB: out->u64 = a.u64 - b.u64; return 1;
+        case IR_MUL: out->u64 = a.u64 * b.u64; return 1;
+        case IR_DIV: case IR_MOD:
+            if (b.u64 == 0 || (isSigned && a.i64 == INT64_MIN && b.i64 == -1)) return 0;
+            if (isSigned) out->i64 = op == IR_DIV ? a.i64 / b.i64 : a.i64 % b.i64;
+            else out->u64 = op == IR_DIV ? a.u64 / b.u64 : a.u64 % b.u64;
+            return 1;
+        case IR_AND: out->u64 = a.u64 & b.u64; return 1;
+        case IR_OR: out->u64 = a.u64 | b.u64; return 1;
+        case IR_XOR: out->u64 = a.u64 ^ b.u64; return 1;
+        case IR_SHL: out->u64 = a.u64 << (b.u64 & 63); return 1;
+        case IR_SHR:
+            if (isSigned) out->i64 = a.i64 >> (b.u64 & 63);
+            else out->u64 = a.u64 >> (b.u64 & 63);
+            return 1;
+        case IR_NEG: out->u64 = 0u - a.u64; return 1;
+        case IR_BNOT: out->u64 = ~a.u64; return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Evaluates 32-bit integer arithmetic, then narrows the result to its type.
+ */
+static int evaluateNarrow(IrOp op, TypeKind type, Slot a, Slot b, Slot *out) {
+    int isSigned = !isUnsigned(type);
+
+    switch (op) {
+        case IR_ADD: out->u32 = a.u32 + b.u32; break;
+        case IR_SUB: out->u32 = a.u32 - b.u32; break;
+        case IR_MUL: out->u32 = a.u32 * b.u32; break;
+        case IR_DIV: case IR_MOD:
+            if (b.u32 == 0 || (isSigned && a.i32 == INT32_MIN && b.i32 == -1)) return 0;
+            if (isSigned) out->i32 = op == IR_DIV ? a.i32 / b.i32 : a.i32 % b.i32;
+            else out->u32 = op == IR_DIV ? a.u32 / b.u32 : a.u32 % b.u32;
+            break;
+        case IR_AND: out->u32 = a.u32 & b.u32; break;
+        case IR_OR: out->u32 = a.u32 | b.u32; break;
+        case IR_XOR: out->u32 = a.u32 ^ b.u32; break;
+        case IR_SHL: out->u32 = a.u32 << (b.u32 & 31); break;
+        case IR_SHR:
+            if (isSigned) out->i32 = a.i32 >> (b.u32 & 31);
+            else out->u32 = a.u32 >> (b.u32 & 31);
+            break;
+        case IR_NEG: out->u32 = 0u - a.u32; break;
+        case IR_BNOT: out->u32 = ~a.u32; break;
+        case IR_NOT: out->u32 = (uint32_t)!a.u32; return 1;
+        default: return 0;
+    }
+    if (type == TypeI8 || type == TypeI16) *out = convertValue(*out, TypeI32, type);
+    else if (type == TypeU8 || type == TypeU16 || type == TypeChar) *out = convertValue(*out, TypeU32, type);
+    return 1;
+}
+
+/**
+ * @brief Computes the result of an instruction whose operands are constants.
+ */
+static int evaluate(const IrInsn *insn, Slot a, Slot b, Slot *out) {
+    out->u64 = 0;
+    switch (insn->op) {
+        case IR_CONV:
+            *out = convertValue(a, insn->operandType, insn->type);
+            return 1;
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+            out->u32 = compare(insn->op, insn->operandType, a, b);
+            return 1;
+        default:
+            break;
+    }
+    if (insn->type == TypeF32 || insn->type == TypeF64) return evaluateFloat(insn->op, insn->type, a, b, out);
+    if (isWide(insn->type)) return evaluateWide(insn->op, insn->type, a, b, out);
+    return evaluateNarrow(insn->op, insn->type, a, b, out);
+}
+
+/**
+ * @brief Rewrites integer instructions with an identity or annihilating operand.
+ */
+static int simplify(IrFunction *fn, int value) {
+    IrInsn *insn = &fn->insns[value];
+    int *args = irArgs(fn, value);
+    int x = resolveCopy(fn, args[0]);
+    int y = insn->argCount > 1 ? resolveCopy(fn, args[1]) : IR_NONE;
+    TypeKind type = insn->op >= IR_EQ && insn->op <= IR_LE ? insn->operandType : insn->type;
+    Slot left, right, zero, one;
+    int leftConstant, rightConstant;
+
+    if (!isIntegerType(type) || y == IR_NONE) return 0;
+    zero.u64 = 0;
+    one.u64 = 0;
+    one.u32 = 1;
+    leftConstant = constantOf(fn, x, &left);
+    rightConstant = constantOf(fn, y, &right);
+
+    if (x == y) {
+        switch (insn->op) {
+            case IR_SUB: case IR_XOR: makeConstant(fn, value, zero); return 1;
+            case IR_AND: case IR_OR: makeCopy(fn, value, x); return 1;
+            case IR_EQ: case IR_LE: makeConstant(fn, value, one); return 1;
+            case IR_NE: case IR_LT: makeConstant(fn, value, zero); return 1;
+            default: return 0;
+        }
+    }
+
+    switch (insn->op) {
+        case IR_ADD: case IR_OR: case IR_XOR:
+            if (rightConstant && constantBits(right, type) == 0) { makeCopy(fn, value, x); return 1; }
+            if (leftConstant && constantBits(left, type) == 0) { makeCopy(fn, value, y); return 1; }
+            return 0;
+        case IR_SUB: case IR_SHL: case IR_SHR:
+            if (rightConstant && constantBits(right, type) == 0) { makeCopy(fn, value, x); return 1; }
+            return 0;
+        case IR_MUL:
+            if (rightConstant && constantBits(right, type) == 1) { makeCopy(fn, value, x); return 1; }
+            if (leftConstant && constantBits(left, type) == 1) { makeCopy(fn, value, y); return 1; }
+            if ((rightConstant && constantBits(right, type) == 0) || (leftConstant && constantBits(left, type) == 0)) {
+                makeConstant(fn, value, zero);
+                return 1;
+            }
+            return 0;
+        case IR_AND:
+            if ((rightConstant && constantBits(right, type) == 0) || (leftConstant && constantBits(left, type) == 0)) {
+                makeConstant(fn, value, zero);
+                return 1;
+            }
+            return 0;
+        case IR_DIV:
+            if (rightConstant && constantBits(right, type) == 1) { makeCopy(fn, value, x); return 1; }
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Folds one instruction, if possible.
+ */
+static int foldInsn(IrFunction *fn, int value) {
+    IrInsn *insn = &fn->insns[value];
+    int *args;
+    Slot a, b, result;
+
+    switch (insn->op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_AND: case IR_OR: case IR_XOR: case IR_SHL: case IR_SHR:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+            if (insn->type == TypeString || insn->operandType == TypeString) return 0;
+            args = irArgs(fn, value);
+            if (constantOf(fn, args[0], &a) && constantOf(fn, args[1], &b) && evaluate(insn, a, b, &result)) {
+                makeConstant(fn, value, result);
+                return 1;
+            }
+            return simplify(fn, value);
+
+        case IR_NEG: case IR_BNOT: case IR_NOT: case IR_CONV:
+            if (insn->type == TypeString || insn->operandType == TypeString) return 0;
+            args = irArgs(fn, value);
+            b.u64 = 0;
+            if (constantOf(fn, args[0], &a) && evaluate(insn, a, b, &result)) {
+                makeConstant(fn, value, result);
+                return 1;
+            }
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Merges every block into its predecessor when that is its only edge.
+ *
+ * Blocks with phis are left alone; once their predecessor count drops to
+ * one, copy propagation removes the phis and a later run merges them.
+ */
+static int mergeBlocks(IrFunction *fn) {
+    int changed = 0;
+
+    for (int b = 1; b < fn->blockCount; b++) {
+        IrBlock *block = &fn->blocks[b];
+        int pred, term, succ[2], n;
+
+        if (block->predCount != 1 || block->insnCount == 0 || fn->insns[block->insns[0]].op == IR_PHI) continue;
+        pred = block->preds[0];
+        term = irTerminator(fn, pred);
+        if (pred == b || term == IR_NONE || fn->insns[term].op != IR_JUMP) continue;
+
+        irDelete(fn, term);
+        fn->blocks[pred].insnCount--;
+        fn->insns[term].block = IR_NONE;
+        for (int i = 0; i < block->insnCount; i++) {
+            irMove(fn, block->insns[i], pred, fn->blocks[pred].insnCount);
+        }
+        n = irSuccessors(fn, pred, succ);
+        for (int s = 0; s < n; s++) {
+            IrBlock *target = &fn->blocks[succ[s]];
+            for (int p = 0; p < target->predCount; p++) {
+                if (target->preds[p] == b) target->preds[p] = pred;
+            }
+        }
+        block->insnCount = 0;
+        block->predCount = 0;
+        changed = 1;
+    }
+    return changed;
+}
+
+/**
+ * @brief Evaluates instructions whose operands are constants.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int foldConstants(IrFunction *fn) {
+    int *rpo = allocate(fn->blockCount, sizeof(int));
+    int count = irComputeOrder(fn, rpo);
+    int changed = 0, branches = 0;
+
+    /* Reverse postorder visits every definition before its uses outside phis,
+       so chains of constant arithmetic fold in a single sweep. */
+    for (int i = 0; i < count; i++) {
+        IrBlock *block = &fn->blocks[rpo[i]];
+        for (int k = 0; k < block->insnCount; k++) {
+            changed |= foldInsn(fn, block->insns[k]);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        int b = rpo[i];
+        int term = irTerminator(fn, b);
+        IrInsn *insn;
+        Slot condition;
+
+        if (term == IR_NONE || fn->insns[term].op != IR_BRANCH) continue;
+        if (!constantOf(fn, fn->operands[fn->insns[term].argStart], &condition)) continue;
+
+        insn = &fn->insns[term];
+        irRemovePred(fn, insn->as.targets[condition.u32 ? 1 : 0], b);
+        insn->as.targets[0] = insn->as.targets[condition.u32 ? 0 : 1];
+        insn->op = IR_JUMP;
+        insn->argCount = 0;
+        branches = 1;
+    }
+    if (branches) irRemoveUnreachable(fn);
+    branches |= mergeBlocks(fn);
+
+    free(rpo);
+    return changed || branches;
+}
+
+/**
+ * @brief Replaces copies with their source and removes trivial phis.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int propagateCopies(IrFunction *fn) {
+    int *forward = allocateMap(fn->insnCount);
+    int changed = 0, progress = 1;
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        if (fn->insns[v].op == IR_COPY && fn->insns[v].block != IR_NONE) {
+            forward[v] = fn->operands[fn->insns[v].argStart];
+            changed = 1;
+        }
+    }
+
+    /* Removing a phi can make the phis that use it trivial in turn. */
+    while (progress) {
+        progress = 0;
+        for (int v = 0; v < fn->insnCount; v++) {
+            const IrInsn *insn = &fn->insns[v];
+            int unique = IR_NONE, trivial = 1;
+
+            if (insn->op != IR_PHI || insn->block == IR_NONE || forward[v] != IR_NONE) continue;
+            for (int i = 0; i < insn->argCount; i++) {
+                int arg = resolveForward(forward, fn->operands[insn->argStart + i]);
+                if (arg == v || arg == unique) continue;
+                if (unique != IR_NONE) {
+                    trivial = 0;
+                    break;
+                }
+                unique = arg;
+            }
+            if (trivial && unique != IR_NONE) {
+                forward[v] = unique;
+                progress = changed = 1;
+            }
+        }
+    }
+
+    if (changed) {
+        irReplaceValues(fn, forward);
+        for (int v = 0; v < fn->insnCount; v++) {
+            if (forward[v] != IR_NONE) irDelete(fn, v);
+        }
+        irCompact(fn);
+    }
+    free(forward);
+    return changed;
+}
+
+/**
+ * @brief Reports whether an instruction must be kept even if its result is unused.
+ */
+static int isRoot(const IrFunction *fn, int value) {
+    switch (fn->insns[value].op) {
+        case IR_JUMP: case IR_BRANCH: case IR_RET: case IR_CALL: case IR_PRINT:
+            return 1;
+        case IR_DIV: case IR_MOD:
+            return !irIsPure(fn, value);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Removes instructions whose results are never used and that have no side effects.
+ *
+ * Unreachable blocks are removed first, so their uses keep nothing alive.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int eliminateDeadCode(IrFunction *fn) {
+    char *live = allocate(fn->insnCount, 1);
+    int *work = allocate(fn->insnCount, sizeof(int));
+    int top = 0, changed = irRemoveUnreachable(fn);
+
+    for (int b = 0; b < fn->blockCount; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (int i = 0; i < block->insnCount; i++) {
+            int v = block->insns[i];
+            if (!live[v] && isRoot(fn, v)) {
+                live[v] = 1;
+                work[top++] = v;
+            }
+        }
+    }
+
+    while (top > 0) {
+        const IrInsn *insn = &fn->insns[work[--top]];
+        for (int i = 0; i < insn->argCount; i++) {
+            int arg = fn->operands[insn->argStart + i];
+            if (!live[arg]) {
+                live[arg] = 1;
+                work[top++] = arg;
+            }
+        }
+    }
+
+    for (int b = 0; b < fn->blockCount; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (int i = 0; i < block->insnCount; i++) {
+            int v = block->insns[i];
+            if (!live[v] && fn->insns[v].op != IR_NOP) {
+                irDelete(fn, v);
+                changed = 1;
+            }
+        }
+    }
+    if (changed) irCompact(fn);
+
+    free(live);
+    free(work);
+    return changed;
+}
+
+/**
+ * @struct Numbering
+ * @brief State of a value-numbering walk: a scoped hash table of available values.
+ *
+ * The table uses linear probing, and entries are only ever removed in the
+ * reverse order of their insertion when the walk leaves a dominator subtree,
+ * which keeps every probe sequence intact.
+ */
+typedef struct {
+    IrFunction *fn;
+    int *forward;
+    int *table;
+    unsigned mask;
+    unsigned *undo;
+    int undoCount;
+} Numbering;
+
+/**
+ * @brief Reports whether an instruction can be numbered.
+ */
+static int isNumbered(IrOp op) {
+    switch (op) {
+        case IR_CONST:
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_AND: case IR_OR: case IR_XOR: case IR_SHL: case IR_SHR:
+        case IR_NEG: case IR_BNOT: case IR_NOT:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+        case IR_CONV:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Reports whether the operands of an opcode may be swapped.
+ */
+static int isCommutative(IrOp op) {
+    switch (op) {
+        case IR_ADD: case IR_MUL: case IR_AND: case IR_OR: case IR_XOR: case IR_EQ: case IR_NE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Returns the current operands of an instruction in canonical order.
+ */
+static void canonicalArgs(const Numbering *numbering, int value, int out[2]) {
+    const IrInsn *insn = &numbering->fn->insns[value];
+    const int *args = numbering->fn->operands + insn->argStart;
+
+    out[0] = insn->argCount > 0 ? resolveForward(numbering->forward, args[0]) : IR_NONE;
+    out[1] = insn->argCount > 1 ? resolveForward(numbering->forward, args[1]) : IR_NONE;
+    if (isCommutative(insn->op) && out[0] > out[1]) {
+        int swap = out[0];
+        out[0] = out[1];
+        out[1] = swap;
+    }
+}
+
+/**
+ * @brief Hashes the operation, types, and operands of an instruction.
+ */
+static unsigned hashInsn(const Numbering *numbering, int value) {
+    const IrInsn *insn = &numbering->fn->insns[value];
+    uint64_t hash = (uint64_t)insn->op * 31u + (uint64_t)insn->type * 7u + (uint64_t)insn->operandType;
+    int args[2];
+
+    if (insn->op == IR_CONST) {
+        hash ^= constantBits(insn->as.constant, insn->type) * 0x9e3779b97f4a7c15u;
+    } else {
+        canonicalArgs(numbering, value, args);
+        hash = (hash ^ (uint64_t)(unsigned)args[0]) * 0x100000001b3u;
+        hash = (hash ^ (uint64_t)(unsigned)args[1]) * 0x100000001b3u;
+    }
+    return (unsigned)(hash ^ (hash >> 29));
+}
+
+/**
+ * @brief Reports whether two instructions compute the same value.
+ */
+static int sameInsn(const Numbering *numbering, int a, int b) {
+    const IrInsn *x = &numbering->fn->insns[a];
+    const IrInsn *y = &numbering->fn->insns[b];
+    int left[2], right[2];
+
+    if (x->op != y->op || x->type != y->type || x->operandType != y->operandType || x->argCount != y->argCount) return 0;
+    if (x->op == IR_CONST) return constantBits(x->as.constant, x->type) == constantBits(y->as.constant, y->type);
+    canonicalArgs(numbering, a, left);
+    canonicalArgs(numbering, b, right);
+    return left[0] == right[0] && left[1] == right[1];
+}
+
+/**
+ * @brief Numbers the instructions of one block against the values available in it.
+ */
+static int numberBlock(Numbering *numbering, int block) {
+    const IrBlock *b = &numbering->fn->blocks[block];
+    int changed = 0;
+
+    for (int i = 0; i < b->insnCount; i++) {
+        int v = b->insns[i];
+        unsigned slot;
+
+        if (!isNumbered(numbering->fn->insns[v].op)) continue;
+        slot = hashInsn(numbering, v) & numbering->mask;
+        while (numbering->table[slot] != IR_NONE && !sameInsn(numbering, numbering->table[slot], v)) {
+            slot = (slot + 1) & numbering->mask;
+        }
+        if (numbering->table[slot] != IR_NONE) {
+            numbering->forward[v] = numbering->table[slot];
+            changed = 1;
+        } else {
+            numbering->table[slot] = v;
+            numbering->undo[numbering->undoCount++] = slot;
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Replaces every pure instruction with an identical dominating one.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int numberValues(IrFunction *fn) {
+    int *rpo = allocate(fn->blockCount, sizeof(int));
+    int *firstChild = allocateMap(fn->blockCount);
+    int *nextSibling = allocateMap(fn->blockCount);
+    int *marks = allocate(fn->blockCount, sizeof(int));
+    int *cursor = allocate(fn->blockCount, sizeof(int));
+    int count = irComputeOrder(fn, rpo);
+    unsigned capacity = 16;
+    int depth = 0, changed = 0;
+    Numbering numbering;
+
+    irComputeDominators(fn, rpo, count);
+    for (int i = count - 1; i > 0; i--) {
+        int idom = fn->blocks[rpo[i]].idom;
+        nextSibling[rpo[i]] = firstChild[idom];
+        firstChild[idom] = rpo[i];
+    }
+
+    while (capacity < (unsigned)fn->insnCount * 2u) capacity <<= 1;
+    numbering.fn = fn;
+    numbering.forward = allocateMap(fn->insnCount);
+    numbering.table = allocateMap((int)capacity);
+    numbering.mask = capacity - 1;
+    numbering.undo = allocate(fn->insnCount, sizeof(unsigned));
+    numbering.undoCount = 0;
+
+    /* Preorder walk of the dominator tree: the table holds exactly the
+       values of the current block's dominators while the block is numbered. */
+    changed |= numberBlock(&numbering, rpo[0]);
+    marks[depth] = 0;
+    cursor[depth++] = firstChild[rpo[0]];
+    while (depth > 0) {
+        int child = cursor[depth - 1];
+        if (child != IR_NONE) {
+            cursor[depth - 1] = nextSibling[child];
+            marks[depth] = numbering.undoCount;
+            changed |= numberBlock(&numbering, child);
+            cursor[depth++] = firstChild[child];
+        } else {
+            depth--;
+            while (numbering.undoCount > marks[depth]) {
+                numbering.table[numbering.undo[--numbering.undoCount]] = IR_NONE;
+            }
+        }
+    }
+
+    if (changed) {
+        irReplaceValues(fn, numbering.forward);
+        for (int v = 0; v < fn->insnCount; v++) {
+            if (numbering.forward[v] != IR_NONE) irDelete(fn, v);
+        }
+        irCompact(fn);
+    }
+
+    free(numbering.forward);
+    free(numbering.table);
+    free(numbering.undo);
+    free(rpo);
+    free(firstChild);
+    free(nextSibling);
+    free(marks);
+    free(cursor);
+    return changed;
+}
+
+/**
+ * @brief Gives every loop entered from a branch, as rotated loops are, a preheader of its own.
+ */
+static int insertPreheaders(IrFunction *fn) {
+    int *rpo = allocate(fn->blockCount, sizeof(int));
+    int count = irComputeOrder(fn, rpo);
+    int blockCount = fn->blockCount, changed = 0;
+
+    irComputeDominators(fn, rpo, count);
+    for (int i = 1; i < count; i++) {
+        const IrBlock *header = &fn->blocks[rpo[i]];
+        int outside = 0, backEdges = 0, entry = IR_NONE, succ[2];
+
+        for (int p = 0; p < header->predCount; p++) {
+            int pred = header->preds[p];
+            if (pred < blockCount && irDominates(fn, rpo[i], pred)) {
+                backEdges++;
+            } else {
+                entry = pred;
+                outside++;
+            }
+        }
+        if (backEdges == 0 || outside != 1 || irSuccessors(fn, entry, succ) != 2) continue;
+        irSplitEdge(fn, entry, succ[0] == rpo[i] ? 0 : 1);
+        changed = 1;
+    }
+
+    free(rpo);
+    return changed;
+}
+
+/**
+ * @brief Moves pure instructions whose operands are defined outside a loop to its preheader.
+ *
+ * @param fn Pointer to the function.
+ * @return int Non-zero if the function changed.
+ */
+int hoistInvariants(IrFunction *fn) {
+    int changed = insertPreheaders(fn);
+    int *rpo = allocate(fn->blockCount, sizeof(int));
+    int *loop = allocate(fn->blockCount, sizeof(int));
+    int *work = allocate(fn->blockCount, sizeof(int));
+    int count = irComputeOrder(fn, rpo);
+
+    irComputeDominators(fn, rpo, count);
+
+    /* Headers later in reverse postorder belong to inner loops. */
+    for (int i = count - 1; i > 0; i--) {
+        int header = rpo[i], stamp = header + 1;
+        int top = 0, backEdges = 0, preheader = IR_NONE, outside = 0, succ[2];
+        const IrBlock *h = &fn->blocks[header];
+
+        loop[header] = stamp;
+        for (int p = 0; p < h->predCount; p++) {
+            int pred = h->preds[p];
+            if (!irDominates(fn, header, pred)) continue;
+            backEdges++;
+            if (loop[pred] != stamp) {
+                loop[pred] = stamp;
+                work[top++] = pred;
+            }
+        }
+        if (backEdges == 0) continue;
+
+        while (top > 0) {
+            const IrBlock *block = &fn->blocks[work[--top]];
+            for (int p = 0; p < block->predCount; p++) {
+                int pred = block->preds[p];
+                if (loop[pred] != stamp && fn->blocks[pred].order != IR_NONE) {
+                    loop[pred] = stamp;
+                    work[top++] = pred;
+                }
+            }
+        }
+
+        for (int p = 0; p < h->predCount; p++) {
+            if (loop[h->preds[p]] != stamp) {
+                preheader = h->preds[p];
+                outside++;
+            }
+        }
+        if (outside != 1 || irSuccessors(fn, preheader, succ) != 1) continue;
+
+        for (int j = i; j < count; j++) {
+            int b = rpo[j];
+            if (loop[b] != stamp) continue;
+            for (int k = 0; k < fn->blocks[b].insnCount; k++) {
+                int v = fn->blocks[b].insns[k];
+                const IrInsn *insn = &fn->insns[v];
+                int invariant = 1;
+
+                if (insn->block != b || insn->op == IR_PHI || !irIsPure(fn, v)) continue;
+                for (int a = 0; a < insn->argCount; a++) {
+                    int def = fn->insns[fn->operands[insn->argStart + a]].block;
+                    if (def == IR_NONE || loop[def] == stamp) {
+                        invariant = 0;
+                        break;
+                    }
+                }
+                if (!invariant) continue;
+                irMove(fn, v, preheader, fn->blocks[preheader].insnCount - 1);
+                changed = 1;
+            }
+        }
+    }
+    if (changed) irCompact(fn);
+
+    free(rpo);
+    free(loop);
+    free(work);
+    return changed;
+}
+
+/**
+ * @brief Reports whether a function is small enough and calls nothing.
+ */
+static int isInlinable(const IrFunction *callee, int limit) {
+    if (callee->blockCount == 0 || callee->blocks[0].predCount > 0 || irSize(callee) > limit) return 0;
+    for (int b = 0; b < callee->blockCount; b++) {
+        const IrBlock *block = &callee->blocks[b];
+        for (int i = 0; i < block->insnCount; i++) {
+            if (callee->insns[block->insns[i]].op == IR_CALL) return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Replaces one call with a copy of the callee's body.
+ *
+ * The calling block is split after the call; the caller jumps into a copy
+ * of the callee's blocks, every return jumps to the continuation, and the
+ * call itself becomes a copy of the returned value.
+ */
+static void inlineCall(IrFunction *fn, int call, const IrFunction *callee) {
+    int argCount = fn->insns[call].argCount;
+    int *args = allocate(argCount, sizeof(int));
+    int *valueMap = allocateMap(callee->insnCount);
+    int *blockMap = allocateMap(callee->blockCount);
+    int *created = allocate(callee->insnCount, sizeof(int));
+    int *returnBlocks = allocate(callee->blockCount, sizeof(int));
+    int *returnValues = allocate(callee->blockCount, sizeof(int));
+    int block = fn->insns[call].block;
+    int position = 0, createdCount = 0, returnCount = 0;
+    int rest, entry, result = IR_NONE, phis = 0, succ[2], n;
+
+    memcpy(args, irArgs(fn, call), (size_t)argCount * sizeof(int));
+    while (fn->blocks[block].insns[position] != call) position++;
+
+    rest = irNewBlock(fn);
+    for (int i = position + 1; i < fn->blocks[block].insnCount; i++) {
+        irMove(fn, fn->blocks[block].insns[i], rest, fn->blocks[rest].insnCount);
+    }
+    fn->blocks[block].insnCount = position;
+    n = irSuccessors(fn, rest, succ);
+    for (int s = 0; s < n; s++) {
+        IrBlock *target = &fn->blocks[succ[s]];
+        for (int p = 0; p < target->predCount; p++) {
+            if (target->preds[p] == block) target->preds[p] = rest;
+        }
+    }
+
+    for (int b = 0; b < callee->blockCount; b++) {
+        if (b == 0 || callee->blocks[b].insnCount > 0) blockMap[b] = irNewBlock(fn);
+    }
+    for (int b = 0; b < callee->blockCount; b++) {
+        const IrBlock *source = &callee->blocks[b];
+        for (int i = 0; i < source->insnCount; i++) {
+            int v = source->insns[i];
+            const IrInsn *insn = &callee->insns[v];
+            int copy;
+
+            if (insn->op == IR_PARAM) {
+                valueMap[v] = args[insn->as.index];
+                continue;
+            }
+            if (insn->op == IR_RET) {
+                copy = irAppend(fn, blockMap[b], IR_JUMP, TypeVoid, NULL, 0);
+                fn->insns[copy].as.targets[0] = rest;
+                returnBlocks[returnCount] = blockMap[b];
+                returnValues[returnCount++] = insn->argCount > 0 ? callee->operands[insn->argStart] : IR_NONE;
+                continue;
+            }
+            copy = irAppend(fn, blockMap[b], insn->op, insn->type, callee->operands + insn->argStart, insn->argCount);
+            fn->insns[copy].operandType = insn->operandType;
+            fn->insns[copy].as = insn->as;
+            if (insn->op == IR_JUMP || insn->op == IR_BRANCH) {
+                fn->insns[copy].as.targets[0] = blockMap[insn->as.targets[0]];
+                if (insn->op == IR_BRANCH) fn->insns[copy].as.targets[1] = blockMap[insn->as.targets[1]];
+            }
+            valueMap[v] = copy;
+            created[createdCount++] = copy;
+        }
+        for (int p = 0; p < source->predCount; p++) {
+            if (blockMap[b] != IR_NONE) irAddPred(fn, blockMap[b], blockMap[source->preds[p]]);
+        }
+    }
+    for (int i = 0; i < createdCount; i++) {
+        int *operands = irArgs(fn, created[i]);
+        for (int a = 0; a < fn->insns[created[i]].argCount; a++) operands[a] = valueMap[operands[a]];
+    }
+
+    entry = irAppend(fn, block, IR_JUMP, TypeVoid, NULL, 0);
+    fn->insns[entry].as.targets[0] = blockMap[0];
+    irAddPred(fn, blockMap[0], block);
+    for (int r = 0; r < returnCount; r++) {
+        irAddPred(fn, rest, returnBlocks[r]);
+        returnValues[r] = returnValues[r] == IR_NONE ? IR_NONE : valueMap[returnValues[r]];
+    }
+
+    if (callee->returnType != TypeVoid && returnCount == 1) {
+        result = returnValues[0];
+    } else if (callee->returnType != TypeVoid && returnCount > 1) {
+        result = irInsert(fn, rest, 0, IR_PHI, callee->returnType, returnValues, returnCount);
+        phis = 1;
+    }
+    if (result != IR_NONE) {
+        makeCopy(fn, call, result);
+        irMove(fn, call, rest, phis);
+    } else {
+        irDelete(fn, call);
+        fn->insns[call].block = IR_NONE;
+    }
+
+    free(args);
+    free(valueMap);
+    free(blockMap);
+    free(created);
+    free(returnBlocks);
+    free(returnValues);
+}
+
+/**
+ * @brief Inlines calls to small functions that do not call anything themselves.
+ *
+ * @param module Pointer to the module that holds the callees.
+ * @param fn Pointer to the calling function.
+ * @param limit Largest callee, in instructions, that is inlined.
+ * @return int Non-zero if the function changed.
+ */
+int inlineCalls(IrModule *module, IrFunction *fn, int limit) {
+    int *calls = allocate(fn->insnCount, sizeof(int));
+    int callCount = 0, changed = 0;
+
+    for (int b = 0; b < fn->blockCount; b++) {
+        const IrBlock *block = &fn->blocks[b];
+        for (int i = 0; i < block->insnCount; i++) {
+            if (fn->insns[block->insns[i]].op == IR_CALL) calls[callCount++] = block->insns[i];
+        }
+    }
+
+    for (int i = 0; i < callCount && irSize(fn) <= INLINE_GROWTH_LIMIT; i++) {
+        const IrFunction *callee = &module->functions[fn->insns[calls[i]].as.index];
+        if (callee == fn || !isInlinable(callee, limit)) continue;
+        inlineCall(fn, calls[i], callee);
+        changed = 1;
+    }
+    if (changed) irRemoveUnreachable(fn);
+
+    free(calls);
+    return changed;
+}
+
+/**
+ * @brief Runs one pass on a function and records its cost.
+ */
+static void runPass(IrModule *module, IrFunction *fn, PassKind pass, int inlineLimit, PassStats *stats) {
+    double start;
+    int changed = 0;
+
+    if (fn->external) return;
+    start = stats != NULL ? now() : 0.0;
+    switch (pass) {
+        case PASS_INLINE: changed = inlineCalls(module, fn, inlineLimit); break;
+        case PASS_COPYPROP: changed = propagateCopies(fn); break;
+        case PASS_CONSTFOLD: changed = foldConstants(fn); break;
+        case PASS_GVN: changed = numberValues(fn); break;
+        case PASS_LICM: changed = hoistInvariants(fn); break;
+        case PASS_DCE: changed = eliminateDeadCode(fn); break;
+        default: break;
+    }
+
+    if (stats != NULL) {
+        stats->seconds[pass] += now() - start;
+        stats->runs[pass]++;
+        stats->changes[pass] += changed != 0;
+    }
+}
+
+/**
+ * @brief Runs a sequence of passes on every function of a module.
+ */
+static void runPipeline(IrModule *module, const PassKind *passes, size_t count, PassStats *stats) {
+    for (int f = 0; f < module->functionCount; f++) {
+        for (size_t i = 0; i < count; i++) {
+            runPass(module, &module->functions[f], passes[i], 0, stats);
+        }
+    }
+}
+
+/**
+ * @brief Counts the instructions of every function of a module.
+ */
+static int moduleSize(const IrModule *module) {
+    int size = 0;
+    for (int f = 0; f < module->functionCount; f++) size += irSize(&module->functions[f]);
+    return size;
+}
+
+/**
+ * @brief Runs the pipeline of an optimization level on every function of a module.
+ *
+ * @param module Pointer to the module.
+ * @param level The optimization level, from 0 to OPT_LEVEL_MAX.
+ * @param stats Pointer to the statistics to accumulate into; may be NULL.
+ */
+void optimizeModule(IrModule *module, int level, PassStats *stats) {
+    if (stats != NULL) stats->sizeBefore += moduleSize(module);
+
+    if (level >= 1) {
+        runPipeline(module, earlyPipeline, sizeof(earlyPipeline) / sizeof(earlyPipeline[0]), stats);
+    }
+    if (level >= 2) {
+        int limit = level >= 3 ? INLINE_LIMIT_O3 : INLINE_LIMIT_O2;
+        for (int f = 0; f < module->functionCount; f++) {
+            runPass(module, &module->functions[f], PASS_INLINE, limit, stats);
+        }
+        runPipeline(module, scalarPipeline, sizeof(scalarPipeline) / sizeof(scalarPipeline[0]), stats);
+    }
+    if (level >= 3) {
+        runPipeline(module, scalarPipeline, sizeof(scalarPipeline) / sizeof(scalarPipeline[0]), stats);
+    }
+
+    if (stats != NULL) stats->sizeAfter += moduleSize(module);
+}
+
+/**
+ * @brief Writes a table of the time spent in each pass.
+ *
+ * @param out The stream to write to.
+ * @param stats Pointer to the accumulated statistics.
+ */
+void printPassStats(FILE *out, const PassStats *stats) {
+    double total = 0.0;
+
+    fprintf(out, "%-18s %6s %8s %12s\n", "pass", "runs", "changed", "time (ms)");
+    for (int pass = 0; pass < PASS_COUNT; pass++) {
+        if (stats->runs[pass] == 0) continue;
+        fprintf(out, "%-18s %6d %8d %12.3f\n", passNames[pass], stats->runs[pass], stats->changes[pass],
+                stats->seconds[pass] * 1000.0);
+        total += stats->seconds[pass];
+    }
+    fprintf(out, "%-18s %6s %8s %12.3f\n", "total", "", "", total * 1000.0);
+    fprintf(out, "instructions: %d -> %d\n", stats->sizeBefore, stats->sizeAfter);
+}
+
+/**
+ * @brief Returns the name of an optimization pass.
+ *
+ * @param pass The pass.
+ * @return const char* The pass's name as shown by `--time-passes`.
+ */
+const char *passName(PassKind pass) {
+    return pass < PASS_COUNT ? passNames[pass] : "?";
+}
@@ -0,0 +1,556 @@
+/**
+ * @file regalloc.c
+ * @brief Implements liveness analysis and linear-scan register allocation over the IR.
+ *
+ * Liveness is computed once per function with bit sets over the values,
+ * iterating the usual backward dataflow equations to a fixed point. Each
+ * value's interval is the hull of every position where it is live, which
+ * loses the holes of a precise interval but keeps allocation a single
+ * sorted sweep, in the manner of Poletto and Sarkar. The precise live sets
+ * are still used to coalesce phis with their operands before allocation.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/regalloc.h"
+#include "include/common.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Allocates zeroed memory; running out goes to outOfMemory().
+ */
+static void *allocate(size_t count, size_t size) {
+    void *memory = calloc(count == 0 ? 1 : count, size);
+    if (memory == NULL) outOfMemory(NULL);
+    return memory;
+}
+
+#define SET_WORD(set, v) ((set)[(v) >> 6])
+#define SET_BIT(v) ((uint64_t)1 << ((v) & 63))
+
+/**
+ * @brief Widens a value's interval to include a position.
+ */
+static void extend(LiveIntervals *live, int value, int position) {
+    if (live->start[value] < 0 || position < live->start[value]) live->start[value] = position;
+    if (position > live->end[value]) live->end[value] = position;
+}
+
+/**
+ * @brief Reports whether a value is a defined result that needs a location.
+ */
+static int hasResult(const IrFunction *fn, int value) {
+    return fn->insns[value].op != IR_NOP && fn->insns[value].type != TypeVoid && fn->insns[value].block != IR_NONE;
+}
+
+/**
+ * @brief Adds the phi operands flowing from `pred` into `succ` to a live set.
+ */
+static void addPhiOperands(const IrFunction *fn, int succ, int pred, uint64_t *set) {
+    const IrBlock *block = &fn->blocks[succ];
+    for (int p = 0; p < block->predCount; p++) {
+        if (block->preds[p] != pred) continue;
+        for (int i = 0; i < block->insnCount; i++) {
+            const IrInsn *insn = &fn->insns[block->insns[i]];
+            if (insn->op != IR_PHI) break;
+            if (p < insn->argCount) {
+                int operand = fn->operands[insn->argStart + p];
+                SET_WORD(set, operand) |= SET_BIT(operand);
+            }
+        }
+    }
+}
+
+#define COALESCE_LIMIT 256    ///< Largest product of group sizes compared for interference.
+
+/**
+ * @struct Liveness
+ * @brief Block live sets and instruction positions, consulted while coalescing.
+ */
+typedef struct {
+    const IrFunction *fn;
+    const uint64_t *in, *out;
+    const int *position;
+    int words;
+} Liveness;
+
+/**
+ * @brief Tests whether a value is in the live set of a block.
+ */
+static int inSet(const Liveness *liveness, const uint64_t *sets, int block, int value) {
+    return (SET_WORD(sets + (size_t)block * (size_t)liveness->words, value) & SET_BIT(value)) != 0;
+}
+
+/**
+ * @brief Reports whether `u` is live just after the definition of `v`.
+ *
+ * A phi is defined at the start of its block and again by the moves at the
+ * end of each predecessor; with critical edges split, a value live across
+ * either point is live into the phi's block.
+ */
+static int liveAtDef(const Liveness *liveness, int u, int v) {
+    const IrFunction *fn = liveness->fn;
+    const IrInsn *def = &fn->insns[v];
+    const IrBlock *block = &fn->blocks[def->block];
+
+    if (def->op == IR_PHI) {
+        if (fn->insns[u].op == IR_PHI && fn->insns[u].block == def->block) return 1;
+        return inSet(liveness, liveness->in, def->block, u);
+    }
+    if (fn->insns[u].block == def->block && fn->insns[u].op != IR_PHI && liveness->position[u] > liveness->position[v]) return 0;
+    if (inSet(liveness, liveness->out, def->block, u)) return 1;
+
+    for (int k = 0; k < block->insnCount; k++) {
+        const IrInsn *insn = &fn->insns[block->insns[k]];
+        if (insn->op == IR_PHI || liveness->position[block->insns[k]] <= liveness->position[v]) continue;
+        for (int a = 0; a < insn->argCount; a++) {
+            if (fn->operands[insn->argStart + a] == u) return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Reports whether any member of one group interferes with any member of another.
+ */
+static int groupsInterfere(const Liveness *liveness, const LiveIntervals *live, const int *next, int a, int b) {
+    for (int u = a; u != IR_NONE; u = next[u]) {
+        for (int v = b; v != IR_NONE; v = next[v]) {
+            if (live->end[u] < live->start[v] || live->end[v] < live->start[u]) continue;
+            if (liveAtDef(liveness, u, v) || liveAtDef(liveness, v, u)) return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Coalesces every phi with the operands it does not interfere with.
+ *
+ * Groups are merged greedily in layout order, so loop-carried values,
+ * which are the ones whose moves execute most often, are merged first.
+ */
+static void coalescePhis(const IrFunction *fn, const Liveness *liveness, LiveIntervals *live) {
+    int *next = allocate((size_t)fn->insnCount, sizeof(int));
+    int *tail = allocate((size_t)fn->insnCount, sizeof(int));
+    int *size = allocate((size_t)fn->insnCount, sizeof(int));
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        live->leader[v] = v;
+        next[v] = IR_NONE;
+        tail[v] = v;
+        size[v] = 1;
+    }
+
+    for (int i = 0; i < live->layoutCount; i++) {
+        const IrBlock *block = &fn->blocks[live->layout[i]];
+        for (int k = 0; k < block->insnCount && fn->insns[block->insns[k]].op == IR_PHI; k++) {
+            int phi = block->insns[k];
+            for (int p = 0; p < fn->insns[phi].argCount; p++) {
+                int operand = fn->operands[fn->insns[phi].argStart + p];
+                int a = live->leader[phi], b = live->leader[operand];
+
+                if (a == b || fn->insns[operand].op == IR_PARAM || !hasResult(fn, operand) || live->start[operand] < 0) continue;
+                if (size[a] * size[b] > COALESCE_LIMIT || groupsInterfere(liveness, live, next, a, b)) continue;
+
+                for (int v = b; v != IR_NONE; v = next[v]) live->leader[v] = a;
+                next[tail[a]] = b;
+                tail[a] = tail[b];
+                size[a] += size[b];
+            }
+        }
+    }
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        if (live->leader[v] != v && live->start[v] >= 0) {
+            extend(live, live->leader[v], live->start[v]);
+            extend(live, live->leader[v], live->end[v]);
+        }
+    }
+
+    free(next);
+    free(tail);
+    free(size);
+}
+
+/**
+ * @brief Lays out the blocks of a function and computes live intervals.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the intervals to fill in.
+ */
+void computeLiveIntervals(IrFunction *fn, LiveIntervals *live) {
+    int words = (fn->insnCount + 63) / 64;
+    size_t setCount = (size_t)fn->blockCount * (size_t)(words == 0 ? 1 : words);
+    uint64_t *use = allocate(setCount, sizeof(uint64_t));
+    uint64_t *def = allocate(setCount, sizeof(uint64_t));
+    uint64_t *in = allocate(setCount, sizeof(uint64_t));
+    uint64_t *out = allocate(setCount, sizeof(uint64_t));
+    int *positions = allocate((size_t)fn->insnCount, sizeof(int));
+    int position = 0, changed = 1;
+    Liveness liveness;
+
+    live->layout = allocate((size_t)fn->blockCount, sizeof(int));
+    live->blockStart = allocate((size_t)fn->blockCount, sizeof(int));
+    live->blockEnd = allocate((size_t)fn->blockCount, sizeof(int));
+    live->start = allocate((size_t)fn->insnCount, sizeof(int));
+    live->end = allocate((size_t)fn->insnCount, sizeof(int));
+    live->leader = allocate((size_t)fn->insnCount, sizeof(int));
+    live->calls = allocate((size_t)fn->insnCount, sizeof(int));
+    live->callCount = 0;
+    live->layoutCount = irComputeOrder(fn, live->layout);
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        live->start[v] = -1;
+        live->end[v] = -1;
+    }
+
+    /* Local use and definition sets. A use counts only if no earlier
+       instruction of the same block defined the value. */
+    for (int i = 0; i < live->layoutCount; i++) {
+        int b = live->layout[i];
+        const IrBlock *block = &fn->blocks[b];
+        uint64_t *blockUse = use + (size_t)b * (size_t)words;
+        uint64_t *blockDef = def + (size_t)b * (size_t)words;
+
+        for (int k = 0; k < block->insnCount; k++) {
+            int v = block->insns[k];
+            const IrInsn *insn = &fn->insns[v];
+            if (insn->op != IR_PHI) {
+                for (int a = 0; a < insn->argCount; a++) {
+                    int operand = fn->operands[insn->argStart + a];
+                    if (!(SET_WORD(blockDef, operand) & SET_BIT(operand))) SET_WORD(blockUse, operand) |= SET_BIT(operand);
+                }
+            }
+            SET_WORD(blockDef, v) |= SET_BIT(v);
+        }
+    }
+
+    while (changed) {
+        changed = 0;
+        for (int i = live->layoutCount - 1; i >= 0; i--) {
+            int b = live->layout[i];
+            uint64_t *blockIn = in + (size_t)b * (size_t)words;
+            uint64_t *blockOut = out + (size_t)b * (size_t)words;
+            int succ[2];
+            int n = irSuccessors(fn, b, succ);
+
+            for (int s = 0; s < n; s++) {
+                const uint64_t *succIn = in + (size_t)succ[s] * (size_t)words;
+                for (int w = 0; w < words; w++) blockOut[w] |= succIn[w];
+                addPhiOperands(fn, succ[s], b, blockOut);
+            }
+            for (int w = 0; w < words; w++) {
+                size_t index = (size_t)b * (size_t)words + (size_t)w;
+                uint64_t next = use[index] | (blockOut[w] & ~def[index]);
+                if (next != blockIn[w]) {
+                    blockIn[w] = next;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < live->layoutCount; i++) {
+        int b = live->layout[i];
+        const IrBlock *block = &fn->blocks[b];
+
+        live->blockStart[b] = position;
+        position += 2;
+        for (int k = 0; k < block->insnCount; k++) {
+            int v = block->insns[k];
+            const IrInsn *insn = &fn->insns[v];
+            int at = insn->op == IR_PHI ? live->blockStart[b] : position;
+
+            positions[v] = at;
+            if (insn->op != IR_PHI) {
+                for (int a = 0; a < insn->argCount; a++) extend(live, fn->operands[insn->argStart + a], at);
+                position += 2;
+            }
+            if (irIsCall(fn, v)) live->calls[live->callCount++] = at;
+            if (hasResult(fn, v)) extend(live, v, at);
+        }
+        live->blockEnd[b] = position;
+        position += 2;
+    }
+
+    for (int i = 0; i < live->layoutCount; i++) {
+        int b = live->layout[i];
+        const IrBlock *block = &fn->blocks[b];
+        const uint64_t *blockIn = in + (size_t)b * (size_t)words;
+        const uint64_t *blockOut = out + (size_t)b * (size_t)words;
+
+        for (int v = 0; v < fn->insnCount; v++) {
+            if (SET_WORD(blockIn, v) & SET_BIT(v)) extend(live, v, live->blockStart[b]);
+            if (SET_WORD(blockOut, v) & SET_BIT(v)) extend(live, v, live->blockEnd[b]);
+        }
+
+        /* A phi is written by the moves at the end of each predecessor. */
+        for (int k = 0; k < block->insnCount && fn->insns[block->insns[k]].op == IR_PHI; k++) {
+            for (int p = 0; p < block->predCount; p++) {
+                if (fn->blocks[block->preds[p]].order != IR_NONE) extend(live, block->insns[k], live->blockEnd[block->preds[p]]);
+            }
+        }
+    }
+
+    liveness.fn = fn;
+    liveness.in = in;
+    liveness.out = out;
+    liveness.position = positions;
+    liveness.words = words;
+    coalescePhis(fn, &liveness, live);
+
+    free(use);
+    free(def);
+    free(in);
+    free(out);
+    free(positions);
+}
+
+/**
+ * @brief Releases the arrays of a set of live intervals.
+ *
+ * @param live Pointer to the intervals to free.
+ */
+void freeLiveIntervals(LiveIntervals *live) {
+    free(live->layout);
+    free(live->blockStart);
+    free(live->blockEnd);
+    free(live->start);
+    free(live->end);
+    free(live->leader);
+    free(live->calls);
+    memset(live, 0, sizeof(*live));
+}
+
+/**
+ * @struct Interval
+ * @brief Sort key of a value during allocation.
+ */
+typedef struct {
+    int start, fixed, value;
+} Interval;
+
+/**
+ * @brief Orders intervals by start, pinned intervals first, then by value.
+ */
+static int compareIntervals(const void *a, const void *b) {
+    const Interval *x = a, *y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    if (x->fixed != y->fixed) return x->fixed > y->fixed ? -1 : 1;
+    return x->value < y->value ? -1 : x->value > y->value;
+}
+
+/**
+ * @brief Reports whether an interval spans a call without starting or ending at it.
+ */
+static int crossesCall(const LiveIntervals *live, int value) {
+    int low = 0, high = live->callCount;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (live->calls[mid] <= live->start[value]) low = mid + 1;
+        else high = mid;
+    }
+    return low < live->callCount && live->calls[low] < live->end[value];
+}
+
+/**
+ * @brief Reports whether a register may hold a value.
+ */
+static int allowed(const RegisterFile *file, int cls, int reg, int acrossCall) {
+    return !acrossCall || reg >= 32 || !(file->callerSaved[cls] & ((uint32_t)1 << reg));
+}
+
+/**
+ * @brief Records that a value was placed in a register.
+ */
+static void assign(Allocation *allocation, int value, int cls, int reg) {
+    allocation->location[value] = reg;
+    if (reg + 1 > allocation->registersUsed[cls]) allocation->registersUsed[cls] = reg + 1;
+    if (reg < 32) allocation->usedMask[cls] |= (uint32_t)1 << reg;
+}
+
+/**
+ * @brief Assigns a location to every value of a function.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the function's live intervals.
+ * @param file Pointer to the description of the available registers.
+ * @param fixed Register of each pinned value, or -1; may be NULL.
+ * @param allocation Pointer to the allocation to fill in.
+ */
+void allocateRegisters(const IrFunction *fn, const LiveIntervals *live, const RegisterFile *file, const int *fixed, Allocation *allocation) {
+    Interval *intervals = allocate((size_t)fn->insnCount, sizeof(Interval));
+    int *active = allocate((size_t)fn->insnCount, sizeof(int));
+    int *holder[REGISTER_CLASSES];
+    int count = 0, activeCount = 0;
+
+    memset(allocation, 0, sizeof(*allocation));
+    allocation->location = allocate((size_t)fn->insnCount, sizeof(int));
+    for (int c = 0; c < REGISTER_CLASSES; c++) {
+        holder[c] = allocate((size_t)file->registerCounts[c] + 1, sizeof(int));
+        for (int r = 0; r < file->registerCounts[c]; r++) holder[c][r] = IR_NONE;
+    }
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        allocation->location[v] = LOCATION_NONE;
+        if (!hasResult(fn, v) || live->start[v] < 0 || live->leader[v] != v) continue;
+        intervals[count].start = live->start[v];
+        intervals[count].fixed = fixed != NULL && fixed[v] >= 0;
+        intervals[count].value = v;
+        count++;
+    }
+    qsort(intervals, (size_t)count, sizeof(Interval), compareIntervals);
+
+    for (int i = 0; i < count; i++) {
+        int v = intervals[i].value;
+        int cls = file->classOf(fn->insns[v].type);
+        int acrossCall = crossesCall(live, v);
+        int reg = -1;
+
+        /* Expire intervals that ended before this one starts. Active is kept
+           sorted by end, so the expired ones are a prefix. */
+        int kept = 0;
+        for (int a = 0; a < activeCount; a++) {
+            int other = active[a];
+            if (live->end[other] < live->start[v]) {
+                int otherClass = file->classOf(fn->insns[other].type);
+                holder[otherClass][allocation->location[other]] = IR_NONE;
+            } else {
+                active[kept++] = other;
+            }
+        }
+        activeCount = kept;
+
+        if (intervals[i].fixed) {
+            reg = fixed[v];
+            if (holder[cls][reg] != IR_NONE) {
+                int evicted = holder[cls][reg];
+                allocation->location[evicted] = LOCATION_SPILL(allocation->spillCount++);
+                for (int a = 0; a < activeCount; a++) {
+                    if (active[a] == evicted) {
+                        memmove(active + a, active + a + 1, (size_t)(activeCount - a - 1) * sizeof(int));
+                        activeCount--;
+                        break;
+                    }
+                }
+            }
+        } else {
+            for (int r = 0; r < file->registerCounts[cls]; r++) {
+                if (holder[cls][r] == IR_NONE && allowed(file, cls, r, acrossCall)) {
+                    reg = r;
+                    break;
+                }
+            }
+        }
+
+        if (reg < 0) {
+            /* Spill whichever of this interval and the active ones of its
+               class ends last, as long as its register suits this value. */
+            int victim = -1;
+            for (int a = activeCount - 1; a >= 0; a--) {
+                int other = active[a];
+                int location = allocation->location[other];
+                if (file->classOf(fn->insns[other].type) != cls) continue;
+                if (fixed != NULL && fixed[other] >= 0) continue;
+                if (!allowed(file, cls, location, acrossCall)) continue;
+                victim = a;
+                break;
+            }
+            if (victim >= 0 && live->end[active[victim]] > live->end[v]) {
+                int other = active[victim];
+                reg = allocation->location[other];
+                allocation->location[other] = LOCATION_SPILL(allocation->spillCount++);
+                memmove(active + victim, active + victim + 1, (size_t)(activeCount - victim - 1) * sizeof(int));
+                activeCount--;
+            } else {
+                allocation->location[v] = LOCATION_SPILL(allocation->spillCount++);
+                continue;
+            }
+        }
+
+        assign(allocation, v, cls, reg);
+        holder[cls][reg] = v;
+        {
+            int a = activeCount;
+            while (a > 0 && live->end[active[a - 1]] > live->end[v]) {
+                active[a] = active[a - 1];
+                a--;
+            }
+            active[a] = v;
+            activeCount++;
+        }
+    }
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        if (live->leader[v] != v && live->start[v] >= 0) allocation->location[v] = allocation->location[live->leader[v]];
+    }
+
+    for (int c = 0; c < REGISTER_CLASSES; c++) free(holder[c]);
+    free(intervals);
+    free(active);
+}
+
+/**
+ * @brief Releases the arrays of an allocation.
+ *
+ * @param allocation Pointer to the allocation to free.
+ */
+void freeAllocation(Allocation *allocation) {
+    free(allocation->location);
+    allocation->location = NULL;
+}
+
+/**
+ * @brief Reports whether entering `target` from `block` needs any phi move.
+ *
+ * Constants without a location are rematerialized, so they always need one.
+ */
+static int needsPhiMoves(const IrFunction *fn, const Allocation *allocation, int block, int target) {
+    const IrBlock *b = &fn->blocks[target];
+    int index = -1;
+
+    for (int p = 0; p < b->predCount; p++) {
+        if (b->preds[p] == block) index = p;
+    }
+    for (int i = 0; index >= 0 && i < b->insnCount; i++) {
+        int phi = b->insns[i];
+        int from;
+        if (fn->insns[phi].op != IR_PHI) break;
+        if (allocation->location[phi] == LOCATION_NONE || index >= fn->insns[phi].argCount) continue;
+        from = fn->operands[fn->insns[phi].argStart + index];
+        if (allocation->location[from] == LOCATION_NONE && fn->insns[from].op != IR_CONST) continue;
+        if (allocation->location[from] != allocation->location[phi]) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Threads jumps through blocks that would only contain a jump.
+ *
+ * @param fn Pointer to the function.
+ * @param live Pointer to the function's live intervals.
+ * @param allocation Pointer to the function's allocation.
+ * @param target Array of `blockCount` entries that receives the landing block of each block.
+ */
+void threadJumps(const IrFunction *fn, const LiveIntervals *live, const Allocation *allocation, int *target) {
+    for (int b = 0; b < fn->blockCount; b++) target[b] = b;
+    for (int i = 1; i < live->layoutCount; i++) {
+        int b = live->layout[i];
+        int last = irTerminator(fn, b);
+        if (fn->blocks[b].insnCount != 1 || fn->insns[last].op != IR_JUMP) continue;
+        if (needsPhiMoves(fn, allocation, b, fn->insns[last].as.targets[0])) continue;
+        target[b] = fn->insns[last].as.targets[0];
+    }
+
+    for (int i = 1; i < live->layoutCount; i++) {
+        int b = live->layout[i];
+        int t = target[b];
+        for (int steps = 0; steps < live->layoutCount && target[t] != t; steps++) t = target[t];
+        target[b] = target[t] == t ? t : b;
+    }
+}
@@ -0,0 +1,534 @@
+/**
+ * @file runtime.c
+ * @brief Implements the memory allocator of the Obsidian runtime library.
+ *
+ * Every thread owns a heap with one list per size class of the slabs that
+ * have blocks to hand out. A slab is a mapping of RUNTIME_SLAB_SIZE bytes
+ * aligned to its own size, so the slab of any block is found by masking the
+ * block's address. Blocks are carved from a fresh slab on demand and
+ * recycled through a free list that only the owning thread touches, which
+ * keeps the common paths free of locks and atomic operations. A slab leaves
+ * the list when it fills up and returns to it when the owner frees one of
+ * its blocks, so finding space never means looking at full slabs.
+ *
+ * A block released by another thread is pushed onto its slab's remote list
+ * with a compare-and-swap. The releasing thread first gathers blocks bound
+ * for the same slab into a batch, so one atomic operation returns many
+ * blocks. The thread whose batch makes a remote list non-empty also pushes
+ * the slab onto its owner's pending stack for the size class, and when its
+ * list runs dry the owner collects the remote frees of just those slabs. A
+ * heap outlives its thread: on exit it is parked and handed to the next
+ * thread that starts allocating, blocks still in use and all.
+ *
+ * Requests above RUNTIME_MAX_SMALL get a mapping of their own, which starts
+ * with the same header so that obsidianDealloc() can tell the two apart.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
+
+#include "include/runtime.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32) && defined(__GNUC__)
+    #define RUNTIME_POOLS 1
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define RUNTIME_POOLS 0
+#endif
+
+#if RUNTIME_POOLS
+
+#define SLAB_HEADER 128             ///< Bytes before the first block of a slab, keeping blocks aligned.
+#define CLASS_COUNT 44              ///< Number of size classes up to RUNTIME_MAX_SMALL.
+#define REMOTE_BATCH 32             ///< Remote frees gathered before they are handed back.
+#define BATCH_SLOTS 8               ///< Slabs a thread gathers remote frees for at once.
+
+/**
+ * @struct Block
+ * @brief A free block, linked through its first word.
+ */
+typedef struct Block {
+    struct Block *next;
+} Block;
+
+struct Heap;
+
+/**
+ * @struct Slab
+ * @brief The header at the start of every mapping the allocator makes.
+ */
+typedef struct Slab {
+    struct Heap *owner;             ///< Heap whose thread may use `free`; set once.
+    struct Slab *next, *previous;   ///< Links in the owner's list for the size class.
+    struct Slab *nextPending;       ///< Link in the owner's pending stack for the size class.
+    Block *free;                    ///< Blocks released by the owner.
+    Block *remote;                  ///< Blocks released by other threads, updated atomically.
+    char *bump, *end;               ///< Part of the slab never handed out yet.
+    size_t blockSize;               ///< Size of every block, or 0 for a large allocation.
+    size_t mapped;                  ///< Length of the mapping of a large allocation.
+    unsigned used;                  ///< Blocks handed out and not yet returned to the owner.
+    unsigned sizeClass;
+    int listed;                     ///< Whether the slab is in the owner's list.
+} Slab;
+
+typedef char slabHeaderFits[sizeof(Slab) <= SLAB_HEADER ? 1 : -1];
+
+/**
+ * @struct RemoteBatch
+ * @brief Blocks of one foreign slab released by the current thread and not yet handed back.
+ */
+typedef struct {
+    Slab *slab;
+    Block *head, *tail;
+    unsigned count;
+} RemoteBatch;
+
+/**
+ * @struct Heap
+ * @brief The pools of one thread.
+ */
+typedef struct Heap {
+    Slab *slabs[CLASS_COUNT];       ///< The slab allocations come from first, followed by others with space.
+    Slab *pending[CLASS_COUNT];     ///< Slabs with remote frees not yet collected, updated atomically.
+    RemoteBatch batches[BATCH_SLOTS];
+    struct Heap *nextParked;
+} Heap;
+
+static __thread Heap *localHeap;
+static pthread_once_t runtimeOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t heapKey;
+static pthread_mutex_t parkedLock = PTHREAD_MUTEX_INITIALIZER;
+static Heap *parkedHeaps;
+static size_t pageSize;
+
+/**
+ * @brief Returns the size class of a small request.
+ *
+ * Classes are 16 bytes apart up to 128 bytes, then four to every doubling,
+ * which wastes at most a fifth of a block.
+ */
+static unsigned sizeClass(size_t size) {
+    unsigned shift;
+
+    if (size <= 128) return size <= 16 ? 0 : (unsigned)((size + 15) / 16) - 1;
+    shift = 63u - (unsigned)__builtin_clzll((unsigned long long)(size - 1));
+    return 8 + (shift - 7) * 4 + (unsigned)((size - 1 - ((size_t)1 << shift)) >> (shift - 2));
+}
+
+/**
+ * @brief Returns the block size of a size class.
+ */
+static size_t classSize(unsigned index) {
+    unsigned shift, step;
+
+    if (index < 8) return (size_t)(index + 1) * 16;
+    shift = 7 + (index - 8) / 4;
+    step = (index - 8) % 4 + 1;
+    return ((size_t)1 << shift) + ((size_t)step << (shift - 2));
+}
+
+/**
+ * @brief Maps zeroed memory aligned to RUNTIME_SLAB_SIZE.
+ *
+ * @param size The length, a multiple of the page size.
+ * @return void* The mapping, or NULL on failure.
+ */
+static void *mapAligned(size_t size) {
+    size_t length = size + RUNTIME_SLAB_SIZE, head, tail;
+    char *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uintptr_t start;
+
+    if (base == MAP_FAILED) return NULL;
+    start = ((uintptr_t)base + RUNTIME_SLAB_SIZE - 1) & ~(uintptr_t)(RUNTIME_SLAB_SIZE - 1);
+    head = (size_t)(start - (uintptr_t)base);
+    tail = length - head - size;
+    if (head > 0) munmap(base, head);
+    if (tail > 0) munmap((char *)start + size, tail);
+    return (void *)start;
+}
+
+/**
+ * @brief Returns the header of the mapping a block belongs to.
+ */
+static Slab *slabOf(const void *pointer) {
+    return (Slab *)((uintptr_t)pointer & ~(uintptr_t)(RUNTIME_SLAB_SIZE - 1));
+}
+
+/**
+ * @brief Pushes a slab onto its owner's pending stack.
+ */
+static void pushPending(Slab *slab) {
+    Slab **stack = &slab->owner->pending[slab->sizeClass];
+    Slab *seen = __atomic_load_n(stack, __ATOMIC_RELAXED);
+
+    do {
+        slab->nextPending = seen;
+    } while (!__atomic_compare_exchange_n(stack, &seen, slab, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Hands a batch of remote frees back to its slab and empties it.
+ *
+ * The owner only collects the remote frees of slabs on its pending stack, so
+ * a slab whose remote list was empty cannot be unmapped before it is pushed.
+ */
+static void flushBatch(RemoteBatch *batch) {
+    Block *seen;
+
+    if (batch->slab == NULL) return;
+    seen = __atomic_load_n(&batch->slab->remote, __ATOMIC_RELAXED);
+    do {
+        batch->tail->next = seen;
+    } while (!__atomic_compare_exchange_n(&batch->slab->remote, &seen, batch->head, 1, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+    if (seen == NULL) pushPending(batch->slab);
+    batch->slab = NULL;
+    batch->head = batch->tail = NULL;
+    batch->count = 0;
+}
+
+/**
+ * @brief Hands every pending batch of remote frees back to its slab.
+ */
+static void flushBatches(Heap *heap) {
+    for (int i = 0; i < BATCH_SLOTS; i++) flushBatch(&heap->batches[i]);
+}
+
+/**
+ * @brief Parks the heap of an exiting thread for the next thread to adopt.
+ */
+static void parkHeap(void *argument) {
+    Heap *heap = argument;
+
+    flushBatches(heap);
+    localHeap = NULL;
+    pthread_mutex_lock(&parkedLock);
+    heap->nextParked = parkedHeaps;
+    parkedHeaps = heap;
+    pthread_mutex_unlock(&parkedLock);
+}
+
+/**
+ * @brief Sets up the process-wide state of the allocator once.
+ */
+static void initRuntime(void) {
+    long size = sysconf(_SC_PAGESIZE);
+
+    pageSize = size > 0 ? (size_t)size : 4096;
+    pthread_key_create(&heapKey, parkHeap);
+}
+
+/**
+ * @brief Returns the heap of the calling thread, adopting a parked heap or mapping a new one.
+ *
+ * @return Heap* The heap, or NULL if no memory is available.
+ */
+static Heap *acquireHeap(void) {
+    Heap *heap;
+
+    if (localHeap != NULL) return localHeap;
+    pthread_once(&runtimeOnce, initRuntime);
+    pthread_mutex_lock(&parkedLock);
+    heap = parkedHeaps;
+    if (heap != NULL) parkedHeaps = heap->nextParked;
+    pthread_mutex_unlock(&parkedLock);
+
+    if (heap == NULL) {
+        heap = mmap(NULL, sizeof(Heap), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (heap == MAP_FAILED) return NULL;
+    }
+    heap->nextParked = NULL;
+    pthread_setspecific(heapKey, heap);
+    localHeap = heap;
+    return heap;
+}
+
+/**
+ * @brief Moves a slab's remote frees into its free list.
+ */
+static void collectRemote(Slab *slab) {
+    Block *block = __atomic_exchange_n(&slab->remote, NULL, __ATOMIC_ACQUIRE);
+    while (block != NULL) {
+        Block *next = block->next;
+        block->next = slab->free;
+        slab->free = block;
+        slab->used--;
+        block = next;
+    }
+}
+
+/**
+ * @brief Reports whether a slab has a block to hand out.
+ */
+static int hasSpace(const Slab *slab) {
+    return slab->free != NULL || slab->bump < slab->end;
+}
+
+/**
+ * @brief Unlinks a slab from its heap's list.
+ */
+static void unlinkSlab(Heap *heap, Slab *slab) {
+    if (slab->previous != NULL) slab->previous->next = slab->next;
+    else heap->slabs[slab->sizeClass] = slab->next;
+    if (slab->next != NULL) slab->next->previous = slab->previous;
+    slab->listed = 0;
+}
+
+/**
+ * @brief Links a slab at the front of its heap's list, where allocations come from.
+ *
+ * A full slab it displaces from the front leaves the list, so every slab
+ * behind the front always has space.
+ */
+static void pushSlab(Heap *heap, Slab *slab) {
+    Slab *front = heap->slabs[slab->sizeClass];
+
+    if (front != NULL && !hasSpace(front)) unlinkSlab(heap, front);
+    slab->listed = 1;
+    slab->previous = NULL;
+    slab->next = heap->slabs[slab->sizeClass];
+    if (slab->next != NULL) slab->next->previous = slab;
+    heap->slabs[slab->sizeClass] = slab;
+}
+
+/**
+ * @brief Takes a block from a slab that has space.
+ */
+static void *takeBlock(Slab *slab) {
+    Block *block = slab->free;
+
+    slab->used++;
+    if (block != NULL) {
+        slab->free = block->next;
+        return block;
+    }
+    block = (Block *)slab->bump;
+    slab->bump += slab->blockSize;
+    return block;
+}
+
+/**
+ * @brief Unlinks an entirely free slab and unmaps it.
+ */
+static void releaseSlab(Heap *heap, Slab *slab) {
+    if (slab->listed) unlinkSlab(heap, slab);
+    munmap(slab, RUNTIME_SLAB_SIZE);
+}
+
+/**
+ * @brief Finds or maps a slab with space for a size class and takes a block from it.
+ *
+ * The full slab at the front leaves the list, and pending remote frees are
+ * handed back. Only the slabs on the class's pending stack then collect
+ * their remote frees: each joins the list, or is unmapped if it turns out
+ * entirely free while another slab has space.
+ *
+ * @return void* The block, or NULL if no memory is available.
+ */
+static void *refill(Heap *heap, unsigned index) {
+    Slab *found = heap->slabs[index], *pending;
+
+    if (found != NULL && !hasSpace(found)) unlinkSlab(heap, found);
+    flushBatches(heap);
+    pending = __atomic_exchange_n(&heap->pending[index], NULL, __ATOMIC_ACQUIRE);
+    while (pending != NULL) {
+        Slab *slab = pending;
+        pending = slab->nextPending;
+        collectRemote(slab);
+        if (slab->used == 0 && heap->slabs[index] != NULL && heap->slabs[index] != slab) {
+            releaseSlab(heap, slab);
+        } else if (!slab->listed) {
+            pushSlab(heap, slab);
+        }
+    }
+
+    found = heap->slabs[index];
+    if (found == NULL) {
+        found = mapAligned(RUNTIME_SLAB_SIZE);
+        if (found == NULL) return NULL;
+        found->owner = heap;
+        found->blockSize = classSize(index);
+        found->sizeClass = index;
+        found->bump = (char *)found + SLAB_HEADER;
+        found->end = found->bump + (RUNTIME_SLAB_SIZE - SLAB_HEADER) / found->blockSize * found->blockSize;
+        pushSlab(heap, found);
+    }
+    return takeBlock(found);
+}
+
+/**
+ * @brief Maps a large allocation of its own.
+ */
+static void *allocLarge(size_t size) {
+    size_t length;
+    Slab *slab;
+
+    pthread_once(&runtimeOnce, initRuntime);
+    if (size > SIZE_MAX - SLAB_HEADER - RUNTIME_SLAB_SIZE - pageSize) return NULL;
+    length = (size + SLAB_HEADER + pageSize - 1) & ~(pageSize - 1);
+    slab = mapAligned(length);
+    if (slab == NULL) return NULL;
+    slab->mapped = length;
+    return (char *)slab + SLAB_HEADER;
+}
+
+/**
+ * @brief Gathers a block released by a thread that does not own its slab.
+ */
+static void freeRemote(Heap *heap, Slab *slab, Block *block) {
+    RemoteBatch *batch = &heap->batches[((uintptr_t)slab / RUNTIME_SLAB_SIZE) % BATCH_SLOTS];
+
+    if (batch->slab != slab) {
+        flushBatch(batch);
+        batch->slab = slab;
+        batch->tail = block;
+    }
+    block->next = batch->head;
+    batch->head = block;
+    if (++batch->count == REMOTE_BATCH) flushBatch(batch);
+}
+
+/**
+ * @brief Allocates memory, backing the language's `alloc`.
+ *
+ * @param size The number of bytes needed; 0 still returns a unique block.
+ * @return void* Pointer to uninitialized memory aligned to RUNTIME_ALIGNMENT,
+ *               or NULL if no memory is available.
+ */
+void *obsidianAlloc(size_t size) {
+    Heap *heap;
+    Slab *slab;
+    unsigned index;
+
+    if (size > RUNTIME_MAX_SMALL) return allocLarge(size);
+    heap = localHeap != NULL ? localHeap : acquireHeap();
+    if (heap == NULL) return NULL;
+    index = sizeClass(size);
+    slab = heap->slabs[index];
+    if (slab != NULL && hasSpace(slab)) return takeBlock(slab);
+    return refill(heap, index);
+}
+
+/**
+ * @brief Releases memory, backing the language's `dealloc`.
+ *
+ * A full slab that gets a block back returns to its pool's list, and one
+ * left entirely free is unmapped unless allocations come from it. Memory
+ * released by a thread other than the one that allocated it is collected in
+ * small batches that are handed back to the owning pool together.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew(), or NULL.
+ */
+void obsidianDealloc(void *pointer) {
+    Slab *slab;
+    Heap *heap;
+    Block *block = pointer;
+
+    if (pointer == NULL) return;
+    slab = slabOf(pointer);
+    if (slab->blockSize == 0) {
+        munmap(slab, slab->mapped);
+        return;
+    }
+    heap = localHeap != NULL ? localHeap : acquireHeap();
+    if (slab->owner == heap) {
+        block->next = slab->free;
+        slab->free = block;
+        slab->used--;
+        if (!slab->listed) pushSlab(heap, slab);
+        else if (slab->used == 0 && heap->slabs[slab->sizeClass] != slab) releaseSlab(heap, slab);
+    } else if (heap != NULL) {
+        freeRemote(heap, slab, block);
+    } else {
+        RemoteBatch lone;
+        lone.slab = slab;
+        lone.head = lone.tail = block;
+        lone.count = 1;
+        flushBatch(&lone);
+    }
+}
+
+/**
+ * @brief Returns the number of bytes usable in an allocated block.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew().
+ * @return size_t The usable size, which is at least the size requested.
+ */
+size_t obsidianAllocSize(const void *pointer) {
+    const Slab *slab = slabOf(pointer);
+    return slab->blockSize != 0 ? slab->blockSize : slab->mapped - SLAB_HEADER;
+}
+
+#else
+
+/**
+ * @struct LargeHeader
+ * @brief The size stored before memory from the C library where no pools are available.
+ */
+typedef union {
+    size_t size;
+    char align[RUNTIME_ALIGNMENT];
+} LargeHeader;
+
+/**
+ * @brief Allocates memory, backing the language's `alloc`.
+ *
+ * @param size The number of bytes needed; 0 still returns a unique block.
+ * @return void* Pointer to uninitialized memory aligned to RUNTIME_ALIGNMENT,
+ *               or NULL if no memory is available.
+ */
+void *obsidianAlloc(size_t size) {
+    LargeHeader *header;
+
+    if (size > SIZE_MAX - sizeof(LargeHeader)) return NULL;
+    header = malloc(sizeof(LargeHeader) + size);
+    if (header == NULL) return NULL;
+    header->size = size;
+    return header + 1;
+}
+
+/**
+ * @brief Releases memory, backing the language's `dealloc`.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew(), or NULL.
+ */
+void obsidianDealloc(void *pointer) {
+    if (pointer != NULL) free((LargeHeader *)pointer - 1);
+}
+
+/**
+ * @brief Returns the number of bytes usable in an allocated block.
+ *
+ * @param pointer Memory returned by obsidianAlloc() or obsidianNew().
+ * @return size_t The usable size, which is at least the size requested.
+ */
+size_t obsidianAllocSize(const void *pointer) {
+    return ((const LargeHeader *)pointer - 1)->size;
+}
+
+#endif
+
+/**
+ * @brief Allocates zeroed memory, backing the language's `new`.
+ *
+ * Large allocations come straight from fresh mappings, which are already zeroed.
+ *
+ * @param size The number of bytes needed.
+ * @return void* Pointer to zeroed memory, or NULL if no memory is available.
+ */
+void *obsidianNew(size_t size) {
+    void *pointer = obsidianAlloc(size);
+    if (pointer != NULL && (!RUNTIME_POOLS || size <= RUNTIME_MAX_SMALL)) memset(pointer, 0, size);
+    return pointer;
+}
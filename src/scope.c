@@ -0,0 +1,156 @@
+/**
+ * @file scope.c
+ * @brief Implements the scoped symbol table used by semantic analysis.
+ *
+ * Only the innermost scope receives declarations, so it always sits at the
+ * top of the arena and may be grown there without disturbing its parents.
+ * A grown scope leaves its old table behind in the arena until it is left.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/scope.h"
+#include "include/intern.h"
+
+#define SCOPE_INITIAL_SLOTS 8u      ///< Slots in the table of a new scope.
+
+/**
+ * @brief Returns the first slot probed for a symbol ID.
+ */
+static uint32_t slotOf(uint32_t name, uint32_t mask) {
+    uint32_t mixed = name * 2654435769u;
+    return (mixed ^ (mixed >> 16)) & mask;
+}
+
+/**
+ * @brief Initializes an empty scope stack.
+ *
+ * @param stack Pointer to the scope stack to initialize.
+ */
+void initScopeStack(ScopeStack *stack) {
+    initArena(&stack->arena);
+    stack->innermost = NULL;
+    stack->depth = 0;
+}
+
+/**
+ * @brief Releases the memory of every scope.
+ *
+ * @param stack Pointer to the scope stack to free.
+ */
+void freeScopeStack(ScopeStack *stack) {
+    freeArena(&stack->arena);
+    stack->innermost = NULL;
+    stack->depth = 0;
+}
+
+/**
+ * @brief Enters a new innermost scope.
+ *
+ * @param stack Pointer to the scope stack.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int pushScope(ScopeStack *stack) {
+    ArenaMark mark = arenaMark(&stack->arena);
+    Scope *scope = arenaAlloc(&stack->arena, sizeof(Scope));
+
+    if (scope == NULL) return -1;
+    scope->slots = arenaAlloc(&stack->arena, SCOPE_INITIAL_SLOTS * sizeof(ScopeEntry));
+    if (scope->slots == NULL) {
+        arenaReset(&stack->arena, mark);
+        return -1;
+    }
+    scope->parent = stack->innermost;
+    scope->mark = mark;
+    scope->mask = SCOPE_INITIAL_SLOTS - 1;
+    scope->count = 0;
+    stack->innermost = scope;
+    stack->depth++;
+    return 0;
+}
+
+/**
+ * @brief Leaves the innermost scope, forgetting every name declared in it.
+ *
+ * @param stack Pointer to the scope stack.
+ */
+void popScope(ScopeStack *stack) {
+    Scope *scope = stack->innermost;
+
+    stack->innermost = scope->parent;
+    stack->depth--;
+    arenaReset(&stack->arena, scope->mark);
+}
+
+/**
+ * @brief Moves the innermost scope's entries to a table twice the size.
+ *
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+static int growScope(ScopeStack *stack, Scope *scope) {
+    uint32_t mask = scope->mask * 2 + 1;
+    ScopeEntry *slots = arenaAlloc(&stack->arena, ((size_t)mask + 1) * sizeof(ScopeEntry));
+
+    if (slots == NULL) return -1;
+    for (uint32_t i = 0; i <= scope->mask; i++) {
+        uint32_t slot;
+        if (scope->slots[i].name == SYMBOL_NONE) continue;
+        slot = slotOf(scope->slots[i].name, mask);
+        while (slots[slot].name != SYMBOL_NONE) slot = (slot + 1) & mask;
+        slots[slot] = scope->slots[i];
+    }
+    scope->slots = slots;
+    scope->mask = mask;
+    return 0;
+}
+
+/**
+ * @brief Declares a name in the innermost scope.
+ *
+ * @param stack Pointer to the scope stack, which must have a scope open.
+ * @param name The symbol ID of the name.
+ * @param value The value bound to the name.
+ * @return int Returns 0 on success, 1 if the name was already declared in
+ *             the innermost scope, or -1 if memory could not be allocated.
+ */
+int declareSymbol(ScopeStack *stack, uint32_t name, int value) {
+    Scope *scope = stack->innermost;
+    uint32_t slot;
+
+    if (name == SYMBOL_NONE) return 0;
+    if ((scope->count + 1) * 4 > (scope->mask + 1) * 3 && growScope(stack, scope) != 0) return -1;
+
+    slot = slotOf(name, scope->mask);
+    while (scope->slots[slot].name != SYMBOL_NONE) {
+        if (scope->slots[slot].name == name) {
+            scope->slots[slot].value = value;
+            return 1;
+        }
+        slot = (slot + 1) & scope->mask;
+    }
+    scope->slots[slot].name = name;
+    scope->slots[slot].value = value;
+    scope->count++;
+    return 0;
+}
+
+/**
+ * @brief Resolves a name through the innermost scope outwards.
+ *
+ * @param stack Pointer to the scope stack.
+ * @param name The symbol ID of the name.
+ * @return int The value bound by the innermost declaration, or -1 if the name is not in scope.
+ */
+int lookupSymbol(const ScopeStack *stack, uint32_t name) {
+    for (const Scope *scope = stack->innermost; scope != NULL; scope = scope->parent) {
+        uint32_t slot = slotOf(name, scope->mask);
+        while (scope->slots[slot].name != SYMBOL_NONE) {
+            if (scope->slots[slot].name == name) return scope->slots[slot].value;
+            slot = (slot + 1) & scope->mask;
+        }
+    }
+    return -1;
+}
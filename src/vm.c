@@ -0,0 +1,492 @@
+/**
+ * @file vm.c
+ * @brief Implements the register-based bytecode virtual machine for the Obsidian language.
+ *
+ * This file contains the module containers and the interpreter loop. With GCC
+ * and Clang the loop uses computed goto: every instruction carries the address
+ * of its handler, and each handler ends by jumping directly to the next one.
+ * Other compilers fall back to a switch over the opcode.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/vm.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+    #define VM_THREADED 1
+#endif
+
+/**
+ * @brief Initializes an empty module.
+ *
+ * @param module Pointer to the module to initialize.
+ */
+void initModule(Module *module) {
+    module->functions = NULL;
+    module->functionCount = 0;
+    module->functionCapacity = 0;
+    initArena(&module->strings);
+}
+
+/**
+ * @brief Releases every function and string owned by the module.
+ *
+ * @param module Pointer to the module to free.
+ */
+void freeModule(Module *module) {
+    for (int i = 0; i < module->functionCount; i++) {
+        free(module->functions[i].code);
+        free(module->functions[i].constants);
+        free(module->functions[i].threaded);
+    }
+    free(module->functions);
+    freeArena(&module->strings);
+    initModule(module);
+}
+
+/**
+ * @brief Adds an empty function to the module.
+ *
+ * @param module Pointer to the module.
+ * @param name Name of the function; copied into the module.
+ * @return int Index of the new function, or -1 if memory could not be allocated.
+ */
+int addFunction(Module *module, const char *name) {
+    Function *function;
+
+    if (module->functionCount == module->functionCapacity) {
+        int capacity = module->functionCapacity ? module->functionCapacity * 2 : 16;
+        Function *functions = realloc(module->functions, (size_t)capacity * sizeof(Function));
+        if (functions == NULL) return -1;
+        module->functions = functions;
+        module->functionCapacity = capacity;
+    }
+
+    function = &module->functions[module->functionCount];
+    memset(function, 0, sizeof(*function));
+    function->name = arenaCopy(&module->strings, name, strlen(name) + 1);
+    if (function->name == NULL) return -1;
+    return module->functionCount++;
+}
+
+/**
+ * @brief Appends an instruction to a function.
+ *
+ * @param function Pointer to the function.
+ * @param insn The encoded instruction.
+ * @return int Index of the instruction, or -1 if memory could not be allocated.
+ */
+int emitInsn(Function *function, uint32_t insn) {
+    if (function->codeCount == function->codeCapacity) {
+        int capacity = function->codeCapacity ? function->codeCapacity * 2 : 64;
+        uint32_t *code = realloc(function->code, (size_t)capacity * sizeof(uint32_t));
+        if (code == NULL) return -1;
+        function->code = code;
+        function->codeCapacity = capacity;
+    }
+    function->code[function->codeCount] = insn;
+    return function->codeCount++;
+}
+
+/**
+ * @brief Adds a constant to a function, reusing an identical one if present.
+ *
+ * Constants are compared bit for bit, so 0.0 and -0.0 stay distinct.
+ *
+ * @param function Pointer to the function.
+ * @param value The constant value.
+ * @return int Index of the constant, or -1 if memory could not be allocated.
+ */
+int addConstant(Function *function, Slot value) {
+    for (int i = 0; i < function->constantCount; i++) {
+        if (memcmp(&function->constants[i], &value, sizeof(Slot)) == 0) return i;
+    }
+
+    if (function->constantCount > INSN_MAX_BX) return -1;
+    if (function->constantCount == function->constantCapacity) {
+        int capacity = function->constantCapacity ? function->constantCapacity * 2 : 16;
+        Slot *constants = realloc(function->constants, (size_t)capacity * sizeof(Slot));
+        if (constants == NULL) return -1;
+        function->constants = constants;
+        function->constantCapacity = capacity;
+    }
+    function->constants[function->constantCount] = value;
+    return function->constantCount++;
+}
+
+/**
+ * @brief Initializes the interpreter and allocates its register stack.
+ *
+ * @param vm Pointer to the VM to initialize.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int initVM(VM *vm) {
+    vm->stack = malloc(VM_STACK_SLOTS * sizeof(Slot));
+    vm->frames = malloc(VM_MAX_FRAMES * sizeof(CallFrame));
+    vm->frameCount = 0;
+    if (vm->stack == NULL || vm->frames == NULL) {
+        freeVM(vm);
+        return -1;
+    }
+    vm->stackEnd = vm->stack + VM_STACK_SLOTS;
+    return 0;
+}
+
+/**
+ * @brief Releases the interpreter's register stack and frames.
+ *
+ * @param vm Pointer to the VM to free.
+ */
+void freeVM(VM *vm) {
+    free(vm->stack);
+    free(vm->frames);
+    vm->stack = NULL;
+    vm->stackEnd = NULL;
+    vm->frames = NULL;
+    vm->frameCount = 0;
+}
+
+/**
+ * @brief Converts a register value between two types.
+ *
+ * Conversions go through a 64-bit integer or a double, so narrowing follows
+ * the usual two's complement truncation and float-to-integer conversion
+ * truncates toward zero.
+ *
+ * @param value The source value.
+ * @param from The source type.
+ * @param to The destination type.
+ * @return Slot The converted value.
+ */
+Slot convertValue(Slot value, TypeKind from, TypeKind to) {
+    Slot out;
+    int64_t asInt = 0;
+    uint64_t asUnsigned = 0;
+    double asFloat = 0.0;
+    int fromFloat = from == TypeF32 || from == TypeF64;
+
+    switch (from) {
+        case TypeI8: case TypeI16: case TypeI32: asInt = value.i32; break;
+        case TypeBool: case TypeChar: case TypeU8: case TypeU16: case TypeU32: asInt = (int64_t)value.u32; break;
+        case TypeI64: asInt = value.i64; break;
+        case TypeU64: asUnsigned = value.u64; asInt = (int64_t)value.u64; break;
+        case TypeF32: asFloat = (double)value.f32; break;
+        case TypeF64: asFloat = value.f64; break;
+        default: break;
+    }
+    if (from != TypeU64) asUnsigned = (uint64_t)asInt;
+
+    out.u64 = 0;
+    switch (to) {
+        case TypeI8: out.i32 = fromFloat ? (int8_t)asFloat : (int8_t)asInt; break;
+        case TypeI16: out.i32 = fromFloat ? (int16_t)asFloat : (int16_t)asInt; break;
+        case TypeI32: out.i32 = fromFloat ? (int32_t)asFloat : (int32_t)asInt; break;
+        case TypeI64: out.i64 = fromFloat ? (int64_t)asFloat : asInt; break;
+        case TypeBool: out.u32 = (uint32_t)(fromFloat ? asFloat != 0.0 : asUnsigned != 0); break;
+        case TypeChar: case TypeU8: out.u32 = fromFloat ? (uint8_t)asFloat : (uint8_t)asUnsigned; break;
+        case TypeU16: out.u32 = fromFloat ? (uint16_t)asFloat : (uint16_t)asUnsigned; break;
+        case TypeU32: out.u32 = fromFloat ? (uint32_t)asFloat : (uint32_t)asUnsigned; break;
+        case TypeU64: out.u64 = fromFloat ? (uint64_t)asFloat : asUnsigned; break;
+        case TypeF32: out.f32 = fromFloat ? (float)asFloat : (from == TypeU64 ? (float)asUnsigned : (float)asInt); break;
+        case TypeF64: out.f64 = fromFloat ? asFloat : (from == TypeU64 ? (double)asUnsigned : (double)asInt); break;
+        default: out = value; break;
+    }
+    return out;
+}
+
+/**
+ * @brief Prints a register value followed by a newline.
+ *
+ * @param value The value to print.
+ * @param type The type of the value.
+ */
+static void printSlot(Slot value, TypeKind type) {
+    switch (type) {
+        case TypeBool: puts(value.u32 ? "true" : "false"); break;
+        case TypeChar: printf("%c\n", (char)value.u32); break;
+        case TypeI8: case TypeI16: case TypeI32: printf("%" PRId32 "\n", value.i32); break;
+        case TypeU8: case TypeU16: case TypeU32: printf("%" PRIu32 "\n", value.u32); break;
+        case TypeI64: printf("%" PRId64 "\n", value.i64); break;
+        case TypeU64: printf("%" PRIu64 "\n", value.u64); break;
+        case TypeF32: printf("%g\n", (double)value.f32); break;
+        case TypeF64: printf("%g\n", value.f64); break;
+        case TypeString: puts(value.str); break;
+        default: putchar('\n'); break;
+    }
+}
+
+/**
+ * @brief Reports a runtime error raised inside a function.
+ *
+ * @param function The function that was running.
+ * @param message The error message.
+ * @return int Always -1.
+ */
+static int runtimeError(const Function *function, const char *message) {
+    fprintf(stderr, "obsidian: runtime error: %s in '%s'\n", message, function->name);
+    return -1;
+}
+
+#ifdef VM_THREADED
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpedantic"
+    #define CASE(name) op_##name:
+    #define DISPATCH() do { insn = ip->insn; goto *ip->handler; } while (0)
+    #define LABEL_ADDRESS(name) &&op_##name,
+#else
+    #define CASE(name) case OP_##name:
+    #define DISPATCH() goto dispatch
+#endif
+
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+#define JUMP(offset) do { ip += 1 + (offset); DISPATCH(); } while (0)
+#define A INSN_A(insn)
+#define B INSN_B(insn)
+#define C INSN_C(insn)
+#define R(n) base[n]
+
+#define ARITH(name, field, op) CASE(name) R(A).field = R(B).field op R(C).field; NEXT();
+#define COMPARE(name, field, op) CASE(name) R(A).u32 = (uint32_t)(R(B).field op R(C).field); NEXT();
+#define SIGNED_DIVIDE(name, field, op, min) CASE(name) \
+    if (R(C).field == 0) return runtimeError(function, "division by zero"); \
+    if (R(B).field == (min) && R(C).field == -1) return runtimeError(function, "integer overflow in division"); \
+    R(A).field = R(B).field op R(C).field; NEXT();
+#define UNSIGNED_DIVIDE(name, field, op) CASE(name) \
+    if (R(C).field == 0) return runtimeError(function, "division by zero"); \
+    R(A).field = R(B).field op R(C).field; NEXT();
+
+/**
+ * @brief Runs bytecode until the outermost frame returns.
+ *
+ * When called with a NULL `function` it only publishes its handler table
+ * through `labels`, which prepareModule uses to thread the bytecode.
+ *
+ * @param vm Pointer to the VM.
+ * @param module Pointer to the prepared module.
+ * @param function The function to start in.
+ * @param base The register window of the first frame.
+ * @param result Pointer that receives the return value; may be NULL.
+ * @param labels Pointer that receives the handler table; may be NULL.
+ * @return int Returns 0 on success, or -1 on a runtime error.
+ */
+static int execute(VM *vm, Module *module, Function *function, Slot *base, Slot *result, const void *const **labels) {
+#ifdef VM_THREADED
+    static const void *const handlers[] = { VM_OPCODES(LABEL_ADDRESS) };
+#endif
+    int entryFrames;
+    ThreadedInsn *ip;
+    uint32_t insn;
+
+    if (function == NULL) {
+#ifdef VM_THREADED
+        if (labels != NULL) *labels = handlers;
+#else
+        if (labels != NULL) *labels = NULL;
+#endif
+        return 0;
+    }
+
+    entryFrames = vm->frameCount;
+    ip = function->threaded;
+#ifdef VM_THREADED
+    DISPATCH();
+#else
+dispatch:
+    insn = ip->insn;
+    switch ((OpCode)INSN_OP(insn)) {
+#endif
+
+    CASE(MOVE) R(A) = R(B); NEXT();
+    CASE(LOADK) R(A) = function->constants[INSN_BX(insn)]; NEXT();
+
+    CASE(ADD_I32) R(A).u32 = R(B).u32 + R(C).u32; NEXT();
+    CASE(SUB_I32) R(A).u32 = R(B).u32 - R(C).u32; NEXT();
+    CASE(MUL_I32) R(A).u32 = R(B).u32 * R(C).u32; NEXT();
+    SIGNED_DIVIDE(DIV_I32, i32, /, INT32_MIN)
+    SIGNED_DIVIDE(MOD_I32, i32, %, INT32_MIN)
+    UNSIGNED_DIVIDE(DIV_U32, u32, /)
+    UNSIGNED_DIVIDE(MOD_U32, u32, %)
+
+    CASE(ADD_I64) R(A).u64 = R(B).u64 + R(C).u64; NEXT();
+    CASE(SUB_I64) R(A).u64 = R(B).u64 - R(C).u64; NEXT();
+    CASE(MUL_I64) R(A).u64 = R(B).u64 * R(C).u64; NEXT();
+    SIGNED_DIVIDE(DIV_I64, i64, /, INT64_MIN)
+    SIGNED_DIVIDE(MOD_I64, i64, %, INT64_MIN)
+    UNSIGNED_DIVIDE(DIV_U64, u64, /)
+    UNSIGNED_DIVIDE(MOD_U64, u64, %)
+
+    ARITH(ADD_F32, f32, +)
+    ARITH(SUB_F32, f32, -)
+    ARITH(MUL_F32, f32, *)
+    ARITH(DIV_F32, f32, /)
+    CASE(MOD_F32) R(A).f32 = fmodf(R(B).f32, R(C).f32); NEXT();
+
+    ARITH(ADD_F64, f64, +)
+    ARITH(SUB_F64, f64, -)
+    ARITH(MUL_F64, f64, *)
+    ARITH(DIV_F64, f64, /)
+    CASE(MOD_F64) R(A).f64 = fmod(R(B).f64, R(C).f64); NEXT();
+
+    ARITH(AND_I32, u32, &)
+    ARITH(OR_I32, u32, |)
+    ARITH(XOR_I32, u32, ^)
+    CASE(SHL_I32) R(A).u32 = R(B).u32 << (R(C).u32 & 31); NEXT();
+    CASE(SHR_I32) R(A).i32 = R(B).i32 >> (R(C).u32 & 31); NEXT();
+    CASE(SHR_U32) R(A).u32 = R(B).u32 >> (R(C).u32 & 31); NEXT();
+
+    ARITH(AND_I64, u64, &)
+    ARITH(OR_I64, u64, |)
+    ARITH(XOR_I64, u64, ^)
+    CASE(SHL_I64) R(A).u64 = R(B).u64 << (R(C).u64 & 63); NEXT();
+    CASE(SHR_I64) R(A).i64 = R(B).i64 >> (R(C).u64 & 63); NEXT();
+    CASE(SHR_U64) R(A).u64 = R(B).u64 >> (R(C).u64 & 63); NEXT();
+
+    CASE(NEG_I32) R(A).u32 = 0u - R(B).u32; NEXT();
+    CASE(NEG_I64) R(A).u64 = 0u - R(B).u64; NEXT();
+    CASE(NEG_F32) R(A).f32 = -R(B).f32; NEXT();
+    CASE(NEG_F64) R(A).f64 = -R(B).f64; NEXT();
+    CASE(BNOT_I32) R(A).u32 = ~R(B).u32; NEXT();
+    CASE(BNOT_I64) R(A).u64 = ~R(B).u64; NEXT();
+    CASE(NOT) R(A).u32 = (uint32_t)!R(B).u32; NEXT();
+
+    COMPARE(EQ_I32, u32, ==)
+    COMPARE(NE_I32, u32, !=)
+    COMPARE(LT_I32, i32, <)
+    COMPARE(LE_I32, i32, <=)
+    COMPARE(LT_U32, u32, <)
+    COMPARE(LE_U32, u32, <=)
+    COMPARE(EQ_I64, u64, ==)
+    COMPARE(NE_I64, u64, !=)
+    COMPARE(LT_I64, i64, <)
+    COMPARE(LE_I64, i64, <=)
+    COMPARE(LT_U64, u64, <)
+    COMPARE(LE_U64, u64, <=)
+    COMPARE(EQ_F32, f32, ==)
+    COMPARE(NE_F32, f32, !=)
+    COMPARE(LT_F32, f32, <)
+    COMPARE(LE_F32, f32, <=)
+    COMPARE(EQ_F64, f64, ==)
+    COMPARE(NE_F64, f64, !=)
+    COMPARE(LT_F64, f64, <)
+    COMPARE(LE_F64, f64, <=)
+
+    CASE(CONV) R(A) = convertValue(R(B), (TypeKind)(C >> 4), (TypeKind)(C & 15)); NEXT();
+
+    CASE(JMP) JUMP(INSN_SBX(insn));
+    CASE(JMPF) if (!R(A).u32) JUMP(INSN_SBX(insn)); NEXT();
+    CASE(JMPT) if (R(A).u32) JUMP(INSN_SBX(insn)); NEXT();
+
+    CASE(CALL) {
+        Function *callee = &module->functions[INSN_BX(insn)];
+        Slot *calleeBase = base + A;
+        CallFrame *frame;
+
+        if (vm->frameCount == VM_MAX_FRAMES || calleeBase + callee->registerCount > vm->stackEnd) {
+            return runtimeError(callee, "stack overflow");
+        }
+        frame = &vm->frames[vm->frameCount++];
+        frame->function = function;
+        frame->ip = ip;
+        frame->base = base;
+
+        function = callee;
+        base = calleeBase;
+        ip = callee->threaded;
+        DISPATCH();
+    }
+
+    CASE(RET)
+        R(0) = R(A);
+        /* fallthrough */
+    CASE(RETV) {
+        CallFrame *frame;
+        if (vm->frameCount == entryFrames) {
+            if (result != NULL) *result = R(0);
+            return 0;
+        }
+        frame = &vm->frames[--vm->frameCount];
+        function = frame->function;
+        base = frame->base;
+        ip = frame->ip;
+        NEXT();
+    }
+
+    CASE(PRINT) printSlot(R(A), (TypeKind)B); NEXT();
+
+#ifndef VM_THREADED
+    default:
+        break;
+    }
+#endif
+    return runtimeError(function, "invalid instruction");
+}
+
+#ifdef VM_THREADED
+    #pragma GCC diagnostic pop
+#endif
+
+/**
+ * @brief Prepares every function of the module for execution.
+ *
+ * @param module Pointer to the module.
+ * @return int Returns 0 on success, or -1 if memory could not be allocated.
+ */
+int prepareModule(Module *module) {
+    const void *const *labels = NULL;
+
+    execute(NULL, module, NULL, NULL, NULL, &labels);
+
+    for (int i = 0; i < module->functionCount; i++) {
+        Function *function = &module->functions[i];
+
+        free(function->threaded);
+        function->threaded = malloc((size_t)(function->codeCount + 1) * sizeof(ThreadedInsn));
+        if (function->threaded == NULL) return -1;
+
+        for (int pc = 0; pc < function->codeCount; pc++) {
+            uint32_t insn = function->code[pc];
+            function->threaded[pc].insn = insn;
+            function->threaded[pc].handler = (labels != NULL && INSN_OP(insn) < OP_COUNT) ? labels[INSN_OP(insn)] : NULL;
+        }
+        function->threaded[function->codeCount].insn = INSN_ABC(OP_RETV, 0, 0, 0); ///< Guard for code that falls off the end.
+        function->threaded[function->codeCount].handler = labels != NULL ? labels[OP_RETV] : NULL;
+    }
+    return 0;
+}
+
+/**
+ * @brief Calls a function of a prepared module.
+ *
+ * @param vm Pointer to the VM.
+ * @param module Pointer to the prepared module.
+ * @param function Index of the function to call.
+ * @param args Argument values, one per parameter.
+ * @param result Pointer that receives the return value; may be NULL.
+ * @return int Returns 0 on success, or -1 on a runtime error.
+ */
+int vmCall(VM *vm, Module *module, int function, const Slot *args, Slot *result) {
+    Function *callee;
+    int status;
+
+    if (function < 0 || function >= module->functionCount) return -1;
+    callee = &module->functions[function];
+    if (callee->threaded == NULL) return runtimeError(callee, "function was not prepared");
+    if (vm->stack + callee->registerCount > vm->stackEnd) return runtimeError(callee, "stack overflow");
+
+    for (int i = 0; i < callee->paramCount; i++) {
+        vm->stack[i] = args[i];
+    }
+
+    vm->frameCount = 0;
+    status = execute(vm, module, callee, vm->stack, result, NULL);
+    vm->frameCount = 0;
+    return status;
+}
@@ -0,0 +1,582 @@
+/**
+ * @file watch.c
+ * @brief Implements the watch mode of the Obsidian compiler.
+ *
+ * Directories are watched with inotify. Watched files are kept in an array
+ * whose indices follow the intern table of their paths, so an event is
+ * matched to its file by one hash of the path. Watched directories are
+ * indexed by their inotify watch descriptor. Files are loaded through a
+ * token cache that lives as long as the loop, which keeps the tokens of
+ * every unchanged file and skips lexing a file that was saved unmodified.
+ *
+ * Each file remembers the sources of the modules it imports, read from its
+ * `import` tokens. A round checks modules before their importers, and when
+ * a check rewrites a module's interface file, the files importing it are
+ * checked again in the same round.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#if defined(__linux__)
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#endif
+
+#include "include/watch.h"
+#include "include/cache.h"
+#include "include/driver.h"
+#include "include/interface.h"
+#include "include/intern.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #include <dirent.h>
+    #include <errno.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/inotify.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#if !defined(__linux__)
+
+int runWatch(const char *directory) {
+    (void)directory;
+    fputs("obsidian: error: watch mode is not supported on this platform\n", stderr);
+    return EXIT_FAILURE;
+}
+
+#else
+
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF)
+#define WATCH_EVENT_BUFFER 16384    ///< Bytes of inotify events read at once.
+
+/**
+ * @struct WatchedFile
+ * @brief A source file under the watched directory.
+ */
+typedef struct {
+    char *path;
+    int live;           ///< Cleared when the file is deleted or moved away.
+    int pending;        ///< Set while the file waits for the next round.
+    int failed;         ///< Whether its last check reported errors.
+    int ordered;        ///< Set while the round's order is built, once the file has its place.
+    uint32_t *imports;  ///< Indices of the files of the modules it imports.
+    size_t importCount, importCapacity;
+} WatchedFile;
+
+/**
+ * @struct Watcher
+ * @brief The state of the watch loop.
+ *
+ * File `i` has the symbol `i + 1` in `names`, since only file paths are
+ * interned there and symbols are assigned in order. An imported module
+ * whose source does not exist gets a file that is not live, so that it can
+ * be named before it appears.
+ */
+typedef struct {
+    TokenCache cache;
+    int fd;                         ///< The inotify instance.
+    const char *root;
+    InternTable names;
+    WatchedFile *files;
+    size_t fileCount, fileCapacity;
+    int *pending;                   ///< Indices of the files to check next round.
+    size_t pendingCount, pendingCapacity;
+    char **directories;             ///< Directory paths indexed by watch descriptor.
+    size_t directoryCapacity;
+} Watcher;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * @brief Signal handler that asks the watch loop to stop.
+ *
+ * @param signal The signal number (unused).
+ */
+static void handleStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+/**
+ * @brief Grows an array to hold at least `needed` items, exiting if memory runs out.
+ */
+static void *growArray(void *items, size_t *capacity, size_t needed, size_t size) {
+    size_t newCapacity;
+    void *grown;
+
+    if (needed <= *capacity) return items;
+    newCapacity = *capacity ? *capacity * 2 : 16;
+    while (newCapacity < needed) newCapacity *= 2;
+    grown = realloc(items, newCapacity * size);
+    if (grown == NULL) {
+        fputs("obsidian: error: out of memory while watching\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    memset((char *)grown + *capacity * size, 0, (newCapacity - *capacity) * size);
+    *capacity = newCapacity;
+    return grown;
+}
+
+/**
+ * @brief Copies a path into newly allocated memory.
+ */
+static char *copyPath(const char *path) {
+    size_t length = strlen(path);
+    char *copy = malloc(length + 1);
+
+    if (copy == NULL) {
+        fputs("obsidian: error: out of memory while watching\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, path, length + 1);
+    return copy;
+}
+
+/**
+ * @brief Joins a directory and a file name into a newly allocated path.
+ */
+static char *joinPath(const char *directory, const char *name) {
+    size_t length = strlen(directory);
+    char *path;
+
+    while (length > 1 && directory[length - 1] == '/') length--;
+    path = malloc(length + strlen(name) + 2);
+    if (path == NULL) {
+        fputs("obsidian: error: out of memory while watching\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    sprintf(path, "%.*s/%s", (int)length, directory, name);
+    return path;
+}
+
+/**
+ * @brief Reports whether a file name has the `.ob` extension.
+ */
+static int isSourceName(const char *name) {
+    size_t length = strlen(name);
+    return length > 3 && strcmp(name + length - 3, ".ob") == 0;
+}
+
+/**
+ * @brief Finds the watched file with a path.
+ *
+ * @return WatchedFile* The file, or NULL if the path was never watched.
+ */
+static WatchedFile *findFile(const Watcher *watcher, const char *path) {
+    uint32_t symbol = findSymbol(&watcher->names, path, strlen(path));
+    return symbol == SYMBOL_NONE ? NULL : &watcher->files[symbol - 1];
+}
+
+/**
+ * @brief Finds the file with a path, adding it, not yet live, if it was never seen.
+ *
+ * @param watcher Pointer to the watcher.
+ * @param path The path of the file; it is copied.
+ * @return size_t The index of the file.
+ */
+static size_t fileIndex(Watcher *watcher, const char *path) {
+    uint32_t symbol = internSymbol(&watcher->names, path, strlen(path));
+    size_t index;
+
+    if (symbol == SYMBOL_NONE) {
+        fputs("obsidian: error: out of memory while watching\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    index = symbol - 1;
+    if (index == watcher->fileCount) {
+        watcher->files = growArray(watcher->files, &watcher->fileCapacity, index + 1, sizeof(WatchedFile));
+        watcher->files[index].path = copyPath(path);
+        watcher->fileCount++;
+    }
+    return index;
+}
+
+/**
+ * @brief Queues a file for the next round unless it is already queued.
+ */
+static void queueFile(Watcher *watcher, size_t index) {
+    if (watcher->files[index].pending) return;
+    watcher->files[index].pending = 1;
+    watcher->pending = growArray(watcher->pending, &watcher->pendingCapacity, watcher->pendingCount + 1, sizeof(int));
+    watcher->pending[watcher->pendingCount++] = (int)index;
+}
+
+/**
+ * @brief Starts watching a file, or revives it, and queues it for the next round.
+ *
+ * @param watcher Pointer to the watcher.
+ * @param path The path of the file; it is copied.
+ */
+static void trackFile(Watcher *watcher, const char *path) {
+    size_t index = fileIndex(watcher, path);
+
+    watcher->files[index].live = 1;
+    queueFile(watcher, index);
+}
+
+/**
+ * @brief Adds a directory and every directory below it to the inotify instance.
+ *
+ * Source files found along the way are queued for the next round. Hidden
+ * entries and symbolic links are skipped.
+ *
+ * @param watcher Pointer to the watcher.
+ * @param path The path of the directory.
+ * @return int Returns 0 on success, or -1 if the directory could not be watched.
+ */
+static int watchDirectory(Watcher *watcher, const char *path) {
+    int descriptor = inotify_add_watch(watcher->fd, path, WATCH_MASK | IN_ONLYDIR);
+    DIR *directory;
+    struct dirent *item;
+
+    if (descriptor < 0) {
+        fprintf(stderr, "obsidian: error: cannot watch '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    watcher->directories = growArray(watcher->directories, &watcher->directoryCapacity, (size_t)descriptor + 1, sizeof(char *));
+    free(watcher->directories[descriptor]);
+    watcher->directories[descriptor] = copyPath(path);
+
+    directory = opendir(path);
+    if (directory == NULL) return 0;
+    while ((item = readdir(directory)) != NULL) {
+        struct stat info;
+        char *child;
+
+        if (item->d_name[0] == '.') continue;
+        child = joinPath(path, item->d_name);
+        if (lstat(child, &info) == 0) {
+            if (S_ISDIR(info.st_mode)) watchDirectory(watcher, child);
+            else if (S_ISREG(info.st_mode) && isSourceName(item->d_name)) trackFile(watcher, child);
+        }
+        free(child);
+    }
+    closedir(directory);
+    return 0;
+}
+
+/**
+ * @brief Applies one inotify event to the set of watched files.
+ */
+static void handleEvent(Watcher *watcher, const struct inotify_event *event) {
+    const char *directory;
+    char *path;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+        fputs("obsidian: warning: file events were lost; rescanning\n", stderr);
+        watchDirectory(watcher, watcher->root);
+        return;
+    }
+    if (event->wd < 0 || (size_t)event->wd >= watcher->directoryCapacity) return;
+    directory = watcher->directories[event->wd];
+    if (directory == NULL) return;
+
+    if (event->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+        free(watcher->directories[event->wd]);
+        watcher->directories[event->wd] = NULL;
+        return;
+    }
+    if (event->len == 0 || event->name[0] == '.') return;
+
+    path = joinPath(directory, event->name);
+    if (event->mask & IN_ISDIR) {
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) watchDirectory(watcher, path);
+    } else if (isSourceName(event->name)) {
+        if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            trackFile(watcher, path);
+        } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            WatchedFile *file = findFile(watcher, path);
+            if (file != NULL && file->live) {
+                /* A file that goes away while it waits to be checked, like an editor's temporary, is dropped quietly. */
+                if (!file->pending) fprintf(stderr, "obsidian: '%s' was removed\n", path);
+                file->live = 0;
+            }
+        }
+    }
+    free(path);
+}
+
+/**
+ * @brief Reads and applies every event that is ready without blocking.
+ *
+ * @return int Returns the number of events read, or -1 on error.
+ */
+static int readEvents(Watcher *watcher) {
+    uint32_t words[WATCH_EVENT_BUFFER / sizeof(uint32_t)];    ///< Aligned like the events' fields.
+    char *buffer = (char *)words;
+    int count = 0;
+
+    while (1) {
+        ssize_t length = read(watcher->fd, words, sizeof(words));
+        if (length < 0) {
+            if (errno == EAGAIN) return count;
+            if (errno == EINTR) return stopRequested ? count : -1;
+            perror("read");
+            return -1;
+        }
+        for (char *cursor = buffer; cursor < buffer + length; count++) {
+            const struct inotify_event *event = (const struct inotify_event *)(void *)cursor;
+            handleEvent(watcher, event);
+            cursor += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Records the modules a file imports from the `import` tokens of its stream.
+ *
+ * A module is looked up as a source next to the importing file, where the
+ * driver looks for its interface.
+ *
+ * @param watcher Pointer to the watcher.
+ * @param index The index of the importing file.
+ * @param entry Pointer to the cache entry holding the file's tokens.
+ */
+static void readImports(Watcher *watcher, size_t index, const CacheEntry *entry) {
+    const char *path = watcher->files[index].path;
+    const char *slash = strrchr(path, '/');
+    int directory = slash == NULL ? 0 : (int)(slash - path + 1);
+    size_t count = 0;
+
+    for (size_t i = 0; i + 1 < entry->stream.count; i++) {
+        const char *module;
+        char *source;
+        size_t imported;
+        WatchedFile *file;
+
+        if (entry->stream.tokens[i].type != TImport || entry->stream.tokens[i + 1].type != TIdentifier) continue;
+        module = symbolName(&watcher->cache.symbols, entry->stream.symbols[i + 1]);
+        source = malloc((size_t)directory + strlen(module) + 4);
+        if (source == NULL) {
+            fputs("obsidian: error: out of memory while watching\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        sprintf(source, "%.*s%s.ob", directory, path, module);
+        imported = fileIndex(watcher, source);
+        free(source);
+
+        file = &watcher->files[index];
+        file->imports = growArray(file->imports, &file->importCapacity, count + 1, sizeof(uint32_t));
+        file->imports[count++] = (uint32_t)imported;
+    }
+    watcher->files[index].importCount = count;
+}
+
+/**
+ * @brief Places a queued file in the round's order after the queued modules it imports.
+ *
+ * A file already placed is skipped, which also ends the walk around an
+ * import cycle.
+ */
+static void orderFile(Watcher *watcher, size_t index, int *order, size_t *count) {
+    WatchedFile *file = &watcher->files[index];
+
+    if (file->ordered) return;
+    file->ordered = 1;
+    for (size_t i = 0; i < file->importCount; i++) {
+        if (watcher->files[file->imports[i]].pending) orderFile(watcher, file->imports[i], order, count);
+    }
+    order[(*count)++] = (int)index;
+}
+
+/**
+ * @brief Reorders the queue so that modules are checked before the files that import them.
+ *
+ * Otherwise an importer could be checked against an interface that the
+ * same round is about to rewrite.
+ */
+static void orderPending(Watcher *watcher) {
+    int *order = malloc((watcher->pendingCount + 1) * sizeof(int));
+    size_t count = 0;
+
+    if (order == NULL) {
+        fputs("obsidian: error: out of memory while watching\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < watcher->pendingCount; i++) {
+        size_t index = (size_t)watcher->pending[i];
+        const CacheEntry *entry = watcher->files[index].live ? loadTokens(&watcher->cache, watcher->files[index].path) : NULL;
+        if (entry != NULL) readImports(watcher, index, entry);
+    }
+    for (size_t i = 0; i < watcher->pendingCount; i++) orderFile(watcher, (size_t)watcher->pending[i], order, &count);
+    for (size_t i = 0; i < count; i++) watcher->files[order[i]].ordered = 0;
+    memcpy(watcher->pending, order, count * sizeof(int));
+    free(order);
+}
+
+/**
+ * @brief Reads the identity of a source file's interface file, all zero if it has none.
+ */
+static void interfaceStamp(const char *source, struct stat *info) {
+    size_t length = strlen(source) - 3;
+    char *path = malloc(length + sizeof(INTERFACE_EXTENSION));
+
+    memset(info, 0, sizeof(*info));
+    if (path == NULL) return;
+    sprintf(path, "%.*s%s", (int)length, source, INTERFACE_EXTENSION);
+    if (stat(path, info) != 0) memset(info, 0, sizeof(*info));
+    free(path);
+}
+
+/**
+ * @brief Queues every live file that imports a module.
+ *
+ * Files checked earlier in the round are queued again, to be checked
+ * against the module's new interface.
+ */
+static void queueImporters(Watcher *watcher, size_t module) {
+    for (size_t i = 0; i < watcher->fileCount; i++) {
+        const WatchedFile *file = &watcher->files[i];
+        if (!file->live || file->pending) continue;
+        for (size_t j = 0; j < file->importCount; j++) {
+            if (file->imports[j] == module) {
+                queueFile(watcher, i);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks every queued file, then the importers of every interface that changed, and prints a summary of the round.
+ */
+static void checkPending(Watcher *watcher) {
+    double start = now();
+    size_t checked = 0, failed = 0;
+
+    orderPending(watcher);
+    for (size_t i = 0; i < watcher->pendingCount; i++) {
+        size_t index = (size_t)watcher->pending[i];
+        WatchedFile *file = &watcher->files[index];
+        const CacheEntry *entry;
+        struct stat before, after;
+
+        file->pending = 0;
+        if (!file->live) continue;
+        checked++;
+        entry = loadTokens(&watcher->cache, file->path);
+        if (entry == NULL) {
+            fprintf(stderr, "obsidian: error: could not read '%s'\n", file->path);
+            file->failed = 1;
+        } else {
+            readImports(watcher, index, entry);
+            file = &watcher->files[index];
+            interfaceStamp(file->path, &before);
+            file->failed = checkFile(entry, &watcher->cache) != 0;
+            interfaceStamp(file->path, &after);
+            if (before.st_ino != after.st_ino || before.st_size != after.st_size || before.st_mtim.tv_sec != after.st_mtim.tv_sec ||
+                before.st_mtim.tv_nsec != after.st_mtim.tv_nsec) {
+                queueImporters(watcher, index);
+            }
+        }
+        if (file->failed) {
+            fprintf(stderr, "obsidian: '%s' has errors\n", file->path);
+            failed++;
+        }
+    }
+    watcher->pendingCount = 0;
+
+    if (checked > 0) {
+        fprintf(stderr, "obsidian: checked %zu file%s in %.1f ms, %zu with errors\n", checked, checked == 1 ? "" : "s",
+                (now() - start) * 1000.0, failed);
+    }
+}
+
+/**
+ * @brief Checks the sources under a directory and rechecks them as they change.
+ *
+ * @param directory The directory to watch.
+ * @return int Returns EXIT_SUCCESS when interrupted, or EXIT_FAILURE on error.
+ */
+int runWatch(const char *directory) {
+    struct sigaction action;
+    struct pollfd poller;
+    Watcher watcher;
+    int status = EXIT_SUCCESS;
+
+    memset(&watcher, 0, sizeof(watcher));
+    watcher.root = directory;
+    watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher.fd < 0) {
+        perror("inotify_init1");
+        return EXIT_FAILURE;
+    }
+    initTokenCache(&watcher.cache);
+    initInternTable(&watcher.names);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (watchDirectory(&watcher, directory) != 0) {
+        status = EXIT_FAILURE;
+        stopRequested = 1;
+    } else {
+        fprintf(stderr, "obsidian: watching '%s' (%zu file%s)\n", directory, watcher.fileCount,
+                watcher.fileCount == 1 ? "" : "s");
+        checkPending(&watcher);
+    }
+
+    poller.fd = watcher.fd;
+    poller.events = POLLIN;
+    while (!stopRequested) {
+        int ready = poll(&poller, 1, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            status = EXIT_FAILURE;
+            break;
+        }
+        /* Keep collecting until the burst of events has been quiet for a while. */
+        while (!stopRequested && ready > 0) {
+            if (readEvents(&watcher) < 0) {
+                status = EXIT_FAILURE;
+                stopRequested = 1;
+                break;
+            }
+            ready = poll(&poller, 1, WATCH_DEBOUNCE_MS);
+            if (ready < 0 && errno != EINTR) {
+                perror("poll");
+                status = EXIT_FAILURE;
+                stopRequested = 1;
+            }
+        }
+        if (!stopRequested) checkPending(&watcher);
+    }
+
+    for (size_t i = 0; i < watcher.directoryCapacity; i++) free(watcher.directories[i]);
+    for (size_t i = 0; i < watcher.fileCount; i++) {
+        free(watcher.files[i].path);
+        free(watcher.files[i].imports);
+    }
+    free(watcher.directories);
+    free(watcher.files);
+    free(watcher.pending);
+    freeInternTable(&watcher.names);
+    freeTokenCache(&watcher.cache);
+    close(watcher.fd);
+    return status;
+}
+
+#endif
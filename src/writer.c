@@ -0,0 +1,171 @@
+/**
+ * @file writer.c
+ * @brief Implements the buffered output writer used by the code generators.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Initializes a writer over a stream.
+ *
+ * @param writer Pointer to the writer to initialize.
+ * @param file The stream that receives the output, or NULL to collect it in memory.
+ */
+void initWriter(Writer *writer, FILE *file) {
+    writer->file = file;
+    writer->memory = NULL;
+    writer->memorySize = 0;
+    writer->memoryCapacity = 0;
+    writer->used = 0;
+    writer->failed = 0;
+}
+
+/**
+ * @brief Appends bytes to the memory block, growing it as needed.
+ */
+static void appendMemory(Writer *writer, const void *data, size_t size) {
+    if (writer->failed) return;
+    if (writer->memorySize + size + 1 > writer->memoryCapacity) {
+        size_t capacity = writer->memoryCapacity < WRITER_BUFFER_SIZE ? WRITER_BUFFER_SIZE : writer->memoryCapacity;
+        char *memory;
+        while (capacity < writer->memorySize + size + 1) capacity *= 2;
+        memory = realloc(writer->memory, capacity);
+        if (memory == NULL) {
+            writer->failed = 1;
+            return;
+        }
+        writer->memory = memory;
+        writer->memoryCapacity = capacity;
+    }
+    memcpy(writer->memory + writer->memorySize, data, size);
+    writer->memorySize += size;
+}
+
+/**
+ * @brief Hands raw bytes to the stream or the memory block.
+ */
+static void emit(Writer *writer, const void *data, size_t size) {
+    if (writer->file == NULL) appendMemory(writer, data, size);
+    else if (fwrite(data, 1, size, writer->file) != size) writer->failed = 1;
+}
+
+/**
+ * @brief Hands the buffered bytes to the stream.
+ */
+static void drain(Writer *writer) {
+    if (writer->used > 0) emit(writer, writer->buffer, writer->used);
+    writer->used = 0;
+}
+
+/**
+ * @brief Appends raw bytes.
+ *
+ * Writes larger than the buffer bypass it.
+ *
+ * @param writer Pointer to the writer.
+ * @param data Pointer to the bytes to write.
+ * @param size Number of bytes to write.
+ */
+void writeBytes(Writer *writer, const void *data, size_t size) {
+    if (writer->used + size > WRITER_BUFFER_SIZE) {
+        drain(writer);
+        if (size > WRITER_BUFFER_SIZE) {
+            emit(writer, data, size);
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->used, data, size);
+    writer->used += size;
+}
+
+/**
+ * @brief Appends a NUL-terminated string.
+ *
+ * @param writer Pointer to the writer.
+ * @param text The string to write.
+ */
+void writeString(Writer *writer, const char *text) {
+    writeBytes(writer, text, strlen(text));
+}
+
+/**
+ * @brief Appends a single character.
+ *
+ * @param writer Pointer to the writer.
+ * @param c The character to write.
+ */
+void writeChar(Writer *writer, char c) {
+    if (writer->used == WRITER_BUFFER_SIZE) drain(writer);
+    writer->buffer[writer->used++] = c;
+}
+
+/**
+ * @brief Appends an unsigned integer in decimal.
+ *
+ * @param writer Pointer to the writer.
+ * @param value The integer to write.
+ */
+void writeUnsigned(Writer *writer, uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+
+    do {
+        digits[sizeof(digits) - ++count] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    writeBytes(writer, digits + sizeof(digits) - count, count);
+}
+
+/**
+ * @brief Appends a signed integer in decimal.
+ *
+ * @param writer Pointer to the writer.
+ * @param value The integer to write.
+ */
+void writeInt(Writer *writer, int64_t value) {
+    if (value < 0) {
+        writeChar(writer, '-');
+        writeUnsigned(writer, 0u - (uint64_t)value);
+    } else {
+        writeUnsigned(writer, (uint64_t)value);
+    }
+}
+
+/**
+ * @brief Writes the buffered output to the stream and flushes it.
+ *
+ * @param writer Pointer to the writer.
+ * @return int Returns 0 on success, or -1 if any write has failed.
+ */
+int flushWriter(Writer *writer) {
+    drain(writer);
+    if (writer->file != NULL && fflush(writer->file) != 0) writer->failed = 1;
+    return writer->failed ? -1 : 0;
+}
+
+/**
+ * @brief Takes the output collected by a writer without a stream.
+ *
+ * @param writer Pointer to the writer.
+ * @param size Pointer that receives the length of the output, excluding its NUL terminator.
+ * @return char* The NUL-terminated output, to be released with free(), or NULL if any write has failed.
+ */
+char *takeWriterMemory(Writer *writer, size_t *size) {
+    char *memory;
+
+    drain(writer);
+    appendMemory(writer, "", 0);
+    memory = writer->failed ? NULL : writer->memory;
+    if (memory != NULL) memory[writer->memorySize] = '\0';
+    else free(writer->memory);
+    *size = memory != NULL ? writer->memorySize : 0;
+    initWriter(writer, NULL);
+    return memory;
+}
@@ -0,0 +1,2085 @@
+/**
+ * @file x86.c
+ * @brief Implements the x86-64 code generator.
+ *
+ * Blocks are emitted in the allocator's layout order, with jumps threaded
+ * through blocks that would only hold a jump. Constants get no register:
+ * integers become immediates and every other constant is loaded from
+ * read-only data where it is used. A comparison whose only use is the
+ * branch right after it sets the flags for that branch directly.
+ *
+ * The registers rax, rcx, rdx, r11, and xmm15 are never allocated, so an
+ * instruction may use them as scratch registers, and division and shifts
+ * find their fixed operands free.
+ *
+ * @author Codezz-ops <codezz-ops@obsidian.cc>
+ *
+ * @copyright Copyright (c) 2024 Obsidian Language
+ * @license BSD 3-Clause
+ */
+
+#include "include/x86.h"
+#include "include/common.h"
+#include "include/regalloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Hardware register numbers; SSE registers follow the general-purpose ones.
+ */
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15, XMM0
+};
+
+#define XMM(n) (XMM0 + (n))
+#define XMM_SCRATCH XMM(15)
+#define GPR_CLASS 0
+#define XMM_CLASS 1
+#define GPR_ALLOCATABLE 10
+#define XMM_ALLOCATABLE 15
+#define INT_ARG_REGISTERS 6
+#define FLOAT_ARG_REGISTERS 8
+#define LIBRARY_FUNCTIONS 5
+
+/** Allocatable general-purpose registers; the first five are caller-saved. */
+static const int gprOrder[GPR_ALLOCATABLE] = { RSI, RDI, R8, R9, R10, RBX, R12, R13, R14, R15 };
+static const int intArgs[INT_ARG_REGISTERS] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+static const char *const gprNames[4][16] = {
+    { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b" },
+    { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di", "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w" },
+    { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" },
+    { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15" }
+};
+
+/**
+ * @enum OperandKind
+ * @brief Enumeration of the places an instruction operand can come from.
+ */
+typedef enum {
+    OPERAND_NONE,
+    OPERAND_REG,        ///< A register.
+    OPERAND_FRAME,      ///< Memory at an offset from %rbp or %rsp.
+    OPERAND_IMM,        ///< An immediate.
+    OPERAND_LABEL,      ///< Memory at a read-only constant.
+    OPERAND_ADDRESS     ///< The address of a read-only constant.
+} OperandKind;
+
+/**
+ * @struct Operand
+ * @brief An instruction operand.
+ */
+typedef struct {
+    OperandKind kind;
+    int reg;
+    int size;           ///< Access size in bytes.
+    int64_t value;      ///< Immediate, frame offset, or constant number.
+} Operand;
+
+/**
+ * @enum PoolKind
+ * @brief Enumeration of read-only constant kinds.
+ */
+typedef enum {
+    POOL_F32, POOL_F64, POOL_STRING, POOL_SIGN32, POOL_SIGN64, POOL_TWO63
+} PoolKind;
+
+/**
+ * @struct PoolEntry
+ * @brief A constant in the module's read-only data.
+ */
+typedef struct {
+    PoolKind kind;
+    uint64_t bits;
+    const char *text;
+} PoolEntry;
+
+/**
+ * @struct Move
+ * @brief One move of a parallel copy.
+ */
+typedef struct {
+    Operand dst, src;
+    int isFloat;
+} Move;
+
+/**
+ * @struct Condition
+ * @brief The flags test that decides a comparison.
+ *
+ * Floating-point equality must also look at the parity flag, which is set
+ * when either operand is NaN.
+ */
+typedef struct {
+    const char *code;   ///< Condition code suffix, as in `j<code>`.
+    int parity;         ///< 0, 1 if true only without parity, 2 if also true with parity.
+} Condition;
+
+/**
+ * @struct Fixup
+ * @brief A 32-bit relative field of the machine code whose target is not placed yet.
+ */
+typedef struct {
+    size_t position;    ///< Offset of the field in the code section.
+    int target;         ///< Block, local label as -1 - label, or function index.
+} Fixup;
+
+/**
+ * @struct PoolReference
+ * @brief A relocation against a read-only constant, whose offset is only known once the pool is laid out.
+ */
+typedef struct {
+    int relocation;
+    int entry;
+} PoolReference;
+
+/**
+ * @struct CodeGen
+ * @brief The state of the code generator.
+ *
+ * When `object` is set, instructions are encoded into it instead of being
+ * written as assembly; the remaining fields are only used then.
+ */
+typedef struct {
+    Writer *out;
+    ObjectFile *object;
+    const IrModule *module;
+    IrFunction *fn;
+    int fnIndex;
+    LiveIntervals live;
+    Allocation allocation;
+    int *target;                ///< Landing block of each block.
+    unsigned char *fused;       ///< Comparisons evaluated by their branch.
+    int saved[GPR_ALLOCATABLE];
+    int savedCount;
+    int frameSize;              ///< Bytes reserved below the saved registers.
+    int labelCount;             ///< Local labels used so far.
+    PoolEntry *pool;
+    int poolCount, poolCapacity;
+    size_t *blockOffsets;       ///< Code offset of each block of the current function.
+    size_t *labelOffsets;       ///< Code offset of each local label.
+    int labelCapacity;
+    Fixup *jumps;               ///< Jumps of the current function.
+    int jumpCount, jumpCapacity;
+    Fixup *calls;               ///< Calls to functions of the module.
+    int callCount, callCapacity;
+    PoolReference *poolReferences;
+    int poolReferenceCount, poolReferenceCapacity;
+    size_t *functionOffsets;
+    int *functionSymbols;       ///< Symbol of each function, or -1 until it has one.
+    int librarySymbols[LIBRARY_FUNCTIONS];  ///< Symbols of the C library functions, in the order of `libraryNames`.
+} CodeGen;
+
+/**
+ * @brief Allocates zeroed memory; running out goes to outOfMemory().
+ */
+static void *allocate(size_t count, size_t size) {
+    void *memory = calloc(count == 0 ? 1 : count, size);
+    if (memory == NULL) outOfMemory(NULL);
+    return memory;
+}
+
+/**
+ * @brief Reports whether a type is held in SSE registers.
+ */
+static int isFloat(TypeKind type) {
+    return type == TypeF32 || type == TypeF64;
+}
+
+/**
+ * @brief Returns the size of a value of a type in registers.
+ *
+ * Integers narrower than 32 bits are kept extended to 32 bits.
+ */
+static int sizeOf(TypeKind type) {
+    return type == TypeI64 || type == TypeU64 || type == TypeString || type == TypeF64 ? 8 : 4;
+}
+
+/**
+ * @brief Maps a type to its register class.
+ */
+static int x86Class(TypeKind type) {
+    return isFloat(type) ? XMM_CLASS : GPR_CLASS;
+}
+
+/**
+ * @brief Reports whether an integer fits a sign-extended 32-bit immediate.
+ */
+static int fitsImmediate(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static Operand makeOperand(OperandKind kind, int reg, int size, int64_t value) {
+    Operand op;
+    op.kind = kind;
+    op.reg = reg;
+    op.size = size;
+    op.value = value;
+    return op;
+}
+
+static Operand reg(int r, int size) {
+    return makeOperand(OPERAND_REG, r, size, 0);
+}
+
+static Operand imm(int64_t value, int size) {
+    return makeOperand(OPERAND_IMM, 0, size, value);
+}
+
+static Operand resized(Operand op, int size) {
+    op.size = size;
+    return op;
+}
+
+static int isReg(Operand op) {
+    return op.kind == OPERAND_REG;
+}
+
+/**
+ * @brief Reports whether two operands name the same register or stack slot.
+ */
+static int sameLocation(Operand a, Operand b) {
+    if (a.kind != b.kind || a.reg != b.reg) return 0;
+    return a.kind == OPERAND_REG || (a.kind == OPERAND_FRAME && a.value == b.value);
+}
+
+/**
+ * @brief Adds a constant to the read-only data, reusing an identical one.
+ */
+static int addPoolEntry(CodeGen *cg, PoolKind kind, uint64_t bits, const char *text) {
+    for (int i = 0; i < cg->poolCount; i++) {
+        const PoolEntry *entry = &cg->pool[i];
+        if (entry->kind != kind || entry->bits != bits) continue;
+        if (kind != POOL_STRING || strcmp(entry->text, text) == 0) return i;
+    }
+    if (cg->poolCount == cg->poolCapacity) {
+        int capacity = cg->poolCapacity ? cg->poolCapacity * 2 : 64;
+        PoolEntry *pool = realloc(cg->pool, (size_t)capacity * sizeof(PoolEntry));
+        if (pool == NULL) outOfMemory(NULL);
+        cg->pool = pool;
+        cg->poolCapacity = capacity;
+    }
+    cg->pool[cg->poolCount].kind = kind;
+    cg->pool[cg->poolCount].bits = bits;
+    cg->pool[cg->poolCount].text = text;
+    return cg->poolCount++;
+}
+
+/**
+ * @brief Returns the operand that reads a constant in place.
+ */
+static Operand constantOperand(CodeGen *cg, Slot constant, TypeKind type) {
+    switch (type) {
+        case TypeString:
+            return makeOperand(OPERAND_ADDRESS, 0, 8, addPoolEntry(cg, POOL_STRING, 0, constant.str));
+        case TypeF32:
+            return makeOperand(OPERAND_LABEL, 0, 4, addPoolEntry(cg, POOL_F32, constant.u32, NULL));
+        case TypeF64:
+            return makeOperand(OPERAND_LABEL, 0, 8, addPoolEntry(cg, POOL_F64, constant.u64, NULL));
+        case TypeI64: case TypeU64:
+            return imm(constant.i64, 8);
+        default:
+            return imm(constant.i32, 4);
+    }
+}
+
+/**
+ * @brief Returns the operand that holds a value.
+ */
+static Operand valueOperand(CodeGen *cg, int value) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    int location = cg->allocation.location[value];
+    int size = sizeOf(insn->type);
+
+    if (location >= 0) return reg(isFloat(insn->type) ? XMM(location) : gprOrder[location], size);
+    if (IS_SPILLED(location)) {
+        return makeOperand(OPERAND_FRAME, RBP, size, -8 * (int64_t)(cg->savedCount + SPILL_SLOT(location) + 1));
+    }
+    if (insn->op == IR_CONST) return constantOperand(cg, insn->as.constant, insn->type);
+    return makeOperand(OPERAND_NONE, 0, size, 0);
+}
+
+/**
+ * @brief Returns the operand of an instruction's `index`-th operand.
+ */
+static Operand argOperand(CodeGen *cg, int value, int index) {
+    return valueOperand(cg, cg->fn->operands[cg->fn->insns[value].argStart + index]);
+}
+
+static void writeOperand(CodeGen *cg, Operand op) {
+    Writer *out = cg->out;
+
+    switch (op.kind) {
+        case OPERAND_REG:
+            writeChar(out, '%');
+            if (op.reg >= XMM0) {
+                writeString(out, "xmm");
+                writeInt(out, op.reg - XMM0);
+            } else {
+                writeString(out, gprNames[op.size == 1 ? 0 : op.size == 2 ? 1 : op.size == 4 ? 2 : 3][op.reg]);
+            }
+            break;
+        case OPERAND_FRAME:
+            writeInt(out, op.value);
+            writeString(out, "(%");
+            writeString(out, gprNames[3][op.reg]);
+            writeChar(out, ')');
+            break;
+        case OPERAND_IMM:
+            writeChar(out, '$');
+            writeInt(out, op.value);
+            break;
+        case OPERAND_LABEL: case OPERAND_ADDRESS:
+            writeString(out, ".LC");
+            writeInt(out, op.value);
+            writeString(out, "(%rip)");
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @enum EncodingForm
+ * @brief Enumeration of the operand layouts of the instructions the code generator uses.
+ */
+typedef enum {
+    FORM_ALU,           ///< Arithmetic group: opcode extension in `extension`.
+    FORM_TEST,
+    FORM_MOV,
+    FORM_MOVABS,
+    FORM_UNARY,         ///< The F7 group: opcode extension in `extension`.
+    FORM_SHIFT,         ///< The D1/C1/D3 group: opcode extension in `extension`.
+    FORM_IMUL,
+    FORM_EXTEND,        ///< 0F `opcode` /r from a narrower source.
+    FORM_LOAD,          ///< `opcode` /r with a 64-bit destination.
+    FORM_PUSH,
+    FORM_POP,
+    FORM_FIXED,         ///< `opcode` alone, with REX bits in `extension`.
+    FORM_SSE,           ///< `prefix` 0F `opcode` /r, with REX bits in `extension`.
+    FORM_SSE_MOVE,      ///< Like FORM_SSE, but opcode + 1 stores to memory.
+    FORM_SSE_TRUNCATE,  ///< Like FORM_SSE, with REX.W for a 64-bit destination.
+    FORM_BTC
+} EncodingForm;
+
+/**
+ * @struct Encoding
+ * @brief How one mnemonic is encoded.
+ */
+typedef struct {
+    const char *mnemonic;
+    EncodingForm form;
+    unsigned char prefix;
+    unsigned char opcode;
+    unsigned char extension;
+} Encoding;
+
+#define REX_W 0x08
+#define REX_FORCE 0x40
+
+/** Every mnemonic the code generator emits, sorted for bsearch(); `set<cc>` and `cmov<cc>` are handled apart. */
+static const Encoding encodings[] = {
+    { "add", FORM_ALU, 0, 0, 0 },
+    { "addsd", FORM_SSE, 0xF2, 0x58, 0 },
+    { "addss", FORM_SSE, 0xF3, 0x58, 0 },
+    { "and", FORM_ALU, 0, 0, 4 },
+    { "btc", FORM_BTC, 0, 0xBA, 7 },
+    { "cltd", FORM_FIXED, 0, 0x99, 0 },
+    { "cmp", FORM_ALU, 0, 0, 7 },
+    { "cqto", FORM_FIXED, 0, 0x99, REX_W },
+    { "cvtsd2ss", FORM_SSE, 0xF2, 0x5A, 0 },
+    { "cvtsi2sdl", FORM_SSE, 0xF2, 0x2A, 0 },
+    { "cvtsi2sdq", FORM_SSE, 0xF2, 0x2A, REX_W },
+    { "cvtsi2ssl", FORM_SSE, 0xF3, 0x2A, 0 },
+    { "cvtsi2ssq", FORM_SSE, 0xF3, 0x2A, REX_W },
+    { "cvtss2sd", FORM_SSE, 0xF3, 0x5A, 0 },
+    { "cvttsd2si", FORM_SSE_TRUNCATE, 0xF2, 0x2C, 0 },
+    { "cvttss2si", FORM_SSE_TRUNCATE, 0xF3, 0x2C, 0 },
+    { "div", FORM_UNARY, 0, 0xF7, 6 },
+    { "divsd", FORM_SSE, 0xF2, 0x5E, 0 },
+    { "divss", FORM_SSE, 0xF3, 0x5E, 0 },
+    { "idiv", FORM_UNARY, 0, 0xF7, 7 },
+    { "imul", FORM_IMUL, 0, 0xAF, 0 },
+    { "lea", FORM_LOAD, 0, 0x8D, 0 },
+    { "leave", FORM_FIXED, 0, 0xC9, 0 },
+    { "mov", FORM_MOV, 0, 0, 0 },
+    { "movabs", FORM_MOVABS, 0, 0xB8, 0 },
+    { "movaps", FORM_SSE, 0, 0x28, 0 },
+    { "movsbl", FORM_EXTEND, 0, 0xBE, 0 },
+    { "movsd", FORM_SSE_MOVE, 0xF2, 0x10, 0 },
+    { "movslq", FORM_LOAD, 0, 0x63, 0 },
+    { "movss", FORM_SSE_MOVE, 0xF3, 0x10, 0 },
+    { "movswl", FORM_EXTEND, 0, 0xBF, 0 },
+    { "movzbl", FORM_EXTEND, 0, 0xB6, 0 },
+    { "movzwl", FORM_EXTEND, 0, 0xB7, 0 },
+    { "mulsd", FORM_SSE, 0xF2, 0x59, 0 },
+    { "mulss", FORM_SSE, 0xF3, 0x59, 0 },
+    { "neg", FORM_UNARY, 0, 0xF7, 3 },
+    { "not", FORM_UNARY, 0, 0xF7, 2 },
+    { "or", FORM_ALU, 0, 0, 1 },
+    { "pop", FORM_POP, 0, 0x58, 0 },
+    { "push", FORM_PUSH, 0, 0x50, 0 },
+    { "ret", FORM_FIXED, 0, 0xC3, 0 },
+    { "sar", FORM_SHIFT, 0, 0, 7 },
+    { "shl", FORM_SHIFT, 0, 0, 4 },
+    { "shr", FORM_SHIFT, 0, 0, 5 },
+    { "sub", FORM_ALU, 0, 0, 5 },
+    { "subsd", FORM_SSE, 0xF2, 0x5C, 0 },
+    { "subss", FORM_SSE, 0xF3, 0x5C, 0 },
+    { "test", FORM_TEST, 0, 0x85, 0 },
+    { "ucomisd", FORM_SSE, 0x66, 0x2E, 0 },
+    { "ucomiss", FORM_SSE, 0, 0x2E, 0 },
+    { "xor", FORM_ALU, 0, 0, 6 },
+    { "xorps", FORM_SSE, 0, 0x57, 0 }
+};
+
+/** Condition code suffixes, indexed by their encoding. */
+static const char *const conditionCodes[16] = {
+    "o", "no", "b", "ae", "e", "ne", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g"
+};
+
+/** The C library functions the generated code calls. */
+static const char *const libraryNames[LIBRARY_FUNCTIONS] = { "printf", "puts", "putchar", "fmod", "fmodf" };
+
+/**
+ * @brief Grows an array so it holds at least `needed` elements; running out goes to outOfMemory().
+ */
+static void *reserve(void *array, int *capacity, int needed, size_t size) {
+    int grown = *capacity ? *capacity : 16;
+
+    if (needed <= *capacity) return array;
+    while (grown < needed) grown *= 2;
+    array = realloc(array, (size_t)grown * size);
+    if (array == NULL) outOfMemory(NULL);
+    *capacity = grown;
+    return array;
+}
+
+static int compareEncodings(const void *key, const void *element) {
+    return strcmp(key, ((const Encoding *)element)->mnemonic);
+}
+
+/**
+ * @brief Returns the encoding of a condition code suffix.
+ */
+static unsigned char conditionCode(const char *code) {
+    for (unsigned char i = 0; i < 16; i++) {
+        if (strcmp(conditionCodes[i], code) == 0) return i;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the number of a register within its file.
+ */
+static int registerNumber(Operand op) {
+    return op.reg >= XMM0 ? op.reg - XMM0 : op.reg;
+}
+
+/**
+ * @brief Reports whether an operand is spl, bpl, sil, or dil, which exist only with a REX prefix.
+ */
+static int needsByteRex(Operand op) {
+    return op.kind == OPERAND_REG && op.size == 1 && op.reg >= RSP && op.reg <= RDI;
+}
+
+/**
+ * @brief Returns the current offset in the code section.
+ */
+static size_t codeOffset(CodeGen *cg) {
+    return cg->object->sections[OBJECT_TEXT].size;
+}
+
+/**
+ * @brief Overwrites a 32-bit field of the code.
+ */
+static void patch32(CodeGen *cg, size_t position, int64_t value) {
+    unsigned char *field = cg->object->sections[OBJECT_TEXT].data + position;
+    for (int i = 0; i < 4; i++) field[i] = (unsigned char)((uint64_t)value >> (8 * i));
+}
+
+/**
+ * @brief Appends instruction bytes and an immediate of 0, 1, 2, 4, or 8 bytes.
+ */
+static void appendCode(CodeGen *cg, unsigned char *code, int length, int immediateSize, int64_t immediate) {
+    for (int i = 0; i < immediateSize; i++) code[length++] = (unsigned char)((uint64_t)immediate >> (8 * i));
+    appendObjectBytes(&cg->object->sections[OBJECT_TEXT], code, (size_t)length);
+}
+
+/**
+ * @brief Encodes an instruction with a ModRM byte.
+ *
+ * `field` goes in the reg field of the ModRM byte, either a register or an
+ * opcode extension, and `rm` is the register or memory operand. A read-only
+ * constant becomes a RIP-relative displacement with a relocation against
+ * the data section, completed once the pool is laid out.
+ */
+static void encodeModRM(CodeGen *cg, unsigned char prefix, int rex, const unsigned char *opcode, int opcodeLength,
+                        int field, Operand rm, int immediateSize, int64_t immediate) {
+    unsigned char code[24];
+    int length = 0, displacement = -1;
+    int base = rm.kind == OPERAND_REG ? registerNumber(rm) : rm.reg;
+
+    if (prefix) code[length++] = prefix;
+    if (field & 8) rex |= 0x04;
+    if ((rm.kind == OPERAND_REG || rm.kind == OPERAND_FRAME) && (base & 8)) rex |= 0x01;
+    if (rex) code[length++] = (unsigned char)(REX_FORCE | rex);
+    memcpy(code + length, opcode, (size_t)opcodeLength);
+    length += opcodeLength;
+
+    switch (rm.kind) {
+        case OPERAND_REG:
+            code[length++] = (unsigned char)(0xC0 | (field & 7) << 3 | (base & 7));
+            break;
+        case OPERAND_FRAME: {
+            /* %rbp as a base always takes a displacement and %rsp always a SIB byte. */
+            int bytes = rm.value == 0 && base != RBP ? 0 : rm.value >= INT8_MIN && rm.value <= INT8_MAX ? 1 : 4;
+            code[length++] = (unsigned char)((bytes == 0 ? 0x00 : bytes == 1 ? 0x40 : 0x80) | (field & 7) << 3 | (base & 7));
+            if ((base & 7) == RSP) code[length++] = 0x24;
+            for (int i = 0; i < bytes; i++) code[length++] = (unsigned char)((uint64_t)rm.value >> (8 * i));
+            break;
+        }
+        default:
+            code[length++] = (unsigned char)(0x05 | (field & 7) << 3);
+            displacement = length;
+            memset(code + length, 0, 4);
+            length += 4;
+            break;
+    }
+
+    if (displacement >= 0) {
+        ObjectFile *object = cg->object;
+        int relocation = addObjectRelocation(object, codeOffset(cg) + (size_t)displacement,
+                                             OBJECT_SECTION_SYMBOL(OBJECT_RODATA), R_X86_64_PC32,
+                                             -(int64_t)(length + immediateSize - displacement));
+        cg->poolReferences = reserve(cg->poolReferences, &cg->poolReferenceCapacity, cg->poolReferenceCount + 1,
+                                     sizeof(PoolReference));
+        cg->poolReferences[cg->poolReferenceCount].relocation = relocation;
+        cg->poolReferences[cg->poolReferenceCount].entry = (int)rm.value;
+        cg->poolReferenceCount++;
+    }
+    appendCode(cg, code, length, immediateSize, immediate);
+}
+
+/**
+ * @brief Encodes an instruction whose opcode carries the register, as in push or mov $imm.
+ */
+static void encodeShort(CodeGen *cg, unsigned char prefix, int rex, unsigned char opcode, int r, int immediateSize,
+                        int64_t immediate) {
+    unsigned char code[16];
+    int length = 0;
+
+    if (prefix) code[length++] = prefix;
+    if (r & 8) rex |= 0x01;
+    if (rex) code[length++] = (unsigned char)(REX_FORCE | rex);
+    code[length++] = (unsigned char)(opcode + (r & 7));
+    appendCode(cg, code, length, immediateSize, immediate);
+}
+
+/**
+ * @brief Encodes one instruction into the code section.
+ *
+ * The arguments are those of the assembly: an AT&T mnemonic, the size its
+ * suffix names, or 0 for none, and the source and destination. An
+ * instruction with one operand passes it as `dst`.
+ */
+static void encodeInstruction(CodeGen *cg, const char *mnemonic, int size, Operand src, Operand dst) {
+    const Encoding *encoding;
+    unsigned char prefix = size == 2 ? 0x66 : 0;
+    int wide = size == 8 ? REX_W : 0;
+    int rex = wide | (size == 1 && (needsByteRex(src) || needsByteRex(dst)) ? REX_FORCE : 0);
+    unsigned char opcode[2];
+
+    if (strncmp(mnemonic, "set", 3) == 0) {
+        opcode[0] = 0x0F;
+        opcode[1] = (unsigned char)(0x90 + conditionCode(mnemonic + 3));
+        encodeModRM(cg, 0, needsByteRex(dst) ? REX_FORCE : 0, opcode, 2, 0, dst, 0, 0);
+        return;
+    }
+    if (strncmp(mnemonic, "cmov", 4) == 0) {
+        opcode[0] = 0x0F;
+        opcode[1] = (unsigned char)(0x40 + conditionCode(mnemonic + 4));
+        encodeModRM(cg, 0, dst.size == 8 ? REX_W : 0, opcode, 2, registerNumber(dst), src, 0, 0);
+        return;
+    }
+
+    encoding = bsearch(mnemonic, encodings, sizeof(encodings) / sizeof(encodings[0]), sizeof(Encoding), compareEncodings);
+    if (encoding == NULL) {
+        fprintf(stderr, "obsidian: internal error: no encoding for '%s'\n", mnemonic);
+        exit(EXIT_FAILURE);
+    }
+
+    switch (encoding->form) {
+        case FORM_ALU:
+            if (src.kind == OPERAND_IMM) {
+                int small = size == 1 || (src.value >= INT8_MIN && src.value <= INT8_MAX);
+                opcode[0] = size == 1 ? 0x80 : small ? 0x83 : 0x81;
+                encodeModRM(cg, prefix, rex, opcode, 1, encoding->extension, dst, small ? 1 : size == 2 ? 2 : 4, src.value);
+            } else if (isReg(src)) {
+                opcode[0] = (unsigned char)(encoding->extension * 8 + (size == 1 ? 0 : 1));
+                encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(src), dst, 0, 0);
+            } else {
+                opcode[0] = (unsigned char)(encoding->extension * 8 + (size == 1 ? 2 : 3));
+                encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(dst), src, 0, 0);
+            }
+            break;
+
+        case FORM_TEST:
+            opcode[0] = size == 1 ? 0x84 : 0x85;
+            encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(src), dst, 0, 0);
+            break;
+
+        case FORM_MOV:
+            if (src.kind == OPERAND_IMM && isReg(dst) && size != 8) {
+                encodeShort(cg, prefix, rex, size == 1 ? 0xB0 : 0xB8, dst.reg, size, src.value);
+            } else if (src.kind == OPERAND_IMM) {
+                opcode[0] = size == 1 ? 0xC6 : 0xC7;
+                encodeModRM(cg, prefix, rex, opcode, 1, 0, dst, size == 8 ? 4 : size, src.value);
+            } else if (isReg(src)) {
+                opcode[0] = size == 1 ? 0x88 : 0x89;
+                encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(src), dst, 0, 0);
+            } else {
+                opcode[0] = size == 1 ? 0x8A : 0x8B;
+                encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(dst), src, 0, 0);
+            }
+            break;
+
+        case FORM_MOVABS:
+            encodeShort(cg, 0, REX_W, encoding->opcode, dst.reg, 8, src.value);
+            break;
+
+        case FORM_UNARY:
+            opcode[0] = size == 1 ? 0xF6 : 0xF7;
+            encodeModRM(cg, prefix, rex, opcode, 1, encoding->extension, dst, 0, 0);
+            break;
+
+        case FORM_SHIFT:
+            if (src.kind == OPERAND_IMM && src.value != 1) {
+                opcode[0] = size == 1 ? 0xC0 : 0xC1;
+                encodeModRM(cg, prefix, rex, opcode, 1, encoding->extension, dst, 1, src.value);
+            } else {
+                opcode[0] = (unsigned char)((isReg(src) ? 0xD2 : 0xD0) + (size == 1 ? 0 : 1));
+                encodeModRM(cg, prefix, rex, opcode, 1, encoding->extension, dst, 0, 0);
+            }
+            break;
+
+        case FORM_IMUL:
+            if (src.kind == OPERAND_IMM) {
+                int small = src.value >= INT8_MIN && src.value <= INT8_MAX;
+                opcode[0] = small ? 0x6B : 0x69;
+                encodeModRM(cg, prefix, rex, opcode, 1, registerNumber(dst), dst, small ? 1 : size == 2 ? 2 : 4, src.value);
+            } else {
+                opcode[0] = 0x0F;
+                opcode[1] = encoding->opcode;
+                encodeModRM(cg, prefix, rex, opcode, 2, registerNumber(dst), src, 0, 0);
+            }
+            break;
+
+        case FORM_EXTEND:
+            opcode[0] = 0x0F;
+            opcode[1] = encoding->opcode;
+            encodeModRM(cg, 0, (dst.size == 8 ? REX_W : 0) | (needsByteRex(src) ? REX_FORCE : 0), opcode, 2,
+                        registerNumber(dst), src, 0, 0);
+            break;
+
+        case FORM_LOAD:
+            encodeModRM(cg, 0, REX_W, &encoding->opcode, 1, registerNumber(dst), src, 0, 0);
+            break;
+
+        case FORM_PUSH:
+            if (isReg(dst)) {
+                encodeShort(cg, 0, 0, encoding->opcode, dst.reg, 0, 0);
+            } else if (dst.kind == OPERAND_IMM) {
+                int small = dst.value >= INT8_MIN && dst.value <= INT8_MAX;
+                opcode[0] = small ? 0x6A : 0x68;
+                appendCode(cg, opcode, 1, small ? 1 : 4, dst.value);
+            } else {
+                opcode[0] = 0xFF;
+                encodeModRM(cg, 0, 0, opcode, 1, 6, dst, 0, 0);
+            }
+            break;
+
+        case FORM_POP:
+            encodeShort(cg, 0, 0, encoding->opcode, dst.reg, 0, 0);
+            break;
+
+        case FORM_FIXED: {
+            unsigned char code[2];
+            int length = 0;
+            if (encoding->extension) code[length++] = (unsigned char)(REX_FORCE | encoding->extension);
+            code[length++] = encoding->opcode;
+            appendCode(cg, code, length, 0, 0);
+            break;
+        }
+
+        case FORM_SSE: case FORM_SSE_MOVE: case FORM_SSE_TRUNCATE: {
+            int store = encoding->form == FORM_SSE_MOVE && !isReg(dst);
+            rex = encoding->form == FORM_SSE_TRUNCATE ? (dst.size == 8 ? REX_W : 0) : encoding->extension;
+            opcode[0] = 0x0F;
+            opcode[1] = (unsigned char)(encoding->opcode + store);
+            if (store) encodeModRM(cg, encoding->prefix, rex, opcode, 2, registerNumber(src), dst, 0, 0);
+            else encodeModRM(cg, encoding->prefix, rex, opcode, 2, registerNumber(dst), src, 0, 0);
+            break;
+        }
+
+        case FORM_BTC:
+            opcode[0] = 0x0F;
+            opcode[1] = encoding->opcode;
+            encodeModRM(cg, 0, wide, opcode, 2, encoding->extension, dst, 1, src.value);
+            break;
+    }
+}
+
+/**
+ * @brief Encodes a jump with a 32-bit displacement, to be resolved at the end of the function.
+ *
+ * @param code The condition code, or "mp" for an unconditional jump.
+ * @param target A block, or -1 - label for a local label.
+ */
+static void encodeJump(CodeGen *cg, const char *code, int target) {
+    unsigned char bytes[6];
+    int length = 0;
+
+    if (strcmp(code, "mp") == 0) {
+        bytes[length++] = 0xE9;
+    } else {
+        bytes[length++] = 0x0F;
+        bytes[length++] = (unsigned char)(0x80 + conditionCode(code));
+    }
+    memset(bytes + length, 0, 4);
+    appendCode(cg, bytes, length + 4, 0, 0);
+    cg->jumps = reserve(cg->jumps, &cg->jumpCapacity, cg->jumpCount + 1, sizeof(Fixup));
+    cg->jumps[cg->jumpCount].position = codeOffset(cg) - 4;
+    cg->jumps[cg->jumpCount].target = target;
+    cg->jumpCount++;
+}
+
+/**
+ * @brief Encodes a call and returns the offset of its displacement.
+ */
+static size_t encodeCall(CodeGen *cg) {
+    unsigned char bytes[5] = { 0xE8, 0, 0, 0, 0 };
+    appendCode(cg, bytes, 5, 0, 0);
+    return codeOffset(cg) - 4;
+}
+
+/**
+ * @brief Returns the symbol name of a function; the caller frees it.
+ */
+static char *functionSymbolName(const IrFunction *fn) {
+    size_t length = strlen(fn->name);
+    char *name = allocate(length + 4, 1);
+    memcpy(name, fn->name, length);
+    if (!fn->exported && strcmp(fn->name, "main") != 0) memcpy(name + length, ".ob", 4);
+    return name;
+}
+
+/**
+ * @brief Writes a mnemonic with the AT&T suffix of an operand size; size 0 adds none.
+ */
+static void writeMnemonic(CodeGen *cg, const char *mnemonic, int size) {
+    writeChar(cg->out, '\t');
+    writeString(cg->out, mnemonic);
+    if (size > 0) writeChar(cg->out, size == 1 ? 'b' : size == 2 ? 'w' : size == 4 ? 'l' : 'q');
+}
+
+static void insn0(CodeGen *cg, const char *mnemonic) {
+    if (cg->object != NULL) {
+        encodeInstruction(cg, mnemonic, 0, makeOperand(OPERAND_NONE, 0, 0, 0), makeOperand(OPERAND_NONE, 0, 0, 0));
+        return;
+    }
+    writeMnemonic(cg, mnemonic, 0);
+    writeChar(cg->out, '\n');
+}
+
+static void insn1(CodeGen *cg, const char *mnemonic, int size, Operand a) {
+    if (cg->object != NULL) {
+        encodeInstruction(cg, mnemonic, size, makeOperand(OPERAND_NONE, 0, 0, 0), a);
+        return;
+    }
+    writeMnemonic(cg, mnemonic, size);
+    writeChar(cg->out, '\t');
+    writeOperand(cg, a);
+    writeChar(cg->out, '\n');
+}
+
+static void insn2(CodeGen *cg, const char *mnemonic, int size, Operand src, Operand dst) {
+    if (cg->object != NULL) {
+        encodeInstruction(cg, mnemonic, size, src, dst);
+        return;
+    }
+    writeMnemonic(cg, mnemonic, size);
+    writeChar(cg->out, '\t');
+    writeOperand(cg, src);
+    writeString(cg->out, ", ");
+    writeOperand(cg, dst);
+    writeChar(cg->out, '\n');
+}
+
+/**
+ * @brief Writes the label of a block.
+ */
+static void writeBlockLabel(CodeGen *cg, int block) {
+    writeString(cg->out, ".LBB");
+    writeInt(cg->out, cg->fnIndex);
+    writeChar(cg->out, '_');
+    writeInt(cg->out, block);
+}
+
+/**
+ * @brief Writes the symbol of a function.
+ */
+static void writeSymbol(CodeGen *cg, int index) {
+    const IrFunction *fn = &cg->module->functions[index];
+    writeString(cg->out, fn->name);
+    if (!fn->exported && strcmp(fn->name, "main") != 0) writeString(cg->out, ".ob");
+}
+
+/**
+ * @brief Emits a jump or conditional jump to a block.
+ */
+static void jumpTo(CodeGen *cg, const char *code, int block) {
+    if (cg->object != NULL) {
+        encodeJump(cg, code, block);
+        return;
+    }
+    writeChar(cg->out, '\t');
+    writeChar(cg->out, 'j');
+    writeString(cg->out, code);
+    writeChar(cg->out, '\t');
+    writeBlockLabel(cg, block);
+    writeChar(cg->out, '\n');
+}
+
+/**
+ * @brief Emits a jump or conditional jump to a local label.
+ */
+static void jumpToLocal(CodeGen *cg, const char *code, int label) {
+    if (cg->object != NULL) {
+        encodeJump(cg, code, -1 - label);
+        return;
+    }
+    writeChar(cg->out, '\t');
+    writeChar(cg->out, 'j');
+    writeString(cg->out, code);
+    writeString(cg->out, "\t.LX");
+    writeInt(cg->out, label);
+    writeChar(cg->out, '\n');
+}
+
+/**
+ * @brief Places a local label.
+ */
+static void placeLocal(CodeGen *cg, int label) {
+    if (cg->object != NULL) {
+        cg->labelOffsets = reserve(cg->labelOffsets, &cg->labelCapacity, label + 1, sizeof(size_t));
+        cg->labelOffsets[label] = codeOffset(cg);
+        return;
+    }
+    writeString(cg->out, ".LX");
+    writeInt(cg->out, label);
+    writeString(cg->out, ":\n");
+}
+
+/**
+ * @brief Emits a call to a C library function.
+ */
+static void callLibrary(CodeGen *cg, const char *name) {
+    if (cg->object != NULL) {
+        size_t position = encodeCall(cg);
+        int library = 0;
+        while (strcmp(libraryNames[library], name) != 0) library++;
+        if (cg->librarySymbols[library] < 0) {
+            cg->librarySymbols[library] = addObjectSymbol(cg->object, name, OBJECT_UNDEFINED, 0, 0, 1);
+        }
+        addObjectRelocation(cg->object, position, cg->librarySymbols[library], R_X86_64_PLT32, -4);
+        return;
+    }
+    writeString(cg->out, "\tcall\t");
+    writeString(cg->out, name);
+    writeString(cg->out, "@PLT\n");
+}
+
+/**
+ * @brief Copies `src` to `dst`, going through a scratch register when both are in memory.
+ */
+static void emitMove(CodeGen *cg, Operand dst, Operand src, int floating) {
+    if (src.kind == OPERAND_NONE || dst.kind == OPERAND_NONE || sameLocation(dst, src)) return;
+
+    if (floating) {
+        const char *load = dst.size == 4 ? "movss" : "movsd";
+        if (isReg(dst)) {
+            insn2(cg, isReg(src) ? "movaps" : load, 0, src, dst);
+        } else if (isReg(src)) {
+            insn2(cg, load, 0, src, dst);
+        } else {
+            insn2(cg, "mov", dst.size, src, reg(RAX, dst.size));
+            insn2(cg, "mov", dst.size, reg(RAX, dst.size), dst);
+        }
+        return;
+    }
+
+    if (src.kind == OPERAND_ADDRESS) {
+        Operand target = isReg(dst) ? resized(dst, 8) : reg(RAX, 8);
+        insn2(cg, "lea", 8, makeOperand(OPERAND_LABEL, 0, 8, src.value), target);
+        if (!isReg(dst)) insn2(cg, "mov", 8, target, dst);
+        return;
+    }
+
+    if (src.kind == OPERAND_IMM) {
+        int64_t value = dst.size == 4 ? (int32_t)src.value : src.value;
+        if (isReg(dst) && value == 0) {
+            insn2(cg, "xor", 4, resized(dst, 4), resized(dst, 4));
+        } else if (isReg(dst) && dst.size == 8 && value >= 0 && value <= (int64_t)UINT32_MAX) {
+            insn2(cg, "mov", 4, imm(value, 4), resized(dst, 4));
+        } else if (dst.size == 8 && !fitsImmediate(value)) {
+            Operand target = isReg(dst) ? dst : reg(RAX, 8);
+            insn2(cg, "movabs", 8, imm(value, 8), target);
+            if (!isReg(dst)) insn2(cg, "mov", 8, target, dst);
+        } else {
+            insn2(cg, "mov", dst.size, imm(value, dst.size), dst);
+        }
+        return;
+    }
+
+    if (isReg(dst) || isReg(src)) {
+        insn2(cg, "mov", dst.size, resized(src, dst.size), dst);
+    } else {
+        insn2(cg, "mov", dst.size, resized(src, dst.size), reg(RAX, dst.size));
+        insn2(cg, "mov", dst.size, reg(RAX, dst.size), dst);
+    }
+}
+
+/**
+ * @brief Reports whether a move reads a register or stack slot.
+ */
+static int readsLocation(const Move *move, Operand location) {
+    return (move->src.kind == OPERAND_REG || move->src.kind == OPERAND_FRAME) && sameLocation(move->src, location);
+}
+
+/**
+ * @brief Emits a set of moves that take place simultaneously.
+ *
+ * Moves are ordered so no location is overwritten while a later move still
+ * reads it; a cycle is broken by parking one location in a scratch register.
+ */
+static void emitParallelMoves(CodeGen *cg, Move *moves, int count) {
+    for (int i = 0; i < count; i++) {
+        if (moves[i].src.kind == OPERAND_NONE || moves[i].dst.kind == OPERAND_NONE || sameLocation(moves[i].dst, moves[i].src)) {
+            moves[i--] = moves[--count];
+        }
+    }
+
+    while (count > 0) {
+        int ready = -1;
+        for (int i = 0; i < count && ready < 0; i++) {
+            int blocked = 0;
+            for (int j = 0; j < count && !blocked; j++) {
+                blocked = j != i && readsLocation(&moves[j], moves[i].dst);
+            }
+            if (!blocked) ready = i;
+        }
+
+        if (ready < 0) {
+            Operand held = moves[0].dst;
+            int floating = 0;
+            Operand scratch;
+            for (int j = 0; j < count; j++) {
+                if (readsLocation(&moves[j], held)) floating = moves[j].isFloat;
+            }
+            scratch = reg(floating ? XMM_SCRATCH : R11, 8);
+            emitMove(cg, scratch, resized(held, 8), floating);
+            for (int j = 0; j < count; j++) {
+                if (readsLocation(&moves[j], held)) moves[j].src = resized(scratch, moves[j].src.size);
+            }
+            ready = 0;
+        }
+        emitMove(cg, moves[ready].dst, moves[ready].src, moves[ready].isFloat);
+        moves[ready] = moves[--count];
+    }
+}
+
+/**
+ * @brief Emits the moves that give the phis of `target` their values from `block`.
+ */
+static void emitPhiMoves(CodeGen *cg, int block, int target) {
+    const IrFunction *fn = cg->fn;
+    const IrBlock *b = &fn->blocks[target];
+    Move *moves = allocate((size_t)b->insnCount, sizeof(Move));
+    int index = -1, count = 0;
+
+    for (int p = 0; p < b->predCount; p++) {
+        if (b->preds[p] == block) index = p;
+    }
+    for (int i = 0; index >= 0 && i < b->insnCount; i++) {
+        int phi = b->insns[i];
+        if (fn->insns[phi].op != IR_PHI) break;
+        if (index >= fn->insns[phi].argCount) continue;
+        moves[count].dst = valueOperand(cg, phi);
+        moves[count].src = argOperand(cg, phi, index);
+        moves[count].isFloat = isFloat(fn->insns[phi].type);
+        count++;
+    }
+    emitParallelMoves(cg, moves, count);
+    free(moves);
+}
+
+/**
+ * @brief Re-normalizes a register after arithmetic on an 8- or 16-bit type.
+ */
+static void emitNarrow(CodeGen *cg, Operand r, TypeKind type) {
+    switch (type) {
+        case TypeI8: insn2(cg, "movsbl", 0, resized(r, 1), resized(r, 4)); break;
+        case TypeI16: insn2(cg, "movswl", 0, resized(r, 2), resized(r, 4)); break;
+        case TypeU8: case TypeChar: insn2(cg, "movzbl", 0, resized(r, 1), resized(r, 4)); break;
+        case TypeU16: insn2(cg, "movzwl", 0, resized(r, 2), resized(r, 4)); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Returns the register a result is computed in: its own if it has one, else a scratch.
+ */
+static Operand resultRegister(Operand dst, int scratch) {
+    return isReg(dst) ? dst : reg(scratch, dst.size);
+}
+
+/**
+ * @brief Emits integer addition, subtraction, multiplication, and bitwise operations.
+ */
+static void emitIntBinary(CodeGen *cg, int value, const char *mnemonic, int commutative) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    Operand dst = valueOperand(cg, value);
+    Operand a = argOperand(cg, value, 0), b = argOperand(cg, value, 1);
+    Operand t;
+
+    if (commutative && (sameLocation(b, dst) || (a.kind == OPERAND_IMM && b.kind != OPERAND_IMM))) {
+        Operand swap = a;
+        a = b;
+        b = swap;
+    }
+    t = isReg(dst) && !sameLocation(b, dst) ? dst : reg(RAX, dst.size);
+    emitMove(cg, t, a, 0);
+    insn2(cg, mnemonic, dst.size, b, t);
+    emitNarrow(cg, t, insn->type);
+    emitMove(cg, dst, t, 0);
+}
+
+/**
+ * @brief Emits integer division or remainder.
+ */
+static void emitIntDivide(CodeGen *cg, int value) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    Operand dst = valueOperand(cg, value);
+    Operand b = argOperand(cg, value, 1);
+    Operand result = reg(insn->op == IR_DIV ? RAX : RDX, dst.size);
+    int isSigned = isSignedType(insn->type);
+
+    emitMove(cg, reg(RAX, dst.size), argOperand(cg, value, 0), 0);
+    if (b.kind == OPERAND_IMM) {
+        emitMove(cg, reg(RCX, dst.size), b, 0);
+        b = reg(RCX, dst.size);
+    }
+    if (isSigned) insn0(cg, dst.size == 8 ? "cqto" : "cltd");
+    else insn2(cg, "xor", 4, reg(RDX, 4), reg(RDX, 4));
+    insn1(cg, isSigned ? "idiv" : "div", dst.size, b);
+    emitNarrow(cg, result, insn->type);
+    emitMove(cg, dst, result, 0);
+}
+
+/**
+ * @brief Emits a shift; the count is masked like the virtual machine does.
+ */
+static void emitShift(CodeGen *cg, int value) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    Operand dst = valueOperand(cg, value);
+    Operand count = argOperand(cg, value, 1);
+    const char *mnemonic = insn->op == IR_SHL ? "shl" : isSignedType(insn->type) ? "sar" : "shr";
+    Operand t = resultRegister(dst, RAX);
+
+    if (count.kind == OPERAND_IMM) {
+        count = imm(count.value & (dst.size == 8 ? 63 : 31), 1);
+    } else {
+        emitMove(cg, reg(RCX, count.size), count, 0);
+        count = reg(RCX, 1);
+    }
+    emitMove(cg, t, argOperand(cg, value, 0), 0);
+    insn2(cg, mnemonic, dst.size, count, t);
+    emitNarrow(cg, t, insn->type);
+    emitMove(cg, dst, t, 0);
+}
+
+/**
+ * @brief Emits scalar SSE addition, subtraction, multiplication, or division.
+ */
+static void emitFloatBinary(CodeGen *cg, int value, const char *mnemonic, int commutative) {
+    Operand dst = valueOperand(cg, value);
+    Operand a = argOperand(cg, value, 0), b = argOperand(cg, value, 1);
+    Operand t;
+    char name[8];
+
+    if (commutative && sameLocation(b, dst)) {
+        Operand swap = a;
+        a = b;
+        b = swap;
+    }
+    t = isReg(dst) && !sameLocation(b, dst) ? dst : reg(XMM_SCRATCH, dst.size);
+    snprintf(name, sizeof(name), "%s%s", mnemonic, dst.size == 4 ? "ss" : "sd");
+    emitMove(cg, t, a, 1);
+    insn2(cg, name, 0, b, t);
+    emitMove(cg, dst, t, 1);
+}
+
+/**
+ * @brief Sets the flags for a comparison and returns the condition that is true when it holds.
+ */
+static Condition emitComparison(CodeGen *cg, int value) {
+    static const char *const signedCodes[4] = { "e", "ne", "l", "le" };
+    static const char *const unsignedCodes[4] = { "e", "ne", "b", "be" };
+    static const char *const swappedSigned[4] = { "e", "ne", "g", "ge" };
+    static const char *const swappedUnsigned[4] = { "e", "ne", "a", "ae" };
+    const IrInsn *insn = &cg->fn->insns[value];
+    Operand a = argOperand(cg, value, 0), b = argOperand(cg, value, 1);
+    int index = insn->op == IR_EQ ? 0 : insn->op == IR_NE ? 1 : insn->op == IR_LT ? 2 : 3;
+    Condition condition;
+
+    condition.parity = 0;
+    if (isFloat(insn->operandType)) {
+        const char *mnemonic = insn->operandType == TypeF32 ? "ucomiss" : "ucomisd";
+        Operand x = index < 2 ? a : b, y = index < 2 ? b : a;
+
+        /* a < b is tested as b > a, which is false when either is NaN. */
+        if (!isReg(x)) {
+            emitMove(cg, reg(XMM_SCRATCH, x.size), x, 1);
+            x = reg(XMM_SCRATCH, x.size);
+        }
+        insn2(cg, mnemonic, 0, y, x);
+        condition.code = index == 0 ? "e" : index == 1 ? "ne" : index == 2 ? "a" : "ae";
+        condition.parity = index == 0 ? 1 : index == 1 ? 2 : 0;
+        return condition;
+    }
+
+    {
+        int isUnsigned = (isIntegerType(insn->operandType) && !isSignedType(insn->operandType)) || insn->operandType == TypeBool || insn->operandType == TypeChar;
+        int swapped = 0;
+        if (a.kind == OPERAND_IMM && b.kind != OPERAND_IMM) {
+            Operand swap = a;
+            a = b;
+            b = swap;
+            swapped = 1;
+        } else if (a.kind == OPERAND_IMM || (a.kind == OPERAND_FRAME && b.kind == OPERAND_FRAME)) {
+            emitMove(cg, reg(RAX, a.size), a, 0);
+            a = reg(RAX, a.size);
+        }
+        insn2(cg, "cmp", a.size, b, a);
+        if (swapped) condition.code = isUnsigned ? swappedUnsigned[index] : swappedSigned[index];
+        else condition.code = isUnsigned ? unsignedCodes[index] : signedCodes[index];
+    }
+    return condition;
+}
+
+/**
+ * @brief Returns the condition code that holds exactly when `code` does not.
+ */
+static const char *negate(const char *code) {
+    static const char *const pairs[][2] = {
+        { "e", "ne" }, { "l", "ge" }, { "le", "g" }, { "b", "ae" }, { "be", "a" }, { "p", "np" }
+    };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        if (strcmp(pairs[i][0], code) == 0) return pairs[i][1];
+        if (strcmp(pairs[i][1], code) == 0) return pairs[i][0];
+    }
+    return code;
+}
+
+/**
+ * @brief Materializes a condition as a 0 or 1 in the low byte of %rax.
+ */
+static void emitSetCondition(CodeGen *cg, Condition condition) {
+    char mnemonic[8];
+
+    snprintf(mnemonic, sizeof(mnemonic), "set%s", condition.code);
+    insn1(cg, mnemonic, 0, reg(RAX, 1));
+    if (condition.parity == 1) {
+        insn1(cg, "setnp", 0, reg(RCX, 1));
+        insn2(cg, "and", 1, reg(RCX, 1), reg(RAX, 1));
+    } else if (condition.parity == 2) {
+        insn1(cg, "setp", 0, reg(RCX, 1));
+        insn2(cg, "or", 1, reg(RCX, 1), reg(RAX, 1));
+    }
+}
+
+/**
+ * @brief Stores the boolean in %al into a value's location.
+ */
+static void storeBool(CodeGen *cg, Operand dst) {
+    Operand t = resultRegister(dst, RAX);
+    insn2(cg, "movzbl", 0, reg(RAX, 1), resized(t, 4));
+    emitMove(cg, dst, t, 0);
+}
+
+/**
+ * @brief Emits the jumps that leave a block on a condition.
+ */
+static void emitConditionalJump(CodeGen *cg, Condition condition, int taken, int notTaken, int next) {
+    if (condition.parity == 1) {
+        jumpTo(cg, "p", notTaken);
+        if (taken == next) {
+            jumpTo(cg, "ne", notTaken);
+            return;
+        }
+        jumpTo(cg, "e", taken);
+    } else if (condition.parity == 2) {
+        jumpTo(cg, "p", taken);
+        if (taken == next) {
+            jumpTo(cg, "e", notTaken);
+            return;
+        }
+        jumpTo(cg, "ne", taken);
+    } else if (taken == next) {
+        jumpTo(cg, negate(condition.code), notTaken);
+        return;
+    } else {
+        jumpTo(cg, condition.code, taken);
+    }
+    if (notTaken != next) jumpTo(cg, "mp", notTaken);
+}
+
+/**
+ * @brief Tests a value against zero and returns the condition that holds when it is non-zero.
+ */
+static Condition emitTest(CodeGen *cg, Operand a) {
+    Condition condition;
+    if (isReg(a)) {
+        insn2(cg, "test", a.size, a, a);
+    } else {
+        if (a.kind == OPERAND_IMM) {
+            emitMove(cg, reg(RAX, a.size), a, 0);
+            a = reg(RAX, a.size);
+        }
+        insn2(cg, "cmp", a.size, imm(0, a.size), a);
+    }
+    condition.code = "ne";
+    condition.parity = 0;
+    return condition;
+}
+
+/**
+ * @brief Converts an unsigned 64-bit integer in %rax to floating point.
+ *
+ * Values with the top bit set are halved, rounding to odd, converted as
+ * signed, and doubled.
+ */
+static void emitU64ToFloat(CodeGen *cg, Operand t, const char *convert, const char *add) {
+    int big = cg->labelCount++, done = cg->labelCount++;
+
+    insn2(cg, "test", 8, reg(RAX, 8), reg(RAX, 8));
+    jumpToLocal(cg, "s", big);
+    insn2(cg, convert, 0, reg(RAX, 8), t);
+    jumpToLocal(cg, "mp", done);
+    placeLocal(cg, big);
+    insn2(cg, "mov", 8, reg(RAX, 8), reg(RCX, 8));
+    insn1(cg, "shr", 8, reg(RCX, 8));
+    insn2(cg, "and", 4, imm(1, 4), reg(RAX, 4));
+    insn2(cg, "or", 8, reg(RAX, 8), reg(RCX, 8));
+    insn2(cg, convert, 0, reg(RCX, 8), t);
+    insn2(cg, add, 0, t, t);
+    placeLocal(cg, done);
+}
+
+/**
+ * @brief Emits a conversion between two types with the virtual machine's semantics.
+ */
+static void emitConversion(CodeGen *cg, int value) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    int source = cg->fn->operands[insn->argStart];
+    TypeKind from = insn->operandType, to = insn->type;
+    Operand dst = valueOperand(cg, value);
+    Operand a = valueOperand(cg, source);
+
+    if (cg->fn->insns[source].op == IR_CONST && (a.kind == OPERAND_IMM || a.kind == OPERAND_LABEL)) {
+        Slot result = convertValue(cg->fn->insns[source].as.constant, from, to);
+        emitMove(cg, dst, constantOperand(cg, result, to), isFloat(to));
+        return;
+    }
+
+    if (isFloat(to)) {
+        Operand t = resultRegister(dst, XMM_SCRATCH);
+        const char *suffix = to == TypeF32 ? "ss" : "sd";
+        char convert[16], add[8];
+        snprintf(convert, sizeof(convert), "cvtsi2%s%c", suffix, 'q');
+        snprintf(add, sizeof(add), "add%s", suffix);
+
+        if (from == to) {
+            emitMove(cg, dst, a, 1);
+            return;
+        }
+        if (isFloat(from)) {
+            insn2(cg, from == TypeF32 ? "cvtss2sd" : "cvtsd2ss", 0, a, t);
+        } else {
+            insn2(cg, "xorps", 0, t, t);
+            if (from == TypeU64) {
+                emitMove(cg, reg(RAX, 8), a, 0);
+                emitU64ToFloat(cg, t, convert, add);
+            } else if (from == TypeI64) {
+                insn2(cg, convert, 0, a, t);
+            } else if (isSignedType(from)) {
+                convert[strlen(convert) - 1] = 'l';
+                insn2(cg, convert, 0, a, t);
+            } else {
+                emitMove(cg, reg(RAX, 4), a, 0);
+                insn2(cg, convert, 0, reg(RAX, 8), t);
+            }
+        }
+        emitMove(cg, dst, t, 1);
+        return;
+    }
+
+    if (isFloat(from)) {
+        const char *truncate = from == TypeF32 ? "cvttss2si" : "cvttsd2si";
+        Operand t = resultRegister(dst, RAX);
+
+        if (to == TypeBool) {
+            insn2(cg, "xorps", 0, reg(XMM_SCRATCH, 16), reg(XMM_SCRATCH, 16));
+            insn2(cg, from == TypeF32 ? "ucomiss" : "ucomisd", 0, a, reg(XMM_SCRATCH, a.size));
+            insn1(cg, "setne", 0, reg(RAX, 1));
+            insn1(cg, "setp", 0, reg(RCX, 1));
+            insn2(cg, "or", 1, reg(RCX, 1), reg(RAX, 1));
+            storeBool(cg, dst);
+            return;
+        }
+        if (to == TypeU64) {
+            Operand limit = makeOperand(OPERAND_LABEL, 0, a.size, addPoolEntry(cg, POOL_TWO63, from == TypeF32, NULL));
+            Operand x = a;
+            int big = cg->labelCount++, done = cg->labelCount++;
+            if (!isReg(x)) {
+                emitMove(cg, reg(XMM_SCRATCH, a.size), a, 1);
+                x = reg(XMM_SCRATCH, a.size);
+            }
+            insn2(cg, from == TypeF32 ? "ucomiss" : "ucomisd", 0, limit, x);
+            jumpToLocal(cg, "ae", big);
+            insn2(cg, truncate, 0, x, reg(RAX, 8));
+            jumpToLocal(cg, "mp", done);
+            placeLocal(cg, big);
+            emitMove(cg, reg(XMM_SCRATCH, a.size), x, 1);
+            insn2(cg, from == TypeF32 ? "subss" : "subsd", 0, limit, reg(XMM_SCRATCH, a.size));
+            insn2(cg, truncate, 0, reg(XMM_SCRATCH, a.size), reg(RAX, 8));
+            insn2(cg, "btc", 8, imm(63, 1), reg(RAX, 8));
+            placeLocal(cg, done);
+            emitMove(cg, dst, reg(RAX, 8), 0);
+            return;
+        }
+        if (to == TypeI64 || to == TypeU32) {
+            insn2(cg, truncate, 0, a, reg(RAX, 8));
+            emitMove(cg, dst, reg(RAX, dst.size), 0);
+            return;
+        }
+        insn2(cg, truncate, 0, a, resized(t, 4));
+        emitNarrow(cg, t, to);
+        emitMove(cg, dst, t, 0);
+        return;
+    }
+
+    if (to == TypeBool) {
+        if (a.kind == OPERAND_FRAME || isReg(a)) insn2(cg, "cmp", a.size, imm(0, a.size), a);
+        insn1(cg, "setne", 0, reg(RAX, 1));
+        storeBool(cg, dst);
+        return;
+    }
+    if (dst.size == 8) {
+        Operand t = resultRegister(dst, RAX);
+        if (a.size == 8) {
+            emitMove(cg, dst, a, 0);
+            return;
+        }
+        if (isSignedType(from)) insn2(cg, "movslq", 0, a, t);
+        else emitMove(cg, resized(t, 4), a, 0);
+        emitMove(cg, dst, t, 0);
+        return;
+    }
+
+    {
+        Operand t = resultRegister(dst, RAX);
+        emitMove(cg, t, resized(a, 4), 0);
+        if (sizeOf(from) == 8 || (to != TypeI32 && to != TypeU32 && to != from)) emitNarrow(cg, t, to);
+        emitMove(cg, dst, t, 0);
+    }
+}
+
+/**
+ * @brief Emits a call to an Obsidian function under the System V calling convention.
+ */
+static void emitCall(CodeGen *cg, int value) {
+    const IrFunction *fn = cg->fn;
+    const IrInsn *insn = &fn->insns[value];
+    Move *moves = allocate((size_t)insn->argCount, sizeof(Move));
+    int *stack = allocate((size_t)insn->argCount, sizeof(int));
+    int ints = 0, floats = 0, count = 0, stackCount = 0, stackBytes;
+
+    for (int i = 0; i < insn->argCount; i++) {
+        int arg = fn->operands[insn->argStart + i];
+        int floating = isFloat(fn->insns[arg].type);
+        Operand src = valueOperand(cg, arg);
+        if (floating ? floats < FLOAT_ARG_REGISTERS : ints < INT_ARG_REGISTERS) {
+            moves[count].dst = floating ? reg(XMM(floats++), src.size) : reg(intArgs[ints++], src.size);
+            moves[count].src = src;
+            moves[count].isFloat = floating;
+            count++;
+        } else {
+            stack[stackCount++] = arg;
+        }
+    }
+
+    /* Stack arguments are pushed last to first, keeping %rsp 16-byte aligned at the call. */
+    stackBytes = 8 * stackCount + (stackCount % 2 == 1 ? 8 : 0);
+    if (stackCount % 2 == 1) insn2(cg, "sub", 8, imm(8, 4), reg(RSP, 8));
+    for (int i = stackCount - 1; i >= 0; i--) {
+        Operand src = valueOperand(cg, stack[i]);
+        if (isFloat(fn->insns[stack[i]].type) && src.kind != OPERAND_FRAME) {
+            insn2(cg, "sub", 8, imm(8, 4), reg(RSP, 8));
+            if (!isReg(src)) {
+                emitMove(cg, reg(XMM_SCRATCH, src.size), src, 1);
+                src = reg(XMM_SCRATCH, src.size);
+            }
+            insn2(cg, src.size == 4 ? "movss" : "movsd", 0, src, makeOperand(OPERAND_FRAME, RSP, src.size, 0));
+        } else if (src.kind == OPERAND_ADDRESS) {
+            emitMove(cg, reg(RAX, 8), src, 0);
+            insn1(cg, "push", 8, reg(RAX, 8));
+        } else if (src.kind == OPERAND_IMM && !fitsImmediate(src.value)) {
+            emitMove(cg, reg(RAX, 8), src, 0);
+            insn1(cg, "push", 8, reg(RAX, 8));
+        } else {
+            insn1(cg, "push", 8, resized(src, 8));
+        }
+    }
+
+    emitParallelMoves(cg, moves, count);
+    if (cg->object != NULL) {
+        cg->calls = reserve(cg->calls, &cg->callCapacity, cg->callCount + 1, sizeof(Fixup));
+        cg->calls[cg->callCount].position = encodeCall(cg);
+        cg->calls[cg->callCount].target = insn->as.index;
+        cg->callCount++;
+    } else {
+        writeString(cg->out, "\tcall\t");
+        writeSymbol(cg, insn->as.index);
+        writeChar(cg->out, '\n');
+    }
+    if (stackBytes > 0) insn2(cg, "add", 8, imm(stackBytes, 4), reg(RSP, 8));
+
+    if (insn->type != TypeVoid) {
+        Operand dst = valueOperand(cg, value);
+        emitMove(cg, dst, reg(isFloat(insn->type) ? XMM(0) : RAX, dst.size), isFloat(insn->type));
+    }
+    free(moves);
+    free(stack);
+}
+
+/**
+ * @brief Emits a print through the C library, matching the virtual machine's output.
+ */
+static void emitPrint(CodeGen *cg, int value) {
+    const IrInsn *insn = &cg->fn->insns[value];
+    Operand a = argOperand(cg, value, 0);
+    const char *format = NULL;
+
+    switch (insn->operandType) {
+        case TypeBool: {
+            Operand yes = makeOperand(OPERAND_LABEL, 0, 8, addPoolEntry(cg, POOL_STRING, 0, "true"));
+            Operand no = makeOperand(OPERAND_LABEL, 0, 8, addPoolEntry(cg, POOL_STRING, 0, "false"));
+            if (a.kind == OPERAND_IMM) {
+                insn2(cg, "lea", 8, a.value ? yes : no, reg(RDI, 8));
+            } else {
+                insn2(cg, "cmp", 4, imm(0, 4), a);
+                insn2(cg, "lea", 8, yes, reg(RDI, 8));
+                insn2(cg, "lea", 8, no, reg(RAX, 8));
+                insn2(cg, "cmove", 0, reg(RAX, 8), reg(RDI, 8));
+            }
+            callLibrary(cg, "puts");
+            return;
+        }
+        case TypeString:
+            emitMove(cg, reg(RDI, 8), a, 0);
+            callLibrary(cg, "puts");
+            return;
+        case TypeChar: format = "%c\n"; break;
+        case TypeI8: case TypeI16: case TypeI32: format = "%d\n"; break;
+        case TypeU8: case TypeU16: case TypeU32: format = "%u\n"; break;
+        case TypeI64: format = "%ld\n"; break;
+        case TypeU64: format = "%lu\n"; break;
+        case TypeF32: case TypeF64: format = "%g\n"; break;
+        default:
+            emitMove(cg, reg(RDI, 4), imm('\n', 4), 0);
+            callLibrary(cg, "putchar");
+            return;
+    }
+
+    if (insn->operandType == TypeF32) {
+        insn2(cg, "cvtss2sd", 0, a, reg(XMM(0), 8));
+    } else if (insn->operandType == TypeF64) {
+        emitMove(cg, reg(XMM(0), 8), a, 1);
+    } else {
+        emitMove(cg, reg(RSI, a.size), a, 0);
+    }
+    insn2(cg, "lea", 8, makeOperand(OPERAND_LABEL, 0, 8, addPoolEntry(cg, POOL_STRING, 0, format)), reg(RDI, 8));
+    emitMove(cg, reg(RAX, 4), imm(isFloat(insn->operandType) ? 1 : 0, 4), 0);
+    callLibrary(cg, "printf");
+}
+
+/**
+ * @brief Emits a floating-point remainder through fmod or fmodf.
+ */
+static void emitFloatRemainder(CodeGen *cg, int value) {
+    Operand dst = valueOperand(cg, value);
+    Move moves[2];
+
+    moves[0].dst = reg(XMM(0), dst.size);
+    moves[0].src = argOperand(cg, value, 0);
+    moves[0].isFloat = 1;
+    moves[1].dst = reg(XMM(1), dst.size);
+    moves[1].src = argOperand(cg, value, 1);
+    moves[1].isFloat = 1;
+    emitParallelMoves(cg, moves, 2);
+    callLibrary(cg, dst.size == 4 ? "fmodf" : "fmod");
+    emitMove(cg, dst, reg(XMM(0), dst.size), 1);
+}
+
+/**
+ * @brief Restores the caller's frame and returns.
+ */
+static void emitEpilogue(CodeGen *cg) {
+    if (cg->savedCount > 0) {
+        if (cg->frameSize > 0) insn2(cg, "add", 8, imm(cg->frameSize, 4), reg(RSP, 8));
+        for (int i = cg->savedCount - 1; i >= 0; i--) insn1(cg, "pop", 8, reg(cg->saved[i], 8));
+        insn1(cg, "pop", 8, reg(RBP, 8));
+    } else if (cg->frameSize > 0) {
+        insn0(cg, "leave");
+    } else {
+        insn1(cg, "pop", 8, reg(RBP, 8));
+    }
+    insn0(cg, "ret");
+}
+
+/**
+ * @brief Emits one IR instruction.
+ *
+ * @param cg Pointer to the code generator.
+ * @param value The instruction to emit.
+ * @param next The block laid out after the current one, or IR_NONE.
+ */
+static void emitIrInsn(CodeGen *cg, int value, int next) {
+    const IrFunction *fn = cg->fn;
+    const IrInsn *insn = &fn->insns[value];
+    Operand dst = valueOperand(cg, value);
+
+    if (cg->fused[value]) return;
+    if (insn->type != TypeVoid && cg->allocation.location[value] == LOCATION_NONE && irIsPure(fn, value)) return;
+
+    switch (insn->op) {
+        case IR_NOP: case IR_PARAM: case IR_PHI:
+            break;
+
+        case IR_CONST:
+            emitMove(cg, dst, constantOperand(cg, insn->as.constant, insn->type), isFloat(insn->type));
+            break;
+
+        case IR_COPY:
+            emitMove(cg, dst, argOperand(cg, value, 0), isFloat(insn->type));
+            break;
+
+        case IR_ADD:
+            if (isFloat(insn->type)) emitFloatBinary(cg, value, "add", 1);
+            else emitIntBinary(cg, value, "add", 1);
+            break;
+        case IR_SUB:
+            if (isFloat(insn->type)) emitFloatBinary(cg, value, "sub", 0);
+            else emitIntBinary(cg, value, "sub", 0);
+            break;
+        case IR_MUL:
+            if (isFloat(insn->type)) emitFloatBinary(cg, value, "mul", 1);
+            else emitIntBinary(cg, value, "imul", 1);
+            break;
+        case IR_DIV:
+            if (isFloat(insn->type)) emitFloatBinary(cg, value, "div", 0);
+            else emitIntDivide(cg, value);
+            break;
+        case IR_MOD:
+            if (isFloat(insn->type)) emitFloatRemainder(cg, value);
+            else emitIntDivide(cg, value);
+            break;
+        case IR_AND: emitIntBinary(cg, value, "and", 1); break;
+        case IR_OR: emitIntBinary(cg, value, "or", 1); break;
+        case IR_XOR: emitIntBinary(cg, value, "xor", 1); break;
+        case IR_SHL: case IR_SHR: emitShift(cg, value); break;
+
+        case IR_NEG:
+            if (isFloat(insn->type)) {
+                Operand t = resultRegister(dst, XMM_SCRATCH);
+                PoolKind mask = insn->type == TypeF32 ? POOL_SIGN32 : POOL_SIGN64;
+                emitMove(cg, t, argOperand(cg, value, 0), 1);
+                insn2(cg, "xorps", 0, makeOperand(OPERAND_LABEL, 0, 16, addPoolEntry(cg, mask, 0, NULL)), t);
+                emitMove(cg, dst, t, 1);
+                break;
+            }
+            /* fall through */
+        case IR_BNOT: {
+            Operand t = resultRegister(dst, RAX);
+            emitMove(cg, t, argOperand(cg, value, 0), 0);
+            insn1(cg, insn->op == IR_NEG ? "neg" : "not", dst.size, t);
+            emitNarrow(cg, t, insn->type);
+            emitMove(cg, dst, t, 0);
+            break;
+        }
+
+        case IR_NOT: {
+            Operand a = argOperand(cg, value, 0);
+            if (a.kind == OPERAND_IMM) {
+                emitMove(cg, dst, imm(a.value == 0, 4), 0);
+                break;
+            }
+            insn2(cg, "cmp", a.size, imm(0, a.size), a);
+            insn1(cg, "sete", 0, reg(RAX, 1));
+            storeBool(cg, dst);
+            break;
+        }
+
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE:
+            emitSetCondition(cg, emitComparison(cg, value));
+            storeBool(cg, dst);
+            break;
+
+        case IR_CONV:
+            emitConversion(cg, value);
+            break;
+
+        case IR_CALL:
+            emitCall(cg, value);
+            break;
+
+        case IR_PRINT:
+            emitPrint(cg, value);
+            break;
+
+        case IR_JUMP: {
+            int target = cg->target[insn->as.targets[0]];
+            emitPhiMoves(cg, insn->block, insn->as.targets[0]);
+            if (target != next) jumpTo(cg, "mp", target);
+            break;
+        }
+
+        case IR_BRANCH: {
+            int taken = cg->target[insn->as.targets[0]];
+            int notTaken = cg->target[insn->as.targets[1]];
+            int condition = fn->operands[insn->argStart];
+            Operand a = valueOperand(cg, condition);
+
+            if (!cg->fused[condition] && a.kind == OPERAND_IMM) {
+                int target = a.value != 0 ? taken : notTaken;
+                if (target != next) jumpTo(cg, "mp", target);
+                break;
+            }
+            emitConditionalJump(cg, cg->fused[condition] ? emitComparison(cg, condition) : emitTest(cg, a), taken, notTaken, next);
+            break;
+        }
+
+        case IR_RET: {
+            int isMain = strcmp(fn->name, "main") == 0;
+            if (isMain && fn->returnType != TypeI32) {
+                emitMove(cg, reg(RAX, 4), imm(0, 4), 0);
+            } else if (insn->argCount > 0) {
+                Operand a = argOperand(cg, value, 0);
+                emitMove(cg, reg(isFloat(fn->returnType) ? XMM(0) : RAX, a.size), a, isFloat(fn->returnType));
+            }
+            emitEpilogue(cg);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Decides which constants and comparisons need no register, then allocates the rest.
+ *
+ * A constant that is not coalesced with a phi is rematerialized at each use
+ * unless it is a 64-bit integer too wide for an immediate. A comparison
+ * that directly precedes the branch that is its only use is fused into it.
+ * Parameters are all written on entry, so their intervals are made to
+ * start together.
+ */
+static void allocateFunction(CodeGen *cg) {
+    IrFunction *fn = cg->fn;
+    LiveIntervals *live = &cg->live;
+    int *uses = allocate((size_t)fn->insnCount, sizeof(int));
+    int *members = allocate((size_t)fn->insnCount, sizeof(int));
+    RegisterFile file;
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        if (fn->insns[v].block == IR_NONE || fn->insns[v].op == IR_NOP) continue;
+        for (int a = 0; a < fn->insns[v].argCount; a++) uses[fn->operands[fn->insns[v].argStart + a]]++;
+        if (live->start[v] >= 0) members[live->leader[v]]++;
+    }
+
+    for (int v = 0; v < fn->insnCount; v++) {
+        const IrInsn *insn = &fn->insns[v];
+        if (live->start[v] < 0) continue;
+        if (insn->op == IR_CONST && live->leader[v] == v && members[v] == 1) {
+            if ((insn->type != TypeI64 && insn->type != TypeU64) || fitsImmediate(insn->as.constant.i64)) {
+                live->start[v] = live->end[v] = -1;
+            }
+        } else if (insn->op == IR_PARAM) {
+            live->start[v] = live->blockStart[0];
+        }
+    }
+
+    for (int i = 0; i < live->layoutCount; i++) {
+        const IrBlock *block = &fn->blocks[live->layout[i]];
+        int last, condition;
+        if (block->insnCount < 2) continue;
+        last = block->insns[block->insnCount - 1];
+        if (fn->insns[last].op != IR_BRANCH) continue;
+        condition = fn->operands[fn->insns[last].argStart];
+        if (block->insns[block->insnCount - 2] != condition || uses[condition] != 1) continue;
+        if (fn->insns[condition].op < IR_EQ || fn->insns[condition].op > IR_LE) continue;
+        if (live->leader[condition] != condition || members[condition] != 1) continue;
+        cg->fused[condition] = 1;
+        live->start[condition] = live->end[condition] = -1;
+    }
+
+    memset(&file, 0, sizeof(file));
+    file.registerCounts[GPR_CLASS] = GPR_ALLOCATABLE;
+    file.registerCounts[XMM_CLASS] = XMM_ALLOCATABLE;
+    file.callerSaved[GPR_CLASS] = 0x1fu;
+    file.callerSaved[XMM_CLASS] = 0x7fffu;
+    file.classOf = x86Class;
+    allocateRegisters(fn, live, &file, NULL, &cg->allocation);
+
+    free(uses);
+    free(members);
+}
+
+/**
+ * @brief Emits the moves that take every parameter from where the caller passed it.
+ */
+static void emitParameterMoves(CodeGen *cg) {
+    const IrFunction *fn = cg->fn;
+    Operand *incoming = allocate((size_t)fn->paramCount, sizeof(Operand));
+    Move *moves = allocate((size_t)fn->paramCount, sizeof(Move));
+    int ints = 0, floats = 0, stack = 0, count = 0;
+
+    for (int i = 0; i < fn->paramCount; i++) {
+        TypeKind type = fn->paramTypes[i];
+        int size = sizeOf(type);
+        if (isFloat(type) ? floats < FLOAT_ARG_REGISTERS : ints < INT_ARG_REGISTERS) {
+            incoming[i] = reg(isFloat(type) ? XMM(floats++) : intArgs[ints++], size);
+        } else {
+            incoming[i] = makeOperand(OPERAND_FRAME, RBP, size, 16 + 8 * stack++);
+        }
+    }
+
+    for (int k = 0; k < fn->blocks[0].insnCount; k++) {
+        int v = fn->blocks[0].insns[k];
+        if (fn->insns[v].op != IR_PARAM) continue;
+        moves[count].dst = valueOperand(cg, v);
+        moves[count].src = incoming[fn->insns[v].as.index];
+        moves[count].isFloat = isFloat(fn->insns[v].type);
+        count++;
+    }
+    emitParallelMoves(cg, moves, count);
+    free(incoming);
+    free(moves);
+}
+
+/**
+ * @brief Resolves the jumps of the function just encoded and defines its symbol.
+ */
+static void finishObjectFunction(CodeGen *cg, int index) {
+    const IrFunction *fn = &cg->module->functions[index];
+    size_t start = cg->functionOffsets[index];
+    char *name = functionSymbolName(fn);
+
+    for (int i = 0; i < cg->jumpCount; i++) {
+        const Fixup *jump = &cg->jumps[i];
+        size_t target = jump->target >= 0 ? cg->blockOffsets[jump->target] : cg->labelOffsets[-1 - jump->target];
+        patch32(cg, jump->position, (int64_t)target - (int64_t)(jump->position + 4));
+    }
+    cg->functionSymbols[index] = addObjectSymbol(cg->object, name, OBJECT_TEXT, start, codeOffset(cg) - start,
+                                                 fn->exported || strcmp(fn->name, "main") == 0);
+    free(name);
+    free(cg->blockOffsets);
+    cg->blockOffsets = NULL;
+}
+
+/**
+ * @brief Generates the assembly of one function.
+ */
+static void emitFunction(CodeGen *cg, int index) {
+    IrFunction *fn = &((IrModule *)cg->module)->functions[index];
+    Writer *out = cg->out;
+    int spills;
+
+    cg->fn = fn;
+    cg->fnIndex = index;
+    irRemoveUnreachable(fn);
+    irSplitEdges(fn);
+    computeLiveIntervals(fn, &cg->live);
+    cg->fused = allocate((size_t)fn->insnCount, 1);
+    allocateFunction(cg);
+    cg->target = allocate((size_t)fn->blockCount, sizeof(int));
+    threadJumps(fn, &cg->live, &cg->allocation, cg->target);
+
+    cg->savedCount = 0;
+    for (int r = 0; r < GPR_ALLOCATABLE; r++) {
+        if ((cg->allocation.usedMask[GPR_CLASS] & ((uint32_t)1 << r)) && !(0x1fu & ((uint32_t)1 << r))) {
+            cg->saved[cg->savedCount++] = gprOrder[r];
+        }
+    }
+    spills = cg->allocation.spillCount;
+    cg->frameSize = 8 * spills + ((cg->savedCount + spills) % 2 == 1 ? 8 : 0);
+
+    if (cg->object != NULL) {
+        alignObjectSection(&cg->object->sections[OBJECT_TEXT], 16, 0x90);
+        cg->functionOffsets[index] = codeOffset(cg);
+        cg->blockOffsets = allocate((size_t)fn->blockCount, sizeof(size_t));
+        cg->jumpCount = 0;
+    } else {
+        writeString(out, "\n\t.p2align 4\n");
+        if (fn->exported || strcmp(fn->name, "main") == 0) {
+            writeString(out, "\t.globl\t");
+            writeSymbol(cg, index);
+            writeChar(out, '\n');
+        }
+        writeString(out, "\t.type\t");
+        writeSymbol(cg, index);
+        writeString(out, ", @function\n");
+        writeSymbol(cg, index);
+        writeString(out, ":\n");
+    }
+
+    insn1(cg, "push", 8, reg(RBP, 8));
+    insn2(cg, "mov", 8, reg(RSP, 8), reg(RBP, 8));
+    for (int i = 0; i < cg->savedCount; i++) insn1(cg, "push", 8, reg(cg->saved[i], 8));
+    if (cg->frameSize > 0) insn2(cg, "sub", 8, imm(cg->frameSize, 4), reg(RSP, 8));
+    emitParameterMoves(cg);
+
+    for (int i = 0; i < cg->live.layoutCount; i++) {
+        int b = cg->live.layout[i];
+        int next = IR_NONE;
+        if (cg->target[b] != b) continue;
+        for (int j = i + 1; j < cg->live.layoutCount && next == IR_NONE; j++) {
+            if (cg->target[cg->live.layout[j]] == cg->live.layout[j]) next = cg->live.layout[j];
+        }
+        if (cg->object != NULL) {
+            cg->blockOffsets[b] = codeOffset(cg);
+        } else if (i > 0) {
+            writeBlockLabel(cg, b);
+            writeString(out, ":\n");
+        }
+        for (int k = 0; k < fn->blocks[b].insnCount; k++) emitIrInsn(cg, fn->blocks[b].insns[k], next);
+    }
+
+    if (cg->object != NULL) {
+        finishObjectFunction(cg, index);
+    } else {
+        writeString(out, "\t.size\t");
+        writeSymbol(cg, index);
+        writeString(out, ", .-");
+        writeSymbol(cg, index);
+        writeChar(out, '\n');
+    }
+
+    free(cg->fused);
+    free(cg->target);
+    freeAllocation(&cg->allocation);
+    freeLiveIntervals(&cg->live);
+}
+
+/**
+ * @brief Writes a string constant with the assembler's escapes.
+ */
+static void writeQuoted(Writer *out, const char *text) {
+    writeChar(out, '"');
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            writeChar(out, '\\');
+            writeChar(out, (char)*c);
+        } else if (*c < 0x20 || *c >= 0x7f) {
+            writeChar(out, '\\');
+            writeChar(out, (char)('0' + (*c >> 6)));
+            writeChar(out, (char)('0' + ((*c >> 3) & 7)));
+            writeChar(out, (char)('0' + (*c & 7)));
+        } else {
+            writeChar(out, (char)*c);
+        }
+    }
+    writeChar(out, '"');
+}
+
+/**
+ * @brief Appends an unsigned value of 1 to 8 bytes in little-endian order.
+ */
+static void appendLittle(ObjectSection *section, uint64_t value, int bytes) {
+    unsigned char data[8];
+    for (int i = 0; i < bytes; i++) data[i] = (unsigned char)(value >> (8 * i));
+    appendObjectBytes(section, data, (size_t)bytes);
+}
+
+/**
+ * @brief Lays out the module's read-only constants in the object and completes the references to them.
+ */
+static void encodePool(CodeGen *cg) {
+    ObjectSection *data = &cg->object->sections[OBJECT_RODATA];
+    size_t *offsets = allocate((size_t)cg->poolCount, sizeof(size_t));
+
+    for (int i = 0; i < cg->poolCount; i++) {
+        const PoolEntry *entry = &cg->pool[i];
+        switch (entry->kind) {
+            case POOL_F32: alignObjectSection(data, 4, 0); break;
+            case POOL_F64: case POOL_TWO63: alignObjectSection(data, 8, 0); break;
+            case POOL_SIGN32: case POOL_SIGN64: alignObjectSection(data, 16, 0); break;
+            default: break;
+        }
+        offsets[i] = data->size;
+        switch (entry->kind) {
+            case POOL_F32: appendLittle(data, entry->bits, 4); break;
+            case POOL_F64: appendLittle(data, entry->bits, 8); break;
+            case POOL_STRING: appendObjectBytes(data, entry->text, strlen(entry->text) + 1); break;
+            case POOL_SIGN32:
+                appendLittle(data, 0x80000000u, 4);
+                appendLittle(data, 0, 8);
+                appendLittle(data, 0, 4);
+                break;
+            case POOL_SIGN64:
+                appendLittle(data, 0x8000000000000000u, 8);
+                appendLittle(data, 0, 8);
+                break;
+            case POOL_TWO63:
+                if (entry->bits) appendLittle(data, 0x5f000000u, 4);
+                else appendLittle(data, 0x43e0000000000000u, 8);
+                break;
+        }
+    }
+    for (int i = 0; i < cg->poolReferenceCount; i++) {
+        const PoolReference *reference = &cg->poolReferences[i];
+        cg->object->relocations[reference->relocation].addend += (int64_t)offsets[reference->entry];
+    }
+    free(offsets);
+}
+
+/**
+ * @brief Writes the module's read-only constants.
+ */
+static void emitPool(CodeGen *cg) {
+    Writer *out = cg->out;
+
+    if (cg->poolCount == 0) return;
+    writeString(out, "\n\t.section\t.rodata\n");
+    for (int i = 0; i < cg->poolCount; i++) {
+        const PoolEntry *entry = &cg->pool[i];
+        switch (entry->kind) {
+            case POOL_F32: writeString(out, "\t.p2align 2\n"); break;
+            case POOL_F64: case POOL_TWO63: writeString(out, "\t.p2align 3\n"); break;
+            case POOL_SIGN32: case POOL_SIGN64: writeString(out, "\t.p2align 4\n"); break;
+            default: break;
+        }
+        writeString(out, ".LC");
+        writeInt(out, i);
+        writeString(out, ":\n");
+        switch (entry->kind) {
+            case POOL_F32:
+                writeString(out, "\t.long\t");
+                writeUnsigned(out, entry->bits);
+                break;
+            case POOL_F64:
+                writeString(out, "\t.quad\t");
+                writeUnsigned(out, entry->bits);
+                break;
+            case POOL_STRING:
+                writeString(out, "\t.string\t");
+                writeQuoted(out, entry->text);
+                break;
+            case POOL_SIGN32:
+                writeString(out, "\t.long\t0x80000000, 0, 0, 0");
+                break;
+            case POOL_SIGN64:
+                writeString(out, "\t.quad\t0x8000000000000000, 0");
+                break;
+            case POOL_TWO63:
+                writeString(out, entry->bits ? "\t.long\t0x5f000000" : "\t.quad\t0x43e0000000000000");
+                break;
+        }
+        writeChar(out, '\n');
+    }
+}
+
+/**
+ * @brief Writes the assembly of every function of an IR module.
+ *
+ * @param ir Pointer to the IR module; its functions are prepared for code generation in place.
+ * @param out Pointer to the writer that receives the assembly.
+ */
+void emitX86Module(IrModule *ir, Writer *out) {
+    CodeGen cg;
+
+    memset(&cg, 0, sizeof(cg));
+    cg.out = out;
+    cg.module = ir;
+
+    writeString(out, "\t.text\n");
+    for (int i = 0; i < ir->functionCount; i++) {
+        if (!ir->functions[i].external) emitFunction(&cg, i);
+    }
+    emitPool(&cg);
+    writeString(out, "\n\t.section\t.note.GNU-stack,\"\",@progbits\n");
+    free(cg.pool);
+}
+
+/**
+ * @brief Encodes every function of an IR module into an object file.
+ *
+ * Calls between functions are resolved once all of them are placed: a call
+ * to a local function is patched in place, and one to a global or external
+ * function gets a relocation, as the assembler would emit.
+ *
+ * @param ir Pointer to the IR module; its functions are prepared for code generation in place.
+ * @param object Pointer to an empty object file that receives the code.
+ */
+void emitX86Object(IrModule *ir, ObjectFile *object) {
+    CodeGen cg;
+
+    memset(&cg, 0, sizeof(cg));
+    cg.object = object;
+    cg.module = ir;
+    cg.functionOffsets = allocate((size_t)ir->functionCount, sizeof(size_t));
+    cg.functionSymbols = allocate((size_t)ir->functionCount, sizeof(int));
+    for (int i = 0; i < ir->functionCount; i++) cg.functionSymbols[i] = -1;
+    for (int i = 0; i < LIBRARY_FUNCTIONS; i++) cg.librarySymbols[i] = -1;
+
+    for (int i = 0; i < ir->functionCount; i++) {
+        if (!ir->functions[i].external) emitFunction(&cg, i);
+    }
+    encodePool(&cg);
+
+    for (int i = 0; i < cg.callCount; i++) {
+        const Fixup *call = &cg.calls[i];
+        const IrFunction *fn = &ir->functions[call->target];
+        if (!fn->external && !fn->exported && strcmp(fn->name, "main") != 0) {
+            patch32(&cg, call->position, (int64_t)cg.functionOffsets[call->target] - (int64_t)(call->position + 4));
+            continue;
+        }
+        if (cg.functionSymbols[call->target] < 0) {
+            char *name = functionSymbolName(fn);
+            cg.functionSymbols[call->target] = addObjectSymbol(object, name, OBJECT_UNDEFINED, 0, 0, 1);
+            free(name);
+        }
+        addObjectRelocation(object, call->position, cg.functionSymbols[call->target], R_X86_64_PLT32, -4);
+    }
+
+    free(cg.pool);
+    free(cg.labelOffsets);
+    free(cg.jumps);
+    free(cg.calls);
+    free(cg.poolReferences);
+    free(cg.functionOffsets);
+    free(cg.functionSymbols);
+}
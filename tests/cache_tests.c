@@ -0,0 +1,123 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "include/cache_tests.h"
+#include "../src/include/cache.h"
+#include "../src/include/memstats.h"
+
+static const char *path = "cache_tests.ob";
+
+static void writeSource(const char *source) {
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+    fputs(source, file);
+    fclose(file);
+}
+
+void test_intern(void) {
+    InternTable table;
+    uint32_t a, b, c;
+
+    initInternTable(&table);
+    a = internSymbol(&table, "alpha", 5);
+    b = internSymbol(&table, "beta", 4);
+    c = internSymbol(&table, "alphabet", 5);
+
+    assert(a != SYMBOL_NONE && b != SYMBOL_NONE);
+    assert(a != b);
+    assert(a == c);
+    assert(findSymbol(&table, "beta", 4) == b);
+    assert(findSymbol(&table, "gamma", 5) == SYMBOL_NONE);
+    assert(strcmp(symbolName(&table, b), "beta") == 0);
+
+    for (int i = 0; i < 1000; i++) {
+        char name[16];
+        int length = snprintf(name, sizeof(name), "sym%d", i);
+        uint32_t id = internSymbol(&table, name, (size_t)length);
+        assert(id == internSymbol(&table, name, (size_t)length));
+        assert(strcmp(symbolName(&table, id), name) == 0);
+    }
+    assert(findSymbol(&table, "alpha", 5) == a);
+
+    freeInternTable(&table);
+}
+
+void test_cache_hit(void) {
+    TokenCache cache;
+    const CacheEntry *first, *second;
+
+    writeSource("fn main() i32 { i32 x = 1; return x; }");
+    initTokenCache(&cache);
+
+    first = loadTokens(&cache, path);
+    assert(first != NULL);
+    assert(first->stream.tokens[first->stream.count - 1].type == TEof);
+    assert(first->stream.tokens[1].type == TIdentifier);
+    assert(first->stream.symbols[1] == findSymbol(&cache.symbols, "main", 4));
+    assert(cache.misses == 1);
+
+    second = loadTokens(&cache, path);
+    assert(second == first);
+    assert(cache.hits == 1 && cache.misses == 1);
+
+    freeTokenCache(&cache);
+    remove(path);
+}
+
+void test_cache_invalidation(void) {
+    TokenCache cache;
+    const CacheEntry *entry;
+    size_t before;
+
+    writeSource("i32 a = 1;");
+    initTokenCache(&cache);
+
+    entry = loadTokens(&cache, path);
+    assert(entry != NULL);
+    before = entry->stream.count;
+
+    writeSource("i32 a = 1; i32 b = 2;");
+    entry = loadTokens(&cache, path);
+    assert(entry != NULL);
+    assert(entry->stream.count > before);
+    assert(cache.misses == 2);
+
+    assert(loadTokens(&cache, "does_not_exist.ob") == NULL);
+
+    freeTokenCache(&cache);
+    remove(path);
+}
+
+void test_mem_accounting(void) {
+    static const char source[] = "fn main() i32 { i32 x = 1; return x; }";
+    TokenCache cache;
+    const CacheEntry *entry;
+    MemStats before, loaded, after;
+
+    writeSource(source);
+    getMemStats(&before);
+    initTokenCache(&cache);
+    entry = loadTokens(&cache, path);
+    assert(entry != NULL);
+    getMemStats(&loaded);
+
+    assert(loaded.current[MEM_SOURCE] - before.current[MEM_SOURCE] == sizeof(source));
+    assert(loaded.current[MEM_TOKENS] - before.current[MEM_TOKENS] >= entry->stream.count * sizeof(Token));
+    assert(loaded.current[MEM_SYMBOLS] > before.current[MEM_SYMBOLS]);
+    assert(loaded.sourceBytes - before.sourceBytes == sizeof(source) - 1);
+    assert(loaded.tokens - before.tokens == entry->stream.count);
+    assert(loaded.totalPeak >= loaded.totalCurrent);
+
+    freeTokenCache(&cache);
+    getMemStats(&after);
+    for (int i = 0; i < MEM_CATEGORY_COUNT; i++) assert(after.current[i] == before.current[i]);
+    remove(path);
+}
+
+int main(void) {
+    test_intern();
+    test_cache_hit();
+    test_cache_invalidation();
+    test_mem_accounting();
+    return 0;
+}
@@ -0,0 +1,304 @@
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "include/daemon_tests.h"
+#include "include/fixture.h"
+#include "../src/include/daemon.h"
+
+static char socketPath[128];
+
+/* Runs `obsidian --daemon=socket` in a child process. */
+static pid_t spawnDaemon(const char *socketFile) {
+    char option[160];
+    pid_t daemon;
+
+    snprintf(option, sizeof(option), "--daemon=%s", socketFile);
+    daemon = fork();
+    assert(daemon >= 0);
+    if (daemon == 0) {
+        execl(compiler, compiler, option, (char *)NULL);
+        _exit(127);
+    }
+    return daemon;
+}
+
+/* Connects to the daemon on the test socket; returns the connection, or -1 if it is not listening. */
+static int tryConnect(void) {
+    struct sockaddr_un address;
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    assert(connection >= 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+    if (connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+static int connectDaemon(void) {
+    int connection = tryConnect();
+
+    assert(connection >= 0);
+    return connection;
+}
+
+/* Starts the daemon on the test socket and waits until it accepts connections, not just until the socket appears. */
+static pid_t startDaemon(void) {
+    struct timespec pause = { 0, 10000000 };
+    pid_t daemon = spawnDaemon(socketPath);
+    int probe = -1;
+
+    for (int i = 0; i < 500 && (probe = tryConnect()) < 0; i++) nanosleep(&pause, NULL);
+    assert(probe >= 0);
+    close(probe);
+    return daemon;
+}
+
+static void stopDaemon(pid_t daemon) {
+    int status;
+
+    assert(kill(daemon, SIGTERM) == 0);
+    assert(waitpid(daemon, &status, 0) == daemon);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    assert(access(socketPath, F_OK) != 0);
+}
+
+/*
+ * Sends one request the way the client does, with the output and errors
+ * going to files in the test directory, and returns the status it answers.
+ */
+static int32_t request(uint32_t magic, const char *const args[], const char *outName, const char *errName) {
+    char payload[1024], control[CMSG_SPACE(2 * sizeof(int))];
+    RequestHeader header;
+    struct iovec iov = { &header, sizeof(header) };
+    struct msghdr message;
+    struct cmsghdr *cmsg;
+    int fds[2], connection;
+    size_t length = strlen(directory) + 1;
+    int32_t status;
+
+    memcpy(payload, directory, length);
+    for (int i = 0; args[i] != NULL; i++) {
+        memcpy(payload + length, args[i], strlen(args[i]) + 1);
+        length += strlen(args[i]) + 1;
+    }
+    fds[0] = open(inDirectory(outName), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    fds[1] = open(inDirectory(errName), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    assert(fds[0] >= 0 && fds[1] >= 0);
+
+    header.magic = magic;
+    header.length = (uint32_t)length;
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    connection = connectDaemon();
+    assert(sendmsg(connection, &message, 0) == (ssize_t)sizeof(header));
+    assert(write(connection, payload, length) == (ssize_t)length);
+    assert(read(connection, &status, sizeof(status)) == (ssize_t)sizeof(status));
+    close(connection);
+    close(fds[0]);
+    close(fds[1]);
+    return status;
+}
+
+/* Starts `obsidian --client --run <source>` in the test directory. */
+static pid_t spawnClient(const char *source) {
+    pid_t client = fork();
+
+    assert(client >= 0);
+    if (client == 0) {
+        int out = open(inDirectory("client.out"), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        int err = open(inDirectory("client.err"), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (out < 0 || err < 0 || chdir(directory) != 0 || setenv(DAEMON_SOCKET_ENV, socketPath, 1) != 0) _exit(127);
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        execl(compiler, compiler, "--client", "--run", source, (char *)NULL);
+        _exit(127);
+    }
+    return client;
+}
+
+/* Runs `obsidian --client --run hello.ob` in the test directory and returns its exit status. */
+static int runClientProcess(void) {
+    int status;
+    pid_t client = spawnClient("hello.ob");
+
+    assert(waitpid(client, &status, 0) == client && WIFEXITED(status));
+    return WEXITSTATUS(status);
+}
+
+#if defined(__linux__)
+/* Kills every live process the daemon has forked; returns how many there were. */
+static int killRequests(pid_t daemon) {
+    DIR *processes = opendir("/proc");
+    struct dirent *item;
+    int killed = 0;
+
+    assert(processes != NULL);
+    while ((item = readdir(processes)) != NULL) {
+        char statPath[300], line[512];
+        const char *fields;
+        FILE *file;
+        long parent;
+        char state;
+
+        if (item->d_name[0] < '0' || item->d_name[0] > '9') continue;
+        snprintf(statPath, sizeof(statPath), "/proc/%s/stat", item->d_name);
+        file = fopen(statPath, "r");
+        if (file == NULL) continue;
+        fields = fgets(line, sizeof(line), file) != NULL ? strrchr(line, ')') : NULL;
+        fclose(file);
+        /* The fields after the command name are the state and then the parent's process ID. */
+        if (fields != NULL && sscanf(fields, ") %c %ld", &state, &parent) == 2 && parent == (long)daemon && state != 'Z') {
+            kill((pid_t)atol(item->d_name), SIGKILL);
+            killed++;
+        }
+    }
+    closedir(processes);
+    return killed;
+}
+#endif
+
+void test_daemon_round_trip(void) {
+    const char *hello[] = { "obsidian", "--run", "hello.ob", NULL };
+    const char *bad[] = { "obsidian", "-fsyntax-only", "bad.ob", NULL };
+    struct stat info;
+    pid_t daemon = startDaemon();
+
+    assert(lstat(socketPath, &info) == 0);
+    assert(S_ISSOCK(info.st_mode) && (info.st_mode & 0777) == 0600);
+
+    assert(request(DAEMON_MAGIC, hello, "hello.out", "hello.err") == EXIT_SUCCESS);
+    assert(strcmp(readText("hello.out"), "42\n") == 0);
+    assert(strcmp(readText("hello.err"), "") == 0);
+
+    /* The second request finds the tokens the daemon lexed after the first. */
+    assert(request(DAEMON_MAGIC, hello, "hello.out", "hello.err") == EXIT_SUCCESS);
+    assert(strcmp(readText("hello.out"), "42\n") == 0);
+
+    /* Lexical errors go to the client on every request, even once the file is cached. */
+    for (int i = 0; i < 2; i++) {
+        assert(request(DAEMON_MAGIC, bad, "bad.out", "bad.err") == EXIT_FAILURE);
+        assert(strstr(readText("bad.err"), "Unexpected character") != NULL);
+    }
+
+    assert(request(DAEMON_MAGIC ^ 1u, hello, "hello.out", "hello.err") == EXIT_FAILURE);
+    assert(strcmp(readText("hello.out"), "") == 0);
+
+    stopDaemon(daemon);
+}
+
+void test_daemon_concurrent(void) {
+    const char *hello[] = { "obsidian", "--run", "hello.ob", NULL };
+    pid_t daemon = startDaemon();
+    int stalled = connectDaemon();
+
+    /* A client that never sends its request must not hold up the next one. */
+    alarm(10);
+    assert(request(DAEMON_MAGIC, hello, "hello.out", "hello.err") == EXIT_SUCCESS);
+    assert(strcmp(readText("hello.out"), "42\n") == 0);
+    alarm(0);
+
+    close(stalled);
+    stopDaemon(daemon);
+}
+
+void test_daemon_client(void) {
+    pid_t daemon = startDaemon();
+
+    assert(runClientProcess() == EXIT_SUCCESS);
+    assert(strcmp(readText("client.out"), "42\n") == 0);
+    assert(strcmp(readText("client.err"), "") == 0);
+
+    /* A socket in a directory others can write to is not trusted; the command is compiled in-process. */
+    assert(chmod(directory, 0777) == 0);
+    assert(runClientProcess() == EXIT_SUCCESS);
+    assert(strcmp(readText("client.out"), "42\n") == 0);
+    assert(strstr(readText("client.err"), "not private to the current user") != NULL);
+    assert(chmod(directory, 0700) == 0);
+
+    stopDaemon(daemon);
+}
+
+void test_daemon_request_killed(void) {
+#if defined(__linux__)
+    struct timespec pause = { 0, 10000000 };
+    pid_t daemon = startDaemon();
+    pid_t client = spawnClient("spin.ob");
+    int status, killed = 0;
+
+    /* A request that dies after it was sent fails; compiling it again in-process would run the program twice. */
+    /* The process that served startDaemon's probe may still be there, so this kills until the client is done. */
+    alarm(10);
+    while (waitpid(client, &status, WNOHANG) == 0) {
+        killed += killRequests(daemon);
+        nanosleep(&pause, NULL);
+    }
+    alarm(0);
+    assert(killed > 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE);
+    assert(strstr(readText("client.err"), "failed while serving the request") != NULL);
+
+    stopDaemon(daemon);
+#endif
+}
+
+void test_daemon_private_directory(void) {
+    char shared[128], socketFile[256];
+    int status;
+    pid_t daemon;
+
+    snprintf(shared, sizeof(shared), "%s/shared", directory);
+    snprintf(socketFile, sizeof(socketFile), "%s/obsidian.sock", shared);
+    assert(mkdir(shared, 0700) == 0);
+    assert(chmod(shared, 0777) == 0);
+
+    daemon = spawnDaemon(socketFile);
+    assert(waitpid(daemon, &status, 0) == daemon);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE);
+    assert(access(socketFile, F_OK) != 0);
+    rmdir(shared);
+}
+
+int main(void) {
+    const char *files[] = { "hello.ob", "bad.ob", "spin.ob", "hello.out", "hello.err", "bad.out", "bad.err", "client.out", "client.err" };
+
+    openFixture("daemon_tests");
+    snprintf(socketPath, sizeof(socketPath), "%s/obsidian.sock", directory);
+    writeText("hello.ob", "fn main() { println(42); }\n");
+    writeText("bad.ob", "fn main() { $ }\n");
+    writeText("spin.ob", "fn main() { i32 i = 0; while (true) { i = i + 1; } }\n");
+
+    test_daemon_round_trip();
+    test_daemon_concurrent();
+    test_daemon_client();
+    test_daemon_request_killed();
+    test_daemon_private_directory();
+
+    closeFixture(files, sizeof(files) / sizeof(files[0]));
+    return 0;
+}
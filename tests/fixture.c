@@ -0,0 +1,47 @@
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "include/fixture.h"
+
+char compiler[PATH_MAX];
+char directory[64];
+static char path[256];
+
+void openFixture(const char *name) {
+    assert(realpath("../src/obsidian", compiler) != NULL);
+    snprintf(directory, sizeof(directory), "/tmp/%s.XXXXXX", name);
+    assert(mkdtemp(directory) != NULL);
+}
+
+void closeFixture(const char *const *files, size_t count) {
+    for (size_t i = 0; i < count; i++) remove(inDirectory(files[i]));
+    rmdir(directory);
+}
+
+const char *inDirectory(const char *name) {
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    return path;
+}
+
+void writeText(const char *name, const char *text) {
+    FILE *file = fopen(inDirectory(name), "w");
+    assert(file != NULL);
+    fputs(text, file);
+    fclose(file);
+}
+
+char *readText(const char *name) {
+    static char text[4096];
+    FILE *file = fopen(inDirectory(name), "r");
+    size_t length;
+
+    assert(file != NULL);
+    length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+    return text;
+}
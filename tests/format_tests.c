@@ -0,0 +1,165 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/format_tests.h"
+#include "../src/include/format.h"
+#include "../src/include/lexer.h"
+
+static char *format(const char *source) {
+    size_t length = strlen(source), size;
+    char *copy = malloc(length + 1);
+    Writer *writer = malloc(sizeof(Writer));
+    char *output;
+
+    assert(copy != NULL && writer != NULL);
+    memcpy(copy, source, length + 1);
+    initWriter(writer, NULL);
+    assert(formatSource(copy, NULL, writer) == 0);
+    output = takeWriterMemory(writer, &size);
+    assert(output != NULL && size == strlen(output));
+    free(writer);
+    free(copy);
+    return output;
+}
+
+static void expectFormat(const char *source, const char *expected) {
+    char *output = format(source);
+    assert(strcmp(output, expected) == 0);
+    free(output);
+}
+
+void test_format_layout(void) {
+    expectFormat("fn f(i32 n)f32{f32 res=1.0;for(i32 i=2;i<=n;i++){res*=cast(i,f32);}return res;}",
+                 "fn f(i32 n) f32 {\n"
+                 "    f32 res = 1.0;\n"
+                 "    for (i32 i = 2; i <= n; i++) {\n"
+                 "        res *= cast(i, f32);\n"
+                 "    }\n"
+                 "    return res;\n"
+                 "}\n");
+    expectFormat("fn main() i32 { if (x<-1.0) { println(-x); } else if (!y) { --x; } else {} return a[i]*-b; }",
+                 "fn main() i32 {\n"
+                 "    if (x < -1.0) {\n"
+                 "        println(-x);\n"
+                 "    } else if (!y) {\n"
+                 "        --x;\n"
+                 "    } else {}\n"
+                 "    return a[i] * -b;\n"
+                 "}\n");
+    expectFormat("fn a() {\n\n\n    x();\n\n\n    y();\n\n}\n\n\nfn b() {}",
+                 "fn a() {\n"
+                 "    x();\n"
+                 "\n"
+                 "    y();\n"
+                 "}\n"
+                 "\n"
+                 "fn b() {}\n");
+}
+
+void test_format_comments(void) {
+    expectFormat("// header\nfn main() i32 { // entry\n  i32 x = 1;   // one  \n\n    // alone\n return x; }",
+                 "// header\n"
+                 "fn main() i32 { // entry\n"
+                 "    i32 x = 1; // one\n"
+                 "\n"
+                 "    // alone\n"
+                 "    return x;\n"
+                 "}\n");
+}
+
+void test_format_wrapping(void) {
+    char source[512];
+    char *output;
+
+    strcpy(source, "fn main() i32 { i32 total = first(aaaaaaaaaaaaaaaa, bbbbbbbbbbbbbbbb) + second(cccccccccccccccc, dddddddddddddddd, eeee); }");
+    output = format(source);
+    assert(strcmp(output, "fn main() i32 {\n"
+                          "    i32 total = first(aaaaaaaaaaaaaaaa, bbbbbbbbbbbbbbbb) +\n"
+                          "            second(cccccccccccccccc, dddddddddddddddd, eeee);\n"
+                          "}\n") == 0);
+    free(output);
+
+    expectFormat("fn main() { println(someFunctionName(alphaValue + betaValue * gammaValue, deltaValue - epsilonValue / zetaValueLonger)); }",
+                 "fn main() {\n"
+                 "    println(someFunctionName(alphaValue + betaValue * gammaValue,\n"
+                 "            deltaValue - epsilonValue / zetaValueLonger));\n"
+                 "}\n");
+
+    output = format("fn main() { call(aaaaaaaaaaaaaaaaaaaa, bbbbbbbbbbbbbbbbbbbb, cccccccccccccccccccc, dddddddddddddddddddd, eeeeeeee); }");
+    for (const char *line = output; *line != '\0'; line = strchr(line, '\n') + 1) {
+        assert(strchr(line, '\n') - line <= FORMAT_LINE_WIDTH);
+    }
+    free(output);
+}
+
+void test_format_idempotent(void) {
+    const char *sources[] = {
+        "fn sin(f32 x,i32 terms)f32{f32 sin=0.0;for(i32 n=0;n<terms;n++){i32 sign=((n%2)==0)?1:-1;"
+        "sin+=cast(sign,f32)*pow(x,2*n+1)/factorial(2*n+1)*someLongFunctionName(x,terms,n,sign,sin);}return sin;}",
+        "fn main() i32 { f(a, // first\n b); while (x > 0) x--; return 0; }",
+    };
+
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+        char *once = format(sources[i]);
+        char *twice = format(once);
+        assert(strcmp(once, twice) == 0);
+        free(twice);
+        free(once);
+    }
+}
+
+static void expectSameTokens(const char *source) {
+    static const DiagnosticSink discard = { NULL, NULL };
+    char *copy = malloc(strlen(source) + 1);
+    char *output = format(source);
+    Lexer before, after;
+    Token a, b;
+
+    assert(copy != NULL);
+    strcpy(copy, source);
+    initLexer(&before, copy);
+    initLexer(&after, output);
+    before.diagnostics = after.diagnostics = &discard;
+    do {
+        a = getNextToken(&before);
+        b = getNextToken(&after);
+        assert(a.type == b.type);
+    } while (a.type != TEof);
+    free(output);
+    free(copy);
+}
+
+void test_format_operators(void) {
+    const char *sources[] = {
+        "fn f() { a = - -b; a = + +b; a = - --b; a = + ++b; a = - -= b; a = + += b; }",
+        "fn f() { a = * *p; a = & &b; a = * *= b; a = !!b; a = ~~b; a = -(-b); }",
+        "fn f() { a = b - -c; a = b + +c; a = b--- -c; a = b++ + ++c; a = b < <c; a = b > >c; }",
+    };
+
+    expectFormat("fn main() i32 { i32 y = 3; i32 x = - -y; println(x); return + +y; }",
+                 "fn main() i32 {\n"
+                 "    i32 y = 3;\n"
+                 "    i32 x = - -y;\n"
+                 "    println(x);\n"
+                 "    return + +y;\n"
+                 "}\n");
+    expectFormat("fn f() { a = - --b; a = + ++b; a = * *p; a = & &b; a = !!b; a = -(-b); }",
+                 "fn f() {\n"
+                 "    a = - --b;\n"
+                 "    a = + ++b;\n"
+                 "    a = * *p;\n"
+                 "    a = & &b;\n"
+                 "    a = !!b;\n"
+                 "    a = -(-b);\n"
+                 "}\n");
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) expectSameTokens(sources[i]);
+}
+
+int main(void) {
+    test_format_layout();
+    test_format_comments();
+    test_format_wrapping();
+    test_format_idempotent();
+    test_format_operators();
+    return 0;
+}
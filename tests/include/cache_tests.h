@@ -0,0 +1,9 @@
+#ifndef CACHE_TESTS_H
+#define CACHE_TESTS_H
+
+void test_intern(void);
+void test_cache_hit(void);
+void test_cache_invalidation(void);
+void test_mem_accounting(void);
+
+#endif // CACHE_TESTS_H
@@ -0,0 +1,10 @@
+#ifndef DAEMON_TESTS_H
+#define DAEMON_TESTS_H
+
+void test_daemon_round_trip(void);
+void test_daemon_concurrent(void);
+void test_daemon_client(void);
+void test_daemon_request_killed(void);
+void test_daemon_private_directory(void);
+
+#endif // DAEMON_TESTS_H
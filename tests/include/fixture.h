@@ -0,0 +1,26 @@
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <stddef.h>
+
+/* Absolute path of the obsidian executable the tests run. */
+extern char compiler[];
+
+/* The temporary directory the test works in. */
+extern char directory[];
+
+/* Finds the compiler and creates the test directory, /tmp/<name>.XXXXXX. */
+void openFixture(const char *name);
+
+/* Removes the named files from the test directory, then the directory itself. */
+void closeFixture(const char *const *files, size_t count);
+
+/* Returns the path of `name` inside the test directory, valid until the next call. */
+const char *inDirectory(const char *name);
+
+void writeText(const char *name, const char *text);
+
+/* Returns the contents of a file in the test directory, valid until the next call. */
+char *readText(const char *name);
+
+#endif // FIXTURE_H
@@ -0,0 +1,10 @@
+#ifndef FORMAT_TESTS_H
+#define FORMAT_TESTS_H
+
+void test_format_layout(void);
+void test_format_comments(void);
+void test_format_wrapping(void);
+void test_format_idempotent(void);
+void test_format_operators(void);
+
+#endif // FORMAT_TESTS_H
@@ -0,0 +1,9 @@
+#ifndef INTERFACE_TESTS_H
+#define INTERFACE_TESTS_H
+
+void test_interface_roundtrip(void);
+void test_interface_invalid(void);
+void test_interface_import(void);
+void test_interface_replace(void);
+
+#endif // INTERFACE_TESTS_H
@@ -0,0 +1,8 @@
+#ifndef JOBSERVER_TESTS_H
+#define JOBSERVER_TESTS_H
+
+void test_jobserver_flags(void);
+void test_jobserver_pipe(void);
+void test_jobserver_fifo(void);
+
+#endif // JOBSERVER_TESTS_H
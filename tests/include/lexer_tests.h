@@ -5,5 +5,6 @@ void test_identifier(void);
 void test_keyword(void);
 void test_numbers(void);
 void test_operator(void);
+void test_comments(void);
 
 #endif // LEXER_TESTS_H
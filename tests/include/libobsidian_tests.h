@@ -0,0 +1,10 @@
+#ifndef LIBOBSIDIAN_TESTS_H
+#define LIBOBSIDIAN_TESTS_H
+
+void test_library_compile(void);
+void test_library_diagnostics(void);
+void test_library_imports(void);
+void test_library_threads(void);
+void test_library_out_of_memory(void);
+
+#endif // LIBOBSIDIAN_TESTS_H
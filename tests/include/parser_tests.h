@@ -0,0 +1,10 @@
+#ifndef PARSER_TESTS_H
+#define PARSER_TESTS_H
+
+void test_parser_lazy_bodies(void);
+void test_parser_lazy_errors(void);
+void test_parser_lazy_compile(void);
+void test_parser_index_errors(void);
+void test_parser_lexical_errors(void);
+
+#endif // PARSER_TESTS_H
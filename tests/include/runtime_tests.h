@@ -0,0 +1,10 @@
+#ifndef RUNTIME_TESTS_H
+#define RUNTIME_TESTS_H
+
+void test_runtime_sizes(void);
+void test_runtime_reuse(void);
+void test_runtime_large(void);
+void test_runtime_random(void);
+void test_runtime_threads(void);
+
+#endif // RUNTIME_TESTS_H
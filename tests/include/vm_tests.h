@@ -0,0 +1,12 @@
+#ifndef VM_TESTS_H
+#define VM_TESTS_H
+
+void test_parse_program(void);
+void test_vm_arithmetic(void);
+void test_vm_control_flow(void);
+void test_vm_calls(void);
+void test_vm_errors(void);
+void test_scopes(void);
+void test_optimizer(void);
+
+#endif // VM_TESTS_H
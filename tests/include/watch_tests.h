@@ -0,0 +1,7 @@
+#ifndef WATCH_TESTS_H
+#define WATCH_TESTS_H
+
+void test_watch_debounce(void);
+void test_watch_importers(void);
+
+#endif // WATCH_TESTS_H
@@ -0,0 +1,9 @@
+#ifndef X86_TESTS_H
+#define X86_TESTS_H
+
+void test_x86_symbols(void);
+void test_x86_codegen(void);
+void test_x86_object(void);
+void test_x86_native(void);
+
+#endif // X86_TESTS_H
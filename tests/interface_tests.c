@@ -0,0 +1,198 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/interface_tests.h"
+#include "../src/include/cache.h"
+#include "../src/include/compiler.h"
+#include "../src/include/interface.h"
+#include "../src/include/parser.h"
+#include "../src/include/passes.h"
+
+#ifndef _WIN32
+    #include <sys/stat.h>
+#endif
+
+static const char *interfacePath = "interface_tests.obi";
+
+static const char *library = "export fn square(i32 x) i32 { return x * x; }\n"
+                             "export fn mix(f64 a, u8 b, bool c) f64 { return a; }\n"
+                             "fn helper() i32 { return 7; }\n"
+                             "export fn seven() i32 { return helper(); }\n"
+                             "export fn hello() { println(1); }";
+
+/* Compiles a program against the given interfaces; returns the result of compileProgram. */
+static int compile(const char *source, const ModuleInterface *interfaces, int count, IrModule *ir) {
+    InternTable symbols;
+    TokenStream stream;
+    Arena arena;
+    Parser parser;
+    Program program;
+    char *copy = malloc(strlen(source) + 1);
+    int status;
+
+    assert(copy != NULL);
+    strcpy(copy, source);
+    initInternTable(&symbols);
+    initArena(&arena);
+    assert(tokenize(copy, &symbols, &stream, NULL) == 0);
+    initParser(&parser, &stream, &arena);
+    assert(parseProgram(&parser, &program) == 0);
+    program.interfaces = interfaces;
+    program.interfaceCount = count;
+    status = compileProgram(&program, &symbols, ir, NULL);
+    optimizeModule(ir, 2, NULL);
+
+    freeArena(&arena);
+    freeTokenStream(&stream);
+    freeInternTable(&symbols);
+    free(copy);
+    return status;
+}
+
+/* Compiles the library and writes its interface file. */
+static void writeLibrary(void) {
+    IrModule ir;
+
+    initIrModule(&ir);
+    assert(compile(library, NULL, 0, &ir) == 0);
+    assert(writeInterface(&ir, interfacePath) == 0);
+    freeIrModule(&ir);
+}
+
+void test_interface_roundtrip(void) {
+    ModuleInterface interfaceFile;
+    InterfaceFunction function;
+    InterfaceHeader header;
+
+    writeLibrary();
+    assert(openInterface(&interfaceFile, interfacePath) == 0);
+    memcpy(&header, interfaceFile.data, sizeof(header));
+    assert(header.magic == INTERFACE_MAGIC && header.version == INTERFACE_VERSION);
+    assert(header.functionCount == 4);
+    assert(header.hash == hashContents((const char *)interfaceFile.data + sizeof(header), interfaceFile.size - sizeof(header)));
+
+    assert(findInterfaceFunction(&interfaceFile, "square", 6, &function) == 0);
+    assert(function.returnType == TypeI32 && function.paramCount == 1 && function.paramTypes[0] == TypeI32);
+    assert(findInterfaceFunction(&interfaceFile, "mix", 3, &function) == 0);
+    assert(function.returnType == TypeF64 && function.paramCount == 3);
+    assert(function.paramTypes[0] == TypeF64 && function.paramTypes[1] == TypeU8 && function.paramTypes[2] == TypeBool);
+    assert(findInterfaceFunction(&interfaceFile, "hello", 5, &function) == 0);
+    assert(function.returnType == TypeVoid && function.paramCount == 0);
+    assert(findInterfaceFunction(&interfaceFile, "seven", 5, &function) == 0);
+
+    assert(findInterfaceFunction(&interfaceFile, "helper", 6, &function) == -1);
+    assert(findInterfaceFunction(&interfaceFile, "squ", 3, &function) == -1);
+    assert(findInterfaceFunction(&interfaceFile, "squares", 7, &function) == -1);
+    closeInterface(&interfaceFile);
+    assert(interfaceFile.data == NULL);
+
+    /* Writing the same interface again leaves an identical file. */
+    writeLibrary();
+    assert(openInterface(&interfaceFile, interfacePath) == 0);
+    assert(findInterfaceFunction(&interfaceFile, "square", 6, &function) == 0);
+    closeInterface(&interfaceFile);
+}
+
+void test_interface_invalid(void) {
+    ModuleInterface interfaceFile;
+    FILE *file;
+
+    assert(openInterface(&interfaceFile, "interface_tests_missing.obi") == -1);
+
+    file = fopen(interfacePath, "wb");
+    assert(file != NULL);
+    fputs("not an interface file at all, just text", file);
+    fclose(file);
+    assert(openInterface(&interfaceFile, interfacePath) == 1);
+
+    file = fopen(interfacePath, "wb");
+    assert(file != NULL);
+    fputs("OBI", file);
+    fclose(file);
+    assert(openInterface(&interfaceFile, interfacePath) == 1);
+    remove(interfacePath);
+}
+
+void test_interface_import(void) {
+    ModuleInterface interfaceFile;
+    IrModule ir;
+    int external = -1;
+
+    writeLibrary();
+    assert(openInterface(&interfaceFile, interfacePath) == 0);
+
+    initIrModule(&ir);
+    assert(compile("fn main() i32 { println(mix(1.5, 2, true)); return square(3) + square(4); }", &interfaceFile, 1, &ir) == 0);
+    assert(ir.functionCount == 3);
+    assert(!ir.functions[0].external);
+    for (int i = 1; i < ir.functionCount; i++) {
+        assert(ir.functions[i].external && ir.functions[i].exported && ir.functions[i].blockCount == 0);
+        if (strcmp(ir.functions[i].name, "square") == 0) external = i;
+    }
+    assert(external > 0);
+    assert(ir.functions[external].paramCount == 1 && ir.functions[external].paramTypes[0] == TypeI32);
+    freeIrModule(&ir);
+
+    /* A local definition wins over the interface, and unused exports are never declared. */
+    initIrModule(&ir);
+    assert(compile("fn square(i32 x) i32 { return x; } fn main() i32 { return square(2); }", &interfaceFile, 1, &ir) == 0);
+    assert(ir.functionCount == 2 && !ir.functions[0].external && !ir.functions[1].external);
+    freeIrModule(&ir);
+
+    initIrModule(&ir);
+    assert(compile("fn main() i32 { return square(1, 2); }", &interfaceFile, 1, &ir) == 1);
+    freeIrModule(&ir);
+    initIrModule(&ir);
+    assert(compile("fn main() i32 { return helper(); }", &interfaceFile, 1, &ir) == 1);
+    freeIrModule(&ir);
+
+    closeInterface(&interfaceFile);
+    remove(interfacePath);
+}
+
+void test_interface_replace(void) {
+    ModuleInterface previous, current;
+    InterfaceFunction function;
+    IrModule ir;
+
+    writeLibrary();
+    assert(openInterface(&previous, interfacePath) == 0);
+
+    /* A changed interface replaces the file instead of overwriting the one an importer has mapped. */
+    initIrModule(&ir);
+    assert(compile("export fn cube(i32 x) i32 { return x * x * x; }", NULL, 0, &ir) == 0);
+    assert(writeInterface(&ir, interfacePath) == 0);
+    freeIrModule(&ir);
+#ifndef _WIN32
+    {
+        /* The replacement gets the default mode, not the private one of its temporary file. */
+        struct stat info;
+        mode_t mask = umask(0);
+
+        umask(mask);
+        assert(stat(interfacePath, &info) == 0 && (info.st_mode & 0777) == (0666 & ~mask));
+    }
+#endif
+
+    assert(findInterfaceFunction(&previous, "square", 6, &function) == 0);
+    assert(findInterfaceFunction(&previous, "cube", 4, &function) == -1);
+    assert(openInterface(&current, interfacePath) == 0);
+    assert(findInterfaceFunction(&current, "cube", 4, &function) == 0);
+    assert(findInterfaceFunction(&current, "square", 6, &function) == -1);
+    closeInterface(&current);
+    closeInterface(&previous);
+    remove(interfacePath);
+}
+
+int main(void) {
+    test_interface_roundtrip();
+    test_interface_invalid();
+    test_interface_import();
+    test_interface_replace();
+    return 0;
+}
@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "include/jobserver_tests.h"
+#include "../src/include/jobserver.h"
+
+static const char *fifoPath = "jobserver_tests.fifo";
+
+void test_jobserver_flags(void) {
+    JobServer server;
+    char flags[128], token;
+
+    assert(openJobServer(&server, NULL) == 0);
+    assert(openJobServer(&server, "") == 0);
+    assert(openJobServer(&server, "-j8") == 0);
+    assert(server.readFd == -1 && tryAcquireJobToken(&server, &token) == 0);
+    closeJobServer(&server);
+
+    /* Descriptors that are not open mean make did not pass the jobserver on. */
+    assert(openJobServer(&server, " -j4 --jobserver-auth=900,901") == 0);
+    assert(openJobServer(&server, "--jobserver-auth=fifo:/nonexistent/jobserver") == 0);
+
+    snprintf(flags, sizeof(flags), "--jobserver-auth=%d", STDIN_FILENO);
+    assert(openJobServer(&server, flags) == 0);
+    snprintf(flags, sizeof(flags), "--jobserver-auth=%d,%dx", STDIN_FILENO, STDOUT_FILENO);
+    assert(openJobServer(&server, flags) == 0);
+}
+
+void test_jobserver_pipe(void) {
+    JobServer server;
+    char flags[128], token, held[2];
+    int fds[2];
+
+    assert(pipe(fds) == 0);
+    assert(write(fds[1], "ab", 2) == 2);
+
+    /* The last option wins, in the older spelling as well. */
+    snprintf(flags, sizeof(flags), "-j --jobserver-auth=900,901 --jobserver-fds=%d,%d", fds[0], fds[1]);
+    assert(openJobServer(&server, flags) == 1);
+    assert(server.writeFd == fds[1]);
+    assert(tryAcquireJobToken(&server, &held[0]) == 1);
+    assert(tryAcquireJobToken(&server, &held[1]) == 1);
+    assert(held[0] == 'a' && held[1] == 'b');
+    assert(tryAcquireJobToken(&server, &token) == 0);
+
+    releaseJobToken(&server, held[1]);
+    assert(tryAcquireJobToken(&server, &token) == 1 && token == 'b');
+    releaseJobToken(&server, token);
+    releaseJobToken(&server, held[0]);
+    closeJobServer(&server);
+
+    /* Every token is back in the pipe, which is still open. */
+    assert(read(fds[0], held, 2) == 2 && held[0] == 'b' && held[1] == 'a');
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_jobserver_fifo(void) {
+    JobServer server;
+    char flags[128], token;
+
+    remove(fifoPath);
+    assert(mkfifo(fifoPath, 0600) == 0);
+    snprintf(flags, sizeof(flags), "-j4 --jobserver-auth=fifo:%s", fifoPath);
+    assert(openJobServer(&server, flags) == 1);
+    assert(server.nonBlocking);
+    assert(tryAcquireJobToken(&server, &token) == 0);
+    releaseJobToken(&server, '+');
+    assert(tryAcquireJobToken(&server, &token) == 1 && token == '+');
+    assert(tryAcquireJobToken(&server, &token) == 0);
+    releaseJobToken(&server, token);
+    closeJobServer(&server);
+    remove(fifoPath);
+}
+
+int main(void) {
+    test_jobserver_flags();
+    test_jobserver_pipe();
+    test_jobserver_fifo();
+    return 0;
+}
@@ -26,8 +26,8 @@ void test_keyword(void) {
     Lexer lexer;
     Token token;
     const char *input;
-    const char *keywords[] = { "alloc", "break", "case", "char", "const", "dealloc", "default", "else", "enum", "export", "false", "fn", "for", "if", "import", "i8", "i16", "i32", "i64", "f32", "f64", "length", "new", "null", "private", "println", "return", "sizeof", "string", "struct", "switch", "true", "typeOf", "unsafe", "u8", "u16", "u32", "u64", "void", "while" };
-    TokenKind expectedTokens[] = { TAlloc, TBreak, TCase, TChar, TConst, TDealloc, TDefault, TElse, TEnum, TExport, TFalse, TFn, TFor, TIf, TImport, TI8, TI16, TI32, TI64, TF32, TF64, TLength, TNew, TNull, TPrivate, TPrintln, TReturn, TSizeof, TString, TStruct, TSwitch, TTrue, TTypeof, TUnsafe, TU8, TU16, TU32, TU64, TVoid, TWhile };
+    const char *keywords[] = { "alloc", "bool", "break", "case", "cast", "char", "const", "dealloc", "default", "else", "enum", "export", "false", "fn", "for", "if", "import", "i8", "i16", "i32", "i64", "f32", "f64", "length", "new", "null", "private", "println", "return", "sizeof", "string", "struct", "switch", "true", "typeOf", "unsafe", "u8", "u16", "u32", "u64", "void", "while" };
+    TokenKind expectedTokens[] = { TAlloc, TBool, TBreak, TCase, TCast, TChar, TConst, TDealloc, TDefault, TElse, TEnum, TExport, TFalse, TFn, TFor, TIf, TImport, TI8, TI16, TI32, TI64, TF32, TF64, TLength, TNew, TNull, TPrivate, TPrintln, TReturn, TSizeof, TString, TStruct, TSwitch, TTrue, TTypeof, TUnsafe, TU8, TU16, TU32, TU64, TVoid, TWhile };
     size_t numKeywords = sizeof(keywords) / sizeof(keywords[0]);
 
     for (size_t i = 0; i < numKeywords; ++i) {
@@ -57,6 +57,7 @@ void test_numbers(void) {
 
         assert(token.type == expectedTokens[i]);
         assert(strcmp(token.start, input) == 0);
+        assert(token.length == (int)strlen(input));
 
         token = getNextToken(&lexer);
         assert(token.type == TEof);
@@ -83,10 +84,34 @@ void test_operator(void) {
     }
 }
 
+void test_comments(void) {
+    Lexer lexer;
+    Token token;
+    char input[] = "x // note\ny / z";
+
+    initLexer(&lexer, input);
+    assert(getNextToken(&lexer).type == TIdentifier);
+    token = getNextToken(&lexer);
+    assert(token.type == TIdentifier && token.line == 2);
+    assert(getNextToken(&lexer).type == TSlash);
+    assert(getNextToken(&lexer).type == TIdentifier);
+
+    initLexer(&lexer, input);
+    lexer.keepComments = 1;
+    assert(getNextToken(&lexer).type == TIdentifier);
+    token = getNextToken(&lexer);
+    assert(token.type == TComment);
+    assert(token.length == 7 && strncmp(token.start, "// note", 7) == 0);
+    assert(token.line == 1 && token.column == 3);
+    token = getNextToken(&lexer);
+    assert(token.type == TIdentifier && token.line == 2 && token.column == 1);
+}
+
 int main(void) {
     test_identifier();
     test_keyword();
     test_numbers();
     test_operator();
+    test_comments();
     return 0;
 }
@@ -0,0 +1,242 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/libobsidian_tests.h"
+#include "../src/include/obsidian.h"
+
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/resource.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#define THREAD_COUNT 8
+#define ROUNDS 25
+
+static const char program[] = "fn square(i32 x) i32 { return x * x; }\n"
+                              "fn main() { i32 s = 0; for (i32 i = 0; i < 10; i++) { s += square(i); } println(s); }";
+
+/* Records the diagnostics delivered to a handler. */
+typedef struct {
+    int count;
+    ObsidianDiagnosticKind kind;
+    int line, column;
+    char file[32];
+    char text[32];
+} Collected;
+
+static void collect(const ObsidianDiagnostic *diagnostic, void *userData) {
+    Collected *collected = userData;
+    if (collected->count++ > 0) return;
+    collected->kind = diagnostic->kind;
+    collected->line = diagnostic->line;
+    collected->column = diagnostic->column;
+    snprintf(collected->file, sizeof(collected->file), "%s", diagnostic->file);
+    snprintf(collected->text, sizeof(collected->text), "%.*s", (int)diagnostic->textLength, diagnostic->text);
+}
+
+/* Checks a source with a fresh handler and returns what it received. */
+static Collected check(ObsidianSession *session, const char *source, int expected) {
+    Collected collected;
+    memset(&collected, 0, sizeof(collected));
+    obsidianSetDiagnosticHandler(session, collect, &collected);
+    assert(obsidianCheck(session, "test.ob", source, strlen(source)) == expected);
+    return collected;
+}
+
+void test_library_compile(void) {
+    ObsidianSession *session = obsidianCreateSession();
+    char *text;
+    size_t size;
+
+    assert(session != NULL);
+    assert(strcmp(obsidianVersion(), "0.1.0") == 0);
+    assert(check(session, program, 0).count == 0);
+
+    obsidianSetOptimizationLevel(session, 9);
+    assert(obsidianCompileToAssembly(session, NULL, program, strlen(program), &text, &size) == 0);
+    assert(text != NULL && strlen(text) == size);
+    assert(strstr(text, "\t.globl\tmain\n") != NULL);
+    obsidianFree(text);
+
+    /* The source need not be NUL-terminated. */
+    assert(obsidianCompileToAssembly(session, NULL, "fn main() {}garbage", 12, &text, NULL) == 0);
+    obsidianFree(text);
+    obsidianDestroySession(session);
+    obsidianDestroySession(NULL);
+}
+
+void test_library_diagnostics(void) {
+    ObsidianSession *session = obsidianCreateSession();
+    Collected collected;
+    char *text;
+
+    assert(session != NULL);
+    collected = check(session, "fn main() { i32 x = 1 $ 2; }", 1);
+    assert(collected.count == 1 && collected.kind == OBSIDIAN_LEXICAL_ERROR);
+    assert(strcmp(collected.file, "test.ob") == 0 && strcmp(collected.text, "$") == 0);
+
+    collected = check(session, "fn main() {\n  i32 x = ;\n}", 1);
+    assert(collected.count >= 1 && collected.kind == OBSIDIAN_SYNTAX_ERROR && collected.line == 2);
+
+    collected = check(session, "fn main() { i32 x = y; bool b = 1; }", 1);
+    assert(collected.count == 2 && collected.kind == OBSIDIAN_SEMANTIC_ERROR && strcmp(collected.text, "y") == 0);
+
+    /* Without a handler, diagnostics are dropped rather than printed. */
+    obsidianSetDiagnosticHandler(session, NULL, NULL);
+    assert(obsidianCompileToAssembly(session, "test.ob", "fn main() { x; }", 16, &text, NULL) == 1);
+    assert(text == NULL);
+    obsidianDestroySession(session);
+}
+
+void test_library_imports(void) {
+    const char *source = "import libobsidian_tests_lib;\nfn main() { println(cube(3)); }";
+    ObsidianSession *session = obsidianCreateSession();
+    Collected collected;
+    FILE *file;
+    char *text;
+
+    assert(session != NULL);
+
+    /* Without an import directory, an import is rejected at the module name. */
+    collected = check(session, source, 1);
+    assert(collected.count == 1 && collected.kind == OBSIDIAN_SEMANTIC_ERROR);
+    assert(collected.line == 1 && collected.column == 8 && strcmp(collected.text, "libobsidian_tests_lib") == 0);
+
+    assert(obsidianSetImportDirectory(session, "libobsidian_tests_missing") == 0);
+    collected = check(session, source, 1);
+    assert(collected.count == 1 && strcmp(collected.text, "libobsidian_tests_lib") == 0);
+
+    /* The interface the command-line compiler writes beside the module resolves the call. */
+    file = fopen("libobsidian_tests_lib.ob", "w");
+    assert(file != NULL);
+    fputs("export fn cube(i32 x) i32 { return x * x * x; }\n", file);
+    assert(fclose(file) == 0);
+    assert(system("../src/obsidian -c libobsidian_tests_lib.ob -o libobsidian_tests_lib.o") == 0);
+
+    assert(obsidianSetImportDirectory(session, ".") == 0);
+    assert(check(session, source, 0).count == 0);
+    assert(obsidianCompileToAssembly(session, NULL, source, strlen(source), &text, NULL) == 0);
+    assert(strstr(text, "cube") != NULL);
+    obsidianFree(text);
+
+    assert(obsidianSetImportDirectory(session, NULL) == 0);
+    assert(check(session, source, 1).count == 1);
+    obsidianDestroySession(session);
+    remove("libobsidian_tests_lib.ob");
+    remove("libobsidian_tests_lib.o");
+    remove("libobsidian_tests_lib.obi");
+}
+
+#ifndef _WIN32
+
+/* Compiles the test program repeatedly in a session of its own. */
+static void *compileRepeatedly(void *argument) {
+    const char *expected = argument;
+    ObsidianSession *session = obsidianCreateSession();
+    Collected collected;
+
+    assert(session != NULL);
+    obsidianSetOptimizationLevel(session, 2);
+    for (int round = 0; round < ROUNDS; round++) {
+        char *text;
+        assert(obsidianCompileToAssembly(session, NULL, program, strlen(program), &text, NULL) == 0);
+        assert(strcmp(text, expected) == 0);
+        obsidianFree(text);
+
+        collected = check(session, "fn main() {\n  u8 c = true;\n}", 1);
+        assert(collected.count == 1 && collected.line == 2 && collected.column == 10);
+    }
+    obsidianDestroySession(session);
+    return NULL;
+}
+
+#endif
+
+void test_library_threads(void) {
+#ifndef _WIN32
+    ObsidianSession *session = obsidianCreateSession();
+    pthread_t threads[THREAD_COUNT];
+    char *expected;
+
+    assert(session != NULL);
+    obsidianSetOptimizationLevel(session, 2);
+    assert(obsidianCompileToAssembly(session, NULL, program, strlen(program), &expected, NULL) == 0);
+    obsidianDestroySession(session);
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        assert(pthread_create(&threads[i], NULL, compileRepeatedly, expected) == 0);
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        assert(pthread_join(threads[i], NULL) == 0);
+    }
+    obsidianFree(expected);
+#endif
+}
+
+#ifdef __linux__
+/* Checks a source in a child process whose address space may grow by `margin` bytes; returns the child's exit status. */
+static int checkWithin(const char *source, size_t margin) {
+    pid_t child = fork();
+    int status;
+
+    assert(child >= 0);
+    if (child == 0) {
+        ObsidianSession *session = obsidianCreateSession();
+        FILE *statm = fopen("/proc/self/statm", "r");
+        struct rlimit limit;
+        size_t used;
+
+        if (session == NULL || statm == NULL || fscanf(statm, "%zu", &used) != 1) _exit(3);
+        fclose(statm);
+        limit.rlim_cur = limit.rlim_max = used * (size_t)sysconf(_SC_PAGESIZE) + margin;
+        if (setrlimit(RLIMIT_AS, &limit) != 0) _exit(3);
+        switch (obsidianCheck(session, NULL, source, strlen(source))) {
+            case 0: _exit(0);
+            case -1: _exit(1);
+            default: _exit(2);
+        }
+    }
+    assert(waitpid(child, &status, 0) == child);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+#endif
+
+void test_library_out_of_memory(void) {
+#ifdef __linux__
+    const char *function = "fn fNNNNN(i32 x) i32 { i32 y = x * 2 + 1; if (y > 3) { y = y - x; } return y; }\n";
+    size_t count = 8000, length = strlen(function), margin = 0;
+    char *source = malloc(count * length + 1);
+    int failed = 0, status;
+
+    /* Memory running out at any point makes the check return -1 instead of ending the process. This
+     * runs before the other tests, which would leave free memory in the heap for the children to use. */
+    assert(source != NULL);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(source + i * length, function, length);
+        snprintf(source + i * length + 4, 6, "%05zu", i);
+        source[i * length + 9] = '(';
+    }
+    source[count * length] = '\0';
+    while ((status = checkWithin(source, margin)) == 1) {
+        failed++;
+        margin += margin / 8 + ((size_t)256 << 10);
+    }
+    assert(status == 0 && failed > 0);
+    free(source);
+#endif
+}
+
+int main(void) {
+    test_library_out_of_memory();
+    test_library_compile();
+    test_library_diagnostics();
+    test_library_imports();
+    test_library_threads();
+    return 0;
+}
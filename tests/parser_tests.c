@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/parser_tests.h"
+#include "../src/include/compiler.h"
+#include "../src/include/error.h"
+#include "../src/include/parser.h"
+
+static const char *indexPath = "parser_tests.ob";
+
+/* Everything a lazily parsed program refers to, which must outlive it. */
+typedef struct {
+    InternTable symbols;
+    TokenStream stream;
+    Arena arena;
+    Parser parser;
+    Program program;
+    DiagnosticSink sink;
+    int errors;
+    char *source;
+} Parsed;
+
+static void countDiagnostic(const Diagnostic *diagnostic, void *context) {
+    (void)diagnostic;
+    ((Parsed *)context)->errors++;
+}
+
+/* Parses the declarations of a program, skipping the bodies; returns the result of parseProgram. */
+static int parseLazily(Parsed *parsed, const char *source) {
+    parsed->source = malloc(strlen(source) + 1);
+    assert(parsed->source != NULL);
+    strcpy(parsed->source, source);
+    parsed->errors = 0;
+    parsed->sink.report = countDiagnostic;
+    parsed->sink.context = parsed;
+
+    initInternTable(&parsed->symbols);
+    initArena(&parsed->arena);
+    assert(tokenize(parsed->source, &parsed->symbols, &parsed->stream, NULL) == 0);
+    initParser(&parsed->parser, &parsed->stream, &parsed->arena);
+    parsed->parser.diagnostics = &parsed->sink;
+    parsed->parser.lazyBodies = 1;
+    return parseProgram(&parsed->parser, &parsed->program);
+}
+
+static void freeParsed(Parsed *parsed) {
+    freeArena(&parsed->arena);
+    freeTokenStream(&parsed->stream);
+    freeInternTable(&parsed->symbols);
+    free(parsed->source);
+}
+
+void test_parser_lazy_bodies(void) {
+    Parsed parsed;
+    const FnDecl *fns;
+
+    assert(parseLazily(&parsed, "import util;\n"
+                                "fn add(i32 a, i32 b) i32 { if (a > b) { return a; } return a + b; }\n"
+                                "export fn twice(f64 x) f64 { return x * 2.0; }\n"
+                                "fn main() { println(add(1, 2)); }") == 0);
+    fns = parsed.program.fns;
+    assert(parsed.program.importCount == 1 && parsed.program.fnCount == 3);
+
+    /* Signatures are complete; bodies are only token ranges from '{' to past '}'. */
+    assert(fns[0].paramCount == 2 && fns[0].returnType == TypeI32 && !fns[0].exported);
+    assert(fns[1].paramCount == 1 && fns[1].params[0].type == TypeF64 && fns[1].exported);
+    for (int i = 0; i < 3; i++) {
+        assert(fns[i].body == NULL);
+        assert(parsed.stream.tokens[fns[i].bodyStart].type == TLbrace);
+        assert(parsed.stream.tokens[fns[i].bodyEnd - 1].type == TRbrace);
+    }
+    assert(parsed.stream.tokens[fns[0].bodyEnd].type == TExport);
+
+    /* A body is parsed on request, and only once. */
+    assert(parseFunctionBody(&parsed.parser, &parsed.program.fns[0]) == 0);
+    assert(fns[0].body != NULL && fns[0].body->kind == StmtBlock && fns[0].body->as.block.count == 2);
+    assert(fns[0].body->as.block.items[0]->kind == StmtIf);
+    {
+        Stmt *body = fns[0].body;
+        assert(parseFunctionBody(&parsed.parser, &parsed.program.fns[0]) == 0 && fns[0].body == body);
+    }
+    assert(fns[1].body == NULL && fns[2].body == NULL);
+    freeParsed(&parsed);
+}
+
+void test_parser_lazy_errors(void) {
+    Parsed parsed;
+
+    /* Errors inside a skipped body are only reported when the body is parsed. */
+    assert(parseLazily(&parsed, "fn bad() { println(1 +); }\nfn good() i32 { return 1; }") == 0);
+    assert(parsed.errors == 0);
+    assert(parseFunctionBody(&parsed.parser, &parsed.program.fns[1]) == 0);
+    assert(parseFunctionBody(&parsed.parser, &parsed.program.fns[0]) == 1);
+    assert(parsed.errors == 1 && parsed.parser.hadError);
+    freeParsed(&parsed);
+
+    /* Errors in declarations and unclosed bodies are found without parsing any body. */
+    assert(parseLazily(&parsed, "fn a( { }\nfn b() i32 { return 2; }") == 1);
+    assert(parsed.errors == 1 && parsed.program.fnCount == 2);
+    assert(parsed.program.fns[0].hasErrors && !parsed.program.fns[1].hasErrors);
+    freeParsed(&parsed);
+    assert(parseLazily(&parsed, "fn a() { if (true) { println(1); }\n") == 1);
+    assert(parsed.errors == 1);
+    freeParsed(&parsed);
+}
+
+void test_parser_lazy_compile(void) {
+    Parsed parsed;
+    IrModule ir;
+
+    /* Once every body is parsed, a lazily parsed program compiles like an eagerly parsed one. */
+    assert(parseLazily(&parsed, "fn sq(i32 x) i32 { return x * x; }\nfn main() i32 { return sq(4) + 1; }") == 0);
+    assert(parseFunctionBodies(&parsed.parser, &parsed.program) == 0);
+    initIrModule(&ir);
+    assert(compileProgram(&parsed.program, &parsed.symbols, &ir, NULL) == 0);
+    assert(ir.functionCount == 2);
+    freeIrModule(&ir);
+    freeParsed(&parsed);
+}
+
+void test_parser_index_errors(void) {
+    char output[1024];
+    size_t length;
+    FILE *file = fopen(indexPath, "w");
+
+    assert(file != NULL);
+    fputs("fn h(i32) { }\nfn g(i32 x) i32 { return x; }\nfn (i32 y) { }\nfn k( {\n", file);
+    fclose(file);
+
+    /* --index leaves out declarations with syntax errors instead of printing their missing names. */
+    file = popen("../src/obsidian --index parser_tests.ob 2>/dev/null", "r");
+    assert(file != NULL);
+    length = fread(output, 1, sizeof(output) - 1, file);
+    output[length] = '\0';
+    assert(pclose(file) != 0);
+    assert(length > 0 && strchr(output, '\n') == output + length - 1);
+    assert(strstr(output, "parser_tests.ob:2:4: fn g(i32 x) i32 lines 2-2\n") != NULL);
+    remove(indexPath);
+}
+
+void test_parser_lexical_errors(void) {
+    char output[2048];
+    size_t length;
+    FILE *file = fopen(indexPath, "w");
+
+    assert(file != NULL);
+    fputs("fn main() { i32 a = 1 $ 2; println(a); }\n", file);
+    fclose(file);
+
+    /* A file with lexical errors is not parsed, so the errors are not followed by ones the parser makes up. */
+    file = popen("../src/obsidian --run parser_tests.ob 2>&1", "r");
+    assert(file != NULL);
+    length = fread(output, 1, sizeof(output) - 1, file);
+    output[length] = '\0';
+    assert(pclose(file) != 0);
+    assert(strstr(output, "Unexpected character") != NULL);
+    assert(strstr(output, "Syntax Error") == NULL);
+    remove(indexPath);
+}
+
+int main(void) {
+    test_parser_lazy_bodies();
+    test_parser_lazy_errors();
+    test_parser_lazy_compile();
+    test_parser_index_errors();
+    test_parser_lexical_errors();
+    return 0;
+}
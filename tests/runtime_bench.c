@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/include/runtime.h"
+
+/* Compares the runtime allocator with the C library's malloc. Each workload
+ * runs on one thread and then on several at once; the time is wall-clock
+ * time for the whole run, so it shows contention between threads as well. */
+
+#define OPERATIONS 2000000
+#define WINDOW 1024
+#define RING 256
+
+typedef struct {
+    const char *name;
+    void *(*alloc)(size_t size);
+    void (*release)(void *pointer);
+} Allocator;
+
+typedef struct {
+    const Allocator *allocator;
+    void *slots[RING];
+    size_t head, tail;      /* Updated atomically: written by the producer and the consumer respectively. */
+} Channel;
+
+static const Allocator allocators[] = {
+    { "obsidian", obsidianAlloc, obsidianDealloc },
+    { "malloc", malloc, free },
+};
+
+/* Size of the n-th request: mostly small, now and then a few kilobytes. */
+static size_t requestSize(unsigned n) {
+    n = n * 2654435761u;
+    return (n >> 28) == 0 ? 4096 + (n & 4095) : 16 + ((n >> 8) & 255);
+}
+
+/* Keeps a sliding window of live blocks, releasing the oldest as each new one is made. */
+static void *churn(void *argument) {
+    const Allocator *allocator = argument;
+    void **window = calloc(WINDOW, sizeof(void *));
+
+    for (unsigned i = 0; i < OPERATIONS; i++) {
+        unsigned slot = i % WINDOW;
+        allocator->release(window[slot]);
+        window[slot] = allocator->alloc(requestSize(i));
+        *(volatile char *)window[slot] = 1;
+    }
+    for (unsigned i = 0; i < WINDOW; i++) allocator->release(window[i]);
+    free(window);
+    return NULL;
+}
+
+/* Allocates blocks and hands them to the consumer through a ring. */
+static void *produce(void *argument) {
+    Channel *channel = argument;
+
+    for (unsigned i = 0; i < OPERATIONS; i++) {
+        size_t head = channel->head;
+        while (head - __atomic_load_n(&channel->tail, __ATOMIC_ACQUIRE) == RING) {
+            sched_yield();
+        }
+        channel->slots[head % RING] = channel->allocator->alloc(requestSize(i));
+        __atomic_store_n(&channel->head, head + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* Releases the blocks the producer made, on a different thread. */
+static void *consume(void *argument) {
+    Channel *channel = argument;
+
+    for (unsigned i = 0; i < OPERATIONS; i++) {
+        size_t tail = channel->tail;
+        while (__atomic_load_n(&channel->head, __ATOMIC_ACQUIRE) == tail) {
+            sched_yield();
+        }
+        channel->allocator->release(channel->slots[tail % RING]);
+        __atomic_store_n(&channel->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/* Runs churn on a number of threads and returns the nanoseconds per operation. */
+static double benchChurn(const Allocator *allocator, int threads) {
+    pthread_t ids[64];
+    double start = now();
+
+    for (int i = 0; i < threads; i++) pthread_create(&ids[i], NULL, churn, (void *)allocator);
+    for (int i = 0; i < threads; i++) pthread_join(ids[i], NULL);
+    return (now() - start) * 1e9 / OPERATIONS;
+}
+
+/* Runs producer and consumer pairs and returns the nanoseconds per block passed. */
+static double benchRemote(const Allocator *allocator, int pairs) {
+    pthread_t ids[64];
+    Channel *channels = calloc((size_t)pairs, sizeof(Channel));
+    double start = now();
+
+    for (int i = 0; i < pairs; i++) {
+        channels[i].allocator = allocator;
+        pthread_create(&ids[2 * i], NULL, produce, &channels[i]);
+        pthread_create(&ids[2 * i + 1], NULL, consume, &channels[i]);
+    }
+    for (int i = 0; i < 2 * pairs; i++) pthread_join(ids[i], NULL);
+    free(channels);
+    return (now() - start) * 1e9 / OPERATIONS;
+}
+
+/* Keeps a large live set of blocks of one size, replacing one picked at random
+ * each time; returns the nanoseconds per replacement. */
+static double benchRandom(const Allocator *allocator, unsigned live, size_t size) {
+    void **blocks = malloc(live * sizeof(void *));
+    unsigned state = 2463534242u;
+    double start;
+
+    for (unsigned i = 0; i < live; i++) {
+        blocks[i] = allocator->alloc(size);
+        *(volatile char *)blocks[i] = 1;
+    }
+    start = now();
+    for (unsigned i = 0; i < OPERATIONS; i++) {
+        unsigned slot;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        slot = state % live;
+        allocator->release(blocks[slot]);
+        blocks[slot] = allocator->alloc(size);
+        *(volatile char *)blocks[slot] = 1;
+    }
+    start = now() - start;
+    for (unsigned i = 0; i < live; i++) allocator->release(blocks[i]);
+    free(blocks);
+    return start * 1e9 / OPERATIONS;
+}
+
+int main(void) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = processors < 2 ? 2 : processors > 32 ? 32 : (int)processors;
+
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+        const Allocator *allocator = &allocators[i];
+        fprintf(stderr, "%-8s churn    1 thread:  %7.1f ns/op\n", allocator->name, benchChurn(allocator, 1));
+        fprintf(stderr, "%-8s churn   %2d threads: %7.1f ns/op\n", allocator->name, threads, benchChurn(allocator, threads));
+        fprintf(stderr, "%-8s remote  %2d pairs:   %7.1f ns/op\n", allocator->name, threads / 2,
+                benchRemote(allocator, threads / 2));
+        fprintf(stderr, "%-8s random  100k x 2 KB:  %7.1f ns/op\n", allocator->name, benchRandom(allocator, 100000, 2048));
+        fprintf(stderr, "%-8s random  16k x 60 KB:  %7.1f ns/op\n", allocator->name, benchRandom(allocator, 16384, 60 << 10));
+    }
+    return EXIT_SUCCESS;
+}
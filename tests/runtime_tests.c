@@ -0,0 +1,146 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include "include/runtime_tests.h"
+#include "../src/include/runtime.h"
+
+#define THREADS 4
+#define BLOCKS 20000
+
+static void *blocks[THREADS][BLOCKS];
+
+/* Size of the block allocated for a given index, cycling through the small classes. */
+static size_t blockSize(int index) {
+    return (size_t)(index * 37 % 1024) + 1;
+}
+
+void test_runtime_sizes(void) {
+    for (size_t size = 0; size <= RUNTIME_MAX_SMALL + 64; size += size < 512 ? 1 : 127) {
+        unsigned char *first = obsidianAlloc(size), *second = obsidianAlloc(size);
+        assert(first != NULL && second != NULL && first != second);
+        assert((uintptr_t)first % RUNTIME_ALIGNMENT == 0 && (uintptr_t)second % RUNTIME_ALIGNMENT == 0);
+        assert(obsidianAllocSize(first) >= size);
+        assert(size <= 128 || obsidianAllocSize(first) - size < size / 4 + RUNTIME_ALIGNMENT);
+        memset(first, 0xa5, size);
+        memset(second, 0x5a, size);
+        assert(size == 0 || (first[size - 1] == 0xa5 && second[0] == 0x5a));
+        obsidianDealloc(second);
+        obsidianDealloc(first);
+    }
+    obsidianDealloc(NULL);
+}
+
+void test_runtime_reuse(void) {
+    unsigned char *pointers[100], *block;
+
+    for (int i = 0; i < 100; i++) pointers[i] = obsidianAlloc(48);
+    for (int i = 0; i < 100; i++) obsidianDealloc(pointers[i]);
+    for (int i = 99; i >= 0; i--) assert(obsidianAlloc(48) == pointers[i]);
+    for (int i = 0; i < 100; i++) obsidianDealloc(pointers[i]);
+
+    block = obsidianAlloc(200);
+    memset(block, 0xff, 200);
+    obsidianDealloc(block);
+    assert(obsidianNew(200) == block);
+    for (int i = 0; i < 200; i++) assert(block[i] == 0);
+    obsidianDealloc(block);
+}
+
+void test_runtime_large(void) {
+    size_t size = 3 * RUNTIME_SLAB_SIZE + 1;
+    unsigned char *block = obsidianNew(size);
+
+    assert(block != NULL && (uintptr_t)block % RUNTIME_ALIGNMENT == 0);
+    assert(obsidianAllocSize(block) >= size);
+    assert(block[0] == 0 && block[size - 1] == 0);
+    block[0] = block[size - 1] = 1;
+    obsidianDealloc(block);
+    assert(obsidianAlloc(SIZE_MAX - 16) == NULL);
+}
+
+void test_runtime_random(void) {
+    static unsigned *live[3000];
+    unsigned state = 2463534242u;
+
+    /* Blocks freed at random into full slabs must be found again without overlapping live ones. */
+    for (unsigned i = 0; i < 3000; i++) {
+        live[i] = obsidianAlloc(2048);
+        live[i][0] = live[i][511] = i;
+    }
+    for (int n = 0; n < 200000; n++) {
+        unsigned slot;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        slot = state % 3000;
+        assert(live[slot][0] == slot && live[slot][511] == slot);
+        obsidianDealloc(live[slot]);
+        live[slot] = obsidianAlloc(2048);
+        assert(live[slot] != NULL);
+        live[slot][0] = live[slot][511] = slot;
+    }
+    for (unsigned i = 0; i < 3000; i++) {
+        assert(live[i][0] == i && live[i][511] == i);
+        obsidianDealloc(live[i]);
+    }
+}
+
+/* Fills the blocks of one thread with its number. */
+static void *allocBlocks(void *argument) {
+    int thread = (int)(intptr_t)argument;
+
+    for (int i = 0; i < BLOCKS; i++) {
+        blocks[thread][i] = obsidianAlloc(blockSize(i));
+        assert(blocks[thread][i] != NULL);
+        memset(blocks[thread][i], thread + 1, blockSize(i));
+    }
+    return NULL;
+}
+
+/* Checks and releases the blocks of the next thread, which are owned by another heap. */
+static void *freeBlocks(void *argument) {
+    int thread = ((int)(intptr_t)argument + 1) % THREADS;
+
+    for (int i = 0; i < BLOCKS; i++) {
+        const unsigned char *block = blocks[thread][i];
+        assert(block[0] == thread + 1 && block[blockSize(i) - 1] == thread + 1);
+        obsidianDealloc(blocks[thread][i]);
+    }
+    return NULL;
+}
+
+/* Runs one function on every thread and waits for them. */
+static void runThreads(void *(*function)(void *)) {
+    pthread_t threads[THREADS];
+
+    for (int i = 0; i < THREADS; i++) assert(pthread_create(&threads[i], NULL, function, (void *)(intptr_t)i) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+}
+
+void test_runtime_threads(void) {
+    for (int round = 0; round < 3; round++) {
+        runThreads(allocBlocks);
+        for (int thread = 0; thread < THREADS; thread++) {
+            for (int i = 1; i < BLOCKS; i++) assert(blocks[thread][i] != blocks[thread][i - 1]);
+        }
+        runThreads(freeBlocks);
+    }
+
+    /* Blocks released by the main thread go back to the heaps the exited threads left behind. */
+    runThreads(allocBlocks);
+    for (int thread = 0; thread < THREADS; thread++) {
+        for (int i = 0; i < BLOCKS; i++) obsidianDealloc(blocks[thread][i]);
+    }
+    runThreads(allocBlocks);
+    runThreads(freeBlocks);
+}
+
+int main(void) {
+    test_runtime_sizes();
+    test_runtime_reuse();
+    test_runtime_large();
+    test_runtime_random();
+    test_runtime_threads();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/include/cache.h"
+#include "../src/include/common.h"
+#include "../src/include/compiler.h"
+#include "../src/include/lower.h"
+#include "../src/include/parser.h"
+#include "../src/include/passes.h"
+
+/* Times the `main` function of each program given on the command line at
+ * -O0 and -O2. Compilation is done once; only execution is measured, so the
+ * numbers track interpreter dispatch and the optimizer's effect on it. */
+static int benchmark(const char *path, int level, int iterations) {
+    InternTable symbols;
+    TokenStream stream;
+    Arena arena;
+    Parser parser;
+    Program program;
+    IrModule ir;
+    Module module;
+    VM vm;
+    size_t length;
+    char *source = readFile(path, &length);
+    int index, status = -1;
+
+    if (source == NULL) {
+        fprintf(stderr, "vm_bench: could not read '%s'\n", path);
+        return -1;
+    }
+    initInternTable(&symbols);
+    initArena(&arena);
+    initIrModule(&ir);
+    initModule(&module);
+
+    if (tokenize(source, &symbols, &stream, NULL) == 0) {
+        initParser(&parser, &stream, &arena);
+        if (parseProgram(&parser, &program) == 0 && compileProgram(&program, &symbols, &ir, NULL) == 0 &&
+            (optimizeModule(&ir, level, NULL), lowerModule(&ir, &module) == 0) &&
+            (index = findFunction(&program, &symbols, "main")) >= 0 && initVM(&vm) == 0) {
+            double best = 0.0;
+            for (int i = 0; i < iterations; i++) {
+                clock_t start = clock();
+                status = vmCall(&vm, &module, index, NULL, NULL);
+                double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+                if (status != 0) break;
+                if (i == 0 || seconds < best) best = seconds;
+            }
+            if (status == 0) fprintf(stderr, "%-24s -O%d best of %d: %8.2f ms\n", path, level, iterations, best * 1000.0);
+            freeVM(&vm);
+        }
+        freeTokenStream(&stream);
+    }
+
+    freeModule(&module);
+    freeIrModule(&ir);
+    freeArena(&arena);
+    freeInternTable(&symbols);
+    free(source);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (benchmark(argv[i], 0, 5) != 0 || benchmark(argv[i], 2, 5) != 0) failed = 1;
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
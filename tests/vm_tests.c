@@ -0,0 +1,264 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/vm_tests.h"
+#include "../src/include/cache.h"
+#include "../src/include/compiler.h"
+#include "../src/include/lower.h"
+#include "../src/include/parser.h"
+#include "../src/include/passes.h"
+#include "../src/include/scope.h"
+
+typedef struct {
+    char *source;
+    InternTable symbols;
+    TokenStream stream;
+    Arena arena;
+    Program program;
+    IrModule ir;
+    Module module;
+} Compiled;
+
+static int compileAt(Compiled *compiled, const char *source, int level) {
+    Parser parser;
+    int status;
+
+    compiled->source = malloc(strlen(source) + 1);
+    assert(compiled->source != NULL);
+    strcpy(compiled->source, source);
+    initInternTable(&compiled->symbols);
+    initArena(&compiled->arena);
+    initIrModule(&compiled->ir);
+    initModule(&compiled->module);
+    assert(tokenize(compiled->source, &compiled->symbols, &compiled->stream, NULL) == 0);
+
+    initParser(&parser, &compiled->stream, &compiled->arena);
+    status = parseProgram(&parser, &compiled->program);
+    if (status == 0) status = compileProgram(&compiled->program, &compiled->symbols, &compiled->ir, NULL);
+    if (status == 0) optimizeModule(&compiled->ir, level, NULL);
+    if (status == 0) status = lowerModule(&compiled->ir, &compiled->module);
+    return status;
+}
+
+static int compile(Compiled *compiled, const char *source) {
+    return compileAt(compiled, source, 0);
+}
+
+static void release(Compiled *compiled) {
+    freeModule(&compiled->module);
+    freeIrModule(&compiled->ir);
+    freeArena(&compiled->arena);
+    freeTokenStream(&compiled->stream);
+    freeInternTable(&compiled->symbols);
+    free(compiled->source);
+}
+
+static int call(Compiled *compiled, const char *name, const Slot *args, Slot *result) {
+    VM vm;
+    int index = findFunction(&compiled->program, &compiled->symbols, name);
+    int status;
+
+    assert(index >= 0);
+    assert(initVM(&vm) == 0);
+    status = vmCall(&vm, &compiled->module, index, args, result);
+    freeVM(&vm);
+    return status;
+}
+
+/* Runs a function at every optimization level; all levels must agree. */
+static Slot run(const char *source, const char *name, const Slot *args) {
+    Compiled compiled;
+    Slot result, expected;
+    TypeKind type;
+
+    expected.u64 = 0;
+    for (int level = 0; level <= OPT_LEVEL_MAX; level++) {
+        assert(compileAt(&compiled, source, level) == 0);
+        result.u64 = 0;
+        assert(call(&compiled, name, args, &result) == 0);
+        type = compiled.module.functions[findFunction(&compiled.program, &compiled.symbols, name)].returnType;
+        release(&compiled);
+        if (level == 0) expected = result;
+        if (type == TypeI64 || type == TypeU64 || type == TypeF64) assert(result.u64 == expected.u64);
+        else assert(result.u32 == expected.u32);
+    }
+    return expected;
+}
+
+static int countOps(const IrFunction *fn, IrOp op) {
+    int count = 0;
+    for (int b = 0; b < fn->blockCount; b++) {
+        for (int i = 0; i < fn->blocks[b].insnCount; i++) {
+            if (fn->insns[fn->blocks[b].insns[i]].op == op) count++;
+        }
+    }
+    return count;
+}
+
+void test_parse_program(void) {
+    Compiled compiled;
+    const FnDecl *fn;
+
+    assert(compile(&compiled, "import io;\nexport fn add(i32 a, i64 b) i64 { return cast(a, i64) + b; }\nfn main() { }") == 0);
+    assert(compiled.program.importCount == 1);
+    assert(compiled.program.fnCount == 2);
+
+    fn = &compiled.program.fns[0];
+    assert(fn->exported && fn->paramCount == 2);
+    assert(fn->params[0].type == TypeI32 && fn->params[1].type == TypeI64);
+    assert(fn->returnType == TypeI64);
+    assert(fn->body->kind == StmtBlock && fn->body->as.block.count == 1);
+    assert(fn->body->as.block.items[0]->kind == StmtReturn);
+    assert(compiled.program.fns[1].returnType == TypeVoid);
+    release(&compiled);
+
+    assert(compile(&compiled, "fn main() i32 { return 1 + ; }") != 0);
+    release(&compiled);
+}
+
+void test_vm_arithmetic(void) {
+    Slot args[2];
+
+    assert(run("fn f() i32 { return 2 + 3 * 4 - 10 / 3; }", "f", NULL).i32 == 11);
+    assert(run("fn f() i32 { return (1 << 4) | 3 ^ 1 & 7; }", "f", NULL).i32 == 18);
+    assert(run("fn f() i32 { return -7 % 3; }", "f", NULL).i32 == -1);
+    assert(run("fn f() u8 { u8 x = 255; x += 2; return x; }", "f", NULL).u32 == 1);
+    assert(run("fn f() i64 { i64 x = 3000000000; return x * 2; }", "f", NULL).i64 == 6000000000LL);
+    assert(run("fn f() f64 { return 7.5 % 2.0; }", "f", NULL).f64 == 1.5);
+    assert(run("fn f() i32 { return cast(3.9, i32) + cast(true, i32); }", "f", NULL).i32 == 4);
+    assert(run("fn f() bool { return 3 > 2 && !(1 >= 2); }", "f", NULL).u32 == 1);
+
+    args[0].f32 = 1.5f;
+    args[1].i32 = 3;
+    assert(run("fn pow(f32 x, i32 n) f32 { f32 r = 1.0; for (i32 i = 0; i < n; i++) { r *= x; } return r; }", "pow", args).f32 == 3.375f);
+}
+
+void test_vm_control_flow(void) {
+    assert(run("fn f() i32 { i32 s = 0; i32 i = 0; while (true) { if (i == 10) { break; } s += i; i++; } return s; }", "f", NULL).i32 == 45);
+    assert(run("fn f() i32 { i32 s = 0; for (i32 i = 0; i < 5; i++) { for (i32 j = 0; j < 5; j++) { if (j > i) { break; } s++; } } return s; }", "f", NULL).i32 == 15);
+    assert(run("fn f() i32 { i32 x = 5; return x > 3 ? x * 2 : 0; }", "f", NULL).i32 == 10);
+    assert(run("fn f() i32 { i32 x = 1; { i32 y = 2; x = x + y; } i32 z = 4; return x + z; }", "f", NULL).i32 == 7);
+    assert(run("fn f() i32 { i32 a = 0; i32 b = a++; i32 c = ++a; return b * 10 + c; }", "f", NULL).i32 == 2);
+}
+
+void test_vm_calls(void) {
+    const char *fib = "fn fib(i32 n) i32 { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }";
+    Slot args[1];
+
+    args[0].i32 = 20;
+    assert(run(fib, "fib", args).i32 == 6765);
+    assert(run("fn add(i32 a, i32 b) i32 { return a + b; }\nfn f() i32 { i32 x = 2; return add(add(x, 3), add(x, x)) * 2; }", "f", NULL).i32 == 18);
+    assert(run("fn f() i32 { return g(); }\nfn g() i32 { return 42; }", "f", NULL).i32 == 42);
+}
+
+void test_vm_errors(void) {
+    Compiled compiled;
+    Slot result;
+
+    assert(compile(&compiled, "fn f() i32 { return true; }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f() i32 { return y; }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f() i32 { return g(1); }\nfn g() i32 { return 0; }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f() { break; }") != 0);
+    release(&compiled);
+
+    /* A non-void function must not run off its end; a void one may. */
+    assert(compile(&compiled, "fn f(i32 x) i32 { if (x > 0) { return 1; } }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f(i32 x) i32 { while (x > 0) { return 1; } }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f(i32 x) i32 { if (x > 0) { return 1; } else { return 2; } }") == 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f(i32 x) i32 { while (true) { if (x > 0) { return x; } x++; } }") == 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f(i32 x) { if (x > 0) { return; } }") == 0);
+    release(&compiled);
+
+    assert(compile(&compiled, "fn f(i32 x) i32 { return 10 / x; }") == 0);
+    result.i32 = 0;
+    assert(call(&compiled, "f", &result, &result) != 0);
+    release(&compiled);
+
+    assert(compile(&compiled, "fn f() i32 { return f(); }") == 0);
+    assert(call(&compiled, "f", NULL, &result) != 0);
+    release(&compiled);
+}
+
+void test_scopes(void) {
+    ScopeStack scopes;
+    Compiled compiled;
+    Slot args[1];
+    char *source = malloc(2000 * 40 + 64);
+    size_t length;
+
+    initScopeStack(&scopes);
+    assert(pushScope(&scopes) == 0);
+    for (uint32_t name = 1; name <= 500; name++) assert(declareSymbol(&scopes, name, (int)name * 2) == 0);
+    assert(declareSymbol(&scopes, 7, 1) == 1);
+    assert(pushScope(&scopes) == 0);
+    assert(declareSymbol(&scopes, 3, -5) == 0);
+    assert(lookupSymbol(&scopes, 3) == -5 && lookupSymbol(&scopes, 7) == 1 && lookupSymbol(&scopes, 500) == 1000);
+    assert(lookupSymbol(&scopes, 501) == -1);
+    popScope(&scopes);
+    assert(lookupSymbol(&scopes, 3) == 6 && scopes.depth == 1);
+    popScope(&scopes);
+    assert(lookupSymbol(&scopes, 3) == -1 && scopes.innermost == NULL);
+    freeScopeStack(&scopes);
+
+    args[0].i32 = 5;
+    assert(run("fn f(i32 x) i32 { i32 y = x; { i32 x = 2; y += x; } return x + y; }", "f", args).i32 == 12);
+    assert(compile(&compiled, "fn f() i32 { { i32 x = 1; } return x; }") != 0);
+    release(&compiled);
+    assert(compile(&compiled, "fn f() { i32 x = 1; f64 x = 2.0; }") != 0);
+    release(&compiled);
+
+    /* Far more locals than any fixed-size table would hold. */
+    assert(source != NULL);
+    length = (size_t)sprintf(source, "fn f() i64 { i64 s = 0; ");
+    for (int i = 0; i < 2000; i++) length += (size_t)sprintf(source + length, "i64 v%d = %d; s += v%d; ", i, i, i);
+    strcpy(source + length, "return s; }");
+    assert(run(source, "f", NULL).i64 == 1999000);
+    free(source);
+}
+
+void test_optimizer(void) {
+    const char *math = "fn square(i32 x) i32 { return x * x; }\n"
+                       "fn f(i32 n) i32 { i32 s = 0; for (i32 i = 0; i < n; i++) { s += square(i) + n * 2; } return s; }";
+    Compiled compiled;
+    Slot args[1], result;
+
+    assert(compileAt(&compiled, "fn f() i32 { i32 x = 6; i32 y = x * 7; if (y > 40) { return y; } return 0; }", 1) == 0);
+    assert(countOps(&compiled.ir.functions[0], IR_CONST) == 1);
+    assert(countOps(&compiled.ir.functions[0], IR_MUL) == 0);
+    assert(countOps(&compiled.ir.functions[0], IR_BRANCH) == 0);
+    release(&compiled);
+
+    assert(compileAt(&compiled, math, 2) == 0);
+    assert(countOps(&compiled.ir.functions[1], IR_CALL) == 0);
+    assert(countOps(&compiled.ir.functions[1], IR_MUL) == 2);
+    args[0].i32 = 10;
+    assert(call(&compiled, "f", args, &result) == 0 && result.i32 == 485);
+    release(&compiled);
+
+    assert(compileAt(&compiled, "fn f(i32 x) i32 { i32 a = x + 1; i32 b = 1 + x; return a * b; }", 2) == 0);
+    assert(countOps(&compiled.ir.functions[0], IR_ADD) == 1);
+    release(&compiled);
+
+    assert(compileAt(&compiled, "fn f() i32 { i32 z = 0; return 1 / z; }", OPT_LEVEL_MAX) == 0);
+    assert(call(&compiled, "f", NULL, &result) != 0);
+    release(&compiled);
+}
+
+int main(void) {
+    test_parse_program();
+    test_vm_arithmetic();
+    test_vm_control_flow();
+    test_vm_calls();
+    test_vm_errors();
+    test_scopes();
+    test_optimizer();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "include/watch_tests.h"
+#include "include/fixture.h"
+
+#if defined(__linux__)
+
+static char output[8192];
+static pid_t watcher;
+
+static void sleepFor(long milliseconds) {
+    struct timespec delay = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+/* Reads what the watcher has printed so far and returns the number of rounds it reported. */
+static int rounds(void) {
+    FILE *file = fopen(inDirectory("watch.log"), "r");
+    size_t length;
+    int count = 0;
+
+    assert(file != NULL);
+    length = fread(output, 1, sizeof(output) - 1, file);
+    output[length] = '\0';
+    fclose(file);
+    for (const char *line = strstr(output, "obsidian: checked "); line != NULL; line = strstr(line + 1, "obsidian: checked ")) count++;
+    return count;
+}
+
+/* Waits until the watcher has reported `count` rounds, then returns the last round's summary. */
+static const char *waitForRound(int count) {
+    const char *last = NULL;
+
+    for (int i = 0; i < 500 && rounds() < count; i++) sleepFor(10);
+    assert(rounds() == count);
+    for (const char *line = strstr(output, "obsidian: checked "); line != NULL; line = strstr(line + 1, "obsidian: checked ")) last = line;
+    return last;
+}
+
+/* Reports whether the last round's summary reads `checked <files>` and `<failed> with errors`. */
+static int roundMatches(const char *summary, const char *files, const char *failed) {
+    const char *end = strchr(summary, '\n');
+    char line[256];
+
+    snprintf(line, sizeof(line), "%.*s", end == NULL ? (int)strlen(summary) : (int)(end - summary), summary);
+    return strncmp(line + strlen("obsidian: checked "), files, strlen(files)) == 0 && strstr(line, failed) != NULL;
+}
+
+/* Starts `obsidian --watch` on the test directory with its messages going to a fresh log. */
+static void startWatcher(void) {
+    int logFd = open(inDirectory("watch.log"), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    assert(logFd >= 0);
+    watcher = fork();
+    assert(watcher >= 0);
+    if (watcher == 0) {
+        dup2(logFd, STDERR_FILENO);
+        execl(compiler, compiler, "--watch", directory, (char *)NULL);
+        _exit(127);
+    }
+    close(logFd);
+}
+
+static void stopWatcher(void) {
+    int status;
+
+    assert(kill(watcher, SIGTERM) == 0);
+    assert(waitpid(watcher, &status, 0) == watcher);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+}
+
+void test_watch_debounce(void) {
+    writeText("lib.ob", "export fn value() i32 { return 1; }\n");
+    startWatcher();
+    assert(roundMatches(waitForRound(1), "1 file", "0 with errors"));
+
+    /* A burst of saves, each well within the quiet time of the one before, is checked once. */
+    for (int i = 0; i < 5; i++) {
+        writeText("lib.ob", "export fn value() i32 { return 2; }\n");
+        sleepFor(5);
+    }
+    assert(roundMatches(waitForRound(2), "1 file", "0 with errors"));
+    sleepFor(200);
+    assert(rounds() == 2);
+
+    stopWatcher();
+}
+
+void test_watch_importers(void) {
+    struct stat info;
+
+    /* The module is checked, and its interface written, before the file that imports it. */
+    writeText("lib.ob", "export fn value() i32 { return 1; }\n");
+    writeText("main.ob", "import lib;\nfn main() i32 { return value(); }\n");
+    remove(inDirectory("lib.obi"));
+    startWatcher();
+    assert(roundMatches(waitForRound(1), "2 files", "0 with errors"));
+    assert(stat(inDirectory("lib.obi"), &info) == 0);
+
+    /* A changed signature rewrites the interface, so the importer is checked again. */
+    writeText("lib.ob", "export fn value(i32 x) i32 { return x; }\n");
+    assert(roundMatches(waitForRound(2), "2 files", "1 with errors"));
+    assert(strstr(output, "main.ob' has errors") != NULL);
+
+    writeText("main.ob", "import lib;\nfn main() i32 { return value(2); }\n");
+    assert(roundMatches(waitForRound(3), "1 file", "0 with errors"));
+
+    /* A change that keeps the interface leaves the importer alone. */
+    writeText("lib.ob", "export fn value(i32 x) i32 { return x + 1; }\n");
+    assert(roundMatches(waitForRound(4), "1 file", "0 with errors"));
+
+    stopWatcher();
+}
+
+int main(void) {
+    const char *files[] = { "lib.ob", "lib.obi", "main.ob", "watch.log" };
+
+    openFixture("watch_tests");
+
+    test_watch_debounce();
+    test_watch_importers();
+
+    closeFixture(files, sizeof(files) / sizeof(files[0]));
+    return 0;
+}
+
+#else
+
+int main(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/x86_tests.h"
+#include "../src/include/compiler.h"
+#include "../src/include/intern.h"
+#include "../src/include/lexer.h"
+#include "../src/include/parser.h"
+#include "../src/include/passes.h"
+#include "../src/include/x86.h"
+
+static const char *asmPath = "x86_tests.s";
+static const char *objectPath = "x86_tests.o";
+static const char *exePath = "./x86_tests.out";
+
+/* Compiles a program to assembly, or encodes it into `object` if that is not NULL; the caller frees the returned text. */
+static char *generate(const char *source, int level, ObjectFile *object) {
+    InternTable symbols;
+    TokenStream stream;
+    Arena arena;
+    Parser parser;
+    Program program;
+    IrModule ir;
+    Writer *writer = malloc(sizeof(Writer));
+    char *copy = malloc(strlen(source) + 1);
+    char *text = NULL;
+    size_t size;
+
+    assert(writer != NULL && copy != NULL);
+    strcpy(copy, source);
+    initInternTable(&symbols);
+    initArena(&arena);
+    initIrModule(&ir);
+    assert(tokenize(copy, &symbols, &stream, NULL) == 0);
+    initParser(&parser, &stream, &arena);
+    assert(parseProgram(&parser, &program) == 0);
+    assert(compileProgram(&program, &symbols, &ir, NULL) == 0);
+    optimizeModule(&ir, level, NULL);
+
+    if (object != NULL) {
+        emitX86Object(&ir, object);
+    } else {
+        initWriter(writer, NULL);
+        emitX86Module(&ir, writer);
+        text = takeWriterMemory(writer, &size);
+        assert(text != NULL && size > 0 && strlen(text) == size);
+    }
+
+    free(writer);
+    freeIrModule(&ir);
+    freeArena(&arena);
+    freeTokenStream(&stream);
+    freeInternTable(&symbols);
+    free(copy);
+    return text;
+}
+
+static char *assemble(const char *source, int level) {
+    return generate(source, level, NULL);
+}
+
+/* Returns the index of the named symbol of an object file, or -1. */
+static int findObjectSymbol(const ObjectFile *object, const char *name) {
+    for (int i = 0; i < object->symbolCount; i++) {
+        if (strcmp((const char *)object->strings.data + object->symbols[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+#if defined(__x86_64__) && defined(__ELF__)
+
+/* Runs the program built by the last test step; it must print `expected`. */
+static void expectRun(const char *expected) {
+    char output[4096];
+    FILE *program = popen(exePath, "r");
+    size_t length;
+
+    assert(program != NULL);
+    length = fread(output, 1, sizeof(output) - 1, program);
+    output[length] = '\0';
+    assert(pclose(program) == 0);
+    assert(strcmp(output, expected) == 0);
+}
+
+/* Builds and runs a program at every optimization level, through the assembler and as a direct object; each run must print `expected`. */
+static void expectOutput(const char *source, const char *expected) {
+    for (int level = 0; level <= OPT_LEVEL_MAX; level++) {
+        char *text = assemble(source, level);
+        FILE *file = fopen(asmPath, "w");
+        ObjectFile object;
+
+        assert(file != NULL);
+        fputs(text, file);
+        fclose(file);
+        free(text);
+        assert(system("${CC:-cc} -o x86_tests.out x86_tests.s -lm") == 0);
+        expectRun(expected);
+
+        initObjectFile(&object);
+        generate(source, level, &object);
+        assert(writeObjectFile(&object, objectPath) == 0);
+        freeObjectFile(&object);
+        assert(system("${CC:-cc} -o x86_tests.out x86_tests.o -lm") == 0);
+        expectRun(expected);
+    }
+    remove(asmPath);
+    remove(objectPath);
+    remove(exePath);
+}
+
+#endif
+
+void test_x86_symbols(void) {
+    char *text = assemble("fn helper(i32 x) i32 { return x + 1; }\n"
+                          "export fn api(i32 x) i32 { return helper(x) * 2; }\n"
+                          "fn main() { println(api(3)); }", 0);
+
+    assert(strstr(text, "\t.globl\tmain\n") != NULL);
+    assert(strstr(text, "\t.globl\tapi\n") != NULL);
+    assert(strstr(text, "helper.ob:\n") != NULL);
+    assert(strstr(text, ".globl\thelper") == NULL);
+    assert(strstr(text, "\tcall\thelper.ob\n") != NULL);
+    assert(strstr(text, "\tcall\tprintf@PLT\n") != NULL);
+    assert(strstr(text, ".note.GNU-stack") != NULL);
+    free(text);
+}
+
+void test_x86_codegen(void) {
+    char *text = assemble("fn f(i32 n) i32 { i32 s = 0; for (i32 i = 0; i < n; i++) { s += i; } return s; }\n"
+                          "fn g(f64 x) f64 { return x * 2.5; }", 1);
+
+    /* The loop condition branches on the flags of its comparison. */
+    assert(strstr(text, "\tcmpl\t") != NULL);
+    assert(strstr(text, "\tsetl\t") == NULL);
+    /* Constants are immediates or read-only data, never registers of their own. */
+    assert(strstr(text, "\tmulsd\t.LC0(%rip), ") != NULL);
+    assert(strstr(text, "\t.quad\t4612811918334230528\n") != NULL);
+    free(text);
+}
+
+void test_x86_object(void) {
+    ObjectFile object;
+    const ObjectSection *text;
+    int helper, api, printfSymbol, found = 0;
+    unsigned char header[20];
+    FILE *file;
+
+    initObjectFile(&object);
+    generate("fn helper(i32 x) i32 { return x + 1; }\n"
+             "export fn api(i32 x) i32 { return helper(x) * 2; }\n"
+             "fn main() { println(api(3)); println(2.5); }", 0, &object);
+    text = &object.sections[OBJECT_TEXT];
+
+    /* Symbols are named as in the assembly, and every function starts with the frame setup. */
+    helper = findObjectSymbol(&object, "helper.ob");
+    api = findObjectSymbol(&object, "api");
+    printfSymbol = findObjectSymbol(&object, "printf");
+    assert(helper >= 0 && !object.symbols[helper].global && object.symbols[helper].section == OBJECT_TEXT);
+    assert(api >= 0 && object.symbols[api].global && object.symbols[api].size > 0);
+    assert(findObjectSymbol(&object, "main") >= 0 && object.symbols[findObjectSymbol(&object, "main")].global);
+    assert(printfSymbol >= 0 && object.symbols[printfSymbol].section == OBJECT_UNDEFINED);
+    assert(text->data[object.symbols[api].value] == 0x55);
+    assert(object.symbols[api].value % 16 == 0);
+
+    /* The call to the local helper is resolved in place; the library call and the constant are not. */
+    for (int i = 0; i < object.relocationCount; i++) {
+        const ObjectRelocation *relocation = &object.relocations[i];
+        assert(relocation->symbol != helper);
+        if (relocation->symbol == printfSymbol) {
+            assert(relocation->type == R_X86_64_PLT32 && relocation->addend == -4);
+            assert(text->data[relocation->offset - 1] == 0xE8);
+            found |= 1;
+        }
+        if (relocation->symbol == OBJECT_SECTION_SYMBOL(OBJECT_RODATA)) {
+            assert(relocation->type == R_X86_64_PC32 && relocation->addend >= -4);
+            found |= 2;
+        }
+    }
+    assert(found == 3);
+    assert(object.sections[OBJECT_RODATA].size >= 8);
+
+    assert(writeObjectFile(&object, objectPath) == 0);
+    freeObjectFile(&object);
+    file = fopen(objectPath, "rb");
+    assert(file != NULL && fread(header, 1, sizeof(header), file) == sizeof(header));
+    fclose(file);
+    remove(objectPath);
+    assert(memcmp(header, "\177ELF\2\1\1", 7) == 0);
+    assert(header[16] == 1 && header[18] == 62);
+}
+
+void test_x86_native(void) {
+#if defined(__x86_64__) && defined(__ELF__)
+    if (system("${CC:-cc} --version >/dev/null 2>&1") != 0) return;
+
+    expectOutput("fn fib(i32 n) i32 { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                 "fn main() { println(fib(20)); println(-7 % 3); println(7.5 % 2.0); }",
+                 "6765\n-1\n1.5\n");
+    expectOutput("fn main() { u8 a = 250; a += 10; println(a); i8 b = 120; b += 10; println(b);\n"
+                 "u64 c = 18446744073709551615; println(c); println(cast(c, f64)); i32 s = 33; println(1 << s); }",
+                 "4\n-126\n18446744073709551615\n1.84467e+19\n2\n");
+    expectOutput("fn main() { f64 z = 0.0; f64 n = z / z; println(n == n); println(n != n); println(n < 1.0);\n"
+                 "if (n != n) { println(\"nan\"); } println(cast(-2.5, i32)); println(true); println('x'); }",
+                 "false\ntrue\nfalse\nnan\n-2\ntrue\nx\n");
+    expectOutput("fn sum(i32 a, f64 b, i32 c, f64 d, i32 e, f64 f, i32 g, f64 h, i32 i, f64 j, i32 k, f64 l,\n"
+                 "i32 m, f64 n, i32 o, f64 p, i32 q, f64 r) f64 {\n"
+                 "return cast(a + c + e + g + i + k + m + o + q, f64) + b + d + f + h + j + l + n + p + r; }\n"
+                 "fn main() { println(sum(1, 0.5, 2, 0.5, 3, 0.5, 4, 0.5, 5, 0.5, 6, 0.5, 7, 0.5, 8, 0.5, 9, 0.5)); }",
+                 "49.5\n");
+#endif
+}
+
+int main(void) {
+    test_x86_symbols();
+    test_x86_codegen();
+    test_x86_object();
+    test_x86_native();
+    return 0;
+}